@@ -0,0 +1,185 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * doc_generator *
+ *   Генератор синтетических документов json и xml одной структуры
+ * для бенчмарков ридеров
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef BENCHMARKS__DOC_GENERATOR_H
+#define BENCHMARKS__DOC_GENERATOR_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Форма документа
+ *
+ * Корень `root` и `depth` уровней узлов `n<i>`, у каждого узла
+ *   `fanout` дочерних узлов(кроме последнего уровня) и `params`
+ *   параметров `p<i>`
+ * */
+struct doc_shape {
+  int depth = 4;
+  int fanout = 8;
+  int params = 8;
+  /** \brief веса типов значений параметров: строки, целые,
+   *   дробные, bool */
+  int mix_string = 1;
+  int mix_int = 1;
+  int mix_float = 1;
+  int mix_bool = 1;
+  uint32_t seed = 1;
+};
+
+/**
+ * \brief Документы одной формы в json и xml с одинаковыми
+ *   значениями и пути запросов к ним
+ * */
+class doc_generator {
+ public:
+  explicit doc_generator(const doc_shape& shape) : shape_(shape) {}
+
+  /** \brief Число узлов документа с корнем */
+  size_t NodesCount() const {
+    size_t count = 1, level = 1;
+    for (int d = 0; d < shape_.depth; ++d) {
+      level *= shape_.fanout;
+      count += level;
+    }
+    return count;
+  }
+
+  /** \brief `{"root": {"p0": ..., "n0": {...}}}` */
+  std::string JSON() const {
+    std::string out = "{\"root\": ";
+    writeJSON(0, 0, &out);
+    out += "}\n";
+    return out;
+  }
+  /** \brief `<root><p0>...</p0><n0>...</n0></root>` */
+  std::string XML() const {
+    std::string out = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<root>";
+    writeXML(0, 0, &out);
+    out += "</root>\n";
+    return out;
+  }
+
+  /** \brief Случайные пути к параметрам без корня, последний
+   *   элемент - имя параметра, см. ReaderSample::GetValueByPath */
+  std::vector<std::vector<std::string>> ParameterPaths(size_t count) const {
+    std::vector<std::vector<std::string>> paths;
+    uint64_t state = shape_.seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = 0; i < count; ++i) {
+      std::vector<std::string> path = nodePath(&state);
+      path.push_back("p" + std::to_string(next(&state) % shape_.params));
+      paths.push_back(std::move(path));
+    }
+    return paths;
+  }
+  /** \brief Случайные пути к узлам без корня, непустые */
+  std::vector<std::vector<std::string>> NodePaths(size_t count) const {
+    std::vector<std::vector<std::string>> paths;
+    uint64_t state = shape_.seed * 0xC2B2AE3D27D4EB4FULL + 7;
+    while (paths.size() < count && shape_.depth > 0) {
+      std::vector<std::string> path = nodePath(&state);
+      if (!path.empty())
+        paths.push_back(std::move(path));
+    }
+    return paths;
+  }
+
+ private:
+  /** \brief splitmix64 */
+  static uint64_t next(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+  /** \brief Путь случайной глубины от 0 до `depth` */
+  std::vector<std::string> nodePath(uint64_t* state) const {
+    std::vector<std::string> path;
+    int depth = static_cast<int>(next(state) % (shape_.depth + 1));
+    for (int d = 0; d < depth; ++d)
+      path.push_back("n" + std::to_string(next(state) % shape_.fanout));
+    return path;
+  }
+  /** \brief Текст значения параметра `param` узла `node`, для
+   *   строк - без кавычек */
+  std::string value(uint64_t node, int param, bool* quoted) const {
+    uint64_t state = (node << 16) ^ static_cast<uint64_t>(param) ^
+                     (static_cast<uint64_t>(shape_.seed) << 48);
+    uint64_t h = next(&state);
+    int total = shape_.mix_string + shape_.mix_int + shape_.mix_float +
+                shape_.mix_bool;
+    int kind = total > 0 ? static_cast<int>(h % total) : 0;
+    h >>= 8;
+    *quoted = false;
+    char buf[32];
+    if ((kind -= shape_.mix_string) < 0) {
+      *quoted = true;
+      snprintf(buf, sizeof(buf), "value_%llx",
+               static_cast<unsigned long long>(h & 0xffffffffff));
+    } else if ((kind -= shape_.mix_int) < 0) {
+      snprintf(buf, sizeof(buf), "%lld",
+               static_cast<long long>(h % 2000000) - 1000000);
+    } else if ((kind -= shape_.mix_float) < 0) {
+      snprintf(buf, sizeof(buf), "%.4f",
+               static_cast<double>(h % 10000000) / 1000.0 - 5000.0);
+    } else {
+      return (h & 1) ? "true" : "false";
+    }
+    return buf;
+  }
+  /** \brief Узел `node` уровня `level`, дочерние узлы нумеруются
+   *   node * fanout + i + 1 */
+  void writeJSON(uint64_t node, int level, std::string* out) const {
+    *out += '{';
+    bool first = true;
+    for (int p = 0; p < shape_.params; ++p) {
+      bool quoted;
+      std::string v = value(node, p, &quoted);
+      *out += first ? "\"p" : ", \"p";
+      *out += std::to_string(p) + "\": ";
+      *out += quoted ? '"' + v + '"' : v;
+      first = false;
+    }
+    if (level < shape_.depth) {
+      for (int i = 0; i < shape_.fanout; ++i) {
+        *out += first ? "\"n" : ", \"n";
+        *out += std::to_string(i) + "\": ";
+        writeJSON(node * shape_.fanout + i + 1, level + 1, out);
+        first = false;
+      }
+    }
+    *out += '}';
+  }
+  void writeXML(uint64_t node, int level, std::string* out) const {
+    for (int p = 0; p < shape_.params; ++p) {
+      bool quoted;
+      std::string name = "p" + std::to_string(p);
+      *out += '<' + name + '>' + value(node, p, &quoted) + "</" + name + '>';
+    }
+    if (level < shape_.depth) {
+      for (int i = 0; i < shape_.fanout; ++i) {
+        std::string name = "n" + std::to_string(i);
+        *out += '<' + name + '>';
+        writeXML(node * shape_.fanout + i + 1, level + 1, out);
+        *out += "</" + name + '>';
+      }
+    }
+  }
+
+ private:
+  doc_shape shape_;
+};
+
+#endif  // !BENCHMARKS__DOC_GENERATOR_H
@@ -0,0 +1,436 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * asp_utils-bench-readers *
+ *   Бенчмарк ридеров на синтетических документах: загрузка файла,
+ * разбор и инициализация дерева, запросы по путям, чтение из
+ * нескольких потоков и удаление ридера. Результат - csv в stdout
+ *
+ *   asp_utils-bench-readers depth=4 fanout=8 params=8 mix=1,1,1,1 \
+ *     seed=1 repeat=5 lookups=10000 threads=1,2,4,8,16,32,64 backend=all
+ *
+ * `mix` - веса строк, целых, дробных и bool среди значений,
+ *   `threads` - числа потоков для замеров масштабирования чтения
+ *   ReaderSample(общий ридер и ReaderSample::Freeze), пустой список -
+ *   без них, `backend` - список через запятую, см. backends
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+#include "asp_utils/FileURL.h"
+#include "asp_utils/Logging.h"
+#include "asp_utils/Readers/INode.h"
+#include "asp_utils/Readers/MsgPack.h"
+#include "asp_utils/Readers/Reader.h"
+#if defined(WITH_RAPIDJSON)
+#include "asp_utils/Readers/JSONReader.h"
+#endif  // WITH_RAPIDJSON
+#if defined(WITH_PUGIXML)
+#include "asp_utils/Readers/XMLReader.h"
+#endif  // WITH_PUGIXML
+#include "doc_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace asp_utils;
+
+#if defined(NDEBUG)
+#define BENCH_BUILD "release"
+#else
+#define BENCH_BUILD "debug"
+#endif  // NDEBUG
+
+/**
+ * \brief Инициализатор узла для любого бэкенда ридера: подузлы -
+ *   дочерние узлы `n<i>`, параметры - листья `p<i>`
+ * */
+template <class NodeT>
+class bench_init final : public NodeInitializer<bench_init<NodeT>> {
+ public:
+  merror_t InitData(NodeT* n, const std::string& name) {
+    if (!n)
+      return ERROR_INIT_NULLP_ST;
+    this->name_ = name;
+    if constexpr (std::is_constructible_v<lib_node<NodeT>, NodeT*>)
+      node_ = lib_node<NodeT>(n);
+    else
+      node_ = lib_node<NodeT>(*n);
+    node_.ForEachChild(
+        [this](std::string_view name, std::string_view, lib_node<NodeT>* ch) {
+          if (ch && !name.empty() && name[0] == 'n')
+            this->subnodes_.push_back(std::string(name));
+        });
+    return ERROR_SUCCESS_T;
+  }
+  /** \brief Строки - без копирования из документа, остальные
+   *   значения - текстом, см. lib_node::ForEachChild */
+  std::string GetParameter(const std::string& name) {
+    std::string_view view = node_.GetValueView(name.c_str());
+    if (!view.empty())
+      return std::string(view);
+    std::string value;
+    node_.ForEachChild(
+        [&](std::string_view n, std::string_view v, lib_node<NodeT>*) {
+          if (value.empty() && n == name)
+            value = v;
+        });
+    return value;
+  }
+  void SetParentData(bench_init&) {}
+
+ private:
+  lib_node<NodeT> node_;
+};
+
+/** \brief Замеры одной фазы, нс */
+struct phase_samples {
+  const char* phase;
+  size_t ops = 1;
+  size_t threads = 1;
+  std::vector<long long> ns;
+};
+
+/** \brief Входные данные бенчмарка одного бэкенда */
+struct bench_input {
+  file_utils::FileURLSample<fs::path>* url;
+  size_t bytes;
+  size_t nodes;
+  const std::vector<std::vector<std::string>>* value_paths;
+  const std::vector<std::vector<std::string>>* node_paths;
+  /** \brief `value_paths`, скомпилированные */
+  const std::vector<path_handle>* value_handles;
+  const std::vector<size_t>* threads;
+};
+
+static long long elapsed_ns(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/**
+ * \brief Выполнить `op(t)` в `threads` потоках одновременно
+ * \return Время от старта последнего готового потока до завершения
+ *   всех, нс: без создания потоков
+ * */
+template <class Op>
+static long long run_threads(size_t threads, Op&& op) {
+  std::atomic<bool> go = false;
+  std::atomic<size_t> ready = 0;
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < threads; ++t) {
+    pool.emplace_back([&go, &ready, &op, t]() {
+      ++ready;
+      while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+      op(t);
+    });
+  }
+  while (ready.load() != threads)
+    std::this_thread::yield();
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto& th : pool)
+    th.join();
+  return elapsed_ns(start);
+}
+
+/**
+ * \brief Замерить чтение ридера из `in.threads` потоков: общий
+ *   ReaderSample(GetValueByPath) и его Freeze, каждый поток -
+ *   все запросы `in.value_handles` со своего смещения
+ * \param phases замеры: freeze, затем пары read_shared/read_frozen
+ *   по числам потоков
+ * \return Количество запросов, не нашедших узел
+ * */
+template <class Reader>
+size_t bench_concurrent(Reader* reader,
+                        const bench_input& in,
+                        phase_samples* phases) {
+  auto start = std::chrono::steady_clock::now();
+  auto frozen = reader->Freeze();
+  phases[0].ns.push_back(elapsed_ns(start));
+  if (!frozen)
+    return in.value_handles->size();
+
+  const auto& handles = *in.value_handles;
+  std::atomic<size_t> missed = 0;
+  for (size_t i = 0; i < in.threads->size(); ++i) {
+    size_t threads = (*in.threads)[i];
+    phases[1 + 2 * i].ns.push_back(run_threads(threads, [&](size_t t) {
+      std::string value;
+      size_t m = 0;
+      for (size_t j = 0; j < handles.size(); ++j) {
+        const path_handle& path = handles[(j + t) % handles.size()];
+        m += reader->GetValueByPath(path, &value) != ERROR_SUCCESS_T;
+      }
+      missed += m;
+    }));
+    phases[2 + 2 * i].ns.push_back(run_threads(threads, [&](size_t t) {
+      std::string_view value;
+      std::string buffer;
+      size_t m = 0;
+      for (size_t j = 0; j < handles.size(); ++j) {
+        const path_handle& path = handles[(j + t) % handles.size()];
+        m += frozen->GetValueByPath(path, &value, &buffer) != ERROR_SUCCESS_T;
+      }
+      missed += m;
+    }));
+  }
+  return missed;
+}
+
+/**
+ * \brief Замерить фазы ридера `Reader`: Init(загрузка файла),
+ *   InitData, GetValueByPath, GetNodeByPath и удаление
+ * \return false если ридер не создан или запросы не нашли значения
+ * */
+template <class Reader>
+bool bench_reader(const bench_input& in,
+                  int repeat,
+                  std::vector<phase_samples>* out) {
+  *out = {{"init"},
+          {"init_data"},
+          {"value_by_path", in.value_paths->size()},
+          {"node_by_path", in.node_paths->size()},
+          {"teardown"}};
+  constexpr bool freezable = requires(Reader* r) { r->Freeze(); };
+  if (freezable && !in.threads->empty()) {
+    out->push_back({"freeze"});
+    for (size_t threads : *in.threads) {
+      size_t ops = threads * in.value_handles->size();
+      out->push_back({"read_shared", ops, threads});
+      out->push_back({"read_frozen", ops, threads});
+    }
+  }
+  bool ok = true;
+  for (int r = 0; r < repeat && ok; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    Reader* reader = Reader::Init(in.url);
+    (*out)[0].ns.push_back(elapsed_ns(start));
+    if (!reader)
+      return false;
+
+    start = std::chrono::steady_clock::now();
+    merror_t error = reader->InitData();
+    (*out)[1].ns.push_back(elapsed_ns(start));
+    ok = !error;
+
+    size_t missed = 0;
+    std::string value;
+    start = std::chrono::steady_clock::now();
+    for (const auto& path : *in.value_paths) {
+      if (reader->GetValueByPath(path, &value) || value.empty())
+        ++missed;
+    }
+    (*out)[2].ns.push_back(elapsed_ns(start));
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& path : *in.node_paths) {
+      if (!reader->GetNodeByPath(path))
+        ++missed;
+    }
+    (*out)[3].ns.push_back(elapsed_ns(start));
+    if constexpr (freezable) {
+      if (out->size() > 5)
+        missed += bench_concurrent(reader, in, &(*out)[5]);
+    }
+    if (missed) {
+      fprintf(stderr, "%zu lookups missed\n", missed);
+      ok = false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    delete reader;
+    (*out)[4].ns.push_back(elapsed_ns(start));
+  }
+  return ok;
+}
+
+/** \brief Строка csv на фазу: минимум и медиана по повторам */
+static void print_samples(const char* backend,
+                          const bench_input& in,
+                          std::vector<phase_samples>* samples) {
+  for (auto& s : *samples) {
+    if (s.ns.empty())
+      continue;
+    std::sort(s.ns.begin(), s.ns.end());
+    printf("%s,%s,%s,%zu,%zu,%zu,%zu,%lld,%lld\n", BENCH_BUILD, backend,
+           s.phase, s.threads, in.bytes, in.nodes, s.ops, s.ns.front(),
+           s.ns[s.ns.size() / 2]);
+  }
+  fflush(stdout);
+}
+
+/** \brief Параметры командной строки `key=value` */
+struct bench_args {
+  doc_shape shape;
+  int repeat = 5;
+  size_t lookups = 10000;
+  std::vector<size_t> threads = {1, 2, 4, 8, 16, 32, 64};
+  std::string backend = "all";
+};
+
+static bool parse_args(int argc, char* argv[], bench_args* args) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos)
+      return false;
+    std::string key = arg.substr(0, eq), value = arg.substr(eq + 1);
+    if (key == "depth") {
+      args->shape.depth = atoi(value.c_str());
+    } else if (key == "fanout") {
+      args->shape.fanout = atoi(value.c_str());
+    } else if (key == "params") {
+      args->shape.params = atoi(value.c_str());
+    } else if (key == "seed") {
+      args->shape.seed = static_cast<uint32_t>(atol(value.c_str()));
+    } else if (key == "repeat") {
+      args->repeat = atoi(value.c_str());
+    } else if (key == "lookups") {
+      args->lookups = static_cast<size_t>(atol(value.c_str()));
+    } else if (key == "threads") {
+      args->threads.clear();
+      for (size_t pos = 0; pos < value.size();) {
+        size_t end = std::min(value.find(',', pos), value.size());
+        size_t threads = static_cast<size_t>(atol(value.c_str() + pos));
+        if (!threads)
+          return false;
+        args->threads.push_back(threads);
+        pos = end + 1;
+      }
+    } else if (key == "backend") {
+      args->backend = value;
+    } else if (key == "mix") {
+      if (sscanf(value.c_str(), "%d,%d,%d,%d", &args->shape.mix_string,
+                 &args->shape.mix_int, &args->shape.mix_float,
+                 &args->shape.mix_bool) != 4)
+        return false;
+    } else {
+      return false;
+    }
+  }
+  return args->shape.depth >= 0 && args->shape.fanout > 0 &&
+         args->shape.params > 0 && args->repeat > 0;
+}
+
+static bool write_file(const fs::path& path, const std::string& data) {
+  std::ofstream f(path, std::ios::binary);
+  f.write(data.data(), data.size());
+  return f.good();
+}
+
+/** \brief Бэкенд: имя, формат документа и замер */
+struct backend {
+  const char* name;
+  /** \brief 'j' - json, 'x' - xml, 'm' - MessagePack */
+  char format;
+  std::function<bool(const bench_input&, int, std::vector<phase_samples>*)>
+      run;
+};
+
+int main(int argc, char* argv[]) {
+  bench_args args;
+  if (!parse_args(argc, argv, &args)) {
+    fprintf(stderr,
+            "usage: %s [depth=N] [fanout=N] [params=N] "
+            "[mix=string,int,float,bool] [seed=N] [repeat=N] "
+            "[lookups=N] [threads=N,...] [backend=name,...|all]\n",
+            argv[0]);
+    return 1;
+  }
+  Logging::InitDefault();
+
+  std::vector<backend> backends = {
+#if defined(WITH_RAPIDJSON)
+      {"reader_rapidjson", 'j',
+       bench_reader<ReaderSample<rjNValue, bench_init<rjNValue>>>},
+      {"json_reader", 'j',
+       bench_reader<JSONReaderSample<bench_init<rjNValue>>>},
+#endif  // WITH_RAPIDJSON
+#if defined(WITH_PUGIXML)
+      {"reader_pugixml", 'x',
+       bench_reader<ReaderSample<pugi::xml_node, bench_init<pugi::xml_node>>>},
+      {"xml_reader", 'x',
+       bench_reader<XMLReaderSample<bench_init<pugi::xml_node>>>},
+#endif  // WITH_PUGIXML
+      {"reader_json_tape", 'j',
+       bench_reader<ReaderSample<json_tape_node, bench_init<json_tape_node>>>},
+      {"reader_msgpack", 'm',
+       bench_reader<ReaderSample<msgpack_node, bench_init<msgpack_node>>>},
+  };
+
+  // документы во временной директории, ридеры загружают их из файлов
+  doc_generator generator(args.shape);
+  std::string json = generator.JSON(), xml = generator.XML(), msgpack;
+  std::string json_copy = json;
+  ErrorWrap ew;
+  if (JSONToMsgPack(json_copy.data(), json_copy.size(), &msgpack, &ew)) {
+    fprintf(stderr, "json to msgpack: %s\n", ew.GetMessage().c_str());
+    return 1;
+  }
+  fs::path dir = fs::temp_directory_path() / "asp_utils_bench_readers";
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  if (!write_file(dir / "doc.json", json) ||
+      !write_file(dir / "doc.xml", xml) ||
+      !write_file(dir / "doc.msgpack", msgpack)) {
+    fprintf(stderr, "can't write documents to %s\n", dir.string().c_str());
+    return 1;
+  }
+  file_utils::SetupURLSample<fs::path> setup(file_utils::url_t::fs_path, dir);
+  file_utils::FileURLRootSample<fs::path> root(setup);
+  file_utils::FileURLSample<fs::path> json_url = root.CreateFileURL("doc.json"),
+                                      xml_url = root.CreateFileURL("doc.xml"),
+                                      msgpack_url =
+                                          root.CreateFileURL("doc.msgpack");
+
+  auto value_paths = generator.ParameterPaths(args.lookups);
+  auto node_paths = generator.NodePaths(args.lookups);
+  std::vector<path_handle> value_handles(value_paths.begin(),
+                                         value_paths.end());
+  printf("build,backend,phase,threads,bytes,nodes,ops,min_ns,median_ns\n");
+  int result = 0;
+  for (const auto& b : backends) {
+    if (args.backend != "all" &&
+        ("," + args.backend + ",").find(std::string(",") + b.name + ",") ==
+            std::string::npos)
+      continue;
+    bench_input in = {&json_url,   json.size(),  generator.NodesCount(),
+                      &value_paths, &node_paths, &value_handles,
+                      &args.threads};
+    if (b.format == 'x') {
+      in.url = &xml_url;
+      in.bytes = xml.size();
+    } else if (b.format == 'm') {
+      in.url = &msgpack_url;
+      in.bytes = msgpack.size();
+    }
+    std::vector<phase_samples> samples;
+    if (!b.run(in, args.repeat, &samples)) {
+      fprintf(stderr, "%s: reader failed\n", b.name);
+      result = 1;
+    }
+    print_samples(b.name, in, &samples);
+  }
+  fs::remove_all(dir, ec);
+  return result;
+}
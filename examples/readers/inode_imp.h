@@ -189,29 +189,22 @@ class json_test_node : public INodeInitializer {
   /* jfl */
   /** \brief инициализировать параметры тестовой структуры first */
   first getFirst() {
-    first f;
+    first f{};
     f.f = GetParameter("f");
     f.s = GetParameter("s");
     f.ff = GetParameter("ff");
-    try {
-      f.t = std::stof(GetParameter("t"));
-    } catch (std::exception& e) {
-      Logging::Append(std::string("Ошибка инициализации float параметра ") +
-                      e.what());
-    }
+    if (GetParameterAs("t", &f.t))
+      Logging::Append("Ошибка инициализации float параметра t");
     return f;
   }
   /** \brief инициализировать параметры тестовой структуры second */
   second getSecond() {
-    second s;
+    second s{};
     s.f = GetParameter("f");
-    try {
-      s.s = std::atoi(GetParameter("s").c_str());
-      s.t = std::atoi(GetParameter("t").c_str());
-    } catch (std::exception& e) {
-      Logging::Append(std::string("Ошибка инициализации float параметра ") +
-                      e.what());
-    }
+    if (GetParameterAs("s", &s.s))
+      Logging::Append("Ошибка инициализации int параметра s");
+    if (GetParameterAs("t", &s.t))
+      Logging::Append("Ошибка инициализации int параметра t");
     return s;
   }
 };
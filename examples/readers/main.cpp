@@ -2,8 +2,10 @@
 #include "asp_utils/FileURL.h"
 #include "asp_utils/Readers/INode.h"
 #include "asp_utils/Readers/JSONReader.h"
+#include "asp_utils/Readers/JSONStreamReader.h"
 #include "asp_utils/Readers/Reader.h"
 #include "asp_utils/Readers/XMLReader.h"
+#include "asp_utils/Readers/XMLStreamReader.h"
 #include "inode_imp.h"
 
 #include <filesystem>
@@ -97,6 +99,30 @@ int json() {
   return 0;
 }
 
+/** \brief Потоковый разбор json файла блоками по 4 KiB */
+int json_stream() {
+  json_test_factory tf;
+  reader_options options;
+  options.stream_buffer_size = 4 * 1024;
+  std::unique_ptr<
+      JSONStreamReaderSample<json_test_node<rjNValue>, json_test_factory>>
+      ss(JSONStreamReaderSample<json_test_node<rjNValue>,
+                                json_test_factory>::Init(j, &tf, options));
+  return ss->InitData();
+}
+
+/** \brief Потоковый разбор xml файла блоками по 4 KiB */
+int xml_stream() {
+  json_test_factory tf;
+  reader_options options;
+  options.stream_buffer_size = 4 * 1024;
+  std::unique_ptr<
+      XMLStreamReaderSample<json_test_node<pugi::xml_node>, json_test_factory>>
+      ss(XMLStreamReaderSample<json_test_node<pugi::xml_node>,
+                               json_test_factory>::Init(x, &tf, options));
+  return ss->InitData();
+}
+
 int reader() {
   // xml
   json_test_factory tf;
@@ -127,6 +153,8 @@ int main(int argc, char* argv[]) {
   j = &sj;
   // xml();
   // json();
+  json_stream();
+  xml_stream();
   reader();
   return 0;
 }
@@ -0,0 +1,129 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * Arena *
+ *   Арена объектов - память выделяется большими блоками,
+ * освобождается вся сразу
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__ARENA_H
+#define UTILS__ARENA_H
+
+#include "asp_utils/Common.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * \brief Размер блока арены по умолчанию
+ * */
+#define DEFAULT_ARENA_BLOCK (64 * 1024)  // 64 KiB
+
+namespace asp_utils {
+/**
+ * \brief Арена объектов
+ *
+ * Объекты создаются в блоках памяти арены, деструкторы вызываются
+ *   в обратном порядке создания при освобождении арены(Release или
+ *   деструктор). Адреса объектов стабильны.
+ * \note Не потокобезопасна
+ * */
+class Arena {
+ public:
+  explicit Arena(size_t block_size = DEFAULT_ARENA_BLOCK);
+  Arena(Arena&& other) noexcept;
+  Arena& operator=(Arena&& other) noexcept;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena();
+
+  /**
+   * \brief Выделить `size` байт с выравниванием `align`
+   * */
+  void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+  /**
+   * \brief Создать объект типа T в памяти арены
+   * \return Указатель на объект, удалять его нельзя
+   * */
+  template <class T, class... Args>
+  T* Create(Args&&... args) {
+    void* mem = Allocate(sizeof(T), alignof(T));
+    T* obj = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      dtor_node* d = static_cast<dtor_node*>(
+          Allocate(sizeof(dtor_node), alignof(dtor_node)));
+      d->object = obj;
+      d->destroy = [](void* o) { static_cast<T*>(o)->~T(); };
+      d->next = dtors_;
+      dtors_ = d;
+    }
+    ++objects_count_;
+    return obj;
+  }
+  /**
+   * \brief Вызвать деструкторы всех объектов и освободить блоки
+   * */
+  void Release();
+  /**
+   * \brief Количество созданных объектов
+   * */
+  size_t GetObjectsCount() const { return objects_count_; }
+  /**
+   * \brief Объём памяти, занятой блоками арены
+   * */
+  size_t GetAllocatedSize() const { return allocated_; }
+
+ private:
+  /**
+   * \brief Заголовок блока памяти
+   * */
+  struct block {
+    block* next;
+    size_t size;
+  };
+  /**
+   * \brief Запись о деструкторе объекта
+   * */
+  struct dtor_node {
+    dtor_node* next;
+    void* object;
+    void (*destroy)(void*);
+  };
+
+ private:
+  /**
+   * \brief Добавить блок, в котором поместится `size` байт
+   * */
+  void add_block(size_t size, size_t align);
+
+ private:
+  /**
+   * \brief Размер блока
+   * */
+  size_t block_size_;
+  /**
+   * \brief Текущий(последний) блок
+   * */
+  block* head_ = nullptr;
+  /**
+   * \brief Свободная память текущего блока
+   * */
+  char* cursor_ = nullptr;
+  char* end_ = nullptr;
+  /**
+   * \brief Список деструкторов, последний созданный - первый
+   * */
+  dtor_node* dtors_ = nullptr;
+  size_t objects_count_ = 0;
+  size_t allocated_ = 0;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__ARENA_H
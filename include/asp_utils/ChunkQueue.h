@@ -0,0 +1,84 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * ChunkQueue *
+ *   Ограниченная очередь блоков данных между потоком-источником
+ * и потоком-разборщиком
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__CHUNKQUEUE_H
+#define UTILS__CHUNKQUEUE_H
+
+#include "asp_utils/Common.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace asp_utils {
+/**
+ * \brief Ограниченная очередь блоков данных
+ *
+ * Источник кладёт блоки методом Push(блокируется, если очередь
+ *   заполнена) и завершает поток данных методом Close. Разборщик
+ *   читает данные методом Read как из файла - блоки склеиваются
+ *   в непрерывный поток байт.
+ * */
+class ChunkQueue {
+ public:
+  /**
+   * \brief Очередь не более чем из `max_chunks` блоков
+   * */
+  explicit ChunkQueue(size_t max_chunks);
+  ChunkQueue(const ChunkQueue&) = delete;
+  ChunkQueue& operator=(const ChunkQueue&) = delete;
+
+  /**
+   * \brief Положить в очередь копию блока `chunk`
+   * \return false если разборщик прервал чтение(Cancel)
+   * */
+  bool Push(std::string_view chunk);
+  /**
+   * \brief Данных больше не будет, Read вернёт 0 после
+   *   чтения оставшихся блоков
+   * */
+  void Close();
+  /**
+   * \brief Прочитать не более `size` байт в `buffer`
+   * \return Количество прочитанных байт, 0 - очередь закрыта
+   *   и все данные прочитаны
+   * */
+  size_t Read(char* buffer, size_t size);
+  /**
+   * \brief Прервать чтение: очередь очищается, Push и Read
+   *   возвращают false/0
+   * */
+  void Cancel();
+  /**
+   * \brief Чтение закончено(например, документ разобран полностью),
+   *   последующие блоки принимаются и отбрасываются
+   * */
+  void Drain();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<std::string> chunks_;
+  /** \brief прочитано байт первого блока */
+  size_t offset_ = 0;
+  size_t max_chunks_;
+  bool closed_ = false;
+  bool cancelled_ = false;
+  bool drained_ = false;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__CHUNKQUEUE_H
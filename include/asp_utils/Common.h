@@ -15,12 +15,16 @@
 #define _UTILS__COMMON_H_
 
 #include <algorithm>
+#include <charconv>
 #include <complex>
+#include <concepts>
 #include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #if defined(BYCMAKE_DEBUG)
 /** \brief Режим отладки */
@@ -162,6 +166,64 @@ inline bool ends_with(const std::string& str, const std::string& ending) {
  * \return Строка без начальных и конечных пробелов
  * */
 std::string trim_str(const std::string& str);
+/**
+ * \brief Обрезать пробелы с обоих концов без копирования
+ * \return Подстрока `str` без начальных и конечных пробелов
+ * */
+std::string_view trim_view(std::string_view str);
+/**
+ * \brief Перечисление с функцией разбора по имени
+ *   `bool from_string(std::string_view, E*)`, найденной по ADL
+ * */
+template <class T>
+concept EnumFromStringType = std::is_enum_v<T> && requires(std::string_view s,
+                                                           T* v) {
+  { from_string(s, v) } -> std::convertible_to<bool>;
+};
+/**
+ * \brief Разобрать строку `str` целиком в значение `out`
+ *
+ * Числа разбираются std::from_chars - без учёта локали и выделения
+ *   памяти, bool - `true`, `false`, `1`, `0`, перечисления - функцией
+ *   from_string(см. EnumFromStringType) или по целому значению
+ * \return true если строка - значение типа T, иначе `out`
+ *   не изменяется
+ * */
+template <class T>
+bool str_to_value(std::string_view str, T* out) {
+  if constexpr (std::is_same_v<T, bool>) {
+    if (str == "true" || str == "1") {
+      *out = true;
+    } else if (str == "false" || str == "0") {
+      *out = false;
+    } else {
+      return false;
+    }
+    return true;
+  } else if constexpr (std::is_enum_v<T>) {
+    if constexpr (EnumFromStringType<T>) {
+      if (from_string(str, out))
+        return true;
+    }
+    std::underlying_type_t<T> value;
+    if (!str_to_value(str, &value))
+      return false;
+    *out = static_cast<T>(value);
+    return true;
+  } else {
+    static_assert(std::is_arithmetic_v<T>, "str_to_value: unsupported type");
+    // from_chars не принимает ведущий '+'
+    if (str.size() > 1 && str[0] == '+' && str[1] != '-')
+      str.remove_prefix(1);
+    T value;
+    const char* end = str.data() + str.size();
+    auto [ptr, ec] = std::from_chars(str.data(), end, value);
+    if (ec != std::errc() || ptr != end)
+      return false;
+    *out = value;
+    return true;
+  }
+}
 /**
  * \brief Проверить что объект файловой системы(файл, директория, соккет,
  *   линк, character_dev) существует
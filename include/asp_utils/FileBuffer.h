@@ -0,0 +1,135 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * FileBuffer *
+ *   Буффер памяти с содержимым файла: считанным в память процесса
+ * или отображённым в неё
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__FILEBUFFER_H
+#define UTILS__FILEBUFFER_H
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <filesystem>
+
+namespace asp_utils {
+namespace file_utils {
+/**
+ * \brief Способ загрузки файла в память
+ * */
+enum class buffer_mode_t {
+  /**
+   * \brief Считать файл в собственный буффер
+   * */
+  copy = 0,
+  /**
+   * \brief Отобразить файл в память(private, copy-on-write),
+   *   если отобразить файл не получилось - считать его в буффер
+   * */
+  mmap = 1
+};
+
+/**
+ * \brief Изменяемый буффер памяти с содержимым файла или строки
+ *
+ * Данные буффера всегда завершаются нулевым байтом и могут
+ *   изменяться парсером(pugixml `load_buffer_inplace`, например),
+ *   изменения в исходный файл не попадают.
+ * */
+class FileBuffer {
+ public:
+  FileBuffer() = default;
+  FileBuffer(FileBuffer&& other) noexcept;
+  FileBuffer& operator=(FileBuffer&& other) noexcept;
+  FileBuffer(const FileBuffer&) = delete;
+  FileBuffer& operator=(const FileBuffer&) = delete;
+  ~FileBuffer();
+
+  /**
+   * \brief Загрузить файл в память
+   * \param path Путь к файлу
+   * \param mode Способ загрузки
+   * \param error Ссылка на объект-ошибку
+   * \return Код ошибки
+   * */
+  merror_t Load(const fs::path& path, buffer_mode_t mode, ErrorWrap& error);
+  /**
+   * \brief Скопировать в буффер `len` байт данных `data`
+   * \return Код ошибки
+   * */
+  merror_t Assign(const char* data, size_t len);
+  /**
+   * \brief Дописать в конец буффера `len` байт данных `data`
+   *
+   * Память выделяется с запасом(удвоением), поэтому сборка
+   *   документа из множества небольших блоков стоит линейное
+   *   время. Отображённый файл при этом копируется в кучу
+   * \return Код ошибки
+   * */
+  merror_t Append(const char* data, size_t len);
+  /**
+   * \brief Освободить буффер
+   * */
+  void Reset();
+  /**
+   * \brief Указатель на данные, nullptr для пустого буффера
+   * */
+  char* GetData() { return data_; }
+  const char* GetData() const { return data_; }
+  /**
+   * \brief Размер данных, без завершающего нуля
+   * */
+  size_t GetSize() const { return size_; }
+  /**
+   * \brief Буффер пуст
+   * */
+  bool IsEmpty() const { return size_ == 0; }
+  /**
+   * \brief Данные отображены из файла, а не скопированы
+   * */
+  bool IsMapped() const { return mapped_size_ != 0; }
+
+ private:
+  /**
+   * \brief Отобразить файл в память
+   * \return true если файл отображён
+   *
+   * Отображение возможно только если за концом файла
+   *   в последней странице остаётся место для завершающего нуля
+   * */
+  bool map(const fs::path& path);
+  /**
+   * \brief Считать файл в буффер за одно копирование
+   * */
+  merror_t read(const fs::path& path, ErrorWrap& error);
+
+ private:
+  /**
+   * \brief Данные буффера
+   * */
+  char* data_ = nullptr;
+  /**
+   * \brief Размер данных
+   * */
+  size_t size_ = 0;
+  /**
+   * \brief Размер выделенной в куче памяти, без завершающего нуля
+   * */
+  size_t capacity_ = 0;
+  /**
+   * \brief Размер отображённой области памяти, 0 если данные
+   *   размещены в куче
+   * */
+  size_t mapped_size_ = 0;
+};
+}  // namespace file_utils
+}  // namespace asp_utils
+
+#endif  // !UTILS__FILEBUFFER_H
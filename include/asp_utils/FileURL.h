@@ -261,6 +261,14 @@ class FileURLRootSample : public BaseObject {
    *   относительно корневой директории
    * */
   FileURLSample<PathT> CreateFileURL(const PathT& relative_path);
+  /**
+   * \brief Собрать адреса файлов по относительным путям,
+   *   например для пакетной загрузки(BatchLoaderSample)
+   * \param relative_paths Относительные пути
+   * \return Адреса в порядке relative_paths
+   * */
+  std::vector<FileURLSample<PathT>> CreateFileURLs(
+      const std::vector<PathT>& relative_paths);
   /**
    * \brief Список файлов в директории
    * \todo можно добавить относительный путь и глубину обхода(сейчас 1)
@@ -310,6 +318,16 @@ FileURLSample<PathT> FileURLRootSample<PathT>::CreateFileURL(
   return FileURLSample<PathT>();
 }
 
+template <PathType PathT>
+std::vector<FileURLSample<PathT>> FileURLRootSample<PathT>::CreateFileURLs(
+    const std::vector<PathT>& relative_paths) {
+  std::vector<FileURLSample<PathT>> urls;
+  urls.reserve(relative_paths.size());
+  for (const auto& path : relative_paths)
+    urls.push_back(CreateFileURL(path));
+  return urls;
+}
+
 template <PathType PathT>
 void FileURLRootSample<PathT>::check_fs_root() {
   status_ = is_exists(setup_.root) ? STATUS_OK : STATUS_NOT;
@@ -0,0 +1,312 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * BatchLoader *
+ *   Пакетная загрузка множества файлов конвейером: чтение файлов
+ * и разбор с инициализацией узлов выполняются параллельно
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__BATCHLOADER_H
+#define UTILS__BATCHLOADER_H
+
+#include "asp_utils/FileBuffer.h"
+#include "asp_utils/FileURL.h"
+#include "asp_utils/Readers/Reader.h"
+#include "asp_utils/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * \brief Максимальное количество файлов, прочитанных, но ещё
+ *   не разобранных, по умолчанию
+ * */
+#define BATCH_MAX_IN_FLIGHT 64
+/**
+ * \brief Максимальный объём файлов, прочитанных, но ещё
+ *   не разобранных, по умолчанию
+ * */
+#define BATCH_MAX_IN_FLIGHT_BYTES (64 * 1024 * 1024)  // 64 MiB
+
+namespace asp_utils {
+/**
+ * \brief Настройки пакетной загрузки
+ * */
+struct batch_options {
+  /**
+   * \brief Количество потоков чтения файлов
+   * */
+  size_t io_threads = 2;
+  /**
+   * \brief Количество потоков разбора и инициализации,
+   *   0 - по количеству аппаратных потоков
+   * \note Для фабрик без GetThreadFactory(см. ThreadFactoryType)
+   *   разбор выполняется в одном потоке
+   * */
+  size_t parse_threads = 0;
+  /**
+   * \brief Ограничения памяти между стадиями: количество и суммарный
+   *   размер прочитанных, но ещё не разобранных файлов. Файл больше
+   *   `max_in_flight_bytes` читается, когда других файлов в работе нет
+   * */
+  size_t max_in_flight = BATCH_MAX_IN_FLIGHT;
+  size_t max_in_flight_bytes = BATCH_MAX_IN_FLIGHT_BYTES;
+};
+
+/**
+ * \brief Статистика стадии конвейера
+ * */
+struct batch_stage_stats {
+  /** \brief обработано файлов */
+  size_t files = 0;
+  /** \brief обработано байт */
+  size_t bytes = 0;
+  /** \brief суммарное время работы потоков стадии, секунды */
+  double busy_seconds = 0.0;
+
+  /** \brief Пропускная способность одного потока стадии, байт/с */
+  double Throughput() const {
+    return busy_seconds > 0.0 ? bytes / busy_seconds : 0.0;
+  }
+};
+
+/**
+ * \brief Статистика пакетной загрузки
+ * */
+struct batch_stats {
+  /** \brief стадия чтения файлов */
+  batch_stage_stats io;
+  /** \brief стадия разбора и инициализации узлов */
+  batch_stage_stats parse;
+  /** \brief время загрузки всего пакета, секунды */
+  double wall_seconds = 0.0;
+  /** \brief файлов с ошибками */
+  size_t errors = 0;
+
+  /** \brief Пропускная способность конвейера, байт/с */
+  double Throughput() const {
+    return wall_seconds > 0.0 ? parse.bytes / wall_seconds : 0.0;
+  }
+};
+
+/**
+ * \brief Пакетный загрузчик файлов ридером ReaderSample
+ *
+ * Файлы читаются в память пулом потоков чтения, прочитанные файлы
+ *   разбираются и инициализируются(ReaderSample::InitData) пулом
+ *   потоков разбора, так что чтение следующих файлов идёт
+ *   одновременно с разбором предыдущих. Между стадиями находится
+ *   не больше `batch_options::max_in_flight` файлов общим размером
+ *   не больше `batch_options::max_in_flight_bytes`.
+ *
+ * Фабрика узлов вызывается из потоков разбора: фабрики с
+ *   GetThreadFactory получают фабрику рабочего потока,
+ *   иначе поток разбора один.
+ * */
+template <class NodeT,
+          class Initializer,
+          class InitializerFactory = SimpleInitializerFactory<Initializer>,
+          class PathT = fs::path,
+          class = typename std::enable_if<
+              NodeInitializerType<Initializer>>::type>
+class BatchLoaderSample {
+ public:
+  typedef ReaderSample<NodeT, Initializer, InitializerFactory, PathT> Reader;
+
+  /**
+   * \brief Результат загрузки файла
+   * */
+  struct batch_item {
+    /** \brief адрес файла */
+    file_utils::FileURLSample<PathT>* source = nullptr;
+    /** \brief ридер с инициализированными данными, nullptr если
+     *   файл не прочитан */
+    std::unique_ptr<Reader> reader;
+    /** \brief код ошибки чтения или разбора */
+    merror_t error = ERROR_SUCCESS_T;
+  };
+
+ public:
+  explicit BatchLoaderSample(const batch_options& options = batch_options())
+      : options_(options) {}
+
+  /**
+   * \brief Загрузить файлы `sources`
+   * \return Результаты в порядке `sources`
+   * */
+  std::vector<batch_item> Load(
+      const std::vector<file_utils::FileURLSample<PathT>*>& sources,
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    auto start = clock::now();
+    stats_ = batch_stats();
+    in_flight_ = 0;
+    in_flight_bytes_ = 0;
+    std::vector<batch_item> items(sources.size());
+    {
+      size_t parse_threads = options_.parse_threads;
+      if constexpr (!ThreadFactoryType<InitializerFactory>) {
+        if (factory)
+          parse_threads = 1;
+      }
+      // пул разбора объявлен первым - разрушается последним,
+      //   после того как стадия чтения поставит все задачи
+      ThreadPool parse_pool(parse_threads);
+      std::vector<std::future<void>> parsed(sources.size());
+      ThreadPool io_pool(std::max<size_t>(options_.io_threads, 1));
+      std::vector<std::future<void>> read;
+      read.reserve(sources.size());
+      for (size_t i = 0; i < sources.size(); ++i) {
+        items[i].source = sources[i];
+        read.push_back(io_pool.Submit([&, i]() {
+          file_utils::FileBuffer memory;
+          size_t size = 0;
+          if (!readFile(items[i], options, memory, &size))
+            return;
+          parsed[i] = parse_pool.Submit(
+              [this, &items, &options, i, size, factory,
+               m = std::move(memory)]() mutable {
+                parseFile(items[i], std::move(m), size, factory, options);
+              });
+        }));
+      }
+      for (auto& r : read)
+        r.get();
+      for (auto& p : parsed)
+        if (p.valid())
+          p.get();
+    }
+    for (const auto& item : items)
+      if (item.error)
+        ++stats_.errors;
+    stats_.wall_seconds = seconds(start);
+    return items;
+  }
+  /**
+   * \brief Загрузить файлы `sources`, например созданные
+   *   FileURLRootSample::CreateFileURLs
+   * */
+  std::vector<batch_item> Load(
+      std::vector<file_utils::FileURLSample<PathT>>& sources,
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    std::vector<file_utils::FileURLSample<PathT>*> ptrs;
+    ptrs.reserve(sources.size());
+    for (auto& source : sources)
+      ptrs.push_back(&source);
+    return Load(ptrs, factory, options);
+  }
+  /**
+   * \brief Статистика последней загрузки
+   * */
+  const batch_stats& GetStats() const { return stats_; }
+
+ private:
+  typedef std::chrono::steady_clock clock;
+
+  static double seconds(clock::time_point start) {
+    return std::chrono::duration<double>(clock::now() - start).count();
+  }
+  /** \brief Стадия чтения: дождаться места в конвейере
+   *   и загрузить файл в память */
+  bool readFile(batch_item& item,
+                const reader_options& options,
+                file_utils::FileBuffer& memory,
+                size_t* reserved) {
+    if (!item.source) {
+      item.error = ERROR_INIT_NULLP_ST;
+      return false;
+    }
+    std::error_code ec;
+    size_t size =
+        static_cast<size_t>(fs::file_size(item.source->GetURL(), ec));
+    if (ec) {
+      item.error = ERROR_FILE_EXISTS_ST;
+      return false;
+    }
+    acquire(size);
+    *reserved = size;
+    auto start = clock::now();
+    ErrorWrap error;
+    memory.Load(item.source->GetURL(), options.buffer_mode, error);
+    double busy = seconds(start);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.io.files;
+      stats_.io.bytes += memory.GetSize();
+      stats_.io.busy_seconds += busy;
+    }
+    if (error.GetErrorCode()) {
+      item.error = error.GetErrorCode();
+      release(size);
+      return false;
+    }
+    return true;
+  }
+  /** \brief Стадия разбора: создать ридер и инициализировать данные */
+  void parseFile(batch_item& item,
+                 file_utils::FileBuffer&& memory,
+                 size_t reserved,
+                 InitializerFactory* factory,
+                 const reader_options& options) {
+    size_t size = memory.GetSize();
+    auto start = clock::now();
+    if constexpr (ThreadFactoryType<InitializerFactory>) {
+      if (factory)
+        factory = factory->GetThreadFactory(ThreadPool::GetWorkerIndex());
+    }
+    item.reader = std::unique_ptr<Reader>(
+        Reader::Init(item.source, std::move(memory), factory, options));
+    item.error = item.reader->InitData();
+    double busy = seconds(start);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.parse.files;
+      stats_.parse.bytes += size;
+      stats_.parse.busy_seconds += busy;
+    }
+    release(reserved);
+  }
+  /** \brief Занять место в конвейере под файл размером `size` */
+  void acquire(size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this, size]() {
+      return in_flight_ == 0 ||
+             (in_flight_ < options_.max_in_flight &&
+              in_flight_bytes_ + size <= options_.max_in_flight_bytes);
+    });
+    ++in_flight_;
+    in_flight_bytes_ += size;
+  }
+  /** \brief Освободить место файла размером `size` */
+  void release(size_t size) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --in_flight_;
+      in_flight_bytes_ -= size;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  batch_options options_;
+  batch_stats stats_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  /** \brief прочитанные и ещё не разобранные файлы */
+  size_t in_flight_ = 0;
+  size_t in_flight_bytes_ = 0;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__BATCHLOADER_H
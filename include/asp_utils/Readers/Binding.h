@@ -0,0 +1,278 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * Binding *
+ *   Привязка документа к структурам с++: таблица полей структуры
+ * описывает узлы документа, из которых заполняются её поля
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__BINDING_H
+#define UTILS__BINDING_H
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+#include "asp_utils/FileBuffer.h"
+#include "asp_utils/FileURL.h"
+#include "asp_utils/Readers/Reader.h"
+#include "asp_utils/Readers/ReaderOptions.h"
+
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/** \brief Поле `member` структуры `type` из узла с тем же именем */
+#define BINDING_FIELD(type, member) \
+  asp_utils::bind_field(#member, &type::member)
+
+namespace asp_utils {
+/**
+ * \brief Таблица полей структуры T, специализируется пользователем
+ *
+ *   template <>
+ *   struct binding<first> {
+ *     static constexpr auto fields =
+ *         std::make_tuple(BINDING_FIELD(first, f),
+ *                         bind_field("t", &first::t),
+ *                         bind_optional("ff", &first::ff));
+ *   };
+ *
+ * Поля могут быть скалярами(числа, bool, перечисления), строками,
+ *   структурами со своей таблицей полей и std::vector из них
+ * */
+template <class T>
+struct binding {};
+
+/** \brief Описание поля: имя узла документа и указатель на член */
+template <class T, class M>
+struct bind_field_t {
+  const char* name;
+  M T::*member;
+  /** \brief отсутствие узла в документе - ошибка привязки */
+  bool required;
+};
+
+/** \brief Обязательное поле `member` из узла `name` */
+template <class T, class M>
+constexpr bind_field_t<T, M> bind_field(const char* name, M T::*member) {
+  return bind_field_t<T, M>{name, member, true};
+}
+/** \brief Необязательное поле: если узла нет, значение не меняется */
+template <class T, class M>
+constexpr bind_field_t<T, M> bind_optional(const char* name, M T::*member) {
+  return bind_field_t<T, M>{name, member, false};
+}
+
+/** \brief Для структуры задана таблица полей, см. binding */
+template <class T>
+concept BoundType = requires {
+  std::tuple_size<std::decay_t<decltype(binding<T>::fields)>>::value;
+};
+
+/** \brief Путь поля для сообщений об ошибках, строится
+ *   только при ошибке */
+struct bind_path {
+  const bind_path* parent;
+  const char* name;
+
+  std::string Str() const {
+    std::string path = parent ? parent->Str() : std::string();
+    if (!path.empty())
+      path += '/';
+    return path + name;
+  }
+};
+
+/**
+ * \brief Заполнение структур с таблицей полей из узлов документа
+ *
+ * Поля заполняются прямо из узлов lib_node, без дерева node_sample
+ *   и инициализаторов: скаляры - lib_value_as, строки - копией
+ *   GetValueView(текст xml - с пробелами, как GetValueByPath),
+ *   структуры - из дочернего узла GetChild. Элементы std::vector -
+ *   все дочерние узлы с именем поля(ForEachChild): элементы массива
+ *   json или повторяющиеся элементы xml
+ * */
+template <class NodeT>
+class struct_binder {
+ public:
+  explicit struct_binder(ErrorWrap* ew) : ew_(ew) {}
+
+  template <BoundType T>
+  bool Bind(lib_node<NodeT>& node, T* out, const bind_path* path) {
+    return std::apply(
+        [&](const auto&... f) {
+          return (bindField(node, out, f, path) && ...);
+        },
+        binding<T>::fields);
+  }
+
+ private:
+  template <class U>
+  struct is_vector : std::false_type {};
+  template <class U, class A>
+  struct is_vector<std::vector<U, A>> : std::true_type {};
+
+  template <class T, class M>
+  bool bindField(lib_node<NodeT>& node,
+                 T* out,
+                 const bind_field_t<T, M>& f,
+                 const bind_path* parent) {
+    bind_path path{parent, f.name};
+    M* value = &(out->*f.member);
+    if constexpr (BoundType<M>) {
+      auto ch = node.GetChild(f.name);
+      if (!lib_node<NodeT>::IsInitialized(ch))
+        return missing(f.required, path);
+      lib_node<NodeT> child(ch);
+      return Bind(child, value, &path);
+    } else if constexpr (is_vector<M>::value) {
+      static_assert(ChildsTraversableType<NodeT>,
+                    "binding: vector field requires lib_node::ForEachChild");
+      std::string_view name(f.name);
+      bool ok = true;
+      value->clear();
+      node.ForEachChild([&](std::string_view ch_name, std::string_view v,
+                            lib_node<NodeT>* child) {
+        if (ok && ch_name == name)
+          ok = bindItem(v, child, &value->emplace_back(), path);
+      });
+      if (!ok)
+        return false;
+      return !value->empty() || missing(f.required, path);
+    } else if constexpr (std::is_same_v<M, std::string>) {
+      std::string_view v = node.GetValueView(f.name);
+      if (v.empty() && !hasChild(node, f.name))
+        return missing(f.required, path);
+      value->assign(v.data(), v.size());
+      return true;
+    } else {
+      if (lib_value_as(node, f.name, value))
+        return true;
+      if (node.GetValueView(f.name).empty() && !hasChild(node, f.name))
+        return missing(f.required, path);
+      return wrongValue(path);
+    }
+  }
+  /** \brief Элемент поля-вектора: значение `v` или узел `child` */
+  template <class U>
+  bool bindItem(std::string_view v,
+                lib_node<NodeT>* child,
+                U* out,
+                const bind_path& path) {
+    if constexpr (BoundType<U>) {
+      return child ? Bind(*child, out, &path) : wrongValue(path);
+    } else if constexpr (std::is_same_v<U, std::string>) {
+      out->assign(v.data(), v.size());
+      return true;
+    } else {
+      return str_to_value(trim_view(v), out) || wrongValue(path);
+    }
+  }
+
+  static bool hasChild(lib_node<NodeT>& node, const char* name) {
+    return lib_node<NodeT>::IsInitialized(node.GetChild(name));
+  }
+  bool missing(bool required, const bind_path& path) {
+    if (required)
+      ew_->SetError(ERROR_PARSER_CHILD_NODE_ST,
+                    "binding: missing node '" + path.Str() + "'");
+    return !required;
+  }
+  bool wrongValue(const bind_path& path) {
+    ew_->SetError(ERROR_STR_PARSE_ST,
+                  "binding: wrong value of node '" + path.Str() + "'");
+    return false;
+  }
+
+ private:
+  ErrorWrap* ew_;
+};
+
+/**
+ * \brief Заполнить структуру `out` из узла `node` документа
+ * \param ew указатель на объект состояния ошибки, для nullptr
+ *   ошибка логируется
+ * \note Пути в сообщениях об ошибках - без узла `node`
+ * */
+template <class NodeT, BoundType T>
+merror_t BindNode(lib_node<NodeT> node, T* out, ErrorWrap* ew = nullptr) {
+  ErrorWrap error;
+  ErrorWrap* e = ew ? ew : &error;
+  if (!out || !node.GetNodePointer()) {
+    e->SetError(ERROR_INIT_NULLP_ST, "binding: null node or structure");
+  } else {
+    struct_binder<NodeT>(e).Bind(node, out, nullptr);
+  }
+  if (!ew && error.GetErrorCode())
+    error.LogIt();
+  return e->GetErrorCode();
+}
+
+/**
+ * \brief Разобрать документ в буффере `memory` и заполнить
+ *   структуру `out` из его корня, см. BindString, BindFile
+ * \note Документ разбирается парсером библиотеки NodeT и живёт
+ *   только до конца привязки
+ * */
+template <class NodeT, BoundType T>
+merror_t BindBuffer(file_utils::FileBuffer& memory,
+                    T* out,
+                    const reader_options& options = reader_options(),
+                    ErrorWrap* ew = nullptr) {
+  ErrorWrap error;
+  ErrorWrap* e = ew ? ew : &error;
+  if (memory.IsEmpty()) {
+    e->SetError(ERROR_PARSER_PARSE_ST, "binding: empty document");
+  } else {
+    typename lib_node<NodeT>::NodeDocType document;
+    std::string root_name;
+    auto r = lib_node<NodeT>::InitDocumentRoot(&document, memory.GetData(),
+                                               memory.GetSize(), &root_name,
+                                               e, options);
+    if (!e->GetErrorCode())
+      BindNode(lib_node<NodeT>(r), out, e);
+  }
+  if (!ew && error.GetErrorCode())
+    error.LogIt();
+  return e->GetErrorCode();
+}
+
+/** \brief Заполнить структуру `out` из документа-строки `data` */
+template <class NodeT, BoundType T>
+merror_t BindString(std::string_view data,
+                    T* out,
+                    const reader_options& options = reader_options(),
+                    ErrorWrap* ew = nullptr) {
+  file_utils::FileBuffer memory;
+  memory.Assign(data.data(), data.size());
+  return BindBuffer<NodeT>(memory, out, options, ew);
+}
+
+/** \brief Заполнить структуру `out` из файла `source` */
+template <class NodeT, BoundType T, class PathT>
+merror_t BindFile(file_utils::FileURLSample<PathT>* source,
+                  T* out,
+                  const reader_options& options = reader_options(),
+                  ErrorWrap* ew = nullptr) {
+  ErrorWrap error;
+  ErrorWrap* e = ew ? ew : &error;
+  file_utils::FileBuffer memory;
+  if (!source) {
+    e->SetError(ERROR_INIT_NULLP_ST, "binding: null source file");
+  } else if (!memory.Load(source->GetURL(), options.buffer_mode, *e)) {
+    BindBuffer<NodeT>(memory, out, options, e);
+  }
+  if (!ew && error.GetErrorCode())
+    error.LogIt();
+  return e->GetErrorCode();
+}
+}  // namespace asp_utils
+
+#endif  // !UTILS__BINDING_H
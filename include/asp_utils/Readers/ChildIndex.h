@@ -0,0 +1,102 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__CHILDINDEX_H
+#define UTILS__CHILDINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * \brief Количество дочерних элементов узла, начиная с которого
+ *   для поиска по имени строится индекс
+ * */
+#define CHILDS_INDEX_THRESHOLD 16
+
+namespace asp_utils {
+/**
+ * \brief Хэш имени узла(FNV-1a, 64 бита)
+ * */
+constexpr uint64_t name_hash(std::string_view name) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : name) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+/**
+ * \brief Индекс поиска дочерних элементов по имени - отсортированный
+ *   по хэшам имён массив позиций элементов
+ *
+ * Строится один раз после инициализации дочерних элементов,
+ *   поиск - двоичный по хэшу, без выделения памяти.
+ * */
+class childs_index {
+ public:
+  /** \brief позиция дочернего элемента */
+  typedef uint32_t position_t;
+  /** \brief позиция отсутствующего элемента */
+  static constexpr position_t npos = static_cast<position_t>(-1);
+
+ public:
+  /** \brief Построить индекс для `count` элементов,
+   *   `name_of(i)` - имя i-го элемента */
+  template <class NameF>
+  void Build(size_t count, NameF&& name_of) {
+    BuildHashes(count, [&name_of](size_t i) { return name_hash(name_of(i)); });
+  }
+  /** \brief Построить индекс по посчитанным хэшам имён,
+   *   `hash_of(i)` - хэш имени i-го элемента */
+  template <class HashF>
+  void BuildHashes(size_t count, HashF&& hash_of) {
+    entries_.clear();
+    entries_.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+      entries_.push_back(entry{hash_of(i), static_cast<position_t>(i)});
+    std::sort(entries_.begin(), entries_.end(),
+              [](const entry& l, const entry& r) {
+                return (l.hash < r.hash) ||
+                       (l.hash == r.hash && l.position < r.position);
+              });
+  }
+  /** \brief Индекс построен */
+  bool IsBuilt() const { return !entries_.empty(); }
+  /** \brief Найти позицию элемента с именем `name`,
+   *   `match(i)` - проверка совпадения имени i-го элемента
+   * \return Позиция первого подходящего элемента или npos */
+  template <class MatchF>
+  position_t Find(std::string_view name, MatchF&& match) const {
+    return FindHash(name_hash(name), match);
+  }
+  /** \brief Найти позицию элемента по посчитанному хэшу имени */
+  template <class MatchF>
+  position_t FindHash(uint64_t hash, MatchF&& match) const {
+    auto it = std::lower_bound(
+        entries_.begin(), entries_.end(), hash,
+        [](const entry& e, uint64_t h) { return e.hash < h; });
+    for (; it != entries_.end() && it->hash == hash; ++it) {
+      if (match(it->position))
+        return it->position;
+    }
+    return npos;
+  }
+
+ private:
+  struct entry {
+    uint64_t hash;
+    position_t position;
+  };
+  std::vector<entry> entries_;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__CHILDINDEX_H
@@ -0,0 +1,306 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * DocumentCache *
+ *   Общий кэш разобранных документов: повторные обращения к файлу
+ * возвращают уже разобранный документ, пока файл не изменился
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__DOCUMENTCACHE_H
+#define UTILS__DOCUMENTCACHE_H
+
+#include "asp_utils/FileURL.h"
+#include "asp_utils/Readers/Reader.h"
+#include "asp_utils/Readers/Snapshot.h"
+
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * \brief Объём документов в кэше по умолчанию
+ * */
+#define DOCUMENT_CACHE_MAX_BYTES (256 * 1024 * 1024)  // 256 MiB
+
+namespace asp_utils {
+/**
+ * \brief Настройки кэша документов
+ * */
+struct document_cache_options {
+  /**
+   * \brief Суммарный размер файлов документов в кэше, при превышении
+   *   вытесняются давно не использованные документы
+   * \note Объём разобранного документа оценивается размером файла:
+   *   буффер файла ридер держит в памяти, DOM библиотек json/xml
+   *   пропорционален ему
+   * */
+  size_t max_bytes = DOCUMENT_CACHE_MAX_BYTES;
+  /**
+   * \brief Сверять с файлом кроме размера и времени изменения
+   *   хэш содержимого(см. content_hash). Файл при каждом обращении
+   *   читается целиком, но не разбирается
+   * */
+  bool verify_content = false;
+};
+
+/**
+ * \brief Счётчики кэша документов
+ * */
+struct document_cache_stats {
+  /** \brief документ взят из кэша или дождался разбора в другом потоке */
+  size_t hits = 0;
+  /** \brief документ разобран */
+  size_t misses = 0;
+  /** \brief документ в кэше устарел - файл изменился */
+  size_t invalidations = 0;
+  /** \brief документ вытеснен по объёму */
+  size_t evictions = 0;
+  /** \brief документов в кэше */
+  size_t documents = 0;
+  /** \brief суммарный размер файлов документов в кэше */
+  size_t bytes = 0;
+};
+
+/**
+ * \brief Потокобезопасный кэш документов, разобранных ридером
+ *   ReaderSample, по полному пути файла
+ *
+ * Документ в кэше проверяется при каждом обращении по размеру,
+ *   времени изменения и, для `document_cache_options::verify_content`,
+ *   хэшу содержимого файла. Документы отдаются общими неизменяемыми
+ *   указателями: вытесненный или устаревший документ живёт, пока
+ *   его используют. Одновременные обращения к ещё не разобранному
+ *   файлу ждут одного разбора.
+ *
+ * Один кэш рассчитан на весь процесс: все документы разбираются
+ *   одной фабрикой с одними настройками ридера.
+ * \note Константные методы ридера(GetValueByPath, GetNodeByPath)
+ *   можно вызывать из нескольких потоков: дочерние элементы
+ *   ленивого дерева инициализируются однократно(call_once)
+ * */
+template <class NodeT,
+          class Initializer,
+          class InitializerFactory = SimpleInitializerFactory<Initializer>,
+          class PathT = fs::path,
+          class = typename std::enable_if<
+              NodeInitializerType<Initializer>>::type>
+class DocumentCacheSample {
+ public:
+  typedef ReaderSample<NodeT, Initializer, InitializerFactory, PathT> Reader;
+  typedef std::shared_ptr<const Reader> document_ptr;
+
+ public:
+  explicit DocumentCacheSample(
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options(),
+      const document_cache_options& cache_options = document_cache_options())
+      : factory_(factory), options_(options), cache_options_(cache_options) {}
+
+  /**
+   * \brief Получить документ файла `source`: из кэша, если файл
+   *   не изменился, иначе прочитать и разобрать его
+   * \param error out-параметр, код ошибки чтения или разбора
+   * \return Документ или nullptr при ошибке. Ошибочные
+   *   документы не кэшируются
+   * \throw Исключение фабрики или инициализатора при разборе
+   *   получают и потоки, ждущие этого разбора. Запись файла
+   *   удаляется, следующее обращение разбирает его заново
+   * */
+  document_ptr Get(const file_utils::FileURLSample<PathT>& source,
+                   merror_t* error = nullptr) {
+    key_type key = cacheKey(source);
+    snapshot_source current;
+    merror_t status =
+        GetSnapshotSource(source.GetURL(), &current,
+                          cache_options_.verify_content);
+    if (status) {
+      if (error)
+        *error = status;
+      return nullptr;
+    }
+    std::promise<load_result> promise;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        entry& e = it->second;
+        if (!e.ready) {
+          // документ разбирается в другом потоке
+          auto loading = e.result;
+          ++stats_.hits;
+          lock.unlock();
+          const load_result& r = loading.get();
+          if (error)
+            *error = r.error;
+          return r.document;
+        }
+        if (isSame(e.source, current)) {
+          ++stats_.hits;
+          lru_.splice(lru_.begin(), lru_, e.lru);
+          if (error)
+            *error = ERROR_SUCCESS_T;
+          return e.document;
+        }
+        ++stats_.invalidations;
+        erase(it);
+      }
+      ++stats_.misses;
+      entry& e = entries_[key];
+      e.source = current;
+      e.result = promise.get_future().share();
+    }
+    load_result r;
+    try {
+      r = load(source);
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.erase(key);
+      }
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+    promise.set_value(r);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(key);
+      if (r.error) {
+        entries_.erase(it);
+      } else {
+        entry& e = it->second;
+        e.ready = true;
+        e.document = r.document;
+        e.bytes = static_cast<size_t>(current.size);
+        e.lru = lru_.insert(lru_.begin(), key);
+        stats_.bytes += e.bytes;
+        ++stats_.documents;
+        evict();
+      }
+    }
+    if (error)
+      *error = r.error;
+    return r.document;
+  }
+  /**
+   * \brief Удалить документ файла `source` из кэша
+   * */
+  void Invalidate(const file_utils::FileURLSample<PathT>& source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(cacheKey(source));
+    if (it != entries_.end() && it->second.ready)
+      erase(it);
+  }
+  /**
+   * \brief Удалить из кэша все разобранные документы
+   * */
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      auto next = std::next(it);
+      if (it->second.ready)
+        erase(it);
+      it = next;
+    }
+  }
+  /**
+   * \brief Счётчики кэша
+   * */
+  document_cache_stats GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  typedef fs::path::string_type key_type;
+  /** \brief Результат разбора документа */
+  struct load_result {
+    document_ptr document;
+    merror_t error = ERROR_SUCCESS_T;
+  };
+  /** \brief Документ вместе с адресом файла, на который
+   *   ссылается ридер */
+  struct cached_document {
+    explicit cached_document(const file_utils::FileURLSample<PathT>& url)
+        : source(url) {}
+
+    file_utils::FileURLSample<PathT> source;
+    std::unique_ptr<Reader> reader;
+  };
+  /** \brief Запись кэша */
+  struct entry {
+    /** \brief документ разобран, иначе разбирается */
+    bool ready = false;
+    /** \brief описание файла на момент разбора */
+    snapshot_source source;
+    document_ptr document;
+    /** \brief результат разбора для ожидающих потоков */
+    std::shared_future<load_result> result;
+    size_t bytes = 0;
+    typename std::list<key_type>::iterator lru;
+  };
+  typedef typename std::unordered_map<key_type, entry>::iterator entry_it;
+
+  /** \brief Ключ кэша - полный нормализованный путь файла */
+  static key_type cacheKey(const file_utils::FileURLSample<PathT>& source) {
+    std::error_code ec;
+    fs::path path = fs::weakly_canonical(fs::path(source.GetURL()), ec);
+    if (ec)
+      path = fs::absolute(fs::path(source.GetURL()), ec).lexically_normal();
+    return path.native();
+  }
+  bool isSame(const snapshot_source& a, const snapshot_source& b) const {
+    return a.size == b.size && a.mtime == b.mtime &&
+           (!cache_options_.verify_content || a.hash == b.hash);
+  }
+  /** \brief Прочитать и разобрать файл, без блокировки кэша */
+  load_result load(const file_utils::FileURLSample<PathT>& source) {
+    load_result r;
+    auto doc = std::make_shared<cached_document>(source);
+    doc->reader = std::unique_ptr<Reader>(
+        Reader::Init(&doc->source, factory_, options_));
+    if (!doc->reader) {
+      r.error = ERROR_FILE_EXISTS_ST;
+      return r;
+    }
+    r.error = doc->reader->InitData();
+    if (!r.error)
+      r.document = document_ptr(doc, doc->reader.get());
+    return r;
+  }
+  /** \brief Вытеснить давно не использованные документы, последний
+   *   использованный остаётся в кэше даже сверх объёма */
+  void evict() {
+    while (stats_.bytes > cache_options_.max_bytes && lru_.size() > 1) {
+      erase(entries_.find(lru_.back()));
+      ++stats_.evictions;
+    }
+  }
+  /** \brief Удалить разобранный документ из кэша */
+  void erase(entry_it it) {
+    stats_.bytes -= it->second.bytes;
+    --stats_.documents;
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+
+ private:
+  InitializerFactory* factory_ = nullptr;
+  reader_options options_;
+  document_cache_options cache_options_;
+  mutable std::mutex mutex_;
+  std::unordered_map<key_type, entry> entries_;
+  /** \brief ключи разобранных документов, последний
+   *   использованный - первый */
+  std::list<key_type> lru_;
+  document_cache_stats stats_;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__DOCUMENTCACHE_H
@@ -10,8 +10,12 @@
 #ifndef UTILS__INODE_H
 #define UTILS__INODE_H
 
+#include "asp_utils/Arena.h"
 #include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
 
+#include <concepts>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,8 +24,73 @@ template <class Initializer>
 class SimpleInitializerFactory {
  public:
   Initializer* GetNodeInitializer() { return new Initializer(); }
+  /** \brief Перегрузка для вызова из шаблонов ридеров:
+   *   `factory->template GetNodeInitializer<NodeT>()` */
+  template <class NodeT>
+  Initializer* GetNodeInitializer() {
+    return new Initializer();
+  }
+  /** \brief Фабрика для рабочего потока `worker` параллельной
+   *   инициализации. Фабрика без состояния - можно использовать
+   *   её же из всех потоков */
+  SimpleInitializerFactory* GetThreadFactory(size_t /* worker */) {
+    return this;
+  }
 };
 
+/** \brief Фабрика, предоставляющая отдельные фабрики(или себя, если
+ *   она потокобезопасна) рабочим потокам параллельной инициализации
+ *   дерева, см. reader_options::parallel_init. Вызовы фабрик без
+ *   GetThreadFactory из рабочих потоков, а при
+ *   reader_options::lazy_init все вызовы, сериализуются мьютексом */
+template <class Factory>
+concept ThreadFactoryType = requires(Factory* f, size_t worker) {
+  { f->GetThreadFactory(worker) } -> std::convertible_to<Factory*>;
+};
+
+/** \brief Фабрика, создающая инициализаторы в арене ридера:
+  *   `arena->Create<T>()`, где T - Initializer или его наследник.
+  *   Ридер держит по арене на поток инициализации и освобождает их
+  *   целиком вместе с деревом, без delete на каждый узел
+  * \note Фабрике нужен и GetNodeInitializer без арены - для узлов
+  *   без общего контекста ридера и потоковых ридеров */
+template <class Factory, class Initializer, class NodeT>
+concept ArenaFactoryType = requires(Factory* f, Arena* arena) {
+  {
+    f->template GetNodeInitializer<NodeT>(arena)
+  } -> std::convertible_to<Initializer*>;
+};
+
+/** \brief Фабрика инициализаторов в арене ридера, см. ArenaFactoryType */
+template <class Initializer>
+class ArenaInitializerFactory : public SimpleInitializerFactory<Initializer> {
+ public:
+  using SimpleInitializerFactory<Initializer>::GetNodeInitializer;
+  template <class NodeT>
+  Initializer* GetNodeInitializer(Arena* arena) {
+    return arena->template Create<Initializer>();
+  }
+  ArenaInitializerFactory* GetThreadFactory(size_t /* worker */) {
+    return this;
+  }
+};
+
+/** \brief Удаление инициализатора узла: созданный в арене
+  *   (`owned == false`) не удаляется, его освобождает арена */
+template <class Initializer>
+struct initializer_deleter {
+  bool owned = true;
+
+  void operator()(Initializer* data) const {
+    if (owned)
+      delete data;
+  }
+};
+/** \brief Указатель на инициализатор узла дерева ридера */
+template <class Initializer>
+using initializer_ptr =
+    std::unique_ptr<Initializer, initializer_deleter<Initializer>>;
+
 // typedef int32_t node_id;
 /** \brief вектор имён дочерних элементов */
 typedef std::vector<std::string> inodes_vec;
@@ -30,7 +99,10 @@ typedef std::vector<std::string> inodes_vec;
 /** \brief Интерфейс узла для составления параметров шаблона
   *   классов JSONReader и XMLReader
   * \note По идее обвязка над структурой(ами) которые нужно
-  *   инициализировать парсером  */
+  *   инициализировать парсером
+  * \note Шаблоны ридеров вызывают методы через тип наследника,
+  *   для `final` наследника компилятор убирает виртуальные вызовы.
+  *   Инициализатор без виртуальных функций - см. NodeInitializer */
 class INodeInitializer {
 public:
   INodeInitializer() = default;
@@ -38,7 +110,7 @@ public:
 
   // node_id GetId() const { return id_; }
   /* maybe virtual... ??? */
-  std::string GetName() const { return name_; }
+  const std::string& GetName() const { return name_; }
   mstatus_t GetStatus() const { return status_; }
 
   /** \brief Узел является простым - не содержит подузлов
@@ -46,6 +118,16 @@ public:
   virtual bool IsLeafNode() const { return subnodes_.empty(); }
   /** \brief Получить параметр по имени */
   virtual std::string GetParameter(const std::string &name) = 0;
+  /** \brief Получить параметр по имени как значение типа T(число,
+    *   bool, перечисление), без учёта локали, см. str_to_value
+    * \note Разбирает строку GetParameter, без копирования - см.
+    *   node_sample::GetParameterAs */
+  template <class T>
+  merror_t GetParameterAs(const std::string &name, T *out) {
+    return str_to_value(trim_view(GetParameter(name)), out)
+               ? ERROR_SUCCESS_T
+               : ERROR_STR_PARSE_ST;
+  }
   /** \brief Записать имена узлов, являющихся
     *   контейнерами других объектов */
   virtual void SetSubnodesNames(inodes_vec *subnodes) = 0;
@@ -63,6 +145,67 @@ protected:
     * \note по ним из класса парсера их можно инициализировать */
   inodes_vec subnodes_;
 };
+
+/** \brief Базовый класс инициализатора узла без виртуальных функций
+  *
+  * Альтернатива INodeInitializer: шаблоны ридеров знают тип
+  *   инициализатора `Derived` и вызывают его методы напрямую,
+  *   их можно встраивать. Наследник определяет InitData
+  *   и GetParameter, и может скрыть методы по умолчанию
+  *   своими(IsLeafNode, SetSubnodesNames, SetParentData)
+  * \note Удаляется только как `Derived` */
+template <class Derived>
+class NodeInitializer {
+public:
+  const std::string& GetName() const { return name_; }
+  mstatus_t GetStatus() const { return status_; }
+
+  /** \brief Узел является простым - не содержит подузлов
+    *   и вложенных параметров */
+  bool IsLeafNode() const { return subnodes_.empty(); }
+  /** \brief см. INodeInitializer::GetParameterAs */
+  template <class T>
+  merror_t GetParameterAs(const std::string &name, T *out) {
+    return str_to_value(trim_view(derived().GetParameter(name)), out)
+               ? ERROR_SUCCESS_T
+               : ERROR_STR_PARSE_ST;
+  }
+  /** \brief Записать имена узлов, являющихся
+    *   контейнерами других объектов */
+  void SetSubnodesNames(inodes_vec *subnodes) { *subnodes = subnodes_; }
+  /** \brief Инициализировать данные родительского узла */
+  void SetParentData(Derived&) {}
+
+protected:
+  NodeInitializer() = default;
+  ~NodeInitializer() = default;
+
+  Derived &derived() { return static_cast<Derived &>(*this); }
+
+protected:
+  mstatus_t status_{STATUS_DEFAULT};
+  /** \brief собственное имя ноды */
+  std::string name_{""};
+  /** \brief вектор имён поднод(подузлов) */
+  inodes_vec subnodes_;
+};
+
+/** \brief Контракт инициализатора узла шаблонов ридеров: наследник
+  *   INodeInitializer или NodeInitializer, либо любой класс с такими
+  *   методами. Кроме них нужен `merror_t InitData(NodeT*, name)`
+  *   для типа узла NodeT ридера. GetName может возвращать имя
+  *   по значению: шаблоны ридеров не хранят его представлений,
+  *   индексы дочерних элементов строятся по хэшам и таблице имён */
+template <class Initializer>
+concept NodeInitializerType =
+    requires(Initializer &i, const Initializer &ci, const std::string &name,
+             inodes_vec *subnodes) {
+  { ci.GetName() } -> std::convertible_to<std::string_view>;
+  { ci.IsLeafNode() } -> std::convertible_to<bool>;
+  { i.GetParameter(name) } -> std::convertible_to<std::string>;
+  i.SetSubnodesNames(subnodes);
+  i.SetParentData(i);
+};
 }  // namespace asp_utils
 
 #endif  // !UTILS__INODE_H
@@ -13,9 +13,13 @@
 #include "asp_utils/Base.h"
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
+#include "asp_utils/FileBuffer.h"
 #include "asp_utils/FileURL.h"
 #include "asp_utils/Logging.h"
+#include "asp_utils/Readers/ChildIndex.h"
 #include "asp_utils/Readers/INode.h"
+#include "asp_utils/Readers/ReaderOptions.h"
+#include "asp_utils/Readers/TreeTraversal.h"
 
 #include "rapidjson/document.h"
 #include "rapidjson/error/en.h"
@@ -23,6 +27,7 @@
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <string_view>
 #include <vector>
 
 /* json errors */
@@ -52,7 +57,7 @@ namespace asp_utils {
 template <class Initializer,
           class InitializerFactory,
           class = typename std::enable_if<
-              std::is_base_of<INodeInitializer, Initializer>::value>::type>
+              NodeInitializerType<Initializer>>::type>
 class json_node_sample {
   typedef json_node_sample<Initializer, InitializerFactory> json_node;
   /** \brief умный указатель на имплементацию json_node */
@@ -60,6 +65,10 @@ class json_node_sample {
   /** \brief вектор указателей на дочерние элементы */
   typedef std::vector<json_node_ptr> childs_vec;
 
+ public:
+  /** \brief константный итератор дочерних элементов */
+  typedef childs_const_iterator<json_node> const_iterator;
+
  public:
   /** \brief Добавить ноду к списку инициализированных(если можно)
    *   вытащив её параметры, в зависимости от типа ноды засунуть их
@@ -73,7 +82,7 @@ class json_node_sample {
   json_node_sample(rjNValue* src,
                    InitializerFactory* factory,
                    const std::string& name)
-      : value_(src), factory(factory), name_(name) {
+      : value_(src), name_(name), factory(factory) {
     if (factory) {
       // See C++'03 Standard 14.2/4 or StackOverflow for more
       //   information about `factory->template GetNodeInitializer<rjNValue>`
@@ -89,21 +98,38 @@ class json_node_sample {
     // инициализировать шаблон-параметр node_data_ptr и
     //   дочерние элементы(в глубину обойти)
     initData();
-    child_it = childs.begin();
+    child_pos = 0;
   }
 
-  /** \brief Проверить наличие дочерних элементов ноды */
+  /** \brief Следующий дочерний элемент ноды, nullptr после последнего
+   * \deprecated Позиция обхода хранится в узле: обход изменяет узел
+   *   и не потокобезопасен. Используйте константные begin()/end()
+   *   или DepthFirst/BreadthFirst */
   json_node* NextChild() {
-    return (child_it != childs.end()) ? child_it++->get() : nullptr;
+    return (child_pos < childs.size()) ? childs[child_pos++].get() : nullptr;
   }
-  /** \brief Поиск по дочерним элементам */
+  /** \brief Константный обход дочерних элементов:
+   *   `for (const auto& ch : node)`, см. также DepthFirst */
+  const_iterator begin() const { return const_iterator(childs.cbegin()); }
+  const_iterator end() const { return const_iterator(childs.cend()); }
+  /** \brief Поиск по дочерним элементам
+   * \note Если дочерних элементов не меньше CHILDS_INDEX_THRESHOLD,
+   *   поиск идёт по индексу хэшей имён */
   json_node* ChildByName(const std::string& name) const {
     json_node* child = nullptr;
     if (!node_data_ptr->IsLeafNode()) {
-      for (const json_node_ptr& ch : childs) {
-        if (ch->node_data_ptr->GetName() == name) {
-          child = ch.get();
-          break;
+      if (childs_idx_.IsBuilt()) {
+        auto pos = childs_idx_.Find(name, [this, &name](size_t i) {
+          return childs[i]->node_data_ptr->GetName() == name;
+        });
+        if (pos != childs_index::npos)
+          child = childs[pos].get();
+      } else {
+        for (const json_node_ptr& ch : childs) {
+          if (ch->node_data_ptr->GetName() == name) {
+            child = ch.get();
+            break;
+          }
         }
       }
     }
@@ -114,6 +140,20 @@ class json_node_sample {
   std::string GetParameter(const std::string& name) {
     return node_data_ptr->GetParameter(name);
   }
+  /** \brief Получить значение строкового параметра без копирования
+   * \note Для `reader_options::parse_insitu` указывает в буффер
+   *   ридера и валидно пока жив ридер */
+  std::string_view GetParameterView(const std::string& name) const {
+    if (value_) {
+      auto ch = value_->FindMember(name.c_str());
+      if (ch != value_->MemberEnd() && ch->value.IsString())
+        return std::string_view(ch->value.GetString(),
+                                ch->value.GetStringLength());
+    }
+    return {};
+  }
+  /** \brief Получить имя узла */
+  std::string_view GetNameView() const { return name_; }
   /** \brief Получить json исходник */
   rjNValue* GetSource() const { return value_; }
   /** \brief Получить код ошибки */
@@ -156,6 +196,7 @@ class json_node_sample {
       }
     }
     setParentData();
+    buildChildsIndex();
   }
   /** \brief Инициализировать иерархичные данные
    * \note тут такое, я пока неопределился id ноды тащить
@@ -166,6 +207,15 @@ class json_node_sample {
     for (auto& x : childs)
       x->node_data_ptr->SetParentData(*node_data_ptr);
   }
+  /** \brief Построить индекс поиска дочерних элементов по имени,
+   *   для узлов с большим количеством дочерних элементов */
+  void buildChildsIndex() {
+    if (childs.size() >= CHILDS_INDEX_THRESHOLD) {
+      childs_idx_.BuildHashes(childs.size(), [this](size_t i) {
+        return name_hash(childs[i]->node_data_ptr->GetName());
+      });
+    }
+  }
 
  private:
   ErrorWrap error_;
@@ -173,14 +223,16 @@ class json_node_sample {
   rjNValue* value_;
   /** \brief имя ноды */
   std::string name_;
+  /** \brief индекс поиска дочерних элементов по имени */
+  childs_index childs_idx_;
 
  public:
   /** \brief ссылка на родительский элемент(unused) */
   // json_node *parent;
   /** \brief дочерние элементы */
   childs_vec childs;
-  /** \brief итератор на обход дочерних элементов */
-  typename childs_vec::iterator child_it;
+  /** \brief позиция обхода NextChild */
+  size_t child_pos = 0;
   // такс, все необходимые для JSONReader операции
   //   реализуем здесь
   /** \brief инициализируемая структура */
@@ -198,7 +250,7 @@ template <class Initializer,
           class InitializerFactory = SimpleInitializerFactory<Initializer>,
           class PathT = fs::path,
           class = typename std::enable_if<
-              std::is_base_of<INodeInitializer, Initializer>::value>::type>
+              NodeInitializerType<Initializer>>::type>
 class JSONReaderSample : public BaseObject {
   typedef JSONReaderSample<Initializer, InitializerFactory, PathT> JSONReader;
   typedef json_node_sample<Initializer, InitializerFactory> json_node;
@@ -209,11 +261,12 @@ class JSONReaderSample : public BaseObject {
 
   static JSONReaderSample<Initializer, InitializerFactory>* Init(
       file_utils::FileURLSample<PathT>* source,
-      InitializerFactory* factory = nullptr) {
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
     JSONReader* reader = nullptr;
     if (source) {
       if (is_exists(source->GetURL())) {
-        reader = new JSONReader(source, factory);
+        reader = new JSONReader(source, factory, options);
       } else {
         source->SetError(ERROR_FILE_EXISTS_ST,
                          "File '" + source->GetURLStr() + "' doesn't exists");
@@ -229,10 +282,11 @@ class JSONReaderSample : public BaseObject {
 
   static JSONReaderSample<Initializer, InitializerFactory>* Init(
       const char* data,
-      InitializerFactory* factory = nullptr) {
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
     JSONReader* reader = nullptr;
     if (data) {
-      reader = new JSONReader(data, factory);
+      reader = new JSONReader(data, factory, options);
     } else {
       Logging::Append(ERROR_INIT_NULLP_ST,
                       "Get 'data'=nullptr into "
@@ -241,25 +295,26 @@ class JSONReaderSample : public BaseObject {
     return reader;
   }
 
-  ~JSONReaderSample() {
-    if (memory_)
-      delete[] memory_;
-  }
-
   static std::string GetFilenameExtension() { return ".json"; }
   /** \brief Инициализировать данные */
   merror_t InitData() {
-    if (!error_.GetErrorCode()) {
-      // распарсить json файл
-      document_.Parse(memory_);
+    if (!error_.GetErrorCode() && !memory_.IsEmpty()) {
+      // распарсить json файл, на месте строки не копируются
+      //   в аллокатор документа
+      if (options_.parse_insitu) {
+        document_.ParseInsitu(memory_.GetData());
+      } else {
+        document_.Parse(memory_.GetData(), memory_.GetSize());
+      }
       if (document_.HasParseError()) {
         error_.SetError(
             ERROR_JSON_FORMAT_ST,
             std::string("RapidJSON parse error: ") +
                 std::string(rj::GetParseError_En(document_.GetParseError())));
       } else {
-        // проверить рут
-        if (document_.IsObject()) {
+        // проверить рут: первый член объекта документа
+        if (document_.IsObject() &&
+            document_.MemberBegin() != document_.MemberEnd()) {
           auto root = document_.MemberBegin();
           root_node_ = std::unique_ptr<json_node>(
               new json_node(&root->value, factory_, root->name.GetString()));
@@ -269,7 +324,7 @@ class JSONReaderSample : public BaseObject {
           error_.SetError(ERROR_JSON_PARSE_ST,
                           "ошибка инициализации "
                           "корневого элемента json файла " +
-                              source_->GetURLStr());
+                              GetFileName());
         }
       }
     }
@@ -324,6 +379,10 @@ class JSONReaderSample : public BaseObject {
     return tmp_node->node_data_ptr.get();
   }
 
+  /** \brief Корень дерева для константного обхода, см. DepthFirst
+   * \return nullptr если дерево не инициализировано */
+  const json_node* GetRootNode() const { return root_node_.get(); }
+
   std::string GetFileName() { return (source_) ? source_->GetURLStr() : ""; }
 
   merror_t GetErrorCode() const { return error_.GetErrorCode(); }
@@ -334,52 +393,36 @@ class JSONReaderSample : public BaseObject {
 
  private:
   JSONReaderSample(file_utils::FileURLSample<PathT>* source,
-                   InitializerFactory* factory)
+                   InitializerFactory* factory,
+                   const reader_options& options)
       : BaseObject(STATUS_DEFAULT),
         source_(source),
-        factory_(factory) {
+        factory_(factory),
+        options_(options) {
     init_memory();
   }
-  JSONReaderSample(const char* data, InitializerFactory* factory)
+  JSONReaderSample(const char* data,
+                   InitializerFactory* factory,
+                   const reader_options& options)
       : BaseObject(STATUS_DEFAULT),
         source_(nullptr),
-        factory_(factory) {
+        factory_(factory),
+        options_(options) {
     init_memory(data);
   }
-  /** \brief обход дерева json объектов,
-   * \note вынесено в отдельный метод потому-что можно
-   *   держать лополнительное состояние, например,
-   *   глубину обхода(см питоновский скрипт в asp_therm) */
-  void tree_traversal(
-      json_node_sample<Initializer, InitializerFactory>* jnode) {
-    json_node_sample<Initializer, InitializerFactory>* child;
-    // rjNValue *child_src;
-    // обход дочерних элементов
-    while ((child = jnode->NextChild()) != nullptr) {
-      tree_traversal(child);
-    }
-  }
-  /** \brief считать файл в память */
+  /** \brief считать файл в память или отобразить его в память,
+   *   в зависимости от `reader_options::buffer_mode` */
   void init_memory() {
-    const auto content = read_file(source_->GetURL(), error_);
-    init_memory(content.str().c_str());
+    memory_.Load(source_->GetURL(), options_.buffer_mode, error_);
   }
   /** \brief скопировать данные в память класса */
-  void init_memory(const char* data) {
-    len_memory_ = strlen(data);
-    if (len_memory_ > 0) {
-      memory_ = new char[len_memory_];
-      strncpy(memory_, data, len_memory_);
-    }
-  }
+  void init_memory(const char* data) { memory_.Assign(data, strlen(data)); }
 
  private:
   /** \brief адрес файла */
   file_utils::FileURLSample<PathT>* source_ = nullptr;
   /** \brief буффер памяти файла */
-  char* memory_ = nullptr;
-  /** \brief величина буффер памяти файла */
-  size_t len_memory_ = 0;
+  file_utils::FileBuffer memory_;
   /** \brief основной json объект */
   rjNDocument document_;
   /** \brief корень json дерева
@@ -387,6 +430,8 @@ class JSONReaderSample : public BaseObject {
   std::unique_ptr<json_node_sample<Initializer, InitializerFactory>> root_node_;
   /** \brief фабрика создания нод json дерева */
   InitializerFactory* factory_;
+  /** \brief настройки ридера */
+  reader_options options_;
 };
 }  // namespace asp_utils
 
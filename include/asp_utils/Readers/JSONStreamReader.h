@@ -0,0 +1,642 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * JSONStreamReader *
+ *   Потоковый(SAX) ридер json файлов - документ не загружается
+ * в память целиком, DOM не строится
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__JSONSTREAMREADER_H
+#define UTILS__JSONSTREAMREADER_H
+
+#include "asp_utils/ChunkQueue.h"
+#include "asp_utils/Readers/JSONReader.h"
+
+#include "rapidjson/filereadstream.h"
+#include "rapidjson/reader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Размер блока аллокатора параметров одного уровня
+ * */
+#define STREAM_LEVEL_CHUNK 1024
+
+namespace asp_utils {
+/**
+ * \brief Входной поток RapidJSON, читающий данные блоками
+ *   функцией `read`(аналог rj::FileReadStream)
+ * */
+class json_read_stream {
+ public:
+  typedef char Ch;
+  /**
+   * \brief Функция чтения: записать в буффер не более `size` байт
+   *   и вернуть их количество, 0 - данных больше нет
+   * */
+  typedef std::function<size_t(char* buffer, size_t size)> read_function;
+
+ public:
+  json_read_stream(read_function read, size_t buffer_size)
+      : read_(std::move(read)), buffer_(std::max<size_t>(buffer_size, 4)) {
+    current_ = last_ = buffer_.data();
+    fill();
+  }
+
+  Ch Peek() const { return *current_; }
+  Ch Take() {
+    Ch c = *current_;
+    next();
+    return c;
+  }
+  size_t Tell() const { return count_ + (current_ - buffer_.data()); }
+  /* поток только для чтения */
+  Ch* PutBegin() {
+    RAPIDJSON_ASSERT(false);
+    return 0;
+  }
+  void Put(Ch) { RAPIDJSON_ASSERT(false); }
+  void Flush() { RAPIDJSON_ASSERT(false); }
+  size_t PutEnd(Ch*) {
+    RAPIDJSON_ASSERT(false);
+    return 0;
+  }
+
+ private:
+  void next() {
+    if (current_ < last_)
+      ++current_;
+    else if (!eof_)
+      fill();
+  }
+  void fill() {
+    count_ += read_count_;
+    read_count_ = read_(buffer_.data(), buffer_.size());
+    current_ = buffer_.data();
+    if (read_count_ == 0) {
+      // конец данных, Peek возвращает '\0'
+      buffer_[0] = '\0';
+      last_ = current_;
+      eof_ = true;
+    } else {
+      last_ = current_ + read_count_ - 1;
+    }
+  }
+
+ private:
+  read_function read_;
+  std::vector<char> buffer_;
+  Ch* current_ = nullptr;
+  /** \brief последний прочитанный символ буффера */
+  Ch* last_ = nullptr;
+  size_t read_count_ = 0;
+  /** \brief количество байт в предыдущих блоках */
+  size_t count_ = 0;
+  bool eof_ = false;
+};
+
+/**
+ * \brief Потоковый ридер json файлов
+ *
+ * Файл читается блоками `reader_options::stream_buffer_size`
+ *   SAX парсером RapidJSON(итеративный разбор, без рекурсии).
+ *   В памяти хранится только стек узлов текущего пути: для каждого
+ *   узла - инициализатор и объект rjNValue со скалярными параметрами
+ *   узла(строки, числа, массивы скаляров).
+ *
+ * Протокол Initializer тот же, что и у JSONReaderSample:
+ *   InitData вызывается для узла с объектом его скалярных параметров,
+ *   после неё SetSubnodesNames, поддеревья с перечисленными именами
+ *   обходятся, остальные пропускаются без разбора значений.
+ *   Массив объектов с перечисленным именем - последовательность
+ *   дочерних узлов с этим именем. SetParentData вызывается при
+ *   закрытии дочернего узла, после чего его инициализатор удаляется.
+ *   Инициализатор корневого узла живёт вместе с ридером, см. GetRootData
+ *
+ * Данные можно передавать по частям(InitFeed, Feed, Finish), например
+ *   из pipe или из потока-производителя: документ разбирается в
+ *   отдельном потоке по мере поступления блоков, непрерывный
+ *   буффер документа не собирается
+ *
+ * \note InitData вызывается при первом вложенном объекте или массиве
+ *   объектов узла, или при закрытии узла, поэтому скалярные параметры
+ *   узла должны предшествовать вложенным объектам. Скалярный параметр
+ *   (или элемент массива) после вложенного объекта - ошибка разбора
+ *   ERROR_JSON_FORMAT_ST. Для документов с произвольным порядком
+ *   членов используйте JSONReaderSample
+ * */
+template <class Initializer,
+          class InitializerFactory = SimpleInitializerFactory<Initializer>,
+          class PathT = fs::path,
+          class = typename std::enable_if<
+              NodeInitializerType<Initializer>>::type>
+class JSONStreamReaderSample : public BaseObject {
+  typedef JSONStreamReaderSample<Initializer, InitializerFactory, PathT>
+      JSONStreamReader;
+
+ public:
+  JSONStreamReaderSample(const JSONStreamReaderSample&) = delete;
+  JSONStreamReaderSample operator=(const JSONStreamReaderSample&) = delete;
+  ~JSONStreamReaderSample() {
+    if (feed_thread_.joinable()) {
+      feed_->Cancel();
+      feed_thread_.join();
+    }
+  }
+
+  static JSONStreamReader* Init(
+      file_utils::FileURLSample<PathT>* source,
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    JSONStreamReader* reader = nullptr;
+    if (source) {
+      if (is_exists(source->GetURL())) {
+        reader = new JSONStreamReader(source, nullptr, factory, options);
+      } else {
+        source->SetError(ERROR_FILE_EXISTS_ST,
+                         "File '" + source->GetURLStr() + "' doesn't exists");
+        source->LogError();
+      }
+    } else {
+      Logging::Append(ERROR_INIT_NULLP_ST,
+                      "Get 'source'=nullptr into "
+                      "JSONStreamReader Init method");
+    }
+    return reader;
+  }
+
+  static JSONStreamReader* Init(
+      const char* data,
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    JSONStreamReader* reader = nullptr;
+    if (data) {
+      reader = new JSONStreamReader(nullptr, data, factory, options);
+    } else {
+      Logging::Append(ERROR_INIT_NULLP_ST,
+                      "Get 'data'=nullptr into "
+                      "JSONStreamReader Init method");
+    }
+    return reader;
+  }
+
+  /**
+   * \brief Создать ридер, данные которому передаются по частям
+   *   методом Feed, см. Finish
+   * */
+  static JSONStreamReader* InitFeed(
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    return new JSONStreamReader(nullptr, nullptr, factory, options);
+  }
+
+  static std::string GetFilenameExtension() { return ".json"; }
+  /** \brief Разобрать документ, инициализируя узлы по ходу чтения */
+  merror_t InitData() {
+    if (!error_.GetErrorCode()) {
+      if (source_) {
+        std::FILE* f = std::fopen(source_->GetURLStr().c_str(), "rb");
+        if (f) {
+          std::vector<char> chunk(
+              std::max<size_t>(options_.stream_buffer_size, 16));
+          rj::FileReadStream is(f, chunk.data(), chunk.size());
+          parse(is);
+          std::fclose(f);
+        } else {
+          error_.SetError(ERROR_FILE_IN_ST,
+                          "cannot open file " + source_->GetURLStr());
+        }
+      } else {
+        rj::StringStream is(data_.c_str());
+        parse(is);
+      }
+    }
+    return setStatus();
+  }
+  /**
+   * \brief Передать ридеру следующую часть документа
+   *
+   * Документ разбирается в отдельном потоке по мере поступления
+   *   данных, блок копируется в очередь ридера. Если в очереди уже
+   *   `reader_options::feed_queue_size` неразобранных блоков - вызов
+   *   ждёт, пока разборщик их обработает
+   * \return ERROR_PARSER_PARSE_ST если разбор уже прерван ошибкой,
+   *   саму ошибку вернёт Finish
+   * */
+  merror_t Feed(std::string_view chunk) {
+    startFeed();
+    return feed_->Push(chunk) ? ERROR_SUCCESS_T : ERROR_PARSER_PARSE_ST;
+  }
+  /**
+   * \brief Данных больше не будет - дождаться окончания разбора
+   * \return Код ошибки разбора, как у InitData
+   * */
+  merror_t Finish() {
+    startFeed();
+    if (feed_thread_.joinable()) {
+      feed_->Close();
+      feed_thread_.join();
+    }
+    return setStatus();
+  }
+  /** \brief Инициализированная структура корневого узла */
+  Initializer* GetRootData() { return root_ ? root_->data.get() : nullptr; }
+  /** \brief Количество инициализированных узлов */
+  size_t GetInitializedCount() const { return initialized_count_; }
+  /** \brief Максимальная глубина стека узлов за время разбора */
+  size_t GetMaxDepth() const { return max_depth_; }
+
+  std::string GetFileName() { return (source_) ? source_->GetURLStr() : ""; }
+
+  merror_t GetErrorCode() const { return error_.GetErrorCode(); }
+
+ private:
+  /** \brief Узел на стеке текущего пути */
+  struct stream_level {
+    stream_level() : allocator(STREAM_LEVEL_CHUNK), value(rj::kObjectType) {}
+
+    /** \brief Подготовить к повторному использованию */
+    void Reset(const std::string& level_name) {
+      name = level_name;
+      data.reset();
+      initialized = false;
+      subnodes.clear();
+      value.SetObject();
+      array.SetNull();
+      allocator.Clear();
+      key.clear();
+      array_mode = array_t::none;
+    }
+    /** \brief Узел `name` есть в списке обходимых поддеревьев */
+    bool IsSubnode(const std::string& name) const {
+      return std::find(subnodes.begin(), subnodes.end(), name) !=
+             subnodes.end();
+    }
+
+    /** \brief режим разбора значения-массива текущего параметра */
+    enum class array_t {
+      /** \brief текущее значение не массив */
+      none,
+      /** \brief массив скаляров - параметр узла */
+      scalars,
+      /** \brief массив объектов - дочерние узлы */
+      childs,
+      /** \brief массив после InitData не из обходимых поддеревьев -
+       *   объекты пропускаются */
+      skipped
+    };
+
+    /** \brief имя узла */
+    std::string name;
+    /** \brief инициализируемая структура */
+    std::unique_ptr<Initializer> data;
+    /** \brief InitData уже вызвана */
+    bool initialized = false;
+    /** \brief имена обходимых поддеревьев */
+    inodes_vec subnodes;
+    /** \brief аллокатор параметров узла */
+    rj::MemoryPoolAllocator<> allocator;
+    /** \brief скалярные параметры узла */
+    rjNValue value;
+    /** \brief собираемый массив скаляров */
+    rjNValue array;
+    /** \brief имя текущего параметра */
+    std::string key;
+    array_t array_mode = array_t::none;
+  };
+  typedef typename stream_level::array_t array_t;
+
+  /** \brief Обработчик событий SAX парсера */
+  struct handler {
+    explicit handler(JSONStreamReader* r) : r(r) {}
+
+    bool Null() { return r->scalar(rjNValue()); }
+    bool Bool(bool b) { return r->scalar(rjNValue(b)); }
+    bool Int(int i) { return r->scalar(rjNValue(i)); }
+    bool Uint(unsigned u) { return r->scalar(rjNValue(u)); }
+    bool Int64(int64_t i) { return r->scalar(rjNValue(i)); }
+    bool Uint64(uint64_t u) { return r->scalar(rjNValue(u)); }
+    bool Double(double d) { return r->scalar(rjNValue(d)); }
+    bool RawNumber(const char* str, rj::SizeType len, bool) {
+      return r->string(str, len);
+    }
+    bool String(const char* str, rj::SizeType len, bool) {
+      return r->string(str, len);
+    }
+    bool Key(const char* str, rj::SizeType len, bool) {
+      return r->key(str, len);
+    }
+    bool StartObject() { return r->startObject(); }
+    bool EndObject(rj::SizeType) { return r->endObject(); }
+    bool StartArray() { return r->startArray(); }
+    bool EndArray(rj::SizeType) { return r->endArray(); }
+
+    JSONStreamReader* r;
+  };
+
+ private:
+  JSONStreamReaderSample(file_utils::FileURLSample<PathT>* source,
+                         const char* data,
+                         InitializerFactory* factory,
+                         const reader_options& options)
+      : BaseObject(STATUS_DEFAULT),
+        source_(source),
+        factory_(factory),
+        options_(options) {
+    if (data)
+      data_ = data;
+  }
+
+  /** \brief Разобрать документ из потока `is` */
+  template <class Stream>
+  void parse(Stream& is) {
+    handler h(this);
+    rj::Reader reader;
+    rj::ParseResult res = reader.Parse<rj::kParseIterativeFlag>(is, h);
+    // ошибки инициализаторов уже записаны в error_
+    if (res.IsError() && !error_.GetErrorCode()) {
+      error_.SetError(ERROR_JSON_FORMAT_ST,
+                      std::string("RapidJSON parse error: ") +
+                          rj::GetParseError_En(res.Code()) + " offset " +
+                          std::to_string(res.Offset()));
+    }
+    if (!error_.GetErrorCode() && !root_)
+      error_.SetError(ERROR_JSON_PARSE_ST,
+                      "ошибка инициализации корневого элемента json файла");
+    levels_.clear();
+    depth_ = 0;
+  }
+  merror_t setStatus() {
+    if (error_.GetErrorCode()) {
+      status_ = STATUS_HAVE_ERROR;
+      error_.LogIt();
+    } else {
+      status_ = STATUS_OK;
+    }
+    return error_.GetErrorCode();
+  }
+  /** \brief Запустить поток разбора данных, передаваемых Feed */
+  void startFeed() {
+    if (feed_)
+      return;
+    feed_ = std::unique_ptr<ChunkQueue>(
+        new ChunkQueue(options_.feed_queue_size));
+    feed_thread_ = std::thread([this]() {
+      ChunkQueue* queue = feed_.get();
+      json_read_stream is(
+          [queue](char* buffer, size_t size) {
+            return queue->Read(buffer, size);
+          },
+          options_.stream_buffer_size);
+      if (!error_.GetErrorCode())
+        parse(is);
+      // остаток данных не нужен, источник не должен ждать
+      if (error_.GetErrorCode())
+        queue->Cancel();
+      else
+        queue->Drain();
+    });
+  }
+
+  stream_level& top() { return *levels_[depth_ - 1]; }
+  /** \brief Положить на стек узел `name` */
+  void push(const std::string& name) {
+    if (depth_ == levels_.size())
+      levels_.emplace_back(new stream_level());
+    levels_[depth_++]->Reset(name);
+    max_depth_ = std::max(max_depth_, depth_);
+  }
+  /** \brief Вызвать InitData узла, если ещё не вызвана */
+  bool ensureInit(stream_level& l) {
+    if (l.initialized)
+      return true;
+    if (factory_) {
+      l.data = std::unique_ptr<Initializer>(
+          factory_->template GetNodeInitializer<rjNValue>());
+      if (!l.data) {
+        error_.SetError(ERROR_GENERAL_T, "Ошибка использования фабрики узлов");
+        return false;
+      }
+    } else {
+      l.data = std::unique_ptr<Initializer>(new Initializer());
+    }
+    merror_t error = l.data->InitData(&l.value, l.name);
+    if (error) {
+      error_.SetError(error, "Initializer InitData finished with error for "
+                             "node '" + l.name + "'");
+      return false;
+    }
+    l.data->SetSubnodesNames(&l.subnodes);
+    l.initialized = true;
+    ++initialized_count_;
+    return true;
+  }
+
+  bool scalar(rjNValue&& v) {
+    if (skip_depth_)
+      return true;
+    if (!depth_) {
+      dropRootCandidate();
+      return true;
+    }
+    stream_level& l = top();
+    if (l.initialized) {
+      // InitData уже получила параметры узла, значение потеряется
+      error_.SetError(ERROR_JSON_FORMAT_ST,
+                      "скалярный параметр '" + l.key + "' узла '" + l.name +
+                          "' расположен после вложенных объектов");
+      return false;
+    }
+    if (l.array_mode == array_t::scalars) {
+      l.array.PushBack(v, l.allocator);
+    } else if (l.array_mode == array_t::none) {
+      rjNValue k(l.key.c_str(), static_cast<rj::SizeType>(l.key.size()),
+                 l.allocator);
+      l.value.AddMember(k, v, l.allocator);
+    }
+    return true;
+  }
+  bool string(const char* str, rj::SizeType len) {
+    if (skip_depth_ || !depth_ || top().initialized)
+      return scalar(rjNValue());
+    return scalar(rjNValue(str, len, top().allocator));
+  }
+  /** \brief Значение члена объекта документа не объект -
+   *   корневым узлом он быть не может */
+  void dropRootCandidate() {
+    if (root_pending_) {
+      root_pending_ = false;
+      root_name_.clear();
+    }
+  }
+  bool key(const char* str, rj::SizeType len) {
+    if (skip_depth_)
+      return true;
+    if (depth_) {
+      top().key.assign(str, len);
+    } else if (!root_ && root_name_.empty()) {
+      // корневой узел - первый член объекта документа
+      root_name_.assign(str, len);
+      root_pending_ = true;
+    }
+    return true;
+  }
+  bool startObject() {
+    if (skip_depth_) {
+      ++skip_depth_;
+      return true;
+    }
+    if (!depth_) {
+      if (!doc_opened_) {
+        doc_opened_ = true;
+      } else if (root_pending_) {
+        root_pending_ = false;
+        push(root_name_);
+      } else {
+        // остальные члены объекта документа пропускаются
+        skip_depth_ = 1;
+      }
+      return true;
+    }
+    stream_level& l = top();
+    if (l.array_mode == array_t::childs) {
+      push(l.key);
+      return true;
+    }
+    if (l.array_mode == array_t::skipped) {
+      skip_depth_ = 1;
+      return true;
+    }
+    if (l.array_mode == array_t::scalars) {
+      // массив объектов: собранные скаляры - параметр узла
+      rjNValue k(l.key.c_str(), static_cast<rj::SizeType>(l.key.size()),
+                 l.allocator);
+      l.value.AddMember(k, l.array, l.allocator);
+      l.array_mode = array_t::none;
+      if (!ensureInit(l))
+        return false;
+      if (l.IsSubnode(l.key)) {
+        l.array_mode = array_t::childs;
+        push(l.key);
+      } else {
+        // пропустить объекты массива, скаляры после них - ошибка
+        l.array_mode = array_t::skipped;
+        skip_depth_ = 1;
+      }
+      return true;
+    }
+    if (!ensureInit(l))
+      return false;
+    if (l.IsSubnode(l.key)) {
+      std::string name = l.key;
+      push(name);
+    } else {
+      skip_depth_ = 1;
+    }
+    return true;
+  }
+  bool endObject() {
+    if (skip_depth_) {
+      --skip_depth_;
+      return true;
+    }
+    if (!depth_)
+      return true;
+    if (!ensureInit(top()))
+      return false;
+    if (depth_ == 1) {
+      root_ = std::move(levels_[0]);
+      levels_[0].reset(new stream_level());
+    } else {
+      stream_level& child = top();
+      stream_level& parent = *levels_[depth_ - 2];
+      child.data->SetParentData(*parent.data);
+      child.data.reset();
+    }
+    --depth_;
+    return true;
+  }
+  bool startArray() {
+    if (skip_depth_) {
+      ++skip_depth_;
+      return true;
+    }
+    if (!depth_) {
+      if (!doc_opened_)
+        error_.SetError(ERROR_JSON_PARSE_ST,
+                        "ошибка инициализации корневого элемента json файла");
+      skip_depth_ = 1;
+      dropRootCandidate();
+      return doc_opened_;
+    }
+    stream_level& l = top();
+    if (l.array_mode != array_t::none) {
+      // вложенные массивы не разбираются
+      skip_depth_ = 1;
+    } else if (!l.initialized) {
+      l.array_mode = array_t::scalars;
+      l.array.SetArray();
+    } else {
+      l.array_mode = l.IsSubnode(l.key) ? array_t::childs : array_t::skipped;
+    }
+    return true;
+  }
+  bool endArray() {
+    if (skip_depth_) {
+      --skip_depth_;
+      return true;
+    }
+    if (!depth_)
+      return true;
+    stream_level& l = top();
+    if (l.array_mode == array_t::scalars && !l.initialized) {
+      rjNValue k(l.key.c_str(), static_cast<rj::SizeType>(l.key.size()),
+                 l.allocator);
+      l.value.AddMember(k, l.array, l.allocator);
+    }
+    l.array_mode = array_t::none;
+    return true;
+  }
+
+ private:
+  /** \brief адрес файла */
+  file_utils::FileURLSample<PathT>* source_ = nullptr;
+  /** \brief данные, переданные строкой */
+  std::string data_;
+  /** \brief фабрика инициализаторов */
+  InitializerFactory* factory_ = nullptr;
+  /** \brief настройки ридера */
+  reader_options options_;
+  /** \brief стек узлов текущего пути, узлы переиспользуются */
+  std::vector<std::unique_ptr<stream_level>> levels_;
+  /** \brief глубина текущего пути */
+  size_t depth_ = 0;
+  size_t max_depth_ = 0;
+  /** \brief глубина пропускаемого поддерева, 0 - не пропускается */
+  size_t skip_depth_ = 0;
+  /** \brief корневой узел, после его закрытия */
+  std::unique_ptr<stream_level> root_;
+  std::string root_name_;
+  bool root_pending_ = false;
+  bool doc_opened_ = false;
+  size_t initialized_count_ = 0;
+  /** \brief очередь данных, переданных методом Feed */
+  std::unique_ptr<ChunkQueue> feed_;
+  /** \brief поток разбора данных Feed */
+  std::thread feed_thread_;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__JSONSTREAMREADER_H
@@ -0,0 +1,189 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * JSONTape *
+ *   Разбор json в два этапа: индекс структурных символов(SIMD) и
+ * лента значений, числа которой разбираются по обращению
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__JSONTAPE_H
+#define UTILS__JSONTAPE_H
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * \brief Размер куска документа первого этапа разбора, кратен 64
+ * */
+#define JSON_TAPE_CHUNK (64 * 1024)  // 64 KiB
+
+namespace asp_utils {
+/**
+ * \brief Набор инструкций первого этапа разбора
+ * */
+enum class json_simd_t {
+  /** \brief побайтовый разбор, без SIMD */
+  scalar,
+  /** \brief блоки по 16 байт */
+  sse42,
+  /** \brief блоки по 32 байта */
+  avx2,
+  /** \brief лучший из поддерживаемых процессором */
+  detect
+};
+/**
+ * \brief Лучший набор инструкций, поддерживаемый процессором
+ * */
+json_simd_t GetJSONSimd();
+/**
+ * \brief Первый этап: индекс структурных символов json
+ *
+ * В индекс попадают позиции `{}[]:,` вне строк, всех неэкранированных
+ *   кавычек и начал скаляров(чисел и литералов) вне строк. Для всех
+ *   наборов инструкций индекс одинаковый
+ * \return Код ошибки: незакрытая строка или управляющий символ
+ *   в строке
+ * */
+merror_t JSONStructuralIndex(const char* data,
+                             size_t len,
+                             std::vector<uint32_t>* index,
+                             json_simd_t simd = json_simd_t::detect);
+
+/**
+ * \brief Тип значения json
+ * */
+enum class json_type_t : uint8_t {
+  null_value,
+  false_value,
+  true_value,
+  number,
+  string,
+  array,
+  object
+};
+
+/**
+ * \brief Запись ленты - значение json
+ *
+ * Записи лежат в порядке обхода в глубину, дочерние значения
+ *   контейнера следуют за ним до записи `next`
+ * */
+struct json_tape_record {
+  /** \brief смещение и длина имени члена объекта в буффере */
+  uint32_t name;
+  uint32_t name_length;
+  /** \brief смещение и длина строки(без кавычек, экранирование
+   *   раскрыто) или исходного текста числа и литерала */
+  uint32_t value;
+  uint32_t value_length;
+  /** \brief индекс записи за поддеревом значения */
+  uint32_t next;
+  json_type_t type;
+};
+
+/**
+ * \brief Разобранный документ: лента значений с указателями в буффер
+ *   документа, корень - запись 0
+ * \note Буффер документа должен жить дольше ленты
+ * */
+struct json_tape_document {
+  const char* data = nullptr;
+  std::vector<json_tape_record> tape;
+};
+
+/**
+ * \brief Разобрать документ: второй этап проверяет грамматику по
+ *   индексу структурных символов и строит ленту
+ *
+ * Первый этап идёт кусками JSON_TAPE_CHUNK байт по мере чтения
+ *   индекса вторым, так что индекс всего документа не хранится.
+ *   Строки проверяются и раскрываются(экранирование, `\uXXXX`) прямо
+ *   в буффере `memory`, числа только проверяются - значения
+ *   разбираются при обращении к ним(json_tape_node::GetInt64 и т.п.).
+ *   Поддерживаются документы размером меньше 4 Гб
+ * */
+merror_t ParseJSONTape(char* memory,
+                       size_t len,
+                       json_tape_document* doc,
+                       ErrorWrap* ew,
+                       json_simd_t simd = json_simd_t::detect);
+
+/**
+ * \brief Значение разобранного документа - индекс в ленте
+ * */
+class json_tape_node {
+ public:
+  json_tape_node() = default;
+  json_tape_node(const json_tape_document* doc, uint32_t index)
+      : doc_(doc), index_(index) {}
+
+  /** \brief Значение существует */
+  bool IsValid() const { return doc_ && index_ < doc_->tape.size(); }
+  json_type_t GetType() const { return record().type; }
+  bool IsObject() const { return GetType() == json_type_t::object; }
+  bool IsArray() const { return GetType() == json_type_t::array; }
+  bool IsString() const { return GetType() == json_type_t::string; }
+  bool IsNumber() const { return GetType() == json_type_t::number; }
+  bool IsBool() const {
+    return GetType() == json_type_t::true_value ||
+           GetType() == json_type_t::false_value;
+  }
+  bool IsNull() const { return GetType() == json_type_t::null_value; }
+  /** \brief Имя члена объекта, пустое для элементов массива */
+  std::string_view GetName() const {
+    return std::string_view(doc_->data + record().name, record().name_length);
+  }
+  /** \brief Строка или исходный текст скаляра */
+  std::string_view GetValue() const {
+    return std::string_view(doc_->data + record().value,
+                            record().value_length);
+  }
+  bool GetBool() const { return GetType() == json_type_t::true_value; }
+  /**
+   * \brief Целое значение числа без дробной части и экспоненты
+   * \return false если число не целое или выходит за границы типа
+   * */
+  bool GetInt64(int64_t* out) const;
+  bool GetUint64(uint64_t* out) const;
+  /** \brief Значение любого числа */
+  bool GetDouble(double* out) const;
+  /** \brief Первый член объекта с именем `name`, невалидный
+   *   если такого нет */
+  json_tape_node GetChild(std::string_view name) const {
+    if (!IsObject())
+      return json_tape_node();
+    const auto& tape = doc_->tape;
+    for (uint32_t i = index_ + 1; i < record().next; i = tape[i].next) {
+      if (std::string_view(doc_->data + tape[i].name, tape[i].name_length) ==
+          name)
+        return json_tape_node(doc_, i);
+    }
+    return json_tape_node();
+  }
+  /** \brief Обойти члены объекта или элементы массива */
+  template <class F>
+  void ForEachChild(F&& f) const {
+    const auto& tape = doc_->tape;
+    for (uint32_t i = index_ + 1; i < record().next; i = tape[i].next)
+      f(json_tape_node(doc_, i));
+  }
+
+ private:
+  const json_tape_record& record() const { return doc_->tape[index_]; }
+
+ private:
+  const json_tape_document* doc_ = nullptr;
+  uint32_t index_ = 0;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__JSONTAPE_H
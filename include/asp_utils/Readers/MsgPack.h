@@ -0,0 +1,234 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * MsgPack *
+ *   Бинарный формат MessagePack: разбор документа в ленту значений
+ * с числами в двоичном виде и запись документов в этот формат
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__MSGPACK_H
+#define UTILS__MSGPACK_H
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asp_utils {
+/**
+ * \brief Тип значения MessagePack
+ * */
+enum class msgpack_type_t : uint8_t {
+  null_value,
+  false_value,
+  true_value,
+  /** \brief отрицательное целое */
+  int_value,
+  /** \brief неотрицательное целое */
+  uint_value,
+  /** \brief float 32 или 64 */
+  float_value,
+  /** \brief str или bin */
+  string,
+  array,
+  map
+};
+
+/**
+ * \brief Запись ленты - значение MessagePack
+ *
+ * Записи лежат в порядке обхода в глубину, дочерние значения
+ *   контейнера следуют за ним до записи `next`
+ * */
+struct msgpack_record {
+  /** \brief смещение и длина ключа члена map в буффере */
+  uint32_t name;
+  uint32_t name_length;
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    /** \brief смещение и длина строки в буффере */
+    struct {
+      uint32_t offset;
+      uint32_t length;
+    } str;
+  } value;
+  /** \brief индекс записи за поддеревом значения */
+  uint32_t next;
+  msgpack_type_t type;
+};
+
+/**
+ * \brief Разобранный документ: лента значений с указателями в буффер
+ *   документа, корень - запись 0
+ * \note Буффер документа должен жить дольше ленты
+ * */
+struct msgpack_document {
+  const char* data = nullptr;
+  std::vector<msgpack_record> tape;
+};
+
+/**
+ * \brief Разобрать документ MessagePack в ленту
+ *
+ * Буффер не изменяется, строки лентой не копируются. Ключи map -
+ *   только строки, типы ext не поддерживаются. Поддерживаются
+ *   документы размером меньше 4 Гб
+ * */
+merror_t ParseMsgPack(const char* memory,
+                      size_t len,
+                      msgpack_document* doc,
+                      ErrorWrap* ew);
+
+/**
+ * \brief Значение разобранного документа - индекс в ленте
+ * */
+class msgpack_node {
+ public:
+  msgpack_node() = default;
+  msgpack_node(const msgpack_document* doc, uint32_t index)
+      : doc_(doc), index_(index) {}
+
+  /** \brief Значение существует */
+  bool IsValid() const { return doc_ && index_ < doc_->tape.size(); }
+  msgpack_type_t GetType() const { return record().type; }
+  bool IsMap() const { return GetType() == msgpack_type_t::map; }
+  bool IsArray() const { return GetType() == msgpack_type_t::array; }
+  bool IsString() const { return GetType() == msgpack_type_t::string; }
+  bool IsNumber() const {
+    return GetType() == msgpack_type_t::int_value ||
+           GetType() == msgpack_type_t::uint_value ||
+           GetType() == msgpack_type_t::float_value;
+  }
+  bool IsBool() const {
+    return GetType() == msgpack_type_t::true_value ||
+           GetType() == msgpack_type_t::false_value;
+  }
+  bool IsNull() const { return GetType() == msgpack_type_t::null_value; }
+  /** \brief Ключ члена map, пустой для элементов массива */
+  std::string_view GetName() const {
+    return std::string_view(doc_->data + record().name, record().name_length);
+  }
+  /** \brief Строка, пустая для других типов */
+  std::string_view GetString() const {
+    if (!IsString())
+      return std::string_view();
+    return std::string_view(doc_->data + record().value.str.offset,
+                            record().value.str.length);
+  }
+  bool GetBool() const { return GetType() == msgpack_type_t::true_value; }
+  /**
+   * \brief Целое значение
+   * \return false если значение не целое или выходит за границы типа
+   * */
+  bool GetInt64(int64_t* out) const {
+    if (GetType() == msgpack_type_t::int_value) {
+      *out = record().value.i;
+    } else if (GetType() == msgpack_type_t::uint_value &&
+               record().value.u <= INT64_MAX) {
+      *out = static_cast<int64_t>(record().value.u);
+    } else {
+      return false;
+    }
+    return true;
+  }
+  bool GetUint64(uint64_t* out) const {
+    if (GetType() != msgpack_type_t::uint_value)
+      return false;
+    *out = record().value.u;
+    return true;
+  }
+  /** \brief Значение любого числа */
+  bool GetDouble(double* out) const {
+    if (GetType() == msgpack_type_t::float_value)
+      *out = record().value.d;
+    else if (GetType() == msgpack_type_t::int_value)
+      *out = static_cast<double>(record().value.i);
+    else if (GetType() == msgpack_type_t::uint_value)
+      *out = static_cast<double>(record().value.u);
+    else
+      return false;
+    return true;
+  }
+  /** \brief Первый член map с ключом `name`, невалидный
+   *   если такого нет */
+  msgpack_node GetChild(std::string_view name) const {
+    if (!IsMap())
+      return msgpack_node();
+    const auto& tape = doc_->tape;
+    for (uint32_t i = index_ + 1; i < record().next; i = tape[i].next) {
+      if (std::string_view(doc_->data + tape[i].name, tape[i].name_length) ==
+          name)
+        return msgpack_node(doc_, i);
+    }
+    return msgpack_node();
+  }
+  /** \brief Обойти члены map или элементы массива */
+  template <class F>
+  void ForEachChild(F&& f) const {
+    const auto& tape = doc_->tape;
+    for (uint32_t i = index_ + 1; i < record().next; i = tape[i].next)
+      f(msgpack_node(doc_, i));
+  }
+
+ private:
+  const msgpack_record& record() const { return doc_->tape[index_]; }
+
+ private:
+  const msgpack_document* doc_ = nullptr;
+  uint32_t index_ = 0;
+};
+
+/**
+ * \brief Запись значений MessagePack в конец строки, в самом
+ *   коротком представлении(числа с плавающей точкой - float 64)
+ *
+ * Для map после Map(n) записываются n пар ключ-значение, для
+ *   массива после Array(n) - n значений
+ * */
+class msgpack_writer {
+ public:
+  explicit msgpack_writer(std::string* out) : out_(out) {}
+
+  void Null();
+  void Bool(bool value);
+  void Int(int64_t value);
+  void Uint(uint64_t value);
+  void Double(double value);
+  void String(std::string_view value);
+  void Array(uint32_t size);
+  void Map(uint32_t size);
+
+ private:
+  /** \brief Байт типа и `bytes` байт значения, старшие вперёд */
+  void put(uint8_t tag, uint64_t value, int bytes);
+
+ private:
+  std::string* out_;
+};
+
+/**
+ * \brief Перевести документ json в MessagePack
+ *
+ * Типы значений сохраняются: числа записываются целыми, если
+ *   помещаются в 64 бита, иначе float 64
+ * \param memory буффер документа, строки раскрываются в нём, см.
+ *   ParseJSONTape
+ * \note Документы xml и других форматов - WriteMsgPack
+ * */
+merror_t JSONToMsgPack(char* memory,
+                       size_t len,
+                       std::string* out,
+                       ErrorWrap* ew);
+}  // namespace asp_utils
+
+#endif  // !UTILS__MSGPACK_H
@@ -0,0 +1,106 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * NameInterner *
+ *   Таблица имён узлов: одинаковые имена дерева хранятся один раз
+ * и сравниваются по идентификатору
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__NAMEINTERNER_H
+#define UTILS__NAMEINTERNER_H
+
+#include "asp_utils/ThreadWrap.h"
+#include "asp_utils/Readers/ChildIndex.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace asp_utils {
+/**
+ * \brief Запись таблицы имён
+ * */
+struct interned_name {
+  /** \brief идентификатор - порядковый номер имени в таблице */
+  uint32_t id;
+  /** \brief хэш имени, см. name_hash */
+  uint64_t hash;
+  std::string name;
+};
+
+/**
+ * \brief Потокобезопасная таблица имён
+ *
+ * Запись имени создаётся один раз и не перемещается, пока жива
+ *   таблица: узлы хранят указатель на неё вместо копии строки.
+ *   Одинаковые имена - одна запись, сравнение записей - сравнение
+ *   указателей или идентификаторов
+ * */
+class NameInterner {
+ public:
+  /** \brief идентификатор имени */
+  typedef uint32_t name_id;
+
+ public:
+  NameInterner() = default;
+  NameInterner(const NameInterner&) = delete;
+  NameInterner& operator=(const NameInterner&) = delete;
+
+  /**
+   * \brief Получить запись имени `name`, добавив её при необходимости
+   * */
+  const interned_name& Intern(std::string_view name) {
+    return Intern(name, name_hash(name));
+  }
+  /**
+   * \brief Получить запись имени по заранее посчитанному хэшу
+   * */
+  const interned_name& Intern(std::string_view name, uint64_t hash);
+  /**
+   * \brief Найти запись имени, не добавляя её
+   * \return nullptr, если имени нет в таблице
+   * */
+  const interned_name* Find(std::string_view name) const {
+    return Find(name, name_hash(name));
+  }
+  const interned_name* Find(std::string_view name, uint64_t hash) const;
+  /**
+   * \brief Запись по идентификатору
+   * */
+  const interned_name& Get(name_id id) const;
+  /**
+   * \brief Количество имён в таблице
+   * */
+  size_t Size() const;
+  /**
+   * \brief Суммарная длина имён таблицы
+   * */
+  size_t GetBytes() const;
+  /**
+   * \brief Удалить все имена
+   * \note Записи, полученные ранее, становятся невалидными
+   * */
+  void Clear();
+
+ private:
+  /** \brief Найти запись, под блокировкой */
+  const interned_name* find(std::string_view name, uint64_t hash) const;
+
+ private:
+  mutable SharedMutex mutex_;
+  /** \brief записи в порядке добавления, адреса стабильны */
+  std::deque<interned_name> names_;
+  /** \brief поиск записей по хэшу имени */
+  std::unordered_multimap<uint64_t, const interned_name*> table_;
+  size_t bytes_ = 0;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__NAMEINTERNER_H
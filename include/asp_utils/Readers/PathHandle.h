@@ -0,0 +1,315 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * PathHandle *
+ *   Скомпилированные пути к узлам деревьев ридеров и индекс
+ * путь -> узел
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__PATHHANDLE_H
+#define UTILS__PATHHANDLE_H
+
+#include "asp_utils/Readers/ChildIndex.h"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * \brief Разделитель имён узлов в строковом представлении пути
+ * */
+#define PATH_SEPARATOR '/'
+
+namespace asp_utils {
+/**
+ * \brief Хэш пустого пути
+ * */
+constexpr uint64_t path_hash_seed = 0x84222325cbf29ce4ull;
+/**
+ * \brief Добавить к хэшу пути `seed` хэш имени следующего узла
+ * */
+constexpr uint64_t path_hash_step(uint64_t seed, uint64_t name_hash) {
+  return seed ^ (name_hash + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+/**
+ * \brief Количество имён в строковом представлении пути
+ * */
+constexpr size_t path_tokens_count(std::string_view path) {
+  if (path.empty())
+    return 0;
+  size_t count = 1;
+  for (char c : path)
+    if (c == PATH_SEPARATOR)
+      ++count;
+  return count;
+}
+
+/**
+ * \brief Концепт скомпилированного пути: имена узлов пути,
+ *   их хэши и хэши префиксов пути
+ * */
+template <class T>
+concept PathHandleType = requires(const T& path, size_t i) {
+  { path.Size() } -> std::convertible_to<size_t>;
+  { path.GetName(i) } -> std::convertible_to<std::string_view>;
+  { path.GetHash(i) } -> std::convertible_to<uint64_t>;
+  { path.GetPrefixHash(i) } -> std::convertible_to<uint64_t>;
+};
+
+/**
+ * \brief Путь, скомпилированный во время выполнения: имена
+ *   и хэши посчитаны один раз
+ * */
+class path_handle {
+ public:
+  path_handle() : prefix_{path_hash_seed} {}
+  /** \brief Путь из имён узлов */
+  explicit path_handle(const std::vector<std::string>& path) : path_handle() {
+    for (const auto& name : path)
+      append(name);
+  }
+  /** \brief Путь из строки вида "a/b/c" */
+  explicit path_handle(std::string_view path) : path_handle() {
+    if (path.empty())
+      return;
+    size_t start = 0;
+    for (size_t pos = path.find(PATH_SEPARATOR); pos != std::string_view::npos;
+         pos = path.find(PATH_SEPARATOR, start)) {
+      append(path.substr(start, pos - start));
+      start = pos + 1;
+    }
+    append(path.substr(start));
+  }
+
+  /** \brief Количество имён в пути */
+  size_t Size() const { return tokens_.size(); }
+  /** \brief Имя i-го узла пути */
+  std::string_view GetName(size_t i) const {
+    return std::string_view(storage_).substr(tokens_[i].offset,
+                                             tokens_[i].length);
+  }
+  /** \brief Хэш имени i-го узла пути */
+  uint64_t GetHash(size_t i) const { return tokens_[i].hash; }
+  /** \brief Хэш первых `n` имён пути */
+  uint64_t GetPrefixHash(size_t n) const { return prefix_[n]; }
+
+ private:
+  void append(std::string_view name) {
+    uint64_t hash = name_hash(name);
+    tokens_.push_back(token{storage_.size(), name.size(), hash});
+    storage_.append(name);
+    prefix_.push_back(path_hash_step(prefix_.back(), hash));
+  }
+
+ private:
+  struct token {
+    size_t offset;
+    size_t length;
+    uint64_t hash;
+  };
+  /** \brief имена узлов, подряд */
+  std::string storage_;
+  std::vector<token> tokens_;
+  /** \brief хэши префиксов, prefix_[0] - хэш пустого пути */
+  std::vector<uint64_t> prefix_;
+};
+
+/**
+ * \brief Путь, скомпилированный во время компиляции,
+ *   см. `operator""_path`
+ * */
+template <size_t N>
+class static_path {
+ public:
+  constexpr explicit static_path(std::string_view path) {
+    prefix_[0] = path_hash_seed;
+    size_t start = 0;
+    for (size_t i = 0; i < N; ++i) {
+      size_t pos = path.find(PATH_SEPARATOR, start);
+      names_[i] = path.substr(start, pos == std::string_view::npos
+                                         ? std::string_view::npos
+                                         : pos - start);
+      hashes_[i] = name_hash(names_[i]);
+      prefix_[i + 1] = path_hash_step(prefix_[i], hashes_[i]);
+      start = pos + 1;
+    }
+  }
+
+  constexpr size_t Size() const { return N; }
+  constexpr std::string_view GetName(size_t i) const { return names_[i]; }
+  constexpr uint64_t GetHash(size_t i) const { return hashes_[i]; }
+  constexpr uint64_t GetPrefixHash(size_t n) const { return prefix_[n]; }
+
+ private:
+  std::array<std::string_view, N> names_{};
+  std::array<uint64_t, N> hashes_{};
+  std::array<uint64_t, N + 1> prefix_{};
+};
+
+/**
+ * \brief Доступ к именам пути, заданного вектором имён или
+ *   скомпилированного. Для вектора имён хэш считается при вызове
+ * */
+inline size_t path_size(const std::vector<std::string>& path) {
+  return path.size();
+}
+inline std::string_view path_name(const std::vector<std::string>& path,
+                                  size_t i) {
+  return path[i];
+}
+inline uint64_t path_name_hash(const std::vector<std::string>& path,
+                               size_t i) {
+  return name_hash(path[i]);
+}
+template <PathHandleType PathH>
+constexpr size_t path_size(const PathH& path) {
+  return path.Size();
+}
+template <PathHandleType PathH>
+constexpr std::string_view path_name(const PathH& path, size_t i) {
+  return path.GetName(i);
+}
+template <PathHandleType PathH>
+constexpr uint64_t path_name_hash(const PathH& path, size_t i) {
+  return path.GetHash(i);
+}
+
+/**
+ * \brief Строковый литерал - параметр шаблона
+ * */
+template <size_t N>
+struct fixed_string {
+  constexpr fixed_string(const char (&str)[N]) {
+    for (size_t i = 0; i < N; ++i)
+      value[i] = str[i];
+  }
+  constexpr std::string_view view() const { return {value, N - 1}; }
+
+  char value[N];
+};
+
+inline namespace path_literals {
+/**
+ * \brief Путь, известный во время компиляции:
+ *   `reader->GetNodeByPath("data/d1"_path)`
+ * */
+template <fixed_string S>
+constexpr auto operator""_path() {
+  return static_path<path_tokens_count(S.view())>(S.view());
+}
+}  // namespace path_literals
+
+/**
+ * \brief Индекс путь -> значение(узел дерева ридера)
+ *
+ * Хэш-таблица с открытой адресацией по хэшам путей, поиск
+ *   скомпилированного пути - одна проба таблицы и сравнение имён,
+ *   без выделения памяти.
+ * */
+template <class ValueT>
+class path_index {
+ public:
+  /** \brief Очистить индекс */
+  void Clear() {
+    entries_.clear();
+    slots_.clear();
+  }
+  /** \brief Количество путей в индексе */
+  size_t Size() const { return entries_.size(); }
+  /** \brief Добавить путь, заданный хэшем и именами, разделёнными '\0'
+   * \note Если путь уже есть в индексе - он не перезаписывается */
+  void Insert(uint64_t hash, std::string key, ValueT value) {
+    if ((entries_.size() + 1) * 2 > slots_.size())
+      rehash(std::max<size_t>(16, slots_.size() * 2));
+    size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      if (slots_[i] == empty_slot) {
+        slots_[i] = static_cast<uint32_t>(entries_.size());
+        entries_.push_back(entry{hash, std::move(key), value});
+        return;
+      }
+      const entry& e = entries_[slots_[i]];
+      if (e.hash == hash && e.key == key)
+        return;
+    }
+  }
+  /** \brief Найти узел по первым `n` именам пути
+   * \return Указатель на значение или nullptr */
+  template <PathHandleType PathH>
+  const ValueT* Find(const PathH& path, size_t n) const {
+    return find(path.GetPrefixHash(n), n,
+                [&path](size_t i) { return path.GetName(i); });
+  }
+  /** \brief Найти узел по первым `n` именам пути */
+  const ValueT* Find(const std::vector<std::string>& path, size_t n) const {
+    uint64_t hash = path_hash_seed;
+    for (size_t i = 0; i < n; ++i)
+      hash = path_hash_step(hash, name_hash(path[i]));
+    return find(hash, n,
+                [&path](size_t i) -> std::string_view { return path[i]; });
+  }
+
+ private:
+  struct entry {
+    uint64_t hash;
+    std::string key;
+    ValueT value;
+  };
+  static constexpr uint32_t empty_slot = static_cast<uint32_t>(-1);
+
+ private:
+  template <class NameAt>
+  const ValueT* find(uint64_t hash, size_t n, NameAt&& name_at) const {
+    if (slots_.empty())
+      return nullptr;
+    size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask; slots_[i] != empty_slot; i = (i + 1) & mask) {
+      const entry& e = entries_[slots_[i]];
+      if (e.hash == hash && equal_key(e.key, n, name_at))
+        return &e.value;
+    }
+    return nullptr;
+  }
+  template <class NameAt>
+  static bool equal_key(std::string_view key, size_t n, NameAt& name_at) {
+    for (size_t i = 0; i < n; ++i) {
+      std::string_view name = name_at(i);
+      if (i > 0) {
+        if (key.empty() || key[0] != '\0')
+          return false;
+        key.remove_prefix(1);
+      }
+      if (key.substr(0, name.size()) != name)
+        return false;
+      key.remove_prefix(name.size());
+    }
+    return key.empty();
+  }
+  void rehash(size_t size) {
+    slots_.assign(size, empty_slot);
+    size_t mask = size - 1;
+    for (size_t e = 0; e < entries_.size(); ++e) {
+      size_t i = entries_[e].hash & mask;
+      while (slots_[i] != empty_slot)
+        i = (i + 1) & mask;
+      slots_[i] = static_cast<uint32_t>(e);
+    }
+  }
+
+ private:
+  std::vector<entry> entries_;
+  /** \brief таблица индексов `entries_`, размер - степень двойки */
+  std::vector<uint32_t> slots_;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__PATHHANDLE_H
@@ -0,0 +1,533 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * Query *
+ *   Запросы к деревьям ридеров: шаги пути с `*`, поиск потомков
+ * `//` и предикаты по значениям параметров, ленивый обход
+ * результатов и индексы значений параметров
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__QUERY_H
+#define UTILS__QUERY_H
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+#include "asp_utils/Readers/ChildIndex.h"
+#include "asp_utils/Readers/NameInterner.h"
+#include "asp_utils/Readers/PathHandle.h"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Максимальное количество шагов запроса
+ * */
+#define QUERY_MAX_STEPS 64
+/**
+ * \brief Глубина стека обхода, резервируемая результатом запроса
+ * */
+#define QUERY_STACK_RESERVE 64
+
+namespace asp_utils {
+/**
+ * \brief Ось шага запроса
+ * */
+enum class query_axis_t : uint8_t {
+  /** \brief дочерние узлы, `a/b` */
+  child,
+  /** \brief все потомки, `a//b` */
+  descendant
+};
+
+/**
+ * \brief Сравнение предиката шага запроса
+ * */
+enum class query_op_t : uint8_t {
+  /** \brief `[@p]` - параметр есть */
+  exists,
+  eq,
+  ne,
+  lt,
+  le,
+  gt,
+  ge
+};
+
+/**
+ * \brief Предикат шага запроса: `[@name op value]`
+ * */
+struct query_predicate {
+  std::string name;
+  query_op_t op;
+  std::string value;
+  /** \brief `value` - число, `number` - его значение */
+  bool is_number;
+  double number;
+  /** \brief `value` - `true` или `false` */
+  bool is_bool;
+  bool boolean;
+};
+
+/**
+ * \brief Шаг запроса: ось, имя узла или `*` и предикаты
+ * */
+struct query_step {
+  query_axis_t axis;
+  /** \brief `*` - любое имя */
+  bool wildcard;
+  std::string name;
+  uint64_t hash;
+  std::vector<query_predicate> predicates;
+};
+
+/**
+ * \brief Скомпилированный запрос к дереву ридера, см. CompileQuery
+ *
+ * Запрос, как и путь GetValueByPath, задаётся без корня: шаги
+ *   разделяются `/`(дочерние узлы) или `//`(все потомки), шаг -
+ *   имя инициализатора узла или `*`, с предикатами по параметрам
+ *   узла:
+ *
+ *   `groups/group[@name='first']`, `//parameter[@t>100]`,
+ *   `//item[@id]`, `catalog//item[@kind!="draft"][@price<=10.5]`
+ *
+ * Параметры предикатов - значения GetParameterView(текст дочернего
+ *   элемента или атрибута xml), `@` перед именем необязателен.
+ *   `=` и `!=` сравнивают текст без пробелов по краям, нестроковые
+ *   значения json - как числа и bool; `<`, `<=`, `>`, `>=` - числа,
+ *   см. GetParameterAs. Значения в кавычках `'...'` или `"..."`,
+ *   числа и bool можно без кавычек
+ * */
+class node_query {
+ public:
+  /** \brief Количество шагов */
+  size_t Size() const { return steps_.size(); }
+  const query_step& GetStep(size_t i) const { return steps_[i]; }
+  /** \brief Текст запроса */
+  const std::string& GetText() const { return text_; }
+
+ private:
+  friend merror_t CompileQuery(std::string_view text,
+                               node_query* query,
+                               ErrorWrap* ew);
+
+ private:
+  std::string text_;
+  std::vector<query_step> steps_;
+};
+
+/**
+ * \brief Скомпилировать запрос `text`, см. node_query
+ * \return ERROR_SUCCESS_T или ERROR_STR_PARSE_ST с позицией
+ *   ошибки в сообщении
+ * */
+merror_t CompileQuery(std::string_view text,
+                      node_query* query,
+                      ErrorWrap* ew);
+
+/**
+ * \brief Концепт дерева для запросов: узлы - значения `handle`,
+ *   имена узлов - записи таблицы имён, параметры - как у lib_node
+ * */
+template <class T>
+concept QueryTreeType = requires(const T& tree,
+                                 typename T::handle h,
+                                 size_t i,
+                                 const char* name,
+                                 double* d,
+                                 bool* b) {
+  { tree.Root() } -> std::same_as<typename T::handle>;
+  { tree.ChildsCount(h) } -> std::convertible_to<size_t>;
+  { tree.Child(h, i) } -> std::same_as<typename T::handle>;
+  { tree.GetKey(h) } -> std::convertible_to<const interned_name*>;
+  { tree.GetValueView(h, name) } -> std::convertible_to<std::string_view>;
+  { tree.GetValueAs(h, name, d) } -> std::convertible_to<bool>;
+  { tree.GetValueAs(h, name, b) } -> std::convertible_to<bool>;
+  tree.Get(h);
+};
+
+/** \brief Хэш числового значения для query_index */
+inline uint64_t query_number_hash(double value) {
+  // -0.0 == 0.0
+  if (value == 0.0)
+    value = 0.0;
+  return path_hash_step(name_hash("#number"),
+                        std::bit_cast<uint64_t>(value));
+}
+
+/** \brief Параметр узла `h` подходит под предикат `p` */
+template <QueryTreeType TreeT>
+bool query_predicate_test(const TreeT& tree,
+                          typename TreeT::handle h,
+                          const query_predicate& p) {
+  const char* name = p.name.c_str();
+  if (p.op == query_op_t::lt || p.op == query_op_t::le ||
+      p.op == query_op_t::gt || p.op == query_op_t::ge) {
+    double value;
+    if (!tree.GetValueAs(h, name, &value))
+      return false;
+    switch (p.op) {
+      case query_op_t::lt:
+        return value < p.number;
+      case query_op_t::le:
+        return value <= p.number;
+      case query_op_t::gt:
+        return value > p.number;
+      default:
+        return value >= p.number;
+    }
+  }
+  bool equal = false;
+  std::string_view view = trim_view(tree.GetValueView(h, name));
+  if (!view.empty()) {
+    equal = (view == p.value);
+  } else {
+    // нестроковые значения
+    double number;
+    bool boolean;
+    if (tree.GetValueAs(h, name, &number))
+      equal = p.is_number && number == p.number;
+    else if (tree.GetValueAs(h, name, &boolean))
+      equal = p.is_bool && boolean == p.boolean;
+    else
+      return false;
+  }
+  if (p.op == query_op_t::exists)
+    return true;
+  return (p.op == query_op_t::eq) ? equal : !equal;
+}
+
+/** \brief Узел `h` подходит под имя и предикаты шага `step` */
+template <QueryTreeType TreeT>
+bool query_step_test(const TreeT& tree,
+                     typename TreeT::handle h,
+                     const query_step& step) {
+  if (!step.wildcard) {
+    const interned_name* key = tree.GetKey(h);
+    if (!key || key->hash != step.hash || key->name != step.name)
+      return false;
+  }
+  for (const query_predicate& p : step.predicates) {
+    if (!query_predicate_test(tree, h, p))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * \brief Индекс узлов дерева по значению параметра
+ *
+ * Отсортированный по хэшам значений массив узлов: запрос, первый
+ *   шаг которого `//name[@parameter='value']`, перебирает только
+ *   узлы с этим значением, а не всё дерево. Индексируются узлы
+ *   с текстовым или числовым значением параметра, кроме корня
+ * \note Строится по готовому дереву и перестраивается вместе с ним
+ * */
+template <QueryTreeType TreeT>
+class query_index {
+ public:
+  typedef typename TreeT::handle handle;
+  /** \brief Узел индекса */
+  struct entry {
+    /** \brief хэш значения: name_hash текста или query_number_hash */
+    uint64_t hash;
+    /** \brief номер узла в порядке обхода в глубину */
+    uint32_t order;
+    /** \brief номер первого узла за поддеревом узла */
+    uint32_t end;
+    handle node;
+  };
+
+ public:
+  explicit query_index(std::string parameter)
+      : parameter_(std::move(parameter)) {}
+
+  /** \brief Имя индексированного параметра */
+  const std::string& GetParameter() const { return parameter_; }
+  /** \brief Количество узлов в индексе */
+  size_t Size() const { return entries_.size(); }
+  /** \brief Построить индекс по дереву `tree`, без рекурсии */
+  void Build(const TreeT& tree) {
+    entries_.clear();
+    std::vector<uint32_t> ends;
+    // узел, следующий дочерний узел, номер узла
+    struct frame {
+      handle node;
+      size_t next;
+      uint32_t order;
+    };
+    std::vector<frame> stack;
+    stack.push_back(frame{tree.Root(), 0, 0});
+    ends.push_back(0);
+    uint32_t order = 1;
+    while (!stack.empty()) {
+      frame& f = stack.back();
+      if (f.next >= tree.ChildsCount(f.node)) {
+        ends[f.order] = order;
+        stack.pop_back();
+        continue;
+      }
+      handle ch = tree.Child(f.node, f.next++);
+      uint64_t hash;
+      if (valueHash(tree, ch, &hash))
+        entries_.push_back(entry{hash, order, 0, ch});
+      ends.push_back(0);
+      stack.push_back(frame{ch, 0, order++});
+    }
+    for (entry& e : entries_)
+      e.end = ends[e.order];
+    std::sort(entries_.begin(), entries_.end(),
+              [](const entry& l, const entry& r) {
+                return (l.hash < r.hash) ||
+                       (l.hash == r.hash && l.order < r.order);
+              });
+  }
+  /** \brief Узлы с хэшем значения `hash`, в порядке обхода */
+  std::pair<const entry*, const entry*> Find(uint64_t hash) const {
+    auto first = std::lower_bound(
+        entries_.begin(), entries_.end(), hash,
+        [](const entry& e, uint64_t h) { return e.hash < h; });
+    auto last = first;
+    while (last != entries_.end() && last->hash == hash)
+      ++last;
+    return {entries_.data() + (first - entries_.begin()),
+            entries_.data() + (last - entries_.begin())};
+  }
+
+ private:
+  bool valueHash(const TreeT& tree, handle h, uint64_t* hash) const {
+    std::string_view view =
+        trim_view(tree.GetValueView(h, parameter_.c_str()));
+    double number;
+    if (!view.empty())
+      *hash = name_hash(view);
+    else if (tree.GetValueAs(h, parameter_.c_str(), &number))
+      *hash = query_number_hash(number);
+    else
+      return false;
+    return true;
+  }
+
+ private:
+  std::string parameter_;
+  std::vector<entry> entries_;
+};
+
+/**
+ * \brief Результаты запроса - ленивый обход дерева
+ *
+ * Узлы находятся по мере продвижения итератора, в порядке обхода
+ *   в глубину(порядке документа), каждый узел - один раз. Состояние
+ *   обхода - стек с маской активных шагов запроса на узел, без
+ *   рекурсии; результаты не собираются в контейнер, обход не
+ *   выделяет память, пока глубина дерева не больше
+ *   QUERY_STACK_RESERVE. Однопроходный: begin() начинает обход
+ * \note Дерево, запрос и индексы должны жить дольше результатов.
+ *   Результаты одного запроса можно обходить из разных потоков
+ *   разными объектами query_range
+ * */
+template <QueryTreeType TreeT>
+class query_range {
+  typedef typename TreeT::handle handle;
+  typedef typename query_index<TreeT>::entry index_entry;
+  /** \brief Узел на стеке обхода: шаги, которые проверяются
+   *   на его дочерних узлах(биты маски), следующий дочерний узел */
+  struct frame {
+    handle node;
+    uint64_t steps;
+    size_t next;
+  };
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = decltype(std::declval<const TreeT&>().Get(
+        std::declval<handle>()));
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+   public:
+    iterator() = default;
+    explicit iterator(query_range* range) : range_(range) {}
+
+    value_type operator*() const { return range_->tree_.Get(range_->current_); }
+    /** \brief Узел дерева текущего результата */
+    handle GetHandle() const { return range_->current_; }
+    iterator& operator++() {
+      range_->advance();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+    bool operator==(const iterator& other) const {
+      return isEnd() == other.isEnd();
+    }
+
+   private:
+    bool isEnd() const { return !range_ || range_->done_; }
+
+   private:
+    query_range* range_ = nullptr;
+  };
+
+ public:
+  /**
+   * \param indexes индексы параметров дерева, nullptr - без них.
+   *   Индекс используется, если первый шаг запроса - поиск
+   *   потомков с предикатом `=` по индексированному параметру
+   * */
+  query_range(const TreeT& tree,
+              const node_query& query,
+              const std::vector<query_index<TreeT>>* indexes = nullptr)
+      : tree_(tree), query_(&query) {
+    if (query.Size() && indexes)
+      selectIndex(*indexes);
+  }
+
+  iterator begin() {
+    if (!started_) {
+      started_ = true;
+      stack_.reserve(QUERY_STACK_RESERVE);
+      if (!query_->Size()) {
+        done_ = true;
+      } else {
+        if (!indexed_)
+          stack_.push_back(frame{tree_.Root(), 1, 0});
+        advance();
+      }
+    }
+    return iterator(this);
+  }
+  iterator end() { return iterator(); }
+  /** \brief Запрос использует индекс параметра */
+  bool IsIndexed() const { return indexed_; }
+
+ private:
+  /** \brief Найти следующий результат */
+  void advance() {
+    const size_t last = query_->Size() - 1;
+    for (;;) {
+      if (stack_.empty()) {
+        bool result = false;
+        if (!indexed_ || !nextCandidate(&result)) {
+          done_ = true;
+          return;
+        }
+        if (result)
+          return;
+        continue;
+      }
+      frame& f = stack_.back();
+      if (f.next >= tree_.ChildsCount(f.node)) {
+        stack_.pop_back();
+        continue;
+      }
+      handle ch = tree_.Child(f.node, f.next++);
+      uint64_t steps = 0;
+      bool matched = false;
+      for (uint64_t mask = f.steps; mask; mask &= mask - 1) {
+        size_t s = static_cast<size_t>(std::countr_zero(mask));
+        const query_step& step = query_->GetStep(s);
+        if (step.axis == query_axis_t::descendant)
+          steps |= uint64_t(1) << s;
+        if (query_step_test(tree_, ch, step)) {
+          if (s == last)
+            matched = true;
+          else
+            steps |= uint64_t(1) << (s + 1);
+        }
+      }
+      // `f` невалиден после push_back
+      if (steps)
+        stack_.push_back(frame{ch, steps, 0});
+      if (matched) {
+        current_ = ch;
+        return;
+      }
+    }
+  }
+  /** \brief Взять следующий узел индекса, подходящий под первый
+   *   шаг: он результат или его поддерево обходится остальными
+   *   шагами
+   * \param result out-параметр, узел - результат запроса
+   * \return false если узлы индекса кончились */
+  bool nextCandidate(bool* result) {
+    const query_step& first = query_->GetStep(0);
+    for (;;) {
+      const index_entry* e;
+      if (text_.first != text_.second &&
+          (number_.first == number_.second ||
+           text_.first->order < number_.first->order)) {
+        e = text_.first++;
+      } else if (number_.first != number_.second) {
+        e = number_.first++;
+      } else {
+        return false;
+      }
+      // поддерево уже обошли с предыдущим узлом
+      if (e->order < skip_end_ || !query_step_test(tree_, e->node, first))
+        continue;
+      if (query_->Size() == 1) {
+        current_ = e->node;
+        *result = true;
+      } else {
+        // дочерние узлы проверяются вторым шагом и, как потомки,
+        //   первым
+        skip_end_ = e->end;
+        stack_.push_back(frame{e->node, 3, 0});
+      }
+      return true;
+    }
+  }
+  /** \brief Выбрать индекс по предикатам первого шага */
+  void selectIndex(const std::vector<query_index<TreeT>>& indexes) {
+    const query_step& first = query_->GetStep(0);
+    if (first.axis != query_axis_t::descendant)
+      return;
+    for (const query_predicate& p : first.predicates) {
+      if (p.op != query_op_t::eq)
+        continue;
+      for (const auto& index : indexes) {
+        if (index.GetParameter() != p.name)
+          continue;
+        uint64_t hash = name_hash(p.value);
+        text_ = index.Find(hash);
+        if (p.is_number && query_number_hash(p.number) != hash)
+          number_ = index.Find(query_number_hash(p.number));
+        indexed_ = true;
+        return;
+      }
+    }
+  }
+
+ private:
+  TreeT tree_;
+  const node_query* query_;
+  std::vector<frame> stack_;
+  handle current_{};
+  bool started_ = false;
+  bool done_ = false;
+  bool indexed_ = false;
+  /** \brief узлы индекса с текстовым и числовым значением */
+  std::pair<const index_entry*, const index_entry*> text_{nullptr, nullptr};
+  std::pair<const index_entry*, const index_entry*> number_{nullptr,
+                                                            nullptr};
+  /** \brief номер первого узла за обойдённым поддеревом */
+  uint32_t skip_end_ = 0;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__QUERY_H
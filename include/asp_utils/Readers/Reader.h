@@ -9,12 +9,25 @@
 #ifndef UTILS__READER_H
 #define UTILS__READER_H
 
+#include "asp_utils/Arena.h"
 #include "asp_utils/Base.h"
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
+#include "asp_utils/FileBuffer.h"
 #include "asp_utils/FileURL.h"
 #include "asp_utils/Logging.h"
+#include "asp_utils/ThreadPool.h"
+#include "asp_utils/ThreadWrap.h"
+#include "asp_utils/Readers/ChildIndex.h"
 #include "asp_utils/Readers/INode.h"
+#include "asp_utils/Readers/JSONTape.h"
+#include "asp_utils/Readers/MsgPack.h"
+#include "asp_utils/Readers/NameInterner.h"
+#include "asp_utils/Readers/PathHandle.h"
+#include "asp_utils/Readers/Query.h"
+#include "asp_utils/Readers/ReaderOptions.h"
+#include "asp_utils/Readers/Snapshot.h"
+#include "asp_utils/Readers/TreeTraversal.h"
 #ifdef WITH_PUGIXML
 #include "pugixml.hpp"
 #endif  // WITH_PUGIXML
@@ -24,9 +37,18 @@
 #include "rapidjson/error/en.h"
 #endif  // WITH_RAPIDJSON
 
+#include <algorithm>
+#include <cstdio>
+#include <deque>
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <string.h>
@@ -46,6 +68,28 @@ struct lib_node {
   NodeT* GetNodePointer() { return nullptr; }
   NodeT* GetChild(const char*) { return nullptr; }
   std::string GetName() { return ""; }
+  /**
+   * \brief Строковое значение параметра `name` без копирования,
+   *   указывает в память документа
+   * \note Имя - string_view: frozen_reader_sample ищет параметры
+   *   по именам скомпилированных путей, не оканчивающимся нулём
+   **/
+  std::string_view GetValueView(std::string_view) const { return {}; }
+  /**
+   * \brief Обойти дочерние узлы документа(для записи снимка,
+   *   см. WriteSnapshot): `f(name, value, child)`, где child -
+   *   указатель на lib_node дочернего узла или nullptr для листа
+   * \note Необязательный метод, без него снимок не записывается
+   **/
+  // template <class F> void ForEachChild(F&& f);
+  /**
+   * \brief Типизированное значение параметра `name` из собственного
+   *   представления библиотеки(например, числа RapidJSON)
+   * \note Необязательный метод, без него значение разбирается
+   *   из GetValueView, см. lib_value_as
+   **/
+  // template <class T>
+  // bool GetValueAs(std::string_view name, T* out) const;
   static bool IsInitialized(const NodeT&) { return false; }
   /**
    * \brief Инициализировать root узел
@@ -54,12 +98,14 @@ struct lib_node {
    * \param size_t Длина считанного буффера памяти
    * \param std::string * out-параметр - имя корневого узла
    * \param ErrorWrap * указатель на объект состояния ошибки
+   * \param reader_options & настройки разбора документа
    **/
   static NodeT InitDocumentRoot(NodeDocType*,
                                 char*,
                                 size_t,
                                 std::string*,
-                                ErrorWrap*) {
+                                ErrorWrap*,
+                                const reader_options&) {
     return NodeT();
   }
 };
@@ -79,6 +125,35 @@ struct lib_node<pugi::xml_node> {
   }
 
   pugi::xml_node GetChild(const char* name) { return data.child(name); }
+  /** \brief Текст подузла `name`, а если такого подузла нет -
+   *   значение атрибута `name` */
+  std::string_view GetValueView(const char* name) const {
+    pugi::xml_node ch = data.child(name);
+    return (!ch.empty()) ? ch.child_value() : data.attribute(name).value();
+  }
+  std::string_view GetValueView(std::string_view name) const {
+    for (pugi::xml_node ch : data.children())
+      if (name == ch.name())
+        return ch.child_value();
+    for (pugi::xml_attribute a : data.attributes())
+      if (name == a.name())
+        return a.value();
+    return {};
+  }
+
+  /** \brief Атрибуты - листья, подэлементы - узлы со значением-текстом */
+  template <class F>
+  void ForEachChild(F&& f) {
+    for (pugi::xml_attribute a : data.attributes())
+      f(std::string_view(a.name()), std::string_view(a.value()), nullptr);
+    for (pugi::xml_node ch : data.children()) {
+      if (ch.type() != pugi::node_element)
+        continue;
+      lib_node child(ch);
+      f(std::string_view(ch.name()), std::string_view(ch.child_value()),
+        &child);
+    }
+  }
 
   static bool IsInitialized(const pugi::xml_node& xn) { return !xn.empty(); }
 
@@ -86,7 +161,8 @@ struct lib_node<pugi::xml_node> {
                                          char* memory,
                                          size_t len,
                                          std::string* root_name,
-                                         ErrorWrap* ew) {
+                                         ErrorWrap* ew,
+                                         const reader_options&) {
     pugi::xml_parse_result res = doc->load_buffer_inplace(memory, len);
     if (!res) {
       ew->SetError(ERROR_PARSER_FORMAT_ST,
@@ -125,38 +201,657 @@ struct lib_node<rjNValue> {
     return (ch != data->MemberEnd()) ? &ch->value : nullptr;
   }
 
+  /** \brief Значение строкового параметра `name`, для
+   *   `reader_options::parse_insitu` указывает в буффер ридера */
+  std::string_view GetValueView(const char* name) const {
+    return valueView(data->FindMember(name));
+  }
+  std::string_view GetValueView(std::string_view name) const {
+    return valueView(findMember(name));
+  }
+  /** \brief Значение параметра `name`: числа и bool - без разбора
+   *   строки, с проверкой диапазона типа T, строки - str_to_value */
+  template <class T>
+  bool GetValueAs(std::string_view name, T* out) const {
+    auto ch = findMember(name);
+    if (ch == data->MemberEnd())
+      return false;
+    const rjNValue& v = ch->value;
+    if (v.IsString())
+      return str_to_value(
+          trim_view(std::string_view(v.GetString(), v.GetStringLength())),
+          out);
+    if constexpr (std::is_same_v<T, bool>) {
+      if (!v.IsBool())
+        return false;
+      *out = v.GetBool();
+      return true;
+    } else if constexpr (std::is_enum_v<T>) {
+      std::underlying_type_t<T> value;
+      if (!GetValueAs(name, &value))
+        return false;
+      *out = static_cast<T>(value);
+      return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+      if (!v.IsNumber())
+        return false;
+      *out = static_cast<T>(v.GetDouble());
+      return true;
+    } else {
+      if (v.IsInt64() && std::in_range<T>(v.GetInt64())) {
+        *out = static_cast<T>(v.GetInt64());
+        return true;
+      }
+      if (v.IsUint64() && std::in_range<T>(v.GetUint64())) {
+        *out = static_cast<T>(v.GetUint64());
+        return true;
+      }
+      return false;
+    }
+  }
+
+  /** \brief Объекты - узлы, скаляры - листья со строковым
+   *   представлением значения. Элементы массива - узлы или листья
+   *   с именем массива, вложенные массивы пропускаются. Для узла-
+   *   массива обходятся его элементы, с пустыми именами */
+  template <class F>
+  void ForEachChild(F&& f) {
+    if (data->IsArray()) {
+      for (auto v = data->Begin(); v != data->End(); ++v)
+        forValue(std::string_view(), *v, f);
+      return;
+    }
+    if (!data->IsObject())
+      return;
+    for (auto m = data->MemberBegin(); m != data->MemberEnd(); ++m) {
+      std::string_view name(m->name.GetString(), m->name.GetStringLength());
+      if (m->value.IsArray()) {
+        for (auto v = m->value.Begin(); v != m->value.End(); ++v)
+          forValue(name, *v, f);
+      } else {
+        forValue(name, m->value, f);
+      }
+    }
+  }
+
   static bool IsInitialized(const rjNValue* xn) { return xn != nullptr; }
 
   static rjNValue* InitDocumentRoot(rjNDocument* doc,
                                     char* memory,
-                                    size_t,
+                                    size_t len,
                                     std::string* root_name,
-                                    ErrorWrap* ew) {
-    doc->Parse(memory);
-    if (!doc->HasParseError()) {
-      if (doc->IsObject()) {
-        auto root = doc->MemberBegin();
-        if (root != doc->MemberEnd()) {
-          *root_name = root->name.GetString();
-          return &root->value;
-        }
-      } else {
-        ew->SetError(ERROR_PARSER_PARSE_ST,
-                     "ошибка инициализации "
-                     "корневого элемента json файла ");
-      }
+                                    ErrorWrap* ew,
+                                    const reader_options& options) {
+    if (options.parse_insitu) {
+      doc->ParseInsitu(memory);
+    } else {
+      doc->Parse(memory, len);
     }
-    ew->SetError(ERROR_PARSER_FORMAT_ST,
-                 std::string("RapidJSON parse error: ") +
-                     std::string(rj::GetParseError_En(doc->GetParseError())));
-    return nullptr;
+    if (doc->HasParseError()) {
+      ew->SetError(ERROR_PARSER_FORMAT_ST,
+                   std::string("RapidJSON parse error: ") +
+                       std::string(rj::GetParseError_En(doc->GetParseError())));
+      return nullptr;
+    }
+    // рут - первый член объекта документа
+    if (!doc->IsObject() || doc->MemberBegin() == doc->MemberEnd()) {
+      ew->SetError(ERROR_PARSER_PARSE_ST,
+                   "ошибка инициализации "
+                   "корневого элемента json файла ");
+      return nullptr;
+    }
+    auto root = doc->MemberBegin();
+    *root_name = root->name.GetString();
+    return &root->value;
   }
 
  public:
   rjNValue* data = nullptr;
+
+ private:
+  /** \brief Поиск параметра: ключ - ссылка на строку, без копирования */
+  rjNValue::MemberIterator findMember(std::string_view name) const {
+    rjNValue key(rj::StringRef(name.data(), name.size()));
+    return data->FindMember(key);
+  }
+  template <class MemberIt>
+  std::string_view valueView(MemberIt ch) const {
+    if (ch != data->MemberEnd() && ch->value.IsString())
+      return std::string_view(ch->value.GetString(),
+                              ch->value.GetStringLength());
+    return {};
+  }
+  template <class F>
+  static void forValue(std::string_view name, rjNValue& v, F& f) {
+    if (v.IsObject()) {
+      lib_node child(&v);
+      f(name, std::string_view(), &child);
+    } else if (v.IsString()) {
+      f(name, std::string_view(v.GetString(), v.GetStringLength()), nullptr);
+    } else if (v.IsBool()) {
+      f(name, std::string_view(v.GetBool() ? "true" : "false"), nullptr);
+    } else if (v.IsInt64()) {
+      f(name, std::string_view(std::to_string(v.GetInt64())), nullptr);
+    } else if (v.IsUint64()) {
+      f(name, std::string_view(std::to_string(v.GetUint64())), nullptr);
+    } else if (v.IsNumber()) {
+      char buf[32];
+      int n = snprintf(buf, sizeof(buf), "%.17g", v.GetDouble());
+      f(name, std::string_view(buf, n), nullptr);
+    } else if (v.IsNull()) {
+      f(name, std::string_view(), nullptr);
+    }
+  }
 };
 #endif  // WITH_RAPIDJSON
 
+/** \brief Представление узла бинарного снимка документа,
+ *   см. Snapshot.h. Документ не разбирается - проверяется только
+ *   заголовок, узлы читаются из буффера(отображённого файла)
+ *   по мере обращения к ним */
+template <>
+struct lib_node<snapshot_node> {
+  using NodeDocType = snapshot_document;
+
+ public:
+  lib_node() {}
+  lib_node(snapshot_node sn) : data(sn) {}
+
+  snapshot_node* GetNodePointer() { return data.IsValid() ? &data : nullptr; }
+  snapshot_node GetChild(const char* name) {
+    return data.GetChild(std::string_view(name));
+  }
+  std::string_view GetValueView(std::string_view name) const {
+    return data.GetChild(name).GetValue();
+  }
+  template <class F>
+  void ForEachChild(F&& f) {
+    for (size_t i = 0; i < data.GetChildsCount(); ++i) {
+      lib_node child(data.GetChild(i));
+      f(child.data.GetName(), child.data.GetValue(), &child);
+    }
+  }
+
+  static bool IsInitialized(const snapshot_node& sn) { return sn.IsValid(); }
+
+  static snapshot_node InitDocumentRoot(snapshot_document* doc,
+                                        char* memory,
+                                        size_t len,
+                                        std::string* root_name,
+                                        ErrorWrap* ew,
+                                        const reader_options&) {
+    if (OpenSnapshot(memory, len, doc, ew))
+      return snapshot_node();
+    snapshot_node root(doc, 0);
+    *root_name = root.GetName();
+    return root;
+  }
+
+ public:
+  snapshot_node data;
+};
+
+/** \brief Представление узла json встроенного разборщика JSONTape,
+ *   см. ParseJSONTape. Значения, имена и обход дочерних узлов те же,
+ *   что у lib_node<rjNValue>; строки раскрываются в буффере ридера,
+ *   как для `reader_options::parse_insitu` */
+template <>
+struct lib_node<json_tape_node> {
+  using NodeDocType = json_tape_document;
+
+ public:
+  lib_node() {}
+  lib_node(json_tape_node jn) : data(jn) {}
+
+  json_tape_node* GetNodePointer() {
+    return data.IsValid() ? &data : nullptr;
+  }
+  json_tape_node GetChild(const char* name) {
+    return data.GetChild(std::string_view(name));
+  }
+  std::string_view GetValueView(std::string_view name) const {
+    json_tape_node ch = data.GetChild(name);
+    return (ch.IsValid() && ch.IsString()) ? ch.GetValue()
+                                           : std::string_view();
+  }
+  /** \brief Значение параметра `name`, числа разбираются из
+   *   исходного текста, см. lib_node<rjNValue>::GetValueAs */
+  template <class T>
+  bool GetValueAs(std::string_view name, T* out) const {
+    json_tape_node v = data.GetChild(name);
+    if (!v.IsValid())
+      return false;
+    if (v.IsString())
+      return str_to_value(trim_view(v.GetValue()), out);
+    if constexpr (std::is_same_v<T, bool>) {
+      if (!v.IsBool())
+        return false;
+      *out = v.GetBool();
+      return true;
+    } else if constexpr (std::is_enum_v<T>) {
+      std::underlying_type_t<T> value;
+      if (!GetValueAs(name, &value))
+        return false;
+      *out = static_cast<T>(value);
+      return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+      double value;
+      if (!v.GetDouble(&value))
+        return false;
+      *out = static_cast<T>(value);
+      return true;
+    } else {
+      int64_t i;
+      if (v.GetInt64(&i) && std::in_range<T>(i)) {
+        *out = static_cast<T>(i);
+        return true;
+      }
+      uint64_t u;
+      if (v.GetUint64(&u) && std::in_range<T>(u)) {
+        *out = static_cast<T>(u);
+        return true;
+      }
+      return false;
+    }
+  }
+
+  /** \brief См. lib_node<rjNValue>::ForEachChild */
+  template <class F>
+  void ForEachChild(F&& f) {
+    if (data.IsArray()) {
+      data.ForEachChild([&f](const json_tape_node& v) {
+        forValue(std::string_view(), v, f);
+      });
+      return;
+    }
+    if (!data.IsObject())
+      return;
+    data.ForEachChild([&f](const json_tape_node& m) {
+      if (m.IsArray()) {
+        std::string_view name = m.GetName();
+        m.ForEachChild(
+            [&f, name](const json_tape_node& v) { forValue(name, v, f); });
+      } else {
+        forValue(m.GetName(), m, f);
+      }
+    });
+  }
+
+  static bool IsInitialized(const json_tape_node& jn) { return jn.IsValid(); }
+
+  static json_tape_node InitDocumentRoot(json_tape_document* doc,
+                                         char* memory,
+                                         size_t len,
+                                         std::string* root_name,
+                                         ErrorWrap* ew,
+                                         const reader_options&) {
+    if (ParseJSONTape(memory, len, doc, ew))
+      return json_tape_node();
+    json_tape_node root(doc, 0), first;
+    if (root.IsObject()) {
+      root.ForEachChild([&first](const json_tape_node& m) {
+        if (!first.IsValid())
+          first = m;
+      });
+    }
+    if (!first.IsValid()) {
+      ew->SetError(ERROR_PARSER_PARSE_ST,
+                   "ошибка инициализации "
+                   "корневого элемента json файла ");
+      return json_tape_node();
+    }
+    *root_name = first.GetName();
+    return first;
+  }
+
+ public:
+  json_tape_node data;
+
+ private:
+  template <class F>
+  static void forValue(std::string_view name, const json_tape_node& v, F& f) {
+    if (v.IsObject()) {
+      lib_node child(v);
+      f(name, std::string_view(), &child);
+    } else if (v.IsString()) {
+      f(name, v.GetValue(), nullptr);
+    } else if (v.IsBool()) {
+      f(name, std::string_view(v.GetBool() ? "true" : "false"), nullptr);
+    } else if (v.IsNumber()) {
+      int64_t i;
+      uint64_t u;
+      double d;
+      // текст целого json совпадает с std::to_string, кроме `-0`
+      if (v.GetInt64(&i) || v.GetUint64(&u)) {
+        if (v.GetValue() != "-0")
+          f(name, v.GetValue(), nullptr);
+        else
+          f(name, std::string_view("0"), nullptr);
+      } else if (v.GetDouble(&d)) {
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), "%.17g", d);
+        f(name, std::string_view(buf, n), nullptr);
+      }
+    } else if (v.IsNull()) {
+      f(name, std::string_view(), nullptr);
+    }
+  }
+};
+
+/** \brief Представление узла бинарного документа MessagePack,
+ *   см. ParseMsgPack. Имена и обход дочерних узлов те же, что
+ *   у lib_node<json_tape_node>; числа читаются без разбора текста */
+template <>
+struct lib_node<msgpack_node> {
+  using NodeDocType = msgpack_document;
+
+ public:
+  lib_node() {}
+  lib_node(msgpack_node mn) : data(mn) {}
+
+  msgpack_node* GetNodePointer() { return data.IsValid() ? &data : nullptr; }
+  msgpack_node GetChild(const char* name) {
+    return data.GetChild(std::string_view(name));
+  }
+  std::string_view GetValueView(std::string_view name) const {
+    msgpack_node ch = data.GetChild(name);
+    return ch.IsValid() ? ch.GetString() : std::string_view();
+  }
+  /** \brief Значение параметра `name`: числа и bool - двоичные
+   *   значения документа, строки разбираются */
+  template <class T>
+  bool GetValueAs(std::string_view name, T* out) const {
+    msgpack_node v = data.GetChild(name);
+    if (!v.IsValid())
+      return false;
+    if (v.IsString())
+      return str_to_value(trim_view(v.GetString()), out);
+    if constexpr (std::is_same_v<T, bool>) {
+      if (!v.IsBool())
+        return false;
+      *out = v.GetBool();
+      return true;
+    } else if constexpr (std::is_enum_v<T>) {
+      std::underlying_type_t<T> value;
+      if (!GetValueAs(name, &value))
+        return false;
+      *out = static_cast<T>(value);
+      return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+      double value;
+      if (!v.GetDouble(&value))
+        return false;
+      *out = static_cast<T>(value);
+      return true;
+    } else {
+      int64_t i;
+      if (v.GetInt64(&i) && std::in_range<T>(i)) {
+        *out = static_cast<T>(i);
+        return true;
+      }
+      uint64_t u;
+      if (v.GetUint64(&u) && std::in_range<T>(u)) {
+        *out = static_cast<T>(u);
+        return true;
+      }
+      return false;
+    }
+  }
+
+  /** \brief См. lib_node<rjNValue>::ForEachChild */
+  template <class F>
+  void ForEachChild(F&& f) {
+    if (data.IsArray()) {
+      data.ForEachChild(
+          [&f](const msgpack_node& v) { forValue(std::string_view(), v, f); });
+      return;
+    }
+    if (!data.IsMap())
+      return;
+    data.ForEachChild([&f](const msgpack_node& m) {
+      if (m.IsArray()) {
+        std::string_view name = m.GetName();
+        m.ForEachChild(
+            [&f, name](const msgpack_node& v) { forValue(name, v, f); });
+      } else {
+        forValue(m.GetName(), m, f);
+      }
+    });
+  }
+
+  static bool IsInitialized(const msgpack_node& mn) { return mn.IsValid(); }
+
+  static msgpack_node InitDocumentRoot(msgpack_document* doc,
+                                       char* memory,
+                                       size_t len,
+                                       std::string* root_name,
+                                       ErrorWrap* ew,
+                                       const reader_options&) {
+    if (ParseMsgPack(memory, len, doc, ew))
+      return msgpack_node();
+    msgpack_node root(doc, 0), first;
+    if (root.IsMap()) {
+      root.ForEachChild([&first](const msgpack_node& m) {
+        if (!first.IsValid())
+          first = m;
+      });
+    }
+    if (!first.IsValid()) {
+      ew->SetError(ERROR_PARSER_PARSE_ST,
+                   "ошибка инициализации "
+                   "корневого элемента msgpack файла ");
+      return msgpack_node();
+    }
+    *root_name = first.GetName();
+    return first;
+  }
+
+ public:
+  msgpack_node data;
+
+ private:
+  /** \brief Значение в текстовом виде, как в json */
+  template <class F>
+  static void forValue(std::string_view name, const msgpack_node& v, F& f) {
+    if (v.IsMap()) {
+      lib_node child(v);
+      f(name, std::string_view(), &child);
+    } else if (v.IsString()) {
+      f(name, v.GetString(), nullptr);
+    } else if (v.IsBool()) {
+      f(name, std::string_view(v.GetBool() ? "true" : "false"), nullptr);
+    } else if (v.IsNumber()) {
+      char buf[32];
+      int64_t i;
+      uint64_t u;
+      double d;
+      int n = 0;
+      if (v.GetInt64(&i))
+        n = snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(i));
+      else if (v.GetUint64(&u))
+        n = snprintf(buf, sizeof(buf), "%llu",
+                     static_cast<unsigned long long>(u));
+      else if (v.GetDouble(&d))
+        n = snprintf(buf, sizeof(buf), "%.17g", d);
+      f(name, std::string_view(buf, n), nullptr);
+    } else if (v.IsNull()) {
+      f(name, std::string_view(), nullptr);
+    }
+  }
+};
+
+/** \brief Типизированное значение параметра `name` узла `node`:
+ *   lib_node::GetValueAs, если он есть, иначе разбор строкового
+ *   значения без пробелов по краям(пробелы текста xml) */
+template <class NodeT, class T>
+bool lib_value_as(const lib_node<NodeT>& node,
+                  std::string_view name,
+                  T* out) {
+  if constexpr (requires { node.GetValueAs(name, out); }) {
+    return node.GetValueAs(name, out);
+  } else {
+    return str_to_value(trim_view(node.GetValueView(name)), out);
+  }
+}
+
+/** \brief Представление узла поддерживает обход дочерних узлов,
+ *   см. lib_node::ForEachChild */
+template <class NodeT>
+concept ChildsTraversableType = requires(lib_node<NodeT> n) {
+  n.ForEachChild(
+      [](std::string_view, std::string_view, lib_node<NodeT>*) {});
+};
+
+/** \brief Записать документ с корнем `root` в бинарный снимок `path`
+ * \param source описание исходного файла, см. GetSnapshotSource */
+template <class NodeT>
+merror_t WriteSnapshot(const fs::path& path,
+                       lib_node<NodeT> root,
+                       const std::string& root_name,
+                       const snapshot_source& source,
+                       ErrorWrap* ew) {
+  snapshot_builder builder;
+  // обход в ширину: дочерние узлы каждого узла записываются подряд,
+  //   индекс в очереди совпадает с индексом узла снимка
+  std::vector<std::pair<lib_node<NodeT>, bool>> queue;
+  queue.emplace_back(root, true);
+  builder.AddNode(root_name, std::string_view());
+  for (size_t i = 0; i < queue.size(); ++i) {
+    if (!queue[i].second)
+      continue;
+    uint32_t first = builder.Size();
+    lib_node<NodeT> node = queue[i].first;
+    node.ForEachChild([&builder, &queue](std::string_view name,
+                                         std::string_view value,
+                                         lib_node<NodeT>* child) {
+      builder.AddNode(name, value);
+      if (child)
+        queue.emplace_back(*child, true);
+      else
+        queue.emplace_back(lib_node<NodeT>(), false);
+    });
+    builder.SetChilds(static_cast<uint32_t>(i), first, builder.Size() - first);
+  }
+  return builder.Write(path, source, ew);
+}
+
+/** \brief Узел с дочерними узлами для WriteMsgPack */
+template <class NodeT>
+void write_msgpack_node(lib_node<NodeT>& node, msgpack_writer* w) {
+  uint32_t size = 0;
+  node.ForEachChild([&size](std::string_view, std::string_view,
+                            lib_node<NodeT>*) { ++size; });
+  w->Map(size);
+  node.ForEachChild([w](std::string_view name, std::string_view value,
+                        lib_node<NodeT>* child) {
+    w->String(name);
+    bool childs = false;
+    if (child) {
+      child->ForEachChild([&childs](std::string_view, std::string_view,
+                                    lib_node<NodeT>*) { childs = true; });
+    }
+    // узел без дочерних узлов и без значения - контейнер(пустой
+    //   объект json, пустой элемент xml), записывается пустым map
+    if (childs || (child && value.empty()))
+      write_msgpack_node(*child, w);
+    else
+      w->String(value);
+  });
+}
+
+/**
+ * \brief Записать документ с корнем `root` в MessagePack: map
+ *   из одного члена `root_name`
+ *
+ * Узлы с дочерними узлами или без значения(пустые объекты)
+ *   записываются map, остальные - строками значений, элементы
+ *   массивов и повторяющиеся имена - повторяющимися ключами(так
+ *   обход дочерних узлов прочитанного документа совпадает с обходом
+ *   исходного). Подходит для xml, где значения - текст; json
+ *   с типами значений переводится JSONToMsgPack
+ * \note Текст узлов с дочерними узлами не записывается
+ * */
+template <class NodeT>
+void WriteMsgPack(lib_node<NodeT> root,
+                  const std::string& root_name,
+                  std::string* out) {
+  static_assert(ChildsTraversableType<NodeT>,
+                "msgpack: requires lib_node::ForEachChild");
+  out->clear();
+  msgpack_writer w(out);
+  w.Map(1);
+  w.String(root_name);
+  write_msgpack_node(root, &w);
+}
+
+/**
+ * \brief Разобрать документ в буффере `memory` парсером библиотеки
+ *   NodeT и записать его в MessagePack, см. WriteMsgPack
+ * */
+template <class NodeT>
+merror_t ConvertToMsgPack(char* memory,
+                          size_t len,
+                          std::string* out,
+                          ErrorWrap* ew,
+                          const reader_options& options = reader_options()) {
+  typename lib_node<NodeT>::NodeDocType document;
+  std::string root_name;
+  auto root = lib_node<NodeT>::InitDocumentRoot(&document, memory, len,
+                                                &root_name, ew, options);
+  if (!ew->GetErrorCode())
+    WriteMsgPack(lib_node<NodeT>(root), root_name, out);
+  return ew->GetErrorCode();
+}
+
+/** \brief Общие настройки и ресурсы узлов дерева node_sample
+ * \note Принадлежат ридеру и должны жить дольше дерева */
+struct node_context {
+  /** \brief см. reader_options::lazy_init */
+  bool lazy = false;
+  /** \brief пул параллельной инициализации, nullptr - без неё */
+  ThreadPool* pool = nullptr;
+  /** \brief см. reader_options::parallel_threshold */
+  size_t parallel_threshold = PARALLEL_INIT_THRESHOLD;
+  /** \brief мьютекс вызовов фабрики из рабочих потоков и при
+   *   ленивой инициализации */
+  Mutex factory_mutex;
+  /** \brief мьютекс значений, запомненных node_sample::GetParameterAs */
+  SharedMutex memo_mutex;
+  /** \brief см. reader_options::reloadable */
+  bool hashes = false;
+  /** \brief документ, загруженный ReaderSample::Reload, из которого
+   *   создаются новые узлы; nullptr - документ самого ридера */
+  std::shared_ptr<const void> document;
+  /** \brief таблица имён узлов дерева */
+  NameInterner names;
+  /** \brief Арена инициализаторов одного потока */
+  struct initializer_arena {
+    Arena arena;
+    Mutex mutex;
+  };
+  /** \brief арены инициализаторов фабрики с ArenaFactoryType:
+   *   [0] - потока, строящего дерево, [i + 1] - рабочего потока i
+   *   пула; пусто - инициализаторы создаются в куче
+   * \note Мьютекс арены блокируется только при ленивой
+   *   инициализации - дочерние элементы тогда создаются из любых
+   *   потоков, читающих дерево */
+  std::vector<initializer_arena> arenas;
+
+  /** \brief Индекс рабочего потока пула ридера, в котором выполняется
+   *   вызов, npos - поток не из пула ридера(в том числе рабочий
+   *   поток другого пула, например BatchLoader) */
+  size_t GetWorker() const {
+    return pool ? pool->GetCurrentWorker() : ThreadPool::npos;
+  }
+  /** \brief Арена инициализаторов текущего потока */
+  initializer_arena& GetArena() {
+    size_t worker = GetWorker();
+    return (worker != ThreadPool::npos && worker + 1 < arenas.size())
+               ? arenas[worker + 1]
+               : arenas[0];
+  }
+};
+
 // class node_sample
 /** \brief Шаблон класса дерева файла, стандартная обёртка
  *   над инициализируемой нодой
@@ -167,7 +862,7 @@ template <class NodeT,
           class Initializer,
           class InitializerFactory,
           class = typename std::enable_if<
-              std::is_base_of<INodeInitializer, Initializer>::value>::type>
+              NodeInitializerType<Initializer>>::type>
 class node_sample : public BaseObject {
   typedef node_sample<NodeT, Initializer, InitializerFactory> node;
   /** \brief умный указатель на имплементацию node */
@@ -175,6 +870,10 @@ class node_sample : public BaseObject {
   /** \brief вектор указателей на дочерние элементы */
   typedef std::vector<node_ptr> childs_vec;
 
+ public:
+  /** \brief константный итератор дочерних элементов */
+  typedef childs_const_iterator<node> const_iterator;
+
  public:
   /** \brief Добавить ноду к списку инициализированных(если можно)
    *   вытащив её параметры, в зависимости от типа ноды засунуть их
@@ -184,11 +883,20 @@ class node_sample : public BaseObject {
    *   данными из src
    * \note Здесь надо вытащить имя(тип) ноды и прокинуть его
    *   в класс node_t, чтобы тонкости реализации выполнял он
-   *   Ну и пока не ясно что делать с иерархичностью */
+   *   Ну и пока не ясно что делать с иерархичностью
+   * \param ctx общие настройки узлов дерева, nullptr - по умолчанию,
+   *   узел заводит свой контекст для своего поддерева */
   node_sample(lib_node<NodeT> src,
               InitializerFactory* factory,
-              const std::string& name)
-      : BaseObject(STATUS_DEFAULT), node_(src), name_(name), factory(factory) {
+              const std::string& name,
+              node_context* ctx = nullptr)
+      : BaseObject(STATUS_DEFAULT), node_(src), ctx_(ctx), factory(factory) {
+    if (!ctx_) {
+      own_ctx_ = std::unique_ptr<node_context>(new node_context());
+      ctx_ = own_ctx_.get();
+    }
+    name_ = &ctx_->names.Intern(name);
+    doc_ = ctx_->document;
     init();
   }
 
@@ -196,56 +904,247 @@ class node_sample : public BaseObject {
    * \note about `factory->template GetNodeInitializer<NodeT>()`
    * See C++'03 Standard 14.2/4 or StackOverflow */
   void init() {
-    if (factory) {
-      node_data_ptr = std::unique_ptr<Initializer>(
-          factory->template GetNodeInitializer<NodeT>());
-      if (!node_data_ptr) {
-        error_.SetError(ERROR_GENERAL_T, "Ошибка использования фабрики узлов");
-        return;
-      }
-    } else {
-      node_data_ptr = std::unique_ptr<Initializer>(new Initializer());
-    }
+    node_data_ptr = newInitializer();
+    if (!node_data_ptr)
+      return;
     // инициализировать шаблон-параметр node_data_ptr и
     //   дочерние элементы(в глубину обойти)
     initData();
-    child_it = childs.begin();
+    child_pos = 0;
   }
 
-  /** \brief Проверить наличие дочерних элементов ноды */
-  NodeT* NextChild() {
-    return (child_it != childs.end()) ? child_it++->get() : nullptr;
+  /** \brief Следующий дочерний элемент ноды, nullptr после последнего
+   * \deprecated Позиция обхода хранится в узле: обход изменяет узел
+   *   и не потокобезопасен. Используйте константные begin()/end()
+   *   или DepthFirst/BreadthFirst */
+  node* NextChild() {
+    ensureChilds();
+    return (child_pos < childs.size()) ? childs[child_pos++].get() : nullptr;
+  }
+  /** \brief Константный обход дочерних элементов:
+   *   `for (const auto& ch : node)`, см. также DepthFirst
+   * \note Не изменяет узел, в ленивом режиме инициализирует
+   *   дочерние элементы как GetChilds */
+  const_iterator begin() const {
+    ensureChilds();
+    return const_iterator(childs.cbegin());
   }
-  /** \brief Поиск по дочерним элементам */
+  const_iterator end() const {
+    ensureChilds();
+    return const_iterator(childs.cend());
+  }
+  /** \brief Получить дочерние элементы, инициализировав их
+   *   при необходимости */
+  const childs_vec& GetChilds() const {
+    ensureChilds();
+    return childs;
+  }
+  /** \brief Поиск по дочерним элементам
+   * \note Если дочерних элементов не меньше CHILDS_INDEX_THRESHOLD,
+   *   поиск идёт по индексу хэшей имён */
   node* ChildByName(const std::string& name) const {
-    node* child = nullptr;
-    if (!node_data_ptr->IsLeafNode()) {
-      for (const node_ptr& ch : childs) {
-        if (ch->node_data_ptr->GetName() == name) {
-          child = ch.get();
-          break;
-        }
-      }
-    }
-    return child;
+    return ChildByName(name, name_hash(name));
+  }
+  /** \brief Поиск по дочерним элементам по имени и заранее
+   *   посчитанному хэшу имени(см. path_handle)
+   * \note Имена сравниваются, только если совпали хэши */
+  node* ChildByName(std::string_view name, uint64_t hash) const {
+    return findChild([&name, hash](const interned_name* key) {
+      return key->hash == hash && key->name == name;
+    }, hash);
+  }
+  /** \brief Поиск по дочерним элементам по записи таблицы имён
+   *   дерева(см. GetNames) - сравнение указателей */
+  node* ChildByName(const interned_name& name) const {
+    return findChild(
+        [&name](const interned_name* key) { return key == &name; },
+        name.hash);
   }
   /** \brief Получить строковое представление параметра
    * \note Так-то актуально только для параметров */
   std::string GetParameter(const std::string& name) {
     return node_data_ptr->GetParameter(name);
   }
+  /** \brief Получить строковое значение параметра без копирования,
+   *   напрямую из исходника
+   * \note Валидно пока жив ридер */
+  std::string_view GetParameterView(std::string_view name) const {
+    return node_.GetValueView(name);
+  }
+  /** \brief Получить типизированное значение параметра: целые,
+   *   числа с плавающей точкой, bool и перечисления
+   *
+   * Значение разбирается из исходника без копирования(см. lib_value_as)
+   *   при первом обращении и запоминается в узле, повторные обращения
+   *   к параметру с тем же типом - поиск по хэшу имени
+   * \return ERROR_SUCCESS_T, ERROR_PARSER_CHILD_NODE_ST если параметра
+   *   нет или это не значение типа T
+   * \note Валидно пока жив ридер. Запоминание потокобезопасно для узлов
+   *   дерева ридера(с общим контекстом node_context). Повторное
+   *   обращение не выделяет память: имена запомненных параметров
+   *   хранятся подряд в memo_names_ */
+  template <class T>
+  merror_t GetParameterAs(std::string_view name, T* out) const {
+    static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= 8,
+                  "GetParameterAs: unsupported type");
+    const void* type = &memo_type<T>;
+    uint64_t hash = name_hash(name);
+    {
+      std::shared_lock<SharedMutex> lock = memoSharedLock();
+      if (const memo_entry* m = findMemo(type, hash, name)) {
+        if (!m->error)
+          memcpy(out, m->value, sizeof(T));
+        return m->error;
+      }
+    }
+    memo_entry m{type, hash, 0, name.size(), ERROR_SUCCESS_T, {}};
+    T value;
+    if (lib_value_as(node_, name, &value)) {
+      memcpy(m.value, &value, sizeof(T));
+      memcpy(out, &value, sizeof(T));
+    } else {
+      m.error = ERROR_PARSER_CHILD_NODE_ST;
+    }
+    std::unique_lock<SharedMutex> lock = memoLock();
+    // другой поток мог запомнить значение между блокировками
+    if (!findMemo(type, hash, name)) {
+      m.name_offset = memo_names_.size();
+      memo_names_.append(name);
+      memo_.push_back(m);
+    }
+    return m.error;
+  }
+  /** \brief Типизированное значение параметра или `value`, если
+   *   параметра нет, см. GetParameterAs(name, out) */
+  template <class T>
+  T GetParameterAs(std::string_view name, T value = T()) const {
+    GetParameterAs(name, &value);
+    return value;
+  }
+  /** \brief Получить имя узла */
+  std::string_view GetNameView() const { return name_->name; }
+  /** \brief Идентификатор имени узла в таблице имён дерева */
+  NameInterner::name_id GetNameId() const { return name_->id; }
+  /** \brief Таблица имён дерева */
+  const NameInterner& GetNames() const { return ctx_->names; }
+  /** \brief Имя инициализатора узла, по которому узел ищет родитель,
+   *   nullptr для корня и неинициализированных узлов */
+  const interned_name* GetKey() const { return key_; }
   /** \brief Получить NodeT исходник */
   const NodeT* GetSource() const { return node_.GetNodePointer(); }
+  /** \brief Представление узла библиотекой */
+  const lib_node<NodeT>& GetLibNode() const { return node_; }
+  /** \brief Структурный хэш поддерева узла(Merkle): значение узла,
+   *   его параметры и хэши дочерних узлов
+   * \note Считается для `reader_options::reloadable`, иначе 0 */
+  uint64_t GetHash() const { return hash_; }
+
+  /** \brief Обновить поддерево по новой версии документа `src`
+   *
+   * Поддерево с неизменившимся хэшем остаётся как есть, вместе
+   *   с инициализаторами. Изменившийся узел получает новый
+   *   инициализатор(InitData), его неизменённые дочерние узлы
+   *   переиспользуются и получают SetParentData заново
+   * \param value_hash хэш значения узла у родительского узла
+   * \param path путь узла без корня, для `changed`
+   * \param changed out-параметр, пути узлов, у которых изменились
+   *   значение или параметры, добавленных и удалённых узлов
+   * \return Поддерево изменилось */
+  bool Reload(lib_node<NodeT> src,
+              uint64_t value_hash,
+              const std::string& path,
+              std::vector<std::string>* changed) {
+    if (!initialized_)
+      return false;
+    inodes_vec names;
+    node_data_ptr->SetSubnodesNames(&names);
+    std::vector<uint64_t> values;
+    uint64_t own = scanChilds(src, names, &values);
+    // сопоставить дочерним узлам поддеревья новой версии
+    //   в порядке initChilds
+    std::vector<node_ptr> olds = std::move(childs);
+    childs.clear();
+    bool structure = false;
+    uint64_t hash = path_hash_step(path_hash_seed, value_hash);
+    hash = path_hash_step(hash, own);
+    for (size_t j = 0; j < names.size(); ++j) {
+      auto ch = src.GetChild(names[j].c_str());
+      if (!lib_node<NodeT>::IsInitialized(ch))
+        continue;
+      node_ptr old = takeChild(olds, ctx_->names.Intern(names[j]));
+      if (!old) {
+        structure = true;
+        continue;
+      }
+      old->Reload(lib_node<NodeT>(ch), values[j], childPath(path, names[j]),
+                  changed);
+      hash = path_hash_step(hash, old->name_->hash);
+      hash = path_hash_step(hash, old->hash_);
+      childs.push_back(std::move(old));
+    }
+    for (const node_ptr& old : olds) {
+      if (old) {
+        structure = true;
+        changed->push_back(childPath(path, old->name_->name));
+      }
+    }
+    if (!structure && hash == hash_) {
+      child_pos = 0;
+      return false;
+    }
+    if (own != own_hash_ || value_hash != value_hash_)
+      changed->push_back(path);
+    reinit(src, path, changed);
+    value_hash_ = value_hash;
+    updateHashes();
+    return true;
+  }
 
  private:
+  /** \brief Дочерний узел с именем из таблицы имён контекста */
+  node_sample(lib_node<NodeT> src,
+              InitializerFactory* factory,
+              const interned_name& name,
+              node_context* ctx)
+      : BaseObject(STATUS_DEFAULT),
+        node_(src),
+        name_(&name),
+        ctx_(ctx),
+        doc_(ctx->document),
+        factory(factory) {
+    init();
+  }
+
+  /** \brief Найти первый дочерний элемент, имя инициализатора
+   *   которого подходит под `match`
+   * \param hash хэш искомого имени, для индекса */
+  template <class MatchF>
+  node* findChild(MatchF&& match, uint64_t hash) const {
+    if (!initialized_ || node_data_ptr->IsLeafNode())
+      return nullptr;
+    ensureChilds();
+    if (childs_idx_.IsBuilt()) {
+      auto pos = childs_idx_.FindHash(hash, [this, &match](size_t i) {
+        return childs[i]->key_ && match(childs[i]->key_);
+      });
+      return (pos != childs_index::npos) ? childs[pos].get() : nullptr;
+    }
+    for (const node_ptr& ch : childs) {
+      if (ch->key_ && match(ch->key_))
+        return ch.get();
+    }
+    return nullptr;
+  }
   /** \brief Инициализировать данные ноды */
   void initData() {
     NodeT* n = node_.GetNodePointer();
     if (n) {
       /* инициализировать */
-      auto error = node_data_ptr->InitData(n, name_);
+      auto error = node_data_ptr->InitData(n, name_->name);
       if (!error) {
-        initChilds();
+        initialized_ = true;
+        if (!ctx_ || !ctx_->lazy)
+          ensureChilds();
       } else {
         error_.SetError(error, "NodeT-> InitData finished with error");
       }
@@ -254,7 +1153,19 @@ class node_sample : public BaseObject {
   /** \brief Получить список имён подузлов узла
    *   с именем 'curr_node' */
   // void ne_nujna();
-  /** \brief Инициализировать дочерние элементы узла */
+  /** \brief Инициализировать дочерние элементы узла, один раз
+   * \note В ленивом режиме вызывается при первом обращении к дочерним
+   *   элементам, в том числе конкурентном - инициализирует их
+   *   только один поток, остальные ждут */
+  void ensureChilds() const {
+    if (initialized_) {
+      std::call_once(childs_flag_,
+                     [this]() { const_cast<node*>(this)->initChilds(); });
+    }
+  }
+  /** \brief Инициализировать дочерние элементы узла
+   * \note В ленивом режиме инициализируется только один уровень -
+   *   дочерние элементы создаются тоже ленивыми */
   void initChilds() {
     // забрать названия подузлов,
     //   хотя сейчас всё сделано так что все подузлы однотипны
@@ -265,13 +1176,251 @@ class node_sample : public BaseObject {
     //   отличается. получим их названия
     node_data_ptr->SetSubnodesNames(&subtrees);
     // если вложенные поддеревья есть - обойдём
+    std::vector<std::pair<lib_node<NodeT>, const interned_name*>> sources;
     for (const auto& st_name : subtrees) {
       auto ch = node_.GetChild(st_name.c_str());
       if (lib_node<NodeT>::IsInitialized(ch))
-        childs.emplace_back(
-            node_ptr(new node(lib_node<NodeT>(ch), factory, st_name)));
+        sources.emplace_back(lib_node<NodeT>(ch),
+                             &ctx_->names.Intern(st_name));
     }
+    if (isParallel(sources.size())) {
+      initChildsParallel(sources);
+    } else {
+      for (auto& [src, st_name] : sources)
+        childs.emplace_back(node_ptr(new node(src, factory, *st_name, ctx_)));
+    }
+    setParentData();
+    buildChildsIndex();
+    child_pos = 0;
+    if (ctx_ && ctx_->hashes)
+      updateHashes(subtrees);
+  }
+  /** \brief Инициализировать узел заново по новой версии документа
+   *   `src`: новый инициализатор, дочерние узлы - из `childs`
+   *   с тем же именем, если есть, иначе новые */
+  void reinit(lib_node<NodeT> src,
+              const std::string& path,
+              std::vector<std::string>* changed) {
+    node_ = src;
+    memo_.clear();
+    memo_names_.clear();
+    doc_ = ctx_ ? ctx_->document : nullptr;
+    initialized_ = false;
+    std::vector<node_ptr> olds = std::move(childs);
+    childs.clear();
+    node_data_ptr = newInitializer();
+    NodeT* n = node_.GetNodePointer();
+    if (node_data_ptr && n) {
+      auto error = node_data_ptr->InitData(n, name_->name);
+      if (error) {
+        error_.SetError(error, "NodeT-> InitData finished with error");
+      } else {
+        initialized_ = true;
+        inodes_vec names;
+        node_data_ptr->SetSubnodesNames(&names);
+        for (const auto& st_name : names) {
+          auto ch = node_.GetChild(st_name.c_str());
+          if (!lib_node<NodeT>::IsInitialized(ch))
+            continue;
+          const interned_name& ch_name = ctx_->names.Intern(st_name);
+          node_ptr old = takeChild(olds, ch_name);
+          if (!old) {
+            old = node_ptr(
+                new node(lib_node<NodeT>(ch), factory, ch_name, ctx_));
+            changed->push_back(childPath(path, st_name));
+          }
+          childs.push_back(std::move(old));
+        }
+      }
+    }
+    for (const node_ptr& old : olds)
+      if (old)
+        changed->push_back(childPath(path, old->name_->name));
     setParentData();
+    childs_idx_ = childs_index();
+    buildChildsIndex();
+    child_pos = 0;
+  }
+  /** \brief Забрать из `olds` первый узел с именем `name` */
+  static node_ptr takeChild(std::vector<node_ptr>& olds,
+                            const interned_name& name) {
+    for (node_ptr& old : olds)
+      if (old && old->name_ == &name)
+        return std::move(old);
+    return nullptr;
+  }
+  static std::string childPath(const std::string& path,
+                               const std::string& name) {
+    return path.empty() ? name : path + "/" + name;
+  }
+  /** \brief Хэш параметров узла `src`: имён и значений всех
+   *   записей, и поддеревьев, не ставших дочерними узлами
+   * \param names имена дочерних узлов(SetSubnodesNames)
+   * \param values out-параметр, хэши значений дочерних узлов */
+  static uint64_t scanChilds(lib_node<NodeT>& src,
+                             const inodes_vec& names,
+                             std::vector<uint64_t>* values) {
+    values->assign(names.size(), 0);
+    std::vector<bool> taken(names.size(), false);
+    uint64_t hash = path_hash_seed;
+    if constexpr (ChildsTraversableType<NodeT>) {
+      src.ForEachChild([&](std::string_view name, std::string_view value,
+                           lib_node<NodeT>* child) {
+        uint64_t vh = name_hash(value);
+        if (child) {
+          // первое поддерево с именем из `names` - дочерний узел(см.
+          //   lib_node::GetChild), оно учитывается его хэшем
+          bool subnode = false;
+          for (size_t j = 0; j < names.size(); ++j) {
+            if (!taken[j] && names[j] == name) {
+              taken[j] = true;
+              (*values)[j] = vh;
+              subnode = true;
+            }
+          }
+          if (subnode)
+            return;
+        }
+        hash = path_hash_step(hash, name_hash(name));
+        hash = path_hash_step(hash, vh);
+        if (child)
+          hash = path_hash_step(hash, subtreeHash(*child));
+      });
+    }
+    return hash;
+  }
+  /** \brief Хэш всего поддерева `src` */
+  static uint64_t subtreeHash(lib_node<NodeT>& src) {
+    uint64_t hash = path_hash_seed;
+    src.ForEachChild([&hash](std::string_view name, std::string_view value,
+                             lib_node<NodeT>* child) {
+      hash = path_hash_step(hash, name_hash(name));
+      hash = path_hash_step(hash, name_hash(value));
+      if (child)
+        hash = path_hash_step(hash, subtreeHash(*child));
+    });
+    return hash;
+  }
+  /** \brief Посчитать хэш параметров узла и хэши значений дочерних
+   *   узлов, обновить хэши дочерних узлов и узла */
+  void updateHashes(const inodes_vec& names) {
+    std::vector<uint64_t> values;
+    own_hash_ = scanChilds(node_, names, &values);
+    for (node_ptr& ch : childs) {
+      for (size_t j = 0; j < names.size(); ++j) {
+        if (names[j] == ch->name_->name) {
+          ch->value_hash_ = values[j];
+          break;
+        }
+      }
+      ch->updateHash();
+    }
+    updateHash();
+  }
+  void updateHashes() {
+    inodes_vec names;
+    if (initialized_)
+      node_data_ptr->SetSubnodesNames(&names);
+    updateHashes(names);
+  }
+  /** \brief Хэш узла по хэшам значения, параметров
+   *   и дочерних узлов */
+  void updateHash() {
+    uint64_t hash = path_hash_step(path_hash_seed, value_hash_);
+    hash = path_hash_step(hash, own_hash_);
+    for (const node_ptr& ch : childs) {
+      hash = path_hash_step(hash, ch->name_->hash);
+      hash = path_hash_step(hash, ch->hash_);
+    }
+    hash_ = hash;
+  }
+  /** \brief Инициализировать дочерние элементы в пуле потоков,
+   *   каждый в свою позицию вектора */
+  void initChildsParallel(
+      std::vector<std::pair<lib_node<NodeT>, const interned_name*>>& sources) {
+    childs.resize(sources.size());
+    std::vector<std::future<void>> results;
+    results.reserve(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+      results.push_back(ctx_->pool->Submit([this, &sources, i]() {
+        childs[i] = node_ptr(new node(sources[i].first, threadFactory(),
+                                      *sources[i].second, ctx_));
+      }));
+    }
+    // дождаться всех задач, прежде чем пробросить исключение
+    for (auto& r : results)
+      r.wait();
+    for (auto& r : results)
+      r.get();
+  }
+  /** \brief Инициализировать дочерние элементы параллельно: есть пул,
+   *   элементов достаточно, и вызов не из рабочего потока пула ридера
+   *   (поддеревья в его рабочих потоках инициализируются
+   *   последовательно) */
+  bool isParallel(size_t count) const {
+    return ctx_ && ctx_->pool && count >= ctx_->parallel_threshold &&
+           count > 1 && ctx_->GetWorker() == ThreadPool::npos;
+  }
+  /** \brief Фабрика для текущего рабочего потока */
+  InitializerFactory* threadFactory() const {
+    if constexpr (ThreadFactoryType<InitializerFactory>) {
+      if (factory)
+        return factory->GetThreadFactory(
+            ctx_ ? ctx_->GetWorker() : ThreadPool::npos);
+    }
+    return factory;
+  }
+  /** \brief Блокировки запомненных значений, без общего контекста
+   *   узлов - пустые */
+  std::shared_lock<SharedMutex> memoSharedLock() const {
+    return ctx_ ? std::shared_lock<SharedMutex>(ctx_->memo_mutex)
+                : std::shared_lock<SharedMutex>();
+  }
+  std::unique_lock<SharedMutex> memoLock() const {
+    return ctx_ ? std::unique_lock<SharedMutex>(ctx_->memo_mutex)
+                : std::unique_lock<SharedMutex>();
+  }
+  /** \brief Создать инициализатор узла: фабрикой, если она задана */
+  initializer_ptr<Initializer> newInitializer() {
+    if (!factory)
+      return initializer_ptr<Initializer>(new Initializer());
+    initializer_ptr<Initializer> data = createInitializer();
+    if (!data)
+      error_.SetError(ERROR_GENERAL_T, "Ошибка использования фабрики узлов");
+    return data;
+  }
+  /** \brief Создать инициализатор фабрикой. Сериализуются вызовы
+   *   фабрики без GetThreadFactory из рабочих потоков и любые вызовы
+   *   в ленивом режиме - дочерние элементы тогда создаются из всех
+   *   потоков, читающих дерево, общей фабрикой узла */
+  initializer_ptr<Initializer> createInitializer() {
+    if (ctx_ && ctx_->lazy) {
+      std::lock_guard<Mutex> lock(ctx_->factory_mutex);
+      return factoryInitializer();
+    }
+    if constexpr (!ThreadFactoryType<InitializerFactory>) {
+      if (ctx_ && ctx_->GetWorker() != ThreadPool::npos) {
+        std::lock_guard<Mutex> lock(ctx_->factory_mutex);
+        return factoryInitializer();
+      }
+    }
+    return factoryInitializer();
+  }
+  /** \brief Вызвать фабрику: в арене потока, если фабрика их
+   *   поддерживает(ArenaFactoryType) и ридер их завёл */
+  initializer_ptr<Initializer> factoryInitializer() {
+    if constexpr (ArenaFactoryType<InitializerFactory, Initializer, NodeT>) {
+      if (ctx_ && !ctx_->arenas.empty()) {
+        auto& a = ctx_->GetArena();
+        auto lock = ctx_->lazy ? std::unique_lock<Mutex>(a.mutex)
+                               : std::unique_lock<Mutex>();
+        return initializer_ptr<Initializer>(
+            factory->template GetNodeInitializer<NodeT>(&a.arena),
+            initializer_deleter<Initializer>{false});
+      }
+    }
+    return initializer_ptr<Initializer>(
+        factory->template GetNodeInitializer<NodeT>());
   }
   /** \brief Инициализировать иерархичные данные
    * \note тут такое, я пока неопределился id ноды тащить
@@ -282,26 +1431,498 @@ class node_sample : public BaseObject {
     for (auto& x : childs)
       x->node_data_ptr->SetParentData(*node_data_ptr);
   }
+  /** \brief Построить индекс поиска дочерних элементов по имени,
+   *   для узлов с большим количеством дочерних элементов */
+  void buildChildsIndex() {
+    internKeys();
+    if (childs.size() >= CHILDS_INDEX_THRESHOLD) {
+      childs_idx_.BuildHashes(childs.size(), [this](size_t i) {
+        return childs[i]->key_ ? childs[i]->key_->hash : name_hash("");
+      });
+    }
+  }
+  /** \brief Запомнить записи таблицы имён для имён инициализаторов
+   *   дочерних элементов, по которым они ищутся. Обычно это имя
+   *   узла, отдельная запись - если инициализатор его сменил */
+  void internKeys() {
+    for (node_ptr& ch : childs) {
+      if (!ch->node_data_ptr)
+        continue;
+      const auto& name = ch->node_data_ptr->GetName();
+      ch->key_ = (name == ch->name_->name) ? ch->name_
+                                           : &ctx_->names.Intern(name);
+    }
+  }
 
  private:
   /** \brief представление узла */
   lib_node<NodeT> node_;
-  /** \brief имя узла */
-  std::string name_;
+  /** \brief имя узла, запись таблицы имён контекста */
+  const interned_name* name_ = nullptr;
+  /** \brief имя инициализатора узла, по нему узел ищет родитель,
+   *   см. internKeys */
+  const interned_name* key_ = nullptr;
+  /** \brief индекс поиска дочерних элементов по имени */
+  childs_index childs_idx_;
+  /** \brief данные узла инициализированы(InitData без ошибок) */
+  bool initialized_ = false;
+  /** \brief общие настройки узлов дерева */
+  node_context* ctx_ = nullptr;
+  /** \brief контекст узла, созданного без контекста */
+  std::unique_ptr<node_context> own_ctx_;
+  /** \brief флаг однократной инициализации дочерних элементов */
+  mutable std::once_flag childs_flag_;
+  /** \brief Значение параметра, запомненное GetParameterAs */
+  struct memo_entry {
+    /** \brief тип значения, см. memo_type */
+    const void* type;
+    uint64_t hash;
+    /** \brief имя параметра - подстрока memo_names_ */
+    size_t name_offset;
+    size_t name_size;
+    merror_t error;
+    alignas(8) unsigned char value[8];
+  };
+  /** \brief Запомненное значение параметра `name` типа `type`,
+   *   под блокировкой memo */
+  const memo_entry* findMemo(const void* type,
+                             uint64_t hash,
+                             std::string_view name) const {
+    for (const memo_entry& m : memo_) {
+      if (m.hash == hash && m.type == type &&
+          std::string_view(memo_names_).substr(m.name_offset, m.name_size) ==
+              name)
+        return &m;
+    }
+    return nullptr;
+  }
+  /** \brief метка типа запомненного значения - адрес переменной */
+  template <class T>
+  static constexpr char memo_type = 0;
+  /** \brief значения, запомненные GetParameterAs */
+  mutable std::vector<memo_entry> memo_;
+  /** \brief имена параметров memo_, подряд */
+  mutable std::string memo_names_;
+  /** \brief структурный хэш поддерева, см. GetHash */
+  uint64_t hash_ = 0;
+  /** \brief хэш параметров узла, без дочерних узлов */
+  uint64_t own_hash_ = 0;
+  /** \brief хэш значения узла, считается родительским узлом */
+  uint64_t value_hash_ = 0;
+  /** \brief документ ReaderSample::Reload, на который ссылается
+   *   узел; nullptr - документ ридера */
+  std::shared_ptr<const void> doc_;
 
  public:
-  /** \brief дочерние элементы */
+  /** \brief дочерние элементы
+   * \note В ленивом режиме до первого обращения пуст,
+   *   см. GetChilds */
   childs_vec childs;
-  /** \brief итератор на обход дочерних элементов */
-  typename childs_vec::iterator child_it;
+  /** \brief позиция обхода NextChild */
+  size_t child_pos = 0;
   // такс, все необходимые для JSONReader операции
   //   реализуем здесь
   /** \brief инициализируемая структура */
-  std::unique_ptr<Initializer> node_data_ptr;
+  initializer_ptr<Initializer> node_data_ptr;
   /** \brief Фабрика */
   InitializerFactory* factory;
 };
 
+// class flat_tree_sample
+/** \brief Плоское представление дерева файла - альтернатива
+ *   дереву node_sample
+ *
+ * Все узлы лежат в одном векторе в порядке обхода в ширину,
+ *   дочерние элементы узла занимают непрерывный диапазон индексов.
+ *   Инициализаторы, если фабрика не задана или поддерживает арены
+ *   (ArenaFactoryType), создаются в арене дерева, и освобождаются
+ *   вместе с ней. Дерево строится
+ *   итеративно, без рекурсии.
+ * \note SetParentData вызывается сразу после InitData дочернего
+ *   узла, а не после инициализации всего его поддерева */
+template <class NodeT,
+          class Initializer,
+          class InitializerFactory,
+          class = typename std::enable_if<
+              NodeInitializerType<Initializer>>::type>
+class flat_tree_sample : public BaseObject {
+ public:
+  /** \brief индекс узла в дереве */
+  typedef uint32_t node_id;
+  /** \brief индекс отсутствующего узла */
+  static constexpr node_id npos = static_cast<node_id>(-1);
+  /** \brief Узел плоского дерева */
+  struct flat_node {
+    /** \brief представление узла */
+    lib_node<NodeT> node;
+    /** \brief имя узла, запись таблицы имён дерева */
+    const interned_name* name;
+    /** \brief индекс родительского узла */
+    node_id parent;
+    /** \brief индекс первого дочернего узла */
+    node_id first_child;
+    /** \brief количество дочерних узлов */
+    node_id childs_count;
+    /** \brief инициализируемая структура */
+    Initializer* data;
+    /** \brief индекс поиска дочерних элементов в `indexes_`,
+     *   npos если не построен */
+    node_id childs_index;
+    /** \brief имя инициализатора, по нему узел ищется
+     *   у родителя, см. node_sample::internKeys */
+    const interned_name* key;
+  };
+
+ public:
+  explicit flat_tree_sample(InitializerFactory* factory)
+      : BaseObject(STATUS_DEFAULT), factory_(factory) {}
+
+  /** \brief Построить дерево от корня `root` с именем `name` */
+  merror_t Build(lib_node<NodeT> root, const std::string& name) {
+    nodes_.clear();
+    nodes_.push_back(flat_node{root, &names_.Intern(name), npos, npos, 0,
+                               nullptr, npos, nullptr});
+    indexes_.clear();
+    std::vector<std::string> subtrees;
+    for (node_id i = 0; i < nodes_.size(); ++i) {
+      Initializer* data = createInitializer();
+      if (!data) {
+        error_.SetError(ERROR_GENERAL_T, "Ошибка использования фабрики узлов");
+        break;
+      }
+      nodes_[i].data = data;
+      nodes_[i].first_child = static_cast<node_id>(nodes_.size());
+      auto* n = nodes_[i].node.GetNodePointer();
+      if (!n)
+        continue;
+      auto error = data->InitData(n, nodes_[i].name->name);
+      if (error) {
+        error_.SetError(error, "NodeT-> InitData finished with error");
+        continue;
+      }
+      if (nodes_[i].parent != npos)
+        data->SetParentData(*nodes_[nodes_[i].parent].data);
+      subtrees.clear();
+      data->SetSubnodesNames(&subtrees);
+      for (const auto& st_name : subtrees) {
+        auto ch = nodes_[i].node.GetChild(st_name.c_str());
+        if (lib_node<NodeT>::IsInitialized(ch))
+          nodes_.push_back(flat_node{lib_node<NodeT>(ch),
+                                     &names_.Intern(st_name), i, npos, 0,
+                                     nullptr, npos, nullptr});
+      }
+      nodes_[i].childs_count =
+          static_cast<node_id>(nodes_.size()) - nodes_[i].first_child;
+    }
+    buildChildsIndexes();
+    status_ = error_.GetErrorCode() ? STATUS_HAVE_ERROR : STATUS_OK;
+    return error_.GetErrorCode();
+  }
+
+  /** \brief Количество узлов */
+  size_t Size() const { return nodes_.size(); }
+  /** \brief Получить узел по индексу */
+  const flat_node& GetNode(node_id id) const { return nodes_[id]; }
+  /** \brief Таблица имён дерева */
+  const NameInterner& GetNames() const { return names_; }
+  /** \brief Поиск по дочерним элементам узла `id`
+   * \note Если дочерних элементов не меньше CHILDS_INDEX_THRESHOLD,
+   *   поиск идёт по индексу хэшей имён */
+  node_id ChildByName(node_id id, const std::string& name) const {
+    return ChildByName(id, name, name_hash(name));
+  }
+  /** \brief Поиск по дочерним элементам узла `id` по имени и заранее
+   *   посчитанному хэшу имени */
+  node_id ChildByName(node_id id, std::string_view name, uint64_t hash) const {
+    const flat_node& fn = nodes_[id];
+    if (fn.data && !fn.data->IsLeafNode()) {
+      const auto match = [this, &fn, &name, hash](size_t i) {
+        const interned_name* key = nodes_[fn.first_child + i].key;
+        return key && key->hash == hash && key->name == name;
+      };
+      if (fn.childs_index != npos) {
+        auto pos = indexes_[fn.childs_index].FindHash(hash, match);
+        return (pos != childs_index::npos) ? fn.first_child + pos : npos;
+      }
+      for (node_id i = 0; i < fn.childs_count; ++i) {
+        if (match(i))
+          return fn.first_child + i;
+      }
+    }
+    return npos;
+  }
+  /** \brief Получить параметр по переданному пути,
+   *   см. ReaderSample::GetValueByPath */
+  merror_t GetValueByPath(const std::vector<std::string>& path,
+                          std::string* outstr) {
+    if (nodes_.empty())
+      return ERROR_GENERAL_T;
+    node_id id = 0;
+    std::string param = "";
+    if (!path.empty()) {
+      param = path.back();
+      for (auto i = path.begin(); i != path.end() - 1 && id != npos; ++i)
+        id = ChildByName(id, *i);
+      if (id == npos)
+        return ERROR_PARSER_CHILD_NODE_ST;
+    }
+    *outstr = nodes_[id].data->GetParameter(param);
+    return ERROR_SUCCESS_T;
+  }
+  /** \brief Получить инициализированную структуру по пути,
+   *   см. ReaderSample::GetNodeByPath */
+  Initializer* GetNodeByPath(const std::vector<std::string>& path) {
+    return FindByPath(path, path.size());
+  }
+  /** \brief Получить инициализированную структуру по первым `n`
+   *   именам пути(вектор имён или скомпилированный путь) */
+  template <class PathH>
+  Initializer* FindByPath(const PathH& path, size_t n) const {
+    if (nodes_.empty())
+      return nullptr;
+    node_id id = 0;
+    for (size_t i = 0; i < n && id != npos; ++i)
+      id = ChildByName(id, path_name(path, i), path_name_hash(path, i));
+    return (id != npos) ? nodes_[id].data : nullptr;
+  }
+
+ private:
+  /** \brief Построить индексы поиска по имени для узлов с большим
+   *   количеством дочерних элементов. Имена берутся у инициализаторов,
+   *   поэтому строятся после инициализации всего дерева */
+  void buildChildsIndexes() {
+    for (flat_node& fn : nodes_) {
+      if (fn.data) {
+        const auto& name = fn.data->GetName();
+        fn.key = (name == fn.name->name) ? fn.name : &names_.Intern(name);
+      }
+    }
+    for (flat_node& fn : nodes_) {
+      if (fn.childs_count >= CHILDS_INDEX_THRESHOLD) {
+        fn.childs_index = static_cast<node_id>(indexes_.size());
+        indexes_.emplace_back();
+        indexes_.back().BuildHashes(fn.childs_count, [this, &fn](size_t i) {
+          const flat_node& ch = nodes_[fn.first_child + i];
+          return ch.key ? ch.key->hash : name_hash("");
+        });
+      }
+    }
+  }
+  /** \brief Создать инициализатор узла: фабрикой, если она задана,
+   *   иначе в арене дерева. Фабрика с ArenaFactoryType создаёт
+   *   инициализаторы в той же арене */
+  Initializer* createInitializer() {
+    if (!factory_)
+      return arena_.template Create<Initializer>();
+    if constexpr (ArenaFactoryType<InitializerFactory, Initializer, NodeT>) {
+      return factory_->template GetNodeInitializer<NodeT>(&arena_);
+    } else {
+      Initializer* data = factory_->template GetNodeInitializer<NodeT>();
+      if (data)
+        owned_.emplace_back(data);
+      return data;
+    }
+  }
+
+ private:
+  /** \brief узлы дерева в порядке обхода в ширину
+   * \note deque: добавление дочерних узлов при обходе не перемещает
+   *   уже добавленные, адрес `flat_node::node`, переданный в InitData,
+   *   валиден, пока живёт дерево */
+  std::deque<flat_node> nodes_;
+  /** \brief индексы поиска дочерних элементов по имени */
+  std::vector<childs_index> indexes_;
+  /** \brief таблица имён узлов */
+  NameInterner names_;
+  /** \brief инициализаторы, созданные фабрикой */
+  std::vector<std::unique_ptr<Initializer>> owned_;
+  /** \brief арена инициализаторов */
+  Arena arena_;
+  /** \brief Фабрика */
+  InitializerFactory* factory_ = nullptr;
+};
+
+// class query_tree_sample
+/** \brief Дерево ридера для запросов node_query(см. QueryTreeType):
+ *   дерево node_sample или плоское дерево flat_tree_sample
+ * \note Дочерние элементы листовых узлов в запросах не участвуют,
+ *   как и в поиске по пути */
+template <class NodeT, class Initializer, class InitializerFactory>
+class query_tree_sample {
+  typedef node_sample<NodeT, Initializer, InitializerFactory> node;
+  typedef flat_tree_sample<NodeT, Initializer, InitializerFactory> flat_tree;
+
+ public:
+  /** \brief Узел: node_sample или индекс узла плоского дерева */
+  struct handle {
+    const node* n;
+    typename flat_tree::node_id id;
+  };
+
+ public:
+  query_tree_sample(const node* root, const flat_tree* flat)
+      : root_(root), flat_(flat) {}
+
+  handle Root() const { return handle{root_, 0}; }
+  size_t ChildsCount(handle h) const {
+    if (flat_) {
+      const auto& fn = flat_->GetNode(h.id);
+      return (fn.data && !fn.data->IsLeafNode()) ? fn.childs_count : 0;
+    }
+    if (!h.n || !h.n->node_data_ptr || h.n->node_data_ptr->IsLeafNode())
+      return 0;
+    return h.n->GetChilds().size();
+  }
+  handle Child(handle h, size_t i) const {
+    if (flat_)
+      return handle{nullptr, static_cast<typename flat_tree::node_id>(
+                                 flat_->GetNode(h.id).first_child + i)};
+    return handle{h.n->GetChilds()[i].get(), 0};
+  }
+  const interned_name* GetKey(handle h) const {
+    return flat_ ? flat_->GetNode(h.id).key : h.n->GetKey();
+  }
+  std::string_view GetValueView(handle h, const char* name) const {
+    return libNode(h).GetValueView(name);
+  }
+  template <class T>
+  bool GetValueAs(handle h, const char* name, T* out) const {
+    return lib_value_as(libNode(h), name, out);
+  }
+  /** \brief Инициализированная структура узла */
+  Initializer* Get(handle h) const {
+    return flat_ ? flat_->GetNode(h.id).data : h.n->node_data_ptr.get();
+  }
+
+ private:
+  const lib_node<NodeT>& libNode(handle h) const {
+    return flat_ ? flat_->GetNode(h.id).node : h.n->GetLibNode();
+  }
+
+ private:
+  const node* root_;
+  const flat_tree* flat_;
+};
+
+// class frozen_reader_sample
+/**
+ * \brief Замороженное дерево ридера для чтения из многих потоков,
+ *   см. ReaderSample::Freeze
+ *
+ * Индекс путей всех узлов дерева(как `reader_options::path_index`):
+ *   исходник узла и его инициализированная структура. Методы только
+ *   константные, без блокировок: значения параметров читаются из
+ *   исходника(lib_node::GetValueView по имени из пути, без
+ *   копирования; lib_value_as), ошибки - кодами, без ErrorWrap.
+ *   Числа и логические значения форматируются как в ReaderSample
+ *   (lib_node::ForEachChild) в буфер вызывающего
+ * \note Валидно, пока жив ридер и дерево не перестраивалось(Reload)
+ * */
+template <class NodeT, class Initializer>
+class frozen_reader_sample {
+ public:
+  /** \brief Узел дерева: исходник и инициализированная структура */
+  struct frozen_node {
+    const lib_node<NodeT>* node;
+    const Initializer* data;
+  };
+
+ public:
+  explicit frozen_reader_sample(path_index<frozen_node> index)
+      : index_(std::move(index)) {}
+
+  /** \brief Количество узлов */
+  size_t Size() const { return index_.Size(); }
+
+  /** \brief Инициализированная структура узла по пути без корня */
+  const Initializer* GetNodeByPath(const std::vector<std::string>& path) const {
+    const frozen_node* n = index_.Find(path, path.size());
+    return n ? n->data : nullptr;
+  }
+  template <PathHandleType PathH>
+  const Initializer* GetNodeByPath(const PathH& path) const {
+    const frozen_node* n = index_.Find(path, path.Size());
+    return n ? n->data : nullptr;
+  }
+  /**
+   * \brief Строковое значение параметра `name` узла по пути `path`
+   * \param buffer буфер вызывающего: строки указывают в исходник
+   *   без копирования, числа и логические значения форматируются
+   *   в `buffer`, `out` валиден до его изменения
+   * \return ERROR_SUCCESS_T, ERROR_PARSER_CHILD_NODE_ST если узла нет.
+   *   Для отсутствующего параметра - пустая строка, как у
+   *   ReaderSample::GetValueByPath
+   * */
+  template <class PathH>
+  merror_t GetValueView(const PathH& path,
+                        std::string_view name,
+                        std::string_view* out,
+                        std::string* buffer) const {
+    return getValue(path, path_size(path), name, out, buffer);
+  }
+  /** \brief Значение параметра по пути, последнее имя пути - имя
+   *   параметра, см. ReaderSample::GetValueByPath, GetValueView */
+  template <class PathH>
+  merror_t GetValueByPath(const PathH& path,
+                          std::string_view* out,
+                          std::string* buffer) const {
+    size_t n = path_size(path);
+    if (!n)
+      return getValue(path, 0, std::string_view(), out, buffer);
+    return getValue(path, n - 1, path_name(path, n - 1), out, buffer);
+  }
+  /** \brief Типизированное значение параметра `name` узла по пути
+   *   `path`, см. lib_value_as
+   * \return ERROR_SUCCESS_T, ERROR_PARSER_CHILD_NODE_ST если узла
+   *   или параметра нет или это не значение типа T
+   * \note В отличие от node_sample::GetParameterAs не запоминается */
+  template <class PathH, class T>
+  merror_t GetValueAs(const PathH& path, const char* name, T* out) const {
+    const frozen_node* n = index_.Find(path, path_size(path));
+    if (!n || !lib_value_as(*n->node, name, out))
+      return ERROR_PARSER_CHILD_NODE_ST;
+    return ERROR_SUCCESS_T;
+  }
+
+ private:
+  template <class PathH>
+  merror_t getValue(const PathH& path,
+                    size_t n,
+                    std::string_view name,
+                    std::string_view* out,
+                    std::string* buffer) const {
+    const frozen_node* fn = index_.Find(path, n);
+    if (!fn)
+      return ERROR_PARSER_CHILD_NODE_ST;
+    *out = fn->node->GetValueView(name);
+    if (out->empty())
+      formatValue(*fn->node, name, out, buffer);
+    return ERROR_SUCCESS_T;
+  }
+  /** \brief Нестроковое значение(число, логическое) первого листа
+   *   `name` узла, отформатированное как в ReaderSample */
+  static void formatValue(lib_node<NodeT> node,
+                          std::string_view name,
+                          std::string_view* out,
+                          std::string* buffer) {
+    if constexpr (ChildsTraversableType<NodeT>) {
+      bool found = false;
+      node.ForEachChild([&](std::string_view ch_name, std::string_view v,
+                            lib_node<NodeT>* child) {
+        if (found || child || ch_name != name)
+          return;
+        found = true;
+        buffer->assign(v.data(), v.size());
+      });
+      if (found)
+        *out = *buffer;
+    }
+  }
+
+ private:
+  path_index<frozen_node> index_;
+};
+
 /** \brief Класс парсинга файлов
  * \note По идее здесь главным должен быть реализоывн метод
  *   позволяет вытащить весь скелет структур с++ привязанных к узлу
@@ -311,10 +1932,26 @@ template <class NodeT,
           class InitializerFactory = SimpleInitializerFactory<Initializer>,
           class PathT = fs::path,
           class = typename std::enable_if<
-              std::is_base_of<INodeInitializer, Initializer>::value>::type>
+              NodeInitializerType<Initializer>>::type>
 class ReaderSample : public BaseObject {
   typedef ReaderSample<NodeT, Initializer, InitializerFactory, PathT> Reader;
   typedef node_sample<NodeT, Initializer, InitializerFactory> node;
+  typedef flat_tree_sample<NodeT, Initializer, InitializerFactory> flat_tree;
+  typedef query_tree_sample<NodeT, Initializer, InitializerFactory> query_tree;
+  /** \brief Версия документа, загруженная Reload */
+  struct reload_document {
+    file_utils::FileBuffer memory;
+    typename lib_node<NodeT>::NodeDocType document;
+  };
+
+ public:
+  /** \brief Подписчик на изменения документа: пути изменённых узлов */
+  typedef std::function<void(const std::vector<std::string>&)>
+      reload_subscriber;
+  /** \brief Узел дерева ридера, см. GetRootNode */
+  typedef node_sample<NodeT, Initializer, InitializerFactory> tree_node;
+  /** \brief Замороженное дерево, см. Freeze */
+  typedef frozen_reader_sample<NodeT, Initializer> frozen_reader;
 
  public:
   ReaderSample(const ReaderSample&) = delete;
@@ -322,11 +1959,12 @@ class ReaderSample : public BaseObject {
 
   static ReaderSample<NodeT, Initializer, InitializerFactory, PathT>* Init(
       file_utils::FileURLSample<PathT>* source,
-      InitializerFactory* factory = nullptr) {
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
     Reader* reader = nullptr;
     if (source) {
       if (is_exists(source->GetURL())) {
-        reader = new Reader(source, factory);
+        reader = new Reader(source, factory, options);
       } else {
         source->SetError(ERROR_FILE_EXISTS_ST,
                          "File '" + source->GetURLStr() + "' doesn't exists");
@@ -342,10 +1980,11 @@ class ReaderSample : public BaseObject {
 
   static ReaderSample<NodeT, Initializer, InitializerFactory, PathT>* Init(
       const char* data,
-      InitializerFactory* factory = nullptr) {
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
     Reader* reader = nullptr;
     if (data) {
-      reader = new Reader(data, factory);
+      reader = new Reader(data, factory, options);
     } else {
       Logging::Append(ERROR_INIT_NULLP_ST,
                       "Get 'data'=nullptr into "
@@ -354,22 +1993,56 @@ class ReaderSample : public BaseObject {
     return reader;
   }
 
-  ~ReaderSample() {
-    if (memory_)
-      delete[] memory_;
+  /**
+   * \brief Создать ридер файла `source`, уже загруженного в память
+   *   `memory`(например, стадией чтения BatchLoaderSample)
+   * */
+  static ReaderSample<NodeT, Initializer, InitializerFactory, PathT>* Init(
+      file_utils::FileURLSample<PathT>* source,
+      file_utils::FileBuffer&& memory,
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    return new Reader(source, std::move(memory), factory, options);
+  }
+
+  /**
+   * \brief Создать ридер, данные которому передаются по частям
+   *   методом Feed, см. Finish
+   * */
+  static ReaderSample<NodeT, Initializer, InitializerFactory, PathT>*
+  InitFeed(InitializerFactory* factory = nullptr,
+           const reader_options& options = reader_options()) {
+    return new Reader(static_cast<const char*>(nullptr), factory, options);
   }
 
   static std::string GetFilenameExtension() { return ".xml"; }
+  /**
+   * \brief Дописать следующую часть документа в буффер ридера
+   * \note DOM парсеры(RapidJSON, pugixml) разбирают документ целиком,
+   *   поэтому части только собираются в буффер, без strlen и
+   *   промежуточных копий, а разбор выполняет Finish. Для разбора
+   *   по мере поступления данных см. потоковые ридеры
+   *   JSONStreamReaderSample и XMLStreamReaderSample
+   * */
+  merror_t Feed(std::string_view chunk) {
+    return memory_.Append(chunk.data(), chunk.size());
+  }
+  /** \brief Данных больше не будет - разобрать документ,
+   *   аналог InitData */
+  merror_t Finish() { return InitData(); }
   /** \brief Инициализировать данные
    * \todo выносим метод из класса, сюда передаём уже данные,
    *   рут ноду, короче говоря */
   merror_t InitData() {
-    if (!error_.GetErrorCode() && (memory_ != nullptr)) {
+    if (!error_.GetErrorCode() && !memory_.IsEmpty()) {
       std::string root_name = "";
-      auto r = lib_node<NodeT>::InitDocumentRoot(
-          &document_, memory_, len_memory_, &root_name, &error_);
+      auto r = lib_node<NodeT>::InitDocumentRoot(&document_, memory_.GetData(),
+                                                 memory_.GetSize(), &root_name,
+                                                 &error_, options_);
       if (!error_.GetErrorCode()) {
-        root_node_ = std::unique_ptr<node>(new node(r, factory_, root_name));
+        doc_root_ = lib_node<NodeT>(r);
+        root_name_ = root_name;
+        initTree();
       }
     }
     if (error_.GetErrorCode()) {
@@ -384,80 +2057,414 @@ class ReaderSample : public BaseObject {
    * \warning outstr придёт с пробелами, если они есть в xml,
    *   алсо путь принимается без рут ноды */
   merror_t GetValueByPath(const std::vector<std::string>& path,
-                          std::string* outstr) {
-    if (!root_node_)
-      return ERROR_GENERAL_T;
-    /* todo: добавить const квалификатор */
-    node* tmp_node = root_node_.get();
-    std::string param = "";
-    if (!path.empty()) {
-      param = path.back();
-      for (auto i = path.begin(); i != path.end() - 1; ++i) {
-        if (tmp_node)
-          tmp_node = tmp_node->ChildByName(*i);
-        else
-          break;
+                          std::string* outstr) const {
+    return getValueByPath(path, outstr);
+  }
+  /** \brief Получить параметр по скомпилированному пути,
+   *   `path_handle` или `"a/b/param"_path`
+   * \note Хэши имён посчитаны заранее, поиск дочерних элементов
+   *   и поиск по индексу путей идут без хэширования и выделения памяти */
+  template <PathHandleType PathH>
+  merror_t GetValueByPath(const PathH& path, std::string* outstr) const {
+    return getValueByPath(path, outstr);
+  }
+
+  Initializer* GetNodeByPath(const std::vector<std::string>& path) const {
+    return findByPath(path, path.size());
+  }
+  /** \brief Получить инициализированную структуру по
+   *   скомпилированному пути */
+  template <PathHandleType PathH>
+  Initializer* GetNodeByPath(const PathH& path) const {
+    return findByPath(path, path.Size());
+  }
+
+  /**
+   * \brief Выбрать узлы дерева запросом `query`, см. node_query
+   * \return Ленивые результаты - инициализированные структуры
+   *   узлов в порядке документа, см. query_range
+   * \note Результаты валидны, пока живы ридер и запрос и дерево
+   *   не перестраивалось(Reload)
+   * */
+  query_range<query_tree> Select(const node_query& query) const {
+    return query_range<query_tree>(queryTree(), query, &query_indexes_);
+  }
+  /**
+   * \brief Построить индекс значений параметра `name` для запросов
+   *   вида `//node[@name='value']...`, см. query_index
+   * \note Индексы перестраиваются при Reload
+   * */
+  merror_t BuildQueryIndex(const std::string& name) {
+    if (!root_node_ && !flat_root_)
+      return error_.SetError(ERROR_GENERAL_T,
+                             "query index: reader tree is not initialized");
+    auto index = std::find_if(
+        query_indexes_.begin(), query_indexes_.end(),
+        [&name](const auto& i) { return i.GetParameter() == name; });
+    if (index == query_indexes_.end())
+      index = query_indexes_.emplace(query_indexes_.end(), name);
+    index->Build(queryTree());
+    return ERROR_SUCCESS_T;
+  }
+  /**
+   * \brief Корень дерева node_sample для константного обхода:
+   *   `for (const auto& n : DepthFirst(*reader->GetRootNode()))`
+   * \return nullptr если дерево не инициализировано или плоское
+   *   (reader_options::flat_tree)
+   * \note Узлы валидны, пока дерево не перестраивалось(Reload)
+   * */
+  const tree_node* GetRootNode() const { return root_node_.get(); }
+  /**
+   * \brief Заморозить дерево ридера: константное представление для
+   *   поиска по путям из многих потоков без блокировок и выделения
+   *   памяти, см. frozen_reader_sample
+   *
+   * В ленивом режиме дерево инициализируется полностью
+   * \return nullptr если дерево не инициализировано
+   * \note Представление валидно, пока жив ридер и дерево не
+   *   перестраивалось(Reload)
+   * */
+  std::shared_ptr<const frozen_reader> Freeze() {
+    if (!root_node_ && !flat_root_) {
+      error_.SetError(ERROR_GENERAL_T,
+                      "freeze: reader tree is not initialized");
+      return nullptr;
+    }
+    typedef typename frozen_reader::frozen_node frozen_node;
+    path_index<frozen_node> index;
+    forEachIndexedPath([&index](uint64_t hash, std::string key,
+                                const lib_node<NodeT>& n, Initializer* data) {
+      index.Insert(hash, std::move(key), frozen_node{&n, data});
+    });
+    return std::make_shared<const frozen_reader>(std::move(index));
+  }
+
+  std::string GetFileName() const {
+    return (source_) ? source_->GetURL() : "";
+  }
+  /** \brief Таблица имён узлов дерева: одинаковые имена узлов
+   *   хранятся в ней один раз */
+  const NameInterner& GetNames() const {
+    return flat_root_ ? flat_root_->GetNames() : ctx_.names;
+  }
+  /**
+   * \brief Перечитать файл ридера и обновить дерево
+   *
+   * Для `reader_options::reloadable` дерево node_sample обновляется
+   *   по структурным хэшам узлов: заново инициализируются только
+   *   изменившиеся поддеревья(см. node_sample::Reload), иначе дерево
+   *   строится заново. Подписчики(Subscribe) получают пути
+   *   изменённых, добавленных и удалённых узлов без корня, путь
+   *   корня - пустая строка
+   * \param changed out-параметр, пути изменённых узлов
+   * \note Ошибка чтения или разбора оставляет дерево как есть.
+   *   Старая версия документа освобождается, когда на неё
+   *   не остаётся ссылок узлов, документ первой версии живёт вместе
+   *   с ридером. Чтение дерева во время Reload не допускается
+   * \note Имена и созданные в арене(ArenaFactoryType) инициализаторы
+   *   заменённых узлов освобождаются только при перестроении всего
+   *   дерева: когда они вырастают больше чем в
+   *   reader_options::reload_rebuild_growth раз, дерево после
+   *   обновления строится заново. Пути изменений при этом те же
+   * */
+  merror_t Reload(std::vector<std::string>* changed = nullptr) {
+    if (!source_)
+      return error_.SetError(ERROR_GENERAL_T,
+                             "reload: reader has no source file");
+    auto doc = std::make_shared<reload_document>();
+    ErrorWrap error;
+    doc->memory.Load(source_->GetURL(), bufferMode(), error);
+    std::string root_name = "";
+    lib_node<NodeT> root;
+    if (!error.GetErrorCode()) {
+      if (doc->memory.IsEmpty()) {
+        error.SetError(ERROR_PARSER_PARSE_ST,
+                       "reload: empty file " + source_->GetURLStr());
+      } else {
+        auto r = lib_node<NodeT>::InitDocumentRoot(
+            &doc->document, doc->memory.GetData(), doc->memory.GetSize(),
+            &root_name, &error, options_);
+        root = lib_node<NodeT>(r);
       }
-      if (!tmp_node)
-        return ERROR_PARSER_CHILD_NODE_ST;
     }
-    *outstr = tmp_node->GetParameter(param);
+    if (error.GetErrorCode()) {
+      error.LogIt();
+      return error.GetErrorCode();
+    }
+    std::vector<std::string> paths;
+    ctx_.document = doc;
+    if (root_node_ && ctx_.hashes && root_name == root_name_) {
+      root_node_->Reload(root, 0, "", &paths);
+      if (overgrown())
+        root_node_ = nullptr;
+    } else {
+      root_node_ = nullptr;
+      flat_root_ = nullptr;
+      paths.push_back("");
+    }
+    doc_root_ = root;
+    root_name_ = root_name;
+    if (!root_node_ && !flat_root_) {
+      initTree();
+    } else {
+      if (options_.path_index)
+        buildPathIndex();
+      buildQueryIndexes();
+    }
+    if (!paths.empty()) {
+      for (auto& [id, subscriber] : subscribers_)
+        subscriber(paths);
+    }
+    if (changed)
+      *changed = std::move(paths);
     return ERROR_SUCCESS_T;
   }
-
-  Initializer* GetNodeByPath(const std::vector<std::string>& path) {
-    if (!root_node_)
-      return nullptr;
-    /* todo: добавить const квалификатор */
-    node* tmp_node = root_node_.get();
-    std::string param = "";
-    param = path.back();
-    for (auto i = path.begin(); i != path.end(); ++i) {
-      if (tmp_node)
-        tmp_node = tmp_node->ChildByName(*i);
-      else
+  /**
+   * \brief Подписаться на изменения документа при Reload
+   * \return Идентификатор подписки, см. Unsubscribe
+   * */
+  size_t Subscribe(reload_subscriber subscriber) {
+    subscribers_.emplace_back(++subscriber_id_, std::move(subscriber));
+    return subscriber_id_;
+  }
+  void Unsubscribe(size_t id) {
+    for (auto s = subscribers_.begin(); s != subscribers_.end(); ++s) {
+      if (s->first == id) {
+        subscribers_.erase(s);
         break;
+      }
     }
-    if (!tmp_node)
-      return nullptr;
-    return tmp_node->node_data_ptr.get();
   }
-
-  std::string GetFileName() { return (source_) ? source_->GetURL() : ""; }
+  /**
+   * \brief Записать разобранный документ в бинарный снимок `path`
+   *
+   * Снимок загружается ридером ReaderSample<snapshot_node, ...>
+   *   без разбора(для `buffer_mode_t::mmap` - читаются только
+   *   затронутые страницы), если IsSnapshotValid(path, исходный файл)
+   * \note Для ридера, созданного из строки, исходного файла нет -
+   *   описание источника в снимке пустое
+   * */
+  merror_t SaveSnapshot(const fs::path& path) {
+    if (!lib_node<NodeT>::IsInitialized(doc_root_.data))
+      return error_.SetError(ERROR_GENERAL_T,
+                             "snapshot: document is not initialized");
+    snapshot_source source;
+    if (source_) {
+      merror_t error = GetSnapshotSource(source_->GetURL(), &source);
+      if (error)
+        return error_.SetError(error, "snapshot: source file error for " +
+                                          source_->GetURLStr());
+    }
+    return WriteSnapshot<NodeT>(path, doc_root_, root_name_, source, &error_);
+  }
 
  private:
   ReaderSample(file_utils::FileURLSample<PathT>* source,
-               InitializerFactory* factory)
+               InitializerFactory* factory,
+               const reader_options& options)
       : BaseObject(STATUS_DEFAULT),
         source_(source),
-        factory_(factory) {
+        factory_(factory),
+        options_(options) {
     init_memory();
   }
-  ReaderSample(const char* data, InitializerFactory* factory)
+  ReaderSample(const char* data,
+               InitializerFactory* factory,
+               const reader_options& options)
       : BaseObject(STATUS_DEFAULT),
         source_(nullptr),
-        factory_(factory) {
-    init_memory(data);
+        factory_(factory),
+        options_(options) {
+    if (data)
+      init_memory(data);
   }
+  ReaderSample(file_utils::FileURLSample<PathT>* source,
+               file_utils::FileBuffer&& memory,
+               InitializerFactory* factory,
+               const reader_options& options)
+      : BaseObject(STATUS_DEFAULT),
+        source_(source),
+        memory_(std::move(memory)),
+        factory_(factory),
+        options_(options) {}
   /**
-   * \brief Считать обрабатываемый файл в память объекта.
+   * \brief Загрузить обрабатываемый файл в память объекта.
    *
    * \todo Копии этой функции в каждом ридере, свести к одной имплементации
    *
    * Перегрузка функции инициализации памяти для случая
-   *   наличия файла в файловой системе.
+   *   наличия файла в файловой системе. Файл считывается
+   *   в буффер или отображается в память, в зависимости от
+   *   `reader_options::buffer_mode`
    */
-  void init_memory() {
-    const auto content = read_file(source_->GetURL(), error_);
-    init_memory(content.str().c_str());
-  }
+  void init_memory() { memory_.Load(source_->GetURL(), bufferMode(), error_); }
   /** \brief скопировать данные в память класса */
-  void init_memory(const char* data) {
-    len_memory_ = strlen(data);
-    if (len_memory_ > 0) {
-      memory_ = new char[len_memory_ + 1];
-      memset(memory_, 0, len_memory_ + 1);
-      strncpy(memory_, data, len_memory_);
+  void init_memory(const char* data) { memory_.Assign(data, strlen(data)); }
+
+  /** \brief Способ загрузки файла, см. reader_options::reloadable */
+  file_utils::buffer_mode_t bufferMode() const {
+    return options_.reloadable ? file_utils::buffer_mode_t::copy
+                               : options_.buffer_mode;
+  }
+  /** \brief Построить дерево от корня документа `doc_root_` */
+  void initTree() {
+    if (options_.flat_tree) {
+      flat_root_ = std::unique_ptr<flat_tree>(new flat_tree(factory_));
+      flat_root_->Build(doc_root_, root_name_);
+    } else {
+      // арены контекста освобождаются только вместе со старым деревом
+      root_node_ = nullptr;
+      initContext();
+      root_node_ = std::unique_ptr<node>(
+          new node(doc_root_, factory_, root_name_, &ctx_));
+      built_names_ = ctx_.names.Size();
+      built_objects_ = arenaObjects();
+    }
+    if (options_.path_index)
+      buildPathIndex();
+    buildQueryIndexes();
+  }
+  /** \brief Дерево ридера для запросов */
+  query_tree queryTree() const {
+    return query_tree(root_node_.get(), flat_root_.get());
+  }
+  /** \brief Перестроить индексы запросов по новому дереву */
+  void buildQueryIndexes() {
+    for (auto& index : query_indexes_)
+      index.Build(queryTree());
+  }
+  /** \brief Количество объектов арен инициализаторов дерева */
+  size_t arenaObjects() const {
+    size_t count = 0;
+    for (const auto& a : ctx_.arenas)
+      count += a.arena.GetObjectsCount();
+    return count;
+  }
+  /** \brief Таблица имён или арены выросли после обновлений Reload
+   *   больше порога reader_options::reload_rebuild_growth */
+  bool overgrown() const {
+    size_t growth = options_.reload_rebuild_growth;
+    if (!growth)
+      return false;
+    return ctx_.names.Size() > growth * built_names_ ||
+           arenaObjects() > growth * built_objects_;
+  }
+  /** \brief Настроить общий контекст узлов дерева
+   * \note Вызывается без дерева: имена прошлого дерева удаляются */
+  void initContext() {
+    ctx_.names.Clear();
+    ctx_.lazy = options_.lazy_init && !options_.reloadable;
+    ctx_.hashes = options_.reloadable;
+    ctx_.parallel_threshold = options_.parallel_threshold;
+    if (options_.parallel_init) {
+      pool_ = std::unique_ptr<ThreadPool>(new ThreadPool(options_.threads));
+      ctx_.pool = pool_.get();
+    }
+    if constexpr (ArenaFactoryType<InitializerFactory, Initializer, NodeT>) {
+      size_t count = pool_ ? pool_->GetThreadsCount() + 1 : 1;
+      ctx_.arenas = std::vector<node_context::initializer_arena>(
+          factory_ ? count : 0);
+    }
+  }
+  template <class PathH>
+  merror_t getValueByPath(const PathH& path, std::string* outstr) const {
+    if (!root_node_ && !flat_root_)
+      return ERROR_GENERAL_T;
+    size_t n = path_size(path);
+    std::string param = "";
+    if (n) {
+      param = path_name(path, --n);
+    }
+    Initializer* data = findByPath(path, n);
+    if (!data)
+      return ERROR_PARSER_CHILD_NODE_ST;
+    *outstr = data->GetParameter(param);
+    return ERROR_SUCCESS_T;
+  }
+  /** \brief Найти инициализированную структуру по первым `n` именам пути:
+   *   по индексу путей, если он построен, иначе обходом дерева */
+  template <class PathH>
+  Initializer* findByPath(const PathH& path, size_t n) const {
+    if (path_index_.Size()) {
+      auto* data = path_index_.Find(path, n);
+      return data ? *data : nullptr;
+    }
+    if (flat_root_)
+      return flat_root_->FindByPath(path, n);
+    if (!root_node_)
+      return nullptr;
+    /* todo: добавить const квалификатор */
+    node* tmp_node = root_node_.get();
+    for (size_t i = 0; i < n && tmp_node; ++i)
+      tmp_node = tmp_node->ChildByName(path_name(path, i),
+                                       path_name_hash(path, i));
+    return tmp_node ? tmp_node->node_data_ptr.get() : nullptr;
+  }
+  /** \brief Построить индекс путей всех узлов дерева */
+  void buildPathIndex() {
+    path_index_.Clear();
+    forEachIndexedPath([this](uint64_t hash, std::string key,
+                              const lib_node<NodeT>&, Initializer* data) {
+      path_index_.Insert(hash, std::move(key), data);
+    });
+  }
+  /** \brief Обойти узлы дерева для индекса путей:
+   *   `f(hash, key, lib_node, data)`, см. path_index::Insert
+   *
+   * Только узлы, достижимые обходом по именам: из одноимённых
+   *   соседей - первый, дочерние элементы листовых узлов не
+   *   обходятся. Так результаты поиска по индексу совпадают
+   *   с результатами обхода дерева */
+  template <class F>
+  void forEachIndexedPath(F&& f) const {
+    struct path_key {
+      uint64_t hash;
+      std::string key;
+    };
+    const auto child_key = [](const path_key& parent, bool parent_is_root,
+                              std::string_view name, uint64_t hash) {
+      path_key k{path_hash_step(parent.hash, hash), parent.key};
+      if (!parent_is_root)
+        k.key.push_back('\0');
+      k.key.append(name);
+      return k;
+    };
+    if (flat_root_) {
+      typedef typename flat_tree::node_id node_id;
+      std::vector<path_key> keys(flat_root_->Size());
+      std::vector<bool> reachable(flat_root_->Size(), false);
+      keys[0] = path_key{path_hash_seed, ""};
+      reachable[0] = true;
+      f(keys[0].hash, keys[0].key, flat_root_->GetNode(0).node,
+        flat_root_->GetNode(0).data);
+      for (node_id id = 1; id < flat_root_->Size(); ++id) {
+        const auto& fn = flat_root_->GetNode(id);
+        if (!reachable[fn.parent] || !fn.data)
+          continue;
+        const auto& name = fn.data->GetName();
+        uint64_t hash = name_hash(name);
+        if (flat_root_->ChildByName(fn.parent, name, hash) != id)
+          continue;
+        reachable[id] = true;
+        keys[id] = child_key(keys[fn.parent], fn.parent == 0, name, hash);
+        f(keys[id].hash, keys[id].key, fn.node, fn.data);
+      }
+    } else if (root_node_) {
+      std::vector<std::pair<const node*, path_key>> stack;
+      stack.emplace_back(root_node_.get(), path_key{path_hash_seed, ""});
+      while (!stack.empty()) {
+        auto [n, k] = std::move(stack.back());
+        stack.pop_back();
+        f(k.hash, k.key, n->GetLibNode(), n->node_data_ptr.get());
+        const auto& childs = n->GetChilds();
+        for (auto ch = childs.rbegin(); ch != childs.rend(); ++ch) {
+          const auto& name = (*ch)->node_data_ptr->GetName();
+          uint64_t hash = name_hash(name);
+          if (n->ChildByName(name, hash) == ch->get())
+            stack.emplace_back(
+                ch->get(), child_key(k, n == root_node_.get(), name, hash));
+        }
+      }
     }
   }
 
@@ -465,19 +2472,40 @@ class ReaderSample : public BaseObject {
   /** \brief адрес файла */
   file_utils::FileURLSample<PathT>* source_ = nullptr;
   /** \brief буффер памяти файла */
-  char* memory_ = nullptr;
-  /** \brief величина буффер памяти файла */
-  size_t len_memory_ = 0;
+  file_utils::FileBuffer memory_;
   /** \brief основной xml объект */
   typename lib_node<NodeT>::NodeDocType document_;
   // pugi::xml_document document_;
+  /** \brief пул потоков, для `reader_options::parallel_init` */
+  std::unique_ptr<ThreadPool> pool_ = nullptr;
+  /** \brief общий контекст узлов дерева, живёт дольше дерева */
+  node_context ctx_;
+  /** \brief размер таблицы имён и объектов арен при последнем
+   *   полном построении дерева, см. overgrown */
+  size_t built_names_ = 0;
+  size_t built_objects_ = 0;
   /** \brief корень json дерева
    * \note а в этом сетапе он наверное и не обязателен */
   std::unique_ptr<node_sample<NodeT, Initializer, InitializerFactory>>
       root_node_ = nullptr;
+  /** \brief плоское дерево, для `reader_options::flat_tree` */
+  std::unique_ptr<flat_tree> flat_root_ = nullptr;
+  /** \brief корень документа, см. SaveSnapshot */
+  lib_node<NodeT> doc_root_;
+  std::string root_name_;
   /** \brief фабрика создания нод json дерева
    * \note добавить такое же в XMLReader */
   InitializerFactory* factory_ = nullptr;
+  /** \brief настройки ридера */
+  reader_options options_;
+  /** \brief индекс путей узлов, для `reader_options::path_index` */
+  path_index<Initializer*> path_index_;
+  /** \brief индексы значений параметров для запросов,
+   *   см. BuildQueryIndex */
+  std::vector<query_index<query_tree>> query_indexes_;
+  /** \brief подписчики на изменения документа, см. Subscribe */
+  std::vector<std::pair<size_t, reload_subscriber>> subscribers_;
+  size_t subscriber_id_ = 0;
 };
 }  // namespace asp_utils
 
@@ -0,0 +1,142 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__READEROPTIONS_H
+#define UTILS__READEROPTIONS_H
+
+#include "asp_utils/FileBuffer.h"
+
+#include <cstddef>
+
+/**
+ * \brief Минимальное количество дочерних элементов узла, которые
+ *   инициализируются параллельно, см. reader_options::parallel_init
+ * */
+#define PARALLEL_INIT_THRESHOLD 4
+/**
+ * \brief Размер буффера чтения потоковых ридеров по умолчанию
+ * */
+#define DEFAULT_STREAM_BUFFER (64 * 1024)  // 64 KiB
+/**
+ * \brief Количество блоков в очереди потоковых ридеров, заполняемых
+ *   методом Feed, по умолчанию
+ * */
+#define DEFAULT_FEED_QUEUE 16
+/**
+ * \brief Во сколько раз таблица имён и инициализаторы арен дерева
+ *   могут вырасти при обновлениях ReaderSample::Reload относительно
+ *   последнего полного построения, прежде чем дерево строится заново,
+ *   см. reader_options::reload_rebuild_growth
+ * */
+#define RELOAD_REBUILD_GROWTH 2
+
+namespace asp_utils {
+/**
+ * \brief Настройки загрузки и разбора документа ридером
+ * */
+struct reader_options {
+  /**
+   * \brief Способ загрузки файла в память
+   * \note Для `buffer_mode_t::mmap` файл не должен изменяться
+   *   пока ридер жив - данные страниц, которые ещё не были
+   *   скопированы при записи, подтягиваются из файла
+   * */
+  file_utils::buffer_mode_t buffer_mode = file_utils::buffer_mode_t::copy;
+  /**
+   * \brief Разбирать документ на месте(RapidJSON `ParseInsitu`)
+   *
+   * Строки документа не копируются в аллокатор документа,
+   *   а указывают в буффер ридера. pugixml всегда разбирает
+   *   буффер на месте, для него флаг ничего не меняет
+   * */
+  bool parse_insitu = false;
+  /**
+   * \brief Строить плоское дерево узлов(flat_tree_sample) вместо
+   *   дерева node_sample
+   * \note Используется ReaderSample
+   * */
+  bool flat_tree = false;
+  /**
+   * \brief Построить после инициализации индекс путей всех узлов,
+   *   GetValueByPath/GetNodeByPath становятся одним поиском в
+   *   хэш-таблице вместо обхода дерева
+   * \note Используется ReaderSample
+   * */
+  bool path_index = false;
+  /**
+   * \brief Ленивая инициализация дерева node_sample: дочерние
+   *   элементы узла инициализируются при первом обращении к ним
+   *   (ChildByName, begin, GetNodeByPath), по одному уровню
+   * \note Не действует для `flat_tree`. С `path_index` всё дерево
+   *   инициализируется при построении индекса. Вызовы фабрики
+   *   узлов сериализуются мьютексом ридера
+   * */
+  bool lazy_init = false;
+  /**
+   * \brief Параллельная инициализация дерева node_sample
+   *
+   * Поддеревья дочерних элементов первого узла, у которого их не
+   *   меньше `parallel_threshold`, инициализируются в пуле потоков
+   *   ридера, каждое поддерево - последовательно в своём потоке.
+   *   Порядок дочерних элементов совпадает с последовательной
+   *   инициализацией, SetParentData вызывается после инициализации
+   *   всех дочерних элементов узла.
+   * \note Фабрика узлов используется из рабочих потоков, см.
+   *   ThreadFactoryType. Не действует для `flat_tree`
+   * */
+  bool parallel_init = false;
+  /**
+   * \brief Количество потоков параллельной инициализации,
+   *   0 - по количеству аппаратных потоков
+   * */
+  size_t threads = 0;
+  /**
+   * \brief Минимальное количество дочерних элементов узла для
+   *   параллельной инициализации
+   * */
+  size_t parallel_threshold = PARALLEL_INIT_THRESHOLD;
+  /**
+   * \brief Считать для узлов дерева node_sample структурные хэши
+   *   (см. node_sample::GetHash), чтобы ReaderSample::Reload
+   *   инициализировал заново только изменившиеся поддеревья
+   * \note Дерево инициализируется целиком(`lazy_init` не действует),
+   *   файл всегда читается в буффер(`buffer_mode_t::copy`) - узлы
+   *   неизменённых поддеревьев продолжают ссылаться на старую
+   *   версию документа
+   * */
+  bool reloadable = false;
+  /**
+   * \brief Порог перестроения дерева `reloadable` ридера: имена
+   *   и инициализаторы арен заменённых при Reload поддеревьев
+   *   освобождаются только вместе со всем деревом. Когда таблица имён
+   *   или количество объектов арен вырастает больше чем в это число
+   *   раз относительно последнего полного построения, Reload строит
+   *   дерево заново. 0 - не перестраивать
+   * */
+  size_t reload_rebuild_growth = RELOAD_REBUILD_GROWTH;
+  /**
+   * \brief Размер блока, которыми потоковые ридеры читают файл
+   * */
+  size_t stream_buffer_size = DEFAULT_STREAM_BUFFER;
+  /**
+   * \brief Максимальное количество блоков, переданных методом Feed
+   *   потоковому ридеру и ещё не разобранных. Если разборщик не
+   *   успевает, Feed ждёт освобождения места в очереди
+   * */
+  size_t feed_queue_size = DEFAULT_FEED_QUEUE;
+  /**
+   * \brief Глубина потокового разбора XMLStreamReaderSample:
+   *   элементы до этой глубины(корень - 0, корень всегда
+   *   разбирается потоково) разбираются потоково,
+   *   элементы на этой глубине загружаются в DOM целиком
+   * */
+  size_t xml_stream_depth = 1;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__READEROPTIONS_H
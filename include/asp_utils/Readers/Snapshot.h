@@ -0,0 +1,207 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * Snapshot *
+ *   Бинарный снимок разобранного документа: узлы со смещениями
+ * вместо указателей и таблица строк, загружается без разбора
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__SNAPSHOT_H
+#define UTILS__SNAPSHOT_H
+
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * \brief Версия формата снимка, снимки других версий не загружаются
+ * */
+#define SNAPSHOT_VERSION 1
+/**
+ * \brief Метка порядка байт в заголовке снимка
+ * */
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+namespace asp_utils {
+/**
+ * \brief Описание исходного файла снимка
+ * */
+struct snapshot_source {
+  /** \brief размер файла */
+  uint64_t size = 0;
+  /** \brief время изменения файла */
+  int64_t mtime = 0;
+  /** \brief хэш содержимого файла, см. content_hash */
+  uint64_t hash = 0;
+};
+
+/**
+ * \brief Заголовок снимка, лежит в начале файла
+ *
+ * Формат: заголовок, массив snapshot_record(смещение кратно 8),
+ *   таблица строк. Строки таблицы завершаются нулём. Дочерние
+ *   узлы узла расположены подряд(узлы записаны обходом в ширину),
+ *   корень - узел 0. Числа записаны в порядке байт платформы,
+ *   снимок другой платформы не загружается
+ * */
+struct snapshot_header {
+  char magic[4];
+  uint32_t version;
+  /** \brief SNAPSHOT_BYTE_ORDER в порядке байт записавшей платформы */
+  uint32_t byte_order;
+  uint32_t reserved;
+  snapshot_source source;
+  uint64_t nodes_offset;
+  uint64_t nodes_count;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+};
+
+/**
+ * \brief Узел снимка
+ * */
+struct snapshot_record {
+  /** \brief смещения имени и значения в таблице строк */
+  uint64_t name;
+  uint64_t value;
+  uint32_t name_length;
+  uint32_t value_length;
+  /** \brief индекс первого дочернего узла и их количество */
+  uint32_t first_child;
+  uint32_t childs_count;
+};
+
+/**
+ * \brief Загруженный снимок: указатели в буффер памяти снимка
+ * */
+struct snapshot_document {
+  const snapshot_header* header = nullptr;
+  const snapshot_record* nodes = nullptr;
+  const char* strings = nullptr;
+};
+
+/**
+ * \brief Узел загруженного снимка - индекс в массиве узлов
+ *
+ * Узел хранит имя, строковое значение и дочерние узлы. Значения
+ *   узлов json - строковое представление скаляров, узлов xml - текст
+ *   элемента; атрибуты xml - дочерние узлы без дочерних элементов
+ * */
+class snapshot_node {
+ public:
+  snapshot_node() = default;
+  snapshot_node(const snapshot_document* doc, uint32_t index)
+      : doc_(doc), index_(index) {}
+
+  /** \brief Узел существует */
+  bool IsValid() const {
+    return doc_ && index_ < doc_->header->nodes_count;
+  }
+  std::string_view GetName() const {
+    return IsValid() ? string(record().name, record().name_length)
+                     : std::string_view();
+  }
+  std::string_view GetValue() const {
+    return IsValid() ? string(record().value, record().value_length)
+                     : std::string_view();
+  }
+  /** \brief Количество дочерних узлов */
+  size_t GetChildsCount() const {
+    return IsValid() ? record().childs_count : 0;
+  }
+  /** \brief i-й дочерний узел */
+  snapshot_node GetChild(size_t i) const {
+    return snapshot_node(doc_,
+                         record().first_child + static_cast<uint32_t>(i));
+  }
+  /** \brief Первый дочерний узел с именем `name`, невалидный
+   *   если такого нет */
+  snapshot_node GetChild(std::string_view name) const {
+    for (size_t i = 0; i < GetChildsCount(); ++i) {
+      snapshot_node ch = GetChild(i);
+      if (ch.IsValid() && ch.GetName() == name)
+        return ch;
+    }
+    return snapshot_node();
+  }
+
+ private:
+  const snapshot_record& record() const { return doc_->nodes[index_]; }
+  /** \brief Строка таблицы, пустая если выходит за её границы */
+  std::string_view string(uint64_t offset, uint32_t length) const {
+    uint64_t size = doc_->header->strings_size;
+    if (offset > size || length > size - offset)
+      return {};
+    return std::string_view(doc_->strings + offset, length);
+  }
+
+ private:
+  const snapshot_document* doc_ = nullptr;
+  uint32_t index_ = 0;
+};
+
+/**
+ * \brief Сборщик снимка: узлы добавляются в порядке обхода в ширину
+ * */
+class snapshot_builder {
+ public:
+  /** \brief Добавить узел, вернуть его индекс */
+  uint32_t AddNode(std::string_view name, std::string_view value);
+  /** \brief Задать дочерние узлы узла `index` */
+  void SetChilds(uint32_t index, uint32_t first_child, uint32_t count);
+  /** \brief Количество узлов */
+  uint32_t Size() const { return static_cast<uint32_t>(nodes_.size()); }
+  /** \brief Записать снимок в файл `path` */
+  merror_t Write(const fs::path& path,
+                 const snapshot_source& source,
+                 ErrorWrap* ew) const;
+
+ private:
+  uint64_t addString(std::string_view str);
+
+ private:
+  std::vector<snapshot_record> nodes_;
+  std::string strings_;
+};
+
+/**
+ * \brief Хэш содержимого файла, 8 байт за шаг
+ * */
+uint64_t content_hash(const char* data, size_t size);
+/**
+ * \brief Получить размер, время изменения и, если `with_hash`,
+ *   хэш содержимого файла `path`
+ * */
+merror_t GetSnapshotSource(const fs::path& path,
+                           snapshot_source* out,
+                           bool with_hash = true);
+/**
+ * \brief Проверить заголовок снимка в буффере `memory` размера `size`
+ *   и заполнить `doc`
+ * */
+merror_t OpenSnapshot(const char* memory,
+                      size_t size,
+                      snapshot_document* doc,
+                      ErrorWrap* ew);
+/**
+ * \brief Снимок `snapshot` построен по текущей версии файла `source`:
+ *   совпадают размер и время изменения, а если `verify_content` -
+ *   и хэш содержимого
+ * \note Читается только заголовок снимка; проверка содержимого
+ *   читает исходный файл целиком(без разбора)
+ * */
+bool IsSnapshotValid(const fs::path& snapshot,
+                     const fs::path& source,
+                     bool verify_content = true);
+}  // namespace asp_utils
+
+#endif  // !UTILS__SNAPSHOT_H
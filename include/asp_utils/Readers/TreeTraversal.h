@@ -0,0 +1,254 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * TreeTraversal *
+ *   Константные итераторы дочерних элементов узлов деревьев ридеров
+ * и обход всего дерева в глубину и в ширину без рекурсии
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__TREETRAVERSAL_H
+#define UTILS__TREETRAVERSAL_H
+
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace asp_utils {
+/**
+ * \brief Константный итератор дочерних элементов узла, хранящихся
+ *   вектором std::unique_ptr: разыменование - ссылка на узел
+ * */
+template <class NodeT>
+class childs_const_iterator {
+  typedef typename std::vector<std::unique_ptr<NodeT>>::const_iterator
+      base_iterator;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = NodeT;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const NodeT*;
+  using reference = const NodeT&;
+
+ public:
+  childs_const_iterator() = default;
+  explicit childs_const_iterator(base_iterator it) : it_(it) {}
+
+  reference operator*() const { return **it_; }
+  pointer operator->() const { return it_->get(); }
+  childs_const_iterator& operator++() {
+    ++it_;
+    return *this;
+  }
+  childs_const_iterator operator++(int) {
+    childs_const_iterator it = *this;
+    ++it_;
+    return it;
+  }
+  bool operator==(const childs_const_iterator& other) const {
+    return it_ == other.it_;
+  }
+
+ private:
+  base_iterator it_;
+};
+
+/**
+ * \brief Концепт узла дерева с константным обходом дочерних
+ *   элементов: `for (const auto& ch : node)`
+ * */
+template <class NodeT>
+concept ChildsIterableType = requires(const NodeT& node) {
+  { *node.begin() } -> std::convertible_to<const NodeT&>;
+  { node.begin() == node.end() } -> std::convertible_to<bool>;
+};
+
+/**
+ * \brief Обход дерева от узла `root` в глубину(прямой порядок)
+ *
+ * Стек обхода - позиции итераторов дочерних элементов узлов текущего
+ *   пути, размер - глубина дерева, без рекурсии. Состояние обхода
+ *   только в объекте обхода: одно дерево могут обходить любое
+ *   количество потоков, каждый своим объектом. Однопроходный:
+ *   begin() начинает обход
+ * */
+template <ChildsIterableType NodeT>
+class depth_first_range {
+  typedef decltype(std::declval<const NodeT&>().begin()) childs_iterator;
+  struct frame {
+    childs_iterator next;
+    childs_iterator end;
+  };
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = NodeT;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const NodeT*;
+    using reference = const NodeT&;
+
+   public:
+    iterator() = default;
+    explicit iterator(depth_first_range* range) : range_(range) {}
+
+    reference operator*() const { return *range_->current_; }
+    pointer operator->() const { return range_->current_; }
+    /** \brief Глубина текущего узла, корень - 0 */
+    size_t GetDepth() const { return range_->stack_.size() - 1; }
+    iterator& operator++() {
+      range_->advance();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+    bool operator==(const iterator& other) const {
+      return isEnd() == other.isEnd();
+    }
+
+   private:
+    bool isEnd() const { return !range_ || !range_->current_; }
+
+   private:
+    depth_first_range* range_ = nullptr;
+  };
+
+ public:
+  explicit depth_first_range(const NodeT& root) : root_(&root) {}
+
+  iterator begin() {
+    if (!started_) {
+      started_ = true;
+      current_ = root_;
+      stack_.push_back(frame{root_->begin(), root_->end()});
+    }
+    return iterator(this);
+  }
+  iterator end() { return iterator(); }
+  /** \brief Не обходить дочерние элементы текущего узла */
+  void SkipChilds() {
+    if (current_ && !stack_.empty())
+      stack_.back().next = stack_.back().end;
+  }
+
+ private:
+  void advance() {
+    while (!stack_.empty()) {
+      frame& f = stack_.back();
+      if (f.next == f.end) {
+        stack_.pop_back();
+        continue;
+      }
+      current_ = &*f.next;
+      ++f.next;
+      // `f` невалиден после push_back
+      stack_.push_back(frame{current_->begin(), current_->end()});
+      return;
+    }
+    current_ = nullptr;
+  }
+
+ private:
+  const NodeT* root_;
+  const NodeT* current_ = nullptr;
+  /** \brief дочерние элементы узлов пути, последний - текущего узла */
+  std::vector<frame> stack_;
+  bool started_ = false;
+};
+
+/**
+ * \brief Обход дерева от узла `root` в ширину, по уровням
+ *
+ * Очередь обхода - узлы следующего уровня, без рекурсии. Как
+ *   и depth_first_range, без общего с другими обходами состояния
+ * */
+template <ChildsIterableType NodeT>
+class breadth_first_range {
+  struct item {
+    const NodeT* node;
+    size_t depth;
+  };
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = NodeT;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const NodeT*;
+    using reference = const NodeT&;
+
+   public:
+    iterator() = default;
+    explicit iterator(breadth_first_range* range) : range_(range) {}
+
+    reference operator*() const { return *range_->queue_.front().node; }
+    pointer operator->() const { return range_->queue_.front().node; }
+    /** \brief Глубина текущего узла, корень - 0 */
+    size_t GetDepth() const { return range_->queue_.front().depth; }
+    iterator& operator++() {
+      range_->advance();
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+    bool operator==(const iterator& other) const {
+      return isEnd() == other.isEnd();
+    }
+
+   private:
+    bool isEnd() const { return !range_ || range_->queue_.empty(); }
+
+   private:
+    breadth_first_range* range_ = nullptr;
+  };
+
+ public:
+  explicit breadth_first_range(const NodeT& root) : root_(&root) {}
+
+  iterator begin() {
+    if (!started_) {
+      started_ = true;
+      queue_.push_back(item{root_, 0});
+    }
+    return iterator(this);
+  }
+  iterator end() { return iterator(); }
+
+ private:
+  void advance() {
+    item current = queue_.front();
+    queue_.pop_front();
+    for (const auto& ch : *current.node)
+      queue_.push_back(item{&ch, current.depth + 1});
+  }
+
+ private:
+  const NodeT* root_;
+  /** \brief текущий узел - первый */
+  std::deque<item> queue_;
+  bool started_ = false;
+};
+
+/** \brief Обход дерева от узла `root` в глубину:
+ *   `for (const auto& node : DepthFirst(*root))` */
+template <ChildsIterableType NodeT>
+depth_first_range<NodeT> DepthFirst(const NodeT& root) {
+  return depth_first_range<NodeT>(root);
+}
+/** \brief Обход дерева от узла `root` в ширину */
+template <ChildsIterableType NodeT>
+breadth_first_range<NodeT> BreadthFirst(const NodeT& root) {
+  return breadth_first_range<NodeT>(root);
+}
+}  // namespace asp_utils
+
+#endif  // !UTILS__TREETRAVERSAL_H
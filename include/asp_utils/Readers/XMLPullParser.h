@@ -0,0 +1,182 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * XMLPullParser *
+ *   Потоковый(pull) разборщик xml - документ читается блоками,
+ * события разбора выдаются по запросу
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__XMLPULLPARSER_H
+#define UTILS__XMLPULLPARSER_H
+
+#include "asp_utils/Base.h"
+#include "asp_utils/Common.h"
+#include "asp_utils/ErrorWrap.h"
+#include "asp_utils/Readers/ReaderOptions.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asp_utils {
+/**
+ * \brief Потоковый разборщик xml
+ *
+ * Документ читается блоками фиксированного размера, в памяти
+ *   хранится непрочитанный остаток блока, стек имён открытых
+ *   элементов и данные последнего события. Поддерживаются элементы,
+ *   атрибуты, текст, CDATA, стандартные и числовые сущности;
+ *   комментарии, инструкции обработки и DOCTYPE пропускаются.
+ *   Текст только из пробельных символов не выдаётся.
+ *
+ * Поддеревья можно пропустить(SkipElement) без разбора атрибутов и
+ *   сущностей, или получить их исходный текст(CaptureElement), например
+ *   для разбора DOM парсером.
+ * \note Пространства имён не обрабатываются - префикс остаётся
+ *   частью имени
+ * */
+class XMLPullParser : public BaseObject {
+ public:
+  /**
+   * \brief Событие разбора
+   * */
+  enum class event_t {
+    /** \brief открывающий тег, см. GetName, GetAttributes */
+    start_element,
+    /** \brief закрывающий тег(и для пустых элементов `<a/>`) */
+    end_element,
+    /** \brief текст или CDATA, см. GetText */
+    text,
+    /** \brief документ закончился */
+    end_document,
+    /** \brief ошибка разбора, см. GetError */
+    error
+  };
+  /**
+   * \brief Атрибут элемента
+   * */
+  struct attribute {
+    std::string name;
+    std::string value;
+  };
+  /**
+   * \brief Функция чтения данных: записать в буффер не более
+   *   `size` байт и вернуть их количество, 0 - данных больше нет
+   * */
+  typedef std::function<size_t(char* buffer, size_t size)> read_function;
+
+ public:
+  explicit XMLPullParser(size_t chunk_size = DEFAULT_STREAM_BUFFER);
+  XMLPullParser(const XMLPullParser&) = delete;
+  XMLPullParser& operator=(const XMLPullParser&) = delete;
+  ~XMLPullParser();
+
+  /**
+   * \brief Читать документ из файла `path`
+   * */
+  merror_t Open(const fs::path& path);
+  /**
+   * \brief Разбирать документ из строки(данные копируются)
+   * */
+  void SetData(std::string_view data);
+  /**
+   * \brief Читать документ функцией `read`
+   * */
+  void SetSource(read_function read);
+
+  /**
+   * \brief Следующее событие разбора
+   * */
+  event_t Next();
+  /**
+   * \brief Пропустить элемент, открывающий тег которого был
+   *   последним событием, вместе со всем содержимым
+   * \note Закрывающий тег пропущенного элемента не выдаётся
+   * */
+  merror_t SkipElement();
+  /**
+   * \brief Получить исходный текст элемента, открывающий тег которого
+   *   был последним событием, вместе с содержимым и закрывающим тегом
+   * \note Закрывающий тег элемента не выдаётся
+   * */
+  merror_t CaptureElement(std::string* out);
+
+  /**
+   * \brief Имя элемента последнего события start_element/end_element
+   * */
+  const std::string& GetName() const { return name_; }
+  /**
+   * \brief Атрибуты элемента последнего события start_element,
+   *   сущности в значениях раскрыты
+   * */
+  const std::vector<attribute>& GetAttributes() const { return attributes_; }
+  /**
+   * \brief Значение атрибута `name` или nullptr
+   * */
+  const std::string* GetAttribute(std::string_view name) const;
+  /**
+   * \brief Текст последнего события text, сущности раскрыты
+   * */
+  const std::string& GetText() const { return text_; }
+  /**
+   * \brief Количество открытых элементов
+   * */
+  size_t GetDepth() const { return stack_.size(); }
+
+ private:
+  /** \brief Количество непрочитанных байт буффера */
+  size_t avail() const { return buf_.size() - pos_; }
+  /** \brief Дочитать блок, прочитанная часть буффера отбрасывается */
+  bool refill();
+  /** \brief Непрочитанная часть буффера начинается с `s` */
+  bool lookingAt(std::string_view s);
+  /** \brief Смещение `pattern` от текущей позиции, начиная с `from` */
+  size_t find(std::string_view pattern, size_t from);
+  /** \brief Смещение '>' конца тега(вне кавычек), начиная с `from` */
+  size_t findTagEnd(size_t from);
+  /** \brief Сместить позицию на `n` байт, дописав их в `out` */
+  void consume(size_t n, std::string* out);
+  /** \brief Пропустить конструкцию от текущей позиции до `end`
+   *   включительно */
+  bool skipTo(std::string_view end, size_t from);
+  /** \brief Пропустить DOCTYPE, с внутренним подмножеством */
+  bool skipDoctype();
+  event_t parseStartTag();
+  event_t parseEndTag();
+  /** \brief Пропустить(или захватить в `out`) текущий элемент */
+  merror_t scanElement(std::string* out);
+  event_t fail(const std::string& msg);
+
+ private:
+  /** \brief функция чтения данных */
+  read_function read_;
+  /** \brief файл, открытый методом Open */
+  std::FILE* file_ = nullptr;
+  /** \brief размер блока чтения */
+  size_t chunk_size_;
+  /** \brief буффер, непрочитанные данные начинаются с pos_ */
+  std::string buf_;
+  size_t pos_ = 0;
+  bool eof_ = false;
+  /** \brief имена открытых элементов */
+  std::vector<std::string> stack_;
+  /** \brief данные последнего события */
+  std::string name_;
+  std::vector<attribute> attributes_;
+  std::string text_;
+  /** \brief исходный текст последнего открывающего тега */
+  std::string raw_tag_;
+  /** \brief последний открывающий тег - пустой элемент `<a/>`,
+   *   следующее событие - end_element */
+  bool pending_end_ = false;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__XMLPULLPARSER_H
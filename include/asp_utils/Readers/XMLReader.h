@@ -12,13 +12,18 @@
 #include "asp_utils/Base.h"
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
+#include "asp_utils/FileBuffer.h"
 #include "asp_utils/FileURL.h"
 #include "asp_utils/Logging.h"
+#include "asp_utils/Readers/ChildIndex.h"
 #include "asp_utils/Readers/INode.h"
+#include "asp_utils/Readers/ReaderOptions.h"
+#include "asp_utils/Readers/TreeTraversal.h"
 
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <string.h>
@@ -31,7 +36,7 @@ namespace asp_utils {
 template <class Initializer,
           class InitializerFactory,
           class = typename std::enable_if<
-              std::is_base_of<INodeInitializer, Initializer>::value>::type>
+              NodeInitializerType<Initializer>>::type>
 class xml_node_sample {
   typedef xml_node_sample<Initializer, InitializerFactory> xml_node;
   /** \brief умный указатель на имплементацию xml_node */
@@ -39,6 +44,10 @@ class xml_node_sample {
   /** \brief вектор указателей на дочерние элементы */
   typedef std::vector<xml_node_ptr> childs_vec;
 
+ public:
+  /** \brief константный итератор дочерних элементов */
+  typedef childs_const_iterator<xml_node> const_iterator;
+
  public:
   /** \brief Добавить ноду к списку инициализированных(если можно)
    *   вытащив её параметры, в зависимости от типа ноды засунуть их
@@ -71,21 +80,38 @@ class xml_node_sample {
       node_data_ptr = std::unique_ptr<Initializer>(new Initializer());
     }
     initData();
-    child_it = childs.begin();
+    child_pos = 0;
   }
 
-  /** \brief Проверить наличие дочерних элементов ноды */
+  /** \brief Следующий дочерний элемент ноды, nullptr после последнего
+   * \deprecated Позиция обхода хранится в узле: обход изменяет узел
+   *   и не потокобезопасен. Используйте константные begin()/end()
+   *   или DepthFirst/BreadthFirst */
   xml_node* NextChild() {
-    return (child_it != childs.end()) ? child_it++->get() : nullptr;
+    return (child_pos < childs.size()) ? childs[child_pos++].get() : nullptr;
   }
-  /** \brief Поиск по дочерним элементам */
+  /** \brief Константный обход дочерних элементов:
+   *   `for (const auto& ch : node)`, см. также DepthFirst */
+  const_iterator begin() const { return const_iterator(childs.cbegin()); }
+  const_iterator end() const { return const_iterator(childs.cend()); }
+  /** \brief Поиск по дочерним элементам
+   * \note Если дочерних элементов не меньше CHILDS_INDEX_THRESHOLD,
+   *   поиск идёт по индексу хэшей имён */
   xml_node* ChildByName(const std::string& name) const {
     xml_node* child = nullptr;
     if (!node_data_ptr->IsLeafNode()) {
-      for (const xml_node_ptr& ch : childs) {
-        if (ch->node_data_ptr->GetName() == name) {
-          child = ch.get();
-          break;
+      if (childs_idx_.IsBuilt()) {
+        auto pos = childs_idx_.Find(name, [this, &name](size_t i) {
+          return childs[i]->node_data_ptr->GetName() == name;
+        });
+        if (pos != childs_index::npos)
+          child = childs[pos].get();
+      } else {
+        for (const xml_node_ptr& ch : childs) {
+          if (ch->node_data_ptr->GetName() == name) {
+            child = ch.get();
+            break;
+          }
         }
       }
     }
@@ -96,6 +122,16 @@ class xml_node_sample {
   std::string GetParameter(const std::string& name) {
     return node_data_ptr->GetParameter(name);
   }
+  /** \brief Получить текст подузла `name` без копирования,
+   *   если подузла нет - значение атрибута `name`
+   * \note Валидно пока жив ридер */
+  std::string_view GetParameterView(const std::string& name) const {
+    pugi::xml_node ch = node_.child(name.c_str());
+    return (!ch.empty()) ? ch.child_value()
+                         : node_.attribute(name.c_str()).value();
+  }
+  /** \brief Получить имя узла */
+  std::string_view GetNameView() const { return node_.name(); }
   /** \brief Получить xml исходник */
   const pugi::xml_node* GetSource() const { return &node_; }
   /** \brief Получить код ошибки */
@@ -136,6 +172,7 @@ class xml_node_sample {
         childs.emplace_back(xml_node_ptr(new xml_node(&ch, factory)));
     }
     setParentData();
+    buildChildsIndex();
   }
   /** \brief Инициализировать иерархичные данные
    * \note тут такое, я пока неопределился id ноды тащить
@@ -146,6 +183,15 @@ class xml_node_sample {
     for (auto& child : childs)
       child->node_data_ptr->SetParentData(*node_data_ptr);
   }
+  /** \brief Построить индекс поиска дочерних элементов по имени,
+   *   для узлов с большим количеством дочерних элементов */
+  void buildChildsIndex() {
+    if (childs.size() >= CHILDS_INDEX_THRESHOLD) {
+      childs_idx_.BuildHashes(childs.size(), [this](size_t i) {
+        return name_hash(childs[i]->node_data_ptr->GetName());
+      });
+    }
+  }
 
  private:
   ErrorWrap error_;
@@ -153,12 +199,14 @@ class xml_node_sample {
   pugi::xml_node node_;
   /** \brief имя узла */
   // std::string name_;
+  /** \brief индекс поиска дочерних элементов по имени */
+  childs_index childs_idx_;
 
  public:
   /** \brief дочерние элементы */
   childs_vec childs;
-  /** \brief итератор на обход дочерних элементов */
-  typename childs_vec::iterator child_it;
+  /** \brief позиция обхода NextChild */
+  size_t child_pos = 0;
   // такс, все необходимые для JSONReader операции
   //   реализуем здесь
   /** \brief инициализируемая структура */
@@ -175,7 +223,7 @@ template <class Initializer,
           class InitializerFactory = SimpleInitializerFactory<Initializer>,
           class PathT = fs::path,
           class = typename std::enable_if<
-              std::is_base_of<INodeInitializer, Initializer>::value>::type>
+              NodeInitializerType<Initializer>>::type>
 class XMLReaderSample : public BaseObject {
   XMLReaderSample(const XMLReaderSample&) = delete;
   XMLReaderSample operator=(const XMLReaderSample&) = delete;
@@ -185,11 +233,12 @@ class XMLReaderSample : public BaseObject {
  public:
   static XMLReaderSample<Initializer, InitializerFactory>* Init(
       file_utils::FileURLSample<PathT>* source,
-      InitializerFactory* factory = nullptr) {
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
     XMLReader* reader = nullptr;
     if (source) {
       if (is_exists(source->GetURL())) {
-        reader = new XMLReader(source, factory);
+        reader = new XMLReader(source, factory, options);
       } else {
         source->SetError(ERROR_FILE_EXISTS_ST,
                          "File '" + source->GetURLStr() + "' doesn't exists");
@@ -205,10 +254,11 @@ class XMLReaderSample : public BaseObject {
 
   static XMLReaderSample<Initializer, InitializerFactory>* Init(
       const char* data,
-      InitializerFactory* factory = nullptr) {
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
     XMLReader* reader = nullptr;
     if (data) {
-      reader = new XMLReader(data, factory);
+      reader = new XMLReader(data, factory, options);
     } else {
       Logging::Append(ERROR_INIT_NULLP_ST,
                       "Get 'data'=nullptr into "
@@ -217,17 +267,12 @@ class XMLReaderSample : public BaseObject {
     return reader;
   }
 
-  ~XMLReaderSample() {
-    if (memory_)
-      delete[] memory_;
-  }
-
   static std::string GetFilenameExtension() { return ".xml"; }
   /** \brief Инициализировать данные */
   merror_t InitData() {
-    if (!error_.GetErrorCode() && (memory_ != nullptr)) {
+    if (!error_.GetErrorCode() && !memory_.IsEmpty()) {
       pugi::xml_parse_result res =
-          document_.load_buffer_inplace(memory_, len_memory_);
+          document_.load_buffer_inplace(memory_.GetData(), memory_.GetSize());
       if (!res) {
         // ошибка разбора документа
         error_.SetError(
@@ -291,6 +336,10 @@ class XMLReaderSample : public BaseObject {
     return tmp_node->node_data_ptr.get();
   }
 
+  /** \brief Корень дерева для константного обхода, см. DepthFirst
+   * \return nullptr если дерево не инициализировано */
+  const xml_node* GetRootNode() const { return root_node_.get(); }
+
   std::string GetFileName() { return (source_) ? source_->GetURLStr() : ""; }
 
   merror_t GetErrorCode() const { return error_.GetErrorCode(); }
@@ -299,49 +348,36 @@ class XMLReaderSample : public BaseObject {
 
  private:
   XMLReaderSample(file_utils::FileURLSample<PathT>* source,
-                  InitializerFactory* factory)
+                  InitializerFactory* factory,
+                  const reader_options& options)
       : BaseObject(STATUS_DEFAULT),
         source_(source),
-        factory_(factory) {
+        factory_(factory),
+        options_(options) {
     init_memory();
   }
-  XMLReaderSample(const char* data, InitializerFactory* factory)
+  XMLReaderSample(const char* data,
+                  InitializerFactory* factory,
+                  const reader_options& options)
       : BaseObject(STATUS_DEFAULT),
         source_(nullptr),
-        factory_(factory) {
+        factory_(factory),
+        options_(options) {
     init_memory(data);
   }
-  /** \brief обход дерева xml объектов,
-   * \note вынесено в отдельный метод потому-что можно
-   *   держать лополнительное состояние, например,
-   *   глубину обхода(см питоновский скрипт в asp_therm) */
-  void tree_traversal(xml_node_sample<Initializer, InitializerFactory>* xnode) {
-    xml_node_sample<Initializer, InitializerFactory>* child;
-    while ((child = xnode->NextChild()) != nullptr) {
-      tree_traversal(child);
-    }
-  }
-  /** \brief считать файл в память */
+  /** \brief считать файл в память или отобразить его в память,
+   *   в зависимости от `reader_options::buffer_mode` */
   void init_memory() {
-    const auto content = read_file(source_->GetURL(), error_);
-    init_memory(content.str().c_str());
+    memory_.Load(source_->GetURL(), options_.buffer_mode, error_);
   }
   /** \brief скопировать данные в память класса */
-  void init_memory(const char* data) {
-    len_memory_ = strlen(data);
-    if (len_memory_ > 0) {
-      memory_ = new char[len_memory_];
-      strncpy(memory_, data, len_memory_);
-    }
-  }
+  void init_memory(const char* data) { memory_.Assign(data, strlen(data)); }
 
  private:
   /** \brief адрес файла */
   file_utils::FileURLSample<PathT>* source_ = nullptr;
   /** \brief буффер памяти файла */
-  char* memory_ = nullptr;
-  /** \brief величина буффер памяти файла */
-  size_t len_memory_ = 0;
+  file_utils::FileBuffer memory_;
   /** \brief основной json объект */
   pugi::xml_document document_;
   /** \brief корень json дерева
@@ -351,6 +387,8 @@ class XMLReaderSample : public BaseObject {
   /** \brief фабрика создания нод json дерева
    * \note добавить такое же в XMLReader */
   InitializerFactory* factory_ = nullptr;
+  /** \brief настройки ридера */
+  reader_options options_;
 };
 }  // namespace asp_utils
 
@@ -0,0 +1,396 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * XMLStreamReader *
+ *   Потоковый ридер больших xml файлов - верхние уровни документа
+ * разбираются потоково, поддеревья загружаются в DOM по одному
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__XMLSTREAMREADER_H
+#define UTILS__XMLSTREAMREADER_H
+
+#include "asp_utils/ChunkQueue.h"
+#include "asp_utils/Readers/XMLPullParser.h"
+#include "asp_utils/Readers/XMLReader.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace asp_utils {
+/**
+ * \brief Потоковый ридер xml файлов
+ *
+ * Документ читается XMLPullParser блоками
+ *   `reader_options::stream_buffer_size`. Элементы на глубине меньше
+ *   `reader_options::xml_stream_depth` разбираются потоково: InitData
+ *   получает узел pugixml только с именем и атрибутами элемента.
+ *   Перечисленные в SetSubnodesNames дочерние элементы на глубине
+ *   `xml_stream_depth` загружаются в DOM по одному и инициализируются
+ *   как в XMLReaderSample(xml_node_sample), после SetParentData
+ *   поддерево и его инициализаторы удаляются. Элементы, не
+ *   перечисленные в SetSubnodesNames, пропускаются без разбора.
+ *   Так в памяти одновременно находится только одно поддерево.
+ *   Инициализатор корневого узла и переданный в его InitData узел
+ *   pugixml живут вместе с ридером, см. GetRootData
+ *
+ * Данные можно передавать по частям(InitFeed, Feed, Finish), документ
+ *   разбирается в отдельном потоке по мере поступления блоков
+ *
+ * \note В отличие от XMLReaderSample, обходятся все дочерние элементы
+ *   с перечисленными именами, а не только первый. Текст потоково
+ *   разбираемых элементов в инициализатор не попадает
+ * */
+template <class Initializer,
+          class InitializerFactory = SimpleInitializerFactory<Initializer>,
+          class PathT = fs::path,
+          class = typename std::enable_if<
+              NodeInitializerType<Initializer>>::type>
+class XMLStreamReaderSample : public BaseObject {
+  typedef XMLStreamReaderSample<Initializer, InitializerFactory, PathT>
+      XMLStreamReader;
+  typedef xml_node_sample<Initializer, InitializerFactory> xml_node;
+
+ public:
+  XMLStreamReaderSample(const XMLStreamReaderSample&) = delete;
+  XMLStreamReaderSample operator=(const XMLStreamReaderSample&) = delete;
+  ~XMLStreamReaderSample() {
+    if (feed_thread_.joinable()) {
+      feed_->Cancel();
+      feed_thread_.join();
+    }
+  }
+
+  static XMLStreamReader* Init(
+      file_utils::FileURLSample<PathT>* source,
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    XMLStreamReader* reader = nullptr;
+    if (source) {
+      if (is_exists(source->GetURL())) {
+        reader = new XMLStreamReader(source, nullptr, factory, options);
+      } else {
+        source->SetError(ERROR_FILE_EXISTS_ST,
+                         "File '" + source->GetURLStr() + "' doesn't exists");
+        source->LogError();
+      }
+    } else {
+      Logging::Append(ERROR_INIT_NULLP_ST,
+                      "Get 'source'=nullptr into "
+                      "XMLStreamReader Init method");
+    }
+    return reader;
+  }
+
+  static XMLStreamReader* Init(
+      const char* data,
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    XMLStreamReader* reader = nullptr;
+    if (data) {
+      reader = new XMLStreamReader(nullptr, data, factory, options);
+    } else {
+      Logging::Append(ERROR_INIT_NULLP_ST,
+                      "Get 'data'=nullptr into "
+                      "XMLStreamReader Init method");
+    }
+    return reader;
+  }
+
+  /**
+   * \brief Создать ридер, данные которому передаются по частям
+   *   методом Feed, см. Finish
+   * */
+  static XMLStreamReader* InitFeed(
+      InitializerFactory* factory = nullptr,
+      const reader_options& options = reader_options()) {
+    return new XMLStreamReader(nullptr, nullptr, factory, options);
+  }
+
+  static std::string GetFilenameExtension() { return ".xml"; }
+  /** \brief Разобрать документ, инициализируя узлы по ходу чтения */
+  merror_t InitData() {
+    if (!error_.GetErrorCode()) {
+      XMLPullParser parser(std::max<size_t>(options_.stream_buffer_size, 16));
+      if (source_) {
+        if (parser.Open(source_->GetURL()))
+          error_.SetError(parser.GetError(),
+                          "cannot open file " + source_->GetURLStr());
+      } else {
+        parser.SetData(data_);
+      }
+      if (!error_.GetErrorCode())
+        parse(parser);
+    }
+    return setStatus();
+  }
+  /**
+   * \brief Передать ридеру следующую часть документа
+   *
+   * Документ разбирается в отдельном потоке по мере поступления
+   *   данных, блок копируется в очередь ридера. Если в очереди уже
+   *   `reader_options::feed_queue_size` неразобранных блоков - вызов
+   *   ждёт, пока разборщик их обработает
+   * \return ERROR_PARSER_PARSE_ST если разбор уже прерван ошибкой,
+   *   саму ошибку вернёт Finish
+   * */
+  merror_t Feed(std::string_view chunk) {
+    startFeed();
+    return feed_->Push(chunk) ? ERROR_SUCCESS_T : ERROR_PARSER_PARSE_ST;
+  }
+  /**
+   * \brief Данных больше не будет - дождаться окончания разбора
+   * \return Код ошибки разбора, как у InitData
+   * */
+  merror_t Finish() {
+    startFeed();
+    if (feed_thread_.joinable()) {
+      feed_->Close();
+      feed_thread_.join();
+    }
+    return setStatus();
+  }
+  /** \brief Инициализированная структура корневого узла */
+  Initializer* GetRootData() { return root_ ? root_->data.get() : nullptr; }
+  /** \brief Количество потоково разобранных элементов */
+  size_t GetStreamedCount() const { return streamed_count_; }
+  /** \brief Количество загруженных в DOM поддеревьев */
+  size_t GetSubtreesCount() const { return subtrees_count_; }
+
+  std::string GetFileName() { return (source_) ? source_->GetURLStr() : ""; }
+
+  merror_t GetErrorCode() const { return error_.GetErrorCode(); }
+
+ private:
+  /** \brief Потоково разбираемый элемент на стеке текущего пути */
+  struct stream_level {
+    /** \brief Узел `name` есть в списке обходимых поддеревьев */
+    bool IsSubnode(const std::string& name) const {
+      return std::find(subnodes.begin(), subnodes.end(), name) !=
+             subnodes.end();
+    }
+
+    /** \brief документ с копией элемента, без содержимого */
+    pugi::xml_document document;
+    /** \brief копия элемента в `document`, адрес передаётся
+     *   в InitData и валиден, пока жив уровень(для корня - ридер) */
+    pugi::xml_node node;
+    /** \brief инициализируемая структура */
+    std::unique_ptr<Initializer> data;
+    /** \brief имена обходимых поддеревьев */
+    inodes_vec subnodes;
+  };
+
+ private:
+  XMLStreamReaderSample(file_utils::FileURLSample<PathT>* source,
+                        const char* data,
+                        InitializerFactory* factory,
+                        const reader_options& options)
+      : BaseObject(STATUS_DEFAULT),
+        source_(source),
+        factory_(factory),
+        options_(options) {
+    if (data)
+      data_ = data;
+  }
+
+  stream_level& top() { return *levels_[depth_ - 1]; }
+  /** \brief Разобрать документ */
+  void parse(XMLPullParser& parser) {
+    parseEvents(parser);
+    if (!error_.GetErrorCode() && !root_)
+      error_.SetError(ERROR_PARSER_PARSE_ST,
+                      "ошибка инициализации корневого элемента xml файла");
+    levels_.clear();
+    depth_ = 0;
+  }
+  /** \brief Цикл разбора событий */
+  void parseEvents(XMLPullParser& parser) {
+    for (;;) {
+      switch (parser.Next()) {
+        case XMLPullParser::event_t::start_element:
+          if (!startElement(parser))
+            return;
+          break;
+        case XMLPullParser::event_t::end_element:
+          endElement();
+          break;
+        case XMLPullParser::event_t::text:
+          break;
+        case XMLPullParser::event_t::end_document:
+          return;
+        case XMLPullParser::event_t::error:
+          error_.SetError(parser.GetError(), parser.GetErrorMessage());
+          return;
+      }
+    }
+  }
+  merror_t setStatus() {
+    if (error_.GetErrorCode()) {
+      status_ = STATUS_HAVE_ERROR;
+      error_.LogIt();
+    } else {
+      status_ = STATUS_OK;
+    }
+    return error_.GetErrorCode();
+  }
+  /** \brief Запустить поток разбора данных, передаваемых Feed */
+  void startFeed() {
+    if (feed_)
+      return;
+    feed_ = std::unique_ptr<ChunkQueue>(
+        new ChunkQueue(options_.feed_queue_size));
+    feed_thread_ = std::thread([this]() {
+      ChunkQueue* queue = feed_.get();
+      XMLPullParser parser(std::max<size_t>(options_.stream_buffer_size, 16));
+      parser.SetSource([queue](char* buffer, size_t size) {
+        return queue->Read(buffer, size);
+      });
+      if (!error_.GetErrorCode())
+        parse(parser);
+      // остаток данных не нужен, источник не должен ждать
+      if (error_.GetErrorCode())
+        queue->Cancel();
+      else
+        queue->Drain();
+    });
+  }
+  bool startElement(XMLPullParser& parser) {
+    if (depth_) {
+      stream_level& parent = top();
+      if (!parent.IsSubnode(parser.GetName())) {
+        return !setParserError(parser.SkipElement(), parser);
+      }
+      if (depth_ >= options_.xml_stream_depth)
+        return loadSubtree(parser, parent);
+    } else if (root_) {
+      // корневой элемент уже разобран
+      return !setParserError(parser.SkipElement(), parser);
+    }
+    return push(parser);
+  }
+  void endElement() {
+    if (!depth_)
+      return;
+    if (depth_ == 1) {
+      root_ = std::move(levels_[0]);
+      levels_[0].reset(new stream_level());
+    } else {
+      stream_level& child = top();
+      child.data->SetParentData(*levels_[depth_ - 2]->data);
+      child.data.reset();
+    }
+    --depth_;
+  }
+  /** \brief Положить на стек потоково разбираемый элемент
+   *   и инициализировать его */
+  bool push(XMLPullParser& parser) {
+    if (depth_ == levels_.size())
+      levels_.emplace_back(new stream_level());
+    stream_level& l = *levels_[depth_++];
+    l.document.reset();
+    l.subnodes.clear();
+    l.node = l.document.append_child(parser.GetName().c_str());
+    for (const auto& attr : parser.GetAttributes())
+      l.node.append_attribute(attr.name.c_str()).set_value(attr.value.c_str());
+    l.data = createInitializer();
+    if (!l.data)
+      return false;
+    merror_t error = l.data->InitData(&l.node, parser.GetName());
+    if (error) {
+      error_.SetError(error, "Initializer InitData finished with error for "
+                             "node '" + parser.GetName() + "'");
+      return false;
+    }
+    l.data->SetSubnodesNames(&l.subnodes);
+    ++streamed_count_;
+    return true;
+  }
+  /** \brief Загрузить текущий элемент в DOM, инициализировать
+   *   поддерево и связать с родителем */
+  bool loadSubtree(XMLPullParser& parser, stream_level& parent) {
+    if (setParserError(parser.CaptureElement(&subtree_), parser))
+      return false;
+    pugi::xml_document document;
+    pugi::xml_parse_result res =
+        document.load_buffer_inplace(subtree_.data(), subtree_.size());
+    if (!res) {
+      error_.SetError(ERROR_PARSER_FORMAT_ST,
+                      std::string("pugixml parse error: ") + res.description());
+      return false;
+    }
+    pugi::xml_node r = *document.begin();
+    xml_node child(&r, factory_);
+    if (!child.node_data_ptr) {
+      error_.SetError(child.GetError() ? child.GetError() : ERROR_GENERAL_T,
+                      "ошибка инициализации элемента '" + parser.GetName() +
+                          "' xml файла");
+      return false;
+    }
+    // ошибка InitData вложенного элемента остаётся в его узле
+    for (const auto& n : DepthFirst(child)) {
+      if (n.GetError()) {
+        error_.SetError(n.GetError(), "ошибка инициализации элемента '" +
+                                          parser.GetName() + "' xml файла");
+        return false;
+      }
+    }
+    child.node_data_ptr->SetParentData(*parent.data);
+    ++subtrees_count_;
+    return true;
+  }
+  std::unique_ptr<Initializer> createInitializer() {
+    std::unique_ptr<Initializer> data;
+    if (factory_) {
+      data = std::unique_ptr<Initializer>(
+          factory_->template GetNodeInitializer<pugi::xml_node>());
+      if (!data)
+        error_.SetError(ERROR_GENERAL_T, "Ошибка использования фабрики узлов");
+    } else {
+      data = std::unique_ptr<Initializer>(new Initializer());
+    }
+    return data;
+  }
+  /** \brief Перенести ошибку разборщика `error` в error_
+   * \return true если ошибка есть */
+  bool setParserError(merror_t error, const XMLPullParser& parser) {
+    if (error)
+      error_.SetError(error, parser.GetErrorMessage());
+    return error != ERROR_SUCCESS_T;
+  }
+
+ private:
+  /** \brief адрес файла */
+  file_utils::FileURLSample<PathT>* source_ = nullptr;
+  /** \brief данные, переданные строкой */
+  std::string data_;
+  /** \brief фабрика инициализаторов */
+  InitializerFactory* factory_ = nullptr;
+  /** \brief настройки ридера */
+  reader_options options_;
+  /** \brief стек потоково разбираемых элементов, переиспользуются */
+  std::vector<std::unique_ptr<stream_level>> levels_;
+  /** \brief глубина текущего пути */
+  size_t depth_ = 0;
+  /** \brief буффер исходного текста поддерева */
+  std::string subtree_;
+  /** \brief корневой узел, после его закрытия */
+  std::unique_ptr<stream_level> root_;
+  size_t streamed_count_ = 0;
+  size_t subtrees_count_ = 0;
+  /** \brief очередь данных, переданных методом Feed */
+  std::unique_ptr<ChunkQueue> feed_;
+  /** \brief поток разбора данных Feed */
+  std::thread feed_thread_;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__XMLSTREAMREADER_H
@@ -0,0 +1,101 @@
+/**
+ * asp_utils library
+ * ===================================================================
+ * * ThreadPool *
+ *   Пул потоков фиксированного размера
+ * ===================================================================
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#ifndef UTILS__THREADPOOL_H
+#define UTILS__THREADPOOL_H
+
+#include "asp_utils/Common.h"
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace asp_utils {
+/**
+ * \brief Пул потоков фиксированного размера с общей очередью задач
+ *
+ * Деструктор дожидается выполнения всех поставленных задач.
+ * \note Задача, ожидающая результата другой задачи того же пула,
+ *   может заблокировать пул - вложенные задачи стоит выполнять
+ *   в текущем потоке, см. GetCurrentWorker
+ * */
+class ThreadPool {
+ public:
+  /** \brief индекс потока, не являющегося рабочим потоком пула */
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+ public:
+  /**
+   * \brief Запустить `threads` рабочих потоков,
+   *   0 - по количеству аппаратных потоков
+   * */
+  explicit ThreadPool(size_t threads = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  /**
+   * \brief Поставить задачу в очередь
+   * \return future результата задачи, исключения задачи
+   *   пробрасываются из future::get
+   * */
+  template <class F>
+  std::future<std::invoke_result_t<F>> Submit(F&& f) {
+    typedef std::invoke_result_t<F> result_t;
+    auto task = std::make_shared<std::packaged_task<result_t()>>(
+        std::forward<F>(f));
+    std::future<result_t> result = task->get_future();
+    push([task]() { (*task)(); });
+    return result;
+  }
+  /**
+   * \brief Количество рабочих потоков
+   * */
+  size_t GetThreadsCount() const { return threads_.size(); }
+  /**
+   * \brief Индекс рабочего потока этого пула, в котором выполняется
+   *   вызов, или npos если вызов не из рабочего потока этого пула
+   *   (в том числе из рабочего потока другого пула)
+   * */
+  size_t GetCurrentWorker() const;
+  /**
+   * \brief Индекс рабочего потока(в его пуле), в котором выполняется
+   *   вызов, или npos если вызов не из рабочего потока пула
+   * \note Пул потока не проверяется, см. GetCurrentWorker
+   * */
+  static size_t GetWorkerIndex();
+  /**
+   * \brief Пул, рабочим потоком которого является текущий поток,
+   *   или nullptr
+   * */
+  static const ThreadPool* GetCurrentPool();
+
+ private:
+  void push(std::function<void()>&& task);
+  void worker(size_t index);
+
+ private:
+  std::vector<std::thread> threads_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+};
+}  // namespace asp_utils
+
+#endif  // !UTILS__THREADPOOL_H
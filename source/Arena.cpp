@@ -0,0 +1,89 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace asp_utils {
+namespace {
+inline char* align_up(char* p, size_t align) {
+  uintptr_t v = reinterpret_cast<uintptr_t>(p);
+  return reinterpret_cast<char*>((v + align - 1) & ~(uintptr_t)(align - 1));
+}
+}  // namespace
+
+Arena::Arena(size_t block_size) : block_size_(block_size) {}
+
+Arena::Arena(Arena&& other) noexcept
+    : block_size_(other.block_size_),
+      head_(std::exchange(other.head_, nullptr)),
+      cursor_(std::exchange(other.cursor_, nullptr)),
+      end_(std::exchange(other.end_, nullptr)),
+      dtors_(std::exchange(other.dtors_, nullptr)),
+      objects_count_(std::exchange(other.objects_count_, 0)),
+      allocated_(std::exchange(other.allocated_, 0)) {}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+  if (this != &other) {
+    Release();
+    block_size_ = other.block_size_;
+    head_ = std::exchange(other.head_, nullptr);
+    cursor_ = std::exchange(other.cursor_, nullptr);
+    end_ = std::exchange(other.end_, nullptr);
+    dtors_ = std::exchange(other.dtors_, nullptr);
+    objects_count_ = std::exchange(other.objects_count_, 0);
+    allocated_ = std::exchange(other.allocated_, 0);
+  }
+  return *this;
+}
+
+Arena::~Arena() {
+  Release();
+}
+
+void* Arena::Allocate(size_t size, size_t align) {
+  char* p = align_up(cursor_, align);
+  if (!cursor_ || p + size > end_) {
+    add_block(size, align);
+    p = align_up(cursor_, align);
+  }
+  cursor_ = p + size;
+  return p;
+}
+
+void Arena::Release() {
+  for (dtor_node* d = dtors_; d; d = d->next)
+    d->destroy(d->object);
+  dtors_ = nullptr;
+  while (head_) {
+    block* next = head_->next;
+    std::free(head_);
+    head_ = next;
+  }
+  cursor_ = end_ = nullptr;
+  objects_count_ = 0;
+  allocated_ = 0;
+}
+
+void Arena::add_block(size_t size, size_t align) {
+  // крупные объекты получают собственный блок
+  size_t len = sizeof(block) + std::max(block_size_, size + align);
+  block* b = static_cast<block*>(std::malloc(len));
+  if (!b)
+    throw std::bad_alloc();
+  b->next = head_;
+  b->size = len;
+  head_ = b;
+  cursor_ = reinterpret_cast<char*>(b + 1);
+  end_ = reinterpret_cast<char*>(b) + len;
+  allocated_ += len;
+}
+}  // namespace asp_utils
@@ -0,0 +1,85 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/ChunkQueue.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace asp_utils {
+ChunkQueue::ChunkQueue(size_t max_chunks)
+    : max_chunks_(std::max<size_t>(max_chunks, 1)) {}
+
+bool ChunkQueue::Push(std::string_view chunk) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  not_full_.wait(lock, [this]() {
+    return cancelled_ || drained_ || chunks_.size() < max_chunks_;
+  });
+  if (cancelled_)
+    return false;
+  if (!drained_ && !chunk.empty()) {
+    chunks_.emplace_back(chunk);
+    not_empty_.notify_one();
+  }
+  return true;
+}
+
+void ChunkQueue::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  not_empty_.notify_all();
+}
+
+size_t ChunkQueue::Read(char* buffer, size_t size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  size_t read = 0;
+  while (read < size) {
+    not_empty_.wait(lock, [this, read]() {
+      return cancelled_ || closed_ || !chunks_.empty() || read > 0;
+    });
+    // отдать уже прочитанное, не дожидаясь следующего блока
+    if (cancelled_ || chunks_.empty())
+      break;
+    const std::string& front = chunks_.front();
+    size_t n = std::min(size - read, front.size() - offset_);
+    memcpy(buffer + read, front.data() + offset_, n);
+    read += n;
+    offset_ += n;
+    if (offset_ == front.size()) {
+      chunks_.pop_front();
+      offset_ = 0;
+      not_full_.notify_one();
+    }
+  }
+  return cancelled_ ? 0 : read;
+}
+
+void ChunkQueue::Cancel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    chunks_.clear();
+    offset_ = 0;
+  }
+  not_full_.notify_all();
+  not_empty_.notify_all();
+}
+
+void ChunkQueue::Drain() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drained_ = true;
+    chunks_.clear();
+    offset_ = 0;
+  }
+  not_full_.notify_all();
+}
+}  // namespace asp_utils
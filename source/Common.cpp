@@ -38,6 +38,17 @@ std::string trim_str(const std::string& str) {
                    .base());
 }
 
+std::string_view trim_view(std::string_view str) {
+  const auto space = [](char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+  };
+  while (!str.empty() && space(str.front()))
+    str.remove_prefix(1);
+  while (!str.empty() && space(str.back()))
+    str.remove_suffix(1);
+  return str;
+}
+
 bool is_exists(const fs::path& path) {
   return fs::exists(path);
 }
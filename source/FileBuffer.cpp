@@ -0,0 +1,166 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/FileBuffer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#include <string.h>
+
+#if defined(OS_UNIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // OS_UNIX
+
+namespace asp_utils {
+namespace file_utils {
+FileBuffer::FileBuffer(FileBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      capacity_(std::exchange(other.capacity_, 0)),
+      mapped_size_(std::exchange(other.mapped_size_, 0)) {}
+
+FileBuffer& FileBuffer::operator=(FileBuffer&& other) noexcept {
+  if (this != &other) {
+    Reset();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    capacity_ = std::exchange(other.capacity_, 0);
+    mapped_size_ = std::exchange(other.mapped_size_, 0);
+  }
+  return *this;
+}
+
+FileBuffer::~FileBuffer() {
+  Reset();
+}
+
+merror_t FileBuffer::Load(const fs::path& path,
+                          buffer_mode_t mode,
+                          ErrorWrap& error) {
+  Reset();
+  if (!fs::exists(path))
+    return error.SetError(ERROR_FILE_EXISTS_ST,
+                          "File open error for: " + path.string());
+  if (mode == buffer_mode_t::mmap && map(path))
+    return ERROR_SUCCESS_T;
+  return read(path, error);
+}
+
+merror_t FileBuffer::Assign(const char* data, size_t len) {
+  Reset();
+  if (!data)
+    return ERROR_INIT_NULLP_ST;
+  if (len > 0) {
+    data_ = new char[len + 1];
+    memcpy(data_, data, len);
+    data_[len] = '\0';
+    size_ = len;
+    capacity_ = len;
+  }
+  return ERROR_SUCCESS_T;
+}
+
+merror_t FileBuffer::Append(const char* data, size_t len) {
+  if (len == 0)
+    return ERROR_SUCCESS_T;
+  if (!data)
+    return ERROR_INIT_NULLP_ST;
+  if (mapped_size_ || size_ + len > capacity_) {
+    size_t size = size_;
+    size_t capacity = std::max(size + len, capacity_ * 2);
+    char* mem = new char[capacity + 1];
+    if (size)
+      memcpy(mem, data_, size);
+    Reset();
+    data_ = mem;
+    size_ = size;
+    capacity_ = capacity;
+  }
+  memcpy(data_ + size_, data, len);
+  size_ += len;
+  data_[size_] = '\0';
+  return ERROR_SUCCESS_T;
+}
+
+void FileBuffer::Reset() {
+#if defined(OS_UNIX)
+  if (mapped_size_)
+    munmap(data_, mapped_size_);
+  else
+    delete[] data_;
+#else
+  delete[] data_;
+#endif  // OS_UNIX
+  data_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+  mapped_size_ = 0;
+}
+
+bool FileBuffer::map(const fs::path& path) {
+#if defined(OS_UNIX)
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  bool mapped = false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    size_t len = static_cast<size_t>(st.st_size);
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    // хвост последней страницы ядро заполняет нулями, его и используем
+    //   как завершающий ноль. Если файл кратен размеру страницы,
+    //   то за его концом ничего нет - обращение вызовет SIGBUS
+    if (len % page != 0) {
+      void* addr =
+          mmap(nullptr, len + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, len + 1, MADV_SEQUENTIAL);
+        data_ = static_cast<char*>(addr);
+        size_ = len;
+        mapped_size_ = len + 1;
+        mapped = true;
+      }
+    }
+  }
+  close(fd);
+  return mapped;
+#else
+  (void)path;
+  return false;
+#endif  // OS_UNIX
+}
+
+merror_t FileBuffer::read(const fs::path& path, ErrorWrap& error) {
+  std::error_code ec;
+  size_t len = static_cast<size_t>(fs::file_size(path, ec));
+  if (ec)
+    return error.SetError(ERROR_FILE_IN_ST,
+                          "File size error for: " + path.string());
+  if (len == 0)
+    return ERROR_SUCCESS_T;
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+    return error.SetError(ERROR_FILE_IN_ST,
+                          "File open error for: " + path.string());
+  data_ = new char[len + 1];
+  capacity_ = len;
+  in.read(data_, static_cast<std::streamsize>(len));
+  size_ = static_cast<size_t>(in.gcount());
+  data_[size_] = '\0';
+  if (size_ != len)
+    return error.SetError(ERROR_FILE_IN_ST,
+                          "File read error for: " + path.string());
+  return ERROR_SUCCESS_T;
+}
+}  // namespace file_utils
+}  // namespace asp_utils
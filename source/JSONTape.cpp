@@ -0,0 +1,734 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Readers/JSONTape.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <string>
+
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define JSON_TAPE_X86
+#include <immintrin.h>
+#endif  // x86
+
+namespace asp_utils {
+namespace {
+/** \brief Маски символов блока из 64 байт: бит i - байт i */
+struct block_masks {
+  uint64_t quote;
+  uint64_t backslash;
+  /** \brief `{}[]:,` */
+  uint64_t op;
+  /** \brief пробел, `\t`, `\n`, `\r` */
+  uint64_t ws;
+  /** \brief байты меньше 0x20 */
+  uint64_t ctrl;
+};
+
+/** \brief Запись в конец индекса, память добавляется с запасом
+ *   на блок */
+class index_writer {
+ public:
+  explicit index_writer(std::vector<uint32_t>* index)
+      : index_(index), size_(index->size()) {}
+  ~index_writer() { index_->resize(size_); }
+
+  void Flatten(uint64_t bits, uint32_t base) {
+    if (size_ + 64 > index_->size())
+      index_->resize(std::max<size_t>(index_->size() * 2, 1024));
+    uint32_t* out = index_->data() + size_;
+    int count = std::popcount(bits);
+    // по 4 позиции без ветвлений, лишние записи за `count`
+    //   перезапишет следующий блок
+    for (int i = 0; i < count; i += 4) {
+      out[i] = base + static_cast<uint32_t>(std::countr_zero(bits));
+      bits &= bits - 1;
+      out[i + 1] = base + static_cast<uint32_t>(std::countr_zero(bits));
+      bits &= bits - 1;
+      out[i + 2] = base + static_cast<uint32_t>(std::countr_zero(bits));
+      bits &= bits - 1;
+      out[i + 3] = base + static_cast<uint32_t>(std::countr_zero(bits));
+      bits &= bits - 1;
+    }
+    size_ += count;
+  }
+
+ private:
+  std::vector<uint32_t>* index_;
+  size_t size_;
+};
+
+/** \brief Состояние первого этапа между блоками и кусками */
+struct scan_state {
+  /** \brief блок закончился нечётной серией `\` */
+  uint64_t odd_backslash = 0;
+  /** \brief блок закончился внутри строки: все единицы или 0 */
+  uint64_t in_string = 0;
+  /** \brief последний байт блока - часть скаляра */
+  uint64_t scalar = 0;
+  /** \brief управляющие символы в строках */
+  uint64_t error = 0;
+  /** \brief в документе есть `\` */
+  uint64_t backslash = 0;
+};
+
+/** \brief Первый этап для байт [begin, end) документа `data`:
+ *   `begin` кратен 64, `end` тоже или равен длине документа */
+using scan_chunk_fn = void (*)(const char* data,
+                               size_t begin,
+                               size_t end,
+                               scan_state* s,
+                               std::vector<uint32_t>* index);
+
+/** \brief Бит i результата - xor битов 0..i */
+uint64_t prefix_xor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+/** \brief Экранированные символы: следующие за нечётной серией `\` */
+uint64_t escaped_chars(uint64_t backslash, uint64_t* odd_backslash) {
+  const uint64_t even_bits = 0x5555555555555555ULL;
+  const uint64_t odd_bits = ~even_bits;
+  uint64_t starts = backslash & ~(backslash << 1);
+  // серия, продолжающая нечётную серию прошлого блока, меняет чётность
+  uint64_t even_start_mask = even_bits ^ *odd_backslash;
+  uint64_t even_starts = starts & even_start_mask;
+  uint64_t odd_starts = starts & ~even_start_mask;
+  uint64_t even_carries = backslash + even_starts;
+  uint64_t odd_carries = backslash + odd_starts;
+  bool ends_odd = odd_carries < backslash;
+  odd_carries |= *odd_backslash;
+  *odd_backslash = ends_odd ? 1 : 0;
+  uint64_t even_carry_ends = even_carries & ~backslash;
+  uint64_t odd_carry_ends = odd_carries & ~backslash;
+  return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+}
+
+/** \brief Структурные символы блока по маскам его байт */
+void process_block(const block_masks& m,
+                   uint32_t base,
+                   scan_state* s,
+                   index_writer* w) {
+  s->backslash |= m.backslash;
+  uint64_t quote = m.quote & ~escaped_chars(m.backslash, &s->odd_backslash);
+  // открывающая кавычка и содержимое строки, без закрывающей кавычки
+  uint64_t in_string = prefix_xor(quote) ^ s->in_string;
+  s->in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+  s->error |= m.ctrl & in_string;
+  uint64_t scalar = ~(m.op | m.ws | quote | in_string);
+  uint64_t scalar_start = scalar & ~((scalar << 1) | s->scalar);
+  s->scalar = scalar >> 63;
+  w->Flatten((m.op & ~in_string) | quote | scalar_start, base);
+}
+
+bool is_op(char c) {
+  return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+bool is_ws(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/** \brief Маски блока по байтам, для остатка документа
+ *   без SIMD-реализации */
+block_masks scalar_masks(const char* data) {
+  block_masks m = {0, 0, 0, 0, 0};
+  for (int i = 0; i < 64; ++i) {
+    uint64_t bit = uint64_t(1) << i;
+    char c = data[i];
+    if (c == '"')
+      m.quote |= bit;
+    else if (c == '\\')
+      m.backslash |= bit;
+    else if (is_op(c))
+      m.op |= bit;
+    if (is_ws(c))
+      m.ws |= bit;
+    if (static_cast<unsigned char>(c) < 0x20)
+      m.ctrl |= bit;
+  }
+  return m;
+}
+
+/** \brief Первый этап без SIMD - побайтовый автомат, состояние
+ *   в тех же полях scan_state */
+void scan_scalar(const char* data,
+                 size_t begin,
+                 size_t end,
+                 scan_state* s,
+                 std::vector<uint32_t>* index) {
+  bool in_string = s->in_string, escaped = s->odd_backslash,
+       scalar = s->scalar;
+  for (size_t i = begin; i < end; ++i) {
+    char c = data[i];
+    bool quote = c == '"' && !escaped;
+    escaped = !escaped && c == '\\';
+    s->backslash |= c == '\\';
+    if (in_string) {
+      if (quote) {
+        in_string = false;
+        index->push_back(static_cast<uint32_t>(i));
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        s->error = 1;
+      }
+      scalar = false;
+    } else if (quote || is_op(c)) {
+      in_string = quote;
+      index->push_back(static_cast<uint32_t>(i));
+      scalar = false;
+    } else if (is_ws(c)) {
+      scalar = false;
+    } else {
+      if (!scalar)
+        index->push_back(static_cast<uint32_t>(i));
+      scalar = true;
+    }
+  }
+  s->in_string = in_string ? ~uint64_t(0) : 0;
+  s->odd_backslash = escaped;
+  s->scalar = scalar;
+}
+
+/** \brief Первый этап блоками по 64 байта: `masks` - маски
+ *   полного блока, остаток документа дополняется пробелами
+ * \note Встраивается в функции с SIMD, чтобы в них
+ *   встроилась и `masks` */
+template <class Masks>
+__attribute__((always_inline)) inline void scan_blocks(
+    const char* data,
+    size_t begin,
+    size_t end,
+    scan_state* s,
+    std::vector<uint32_t>* index,
+    Masks masks) {
+  index_writer w(index);
+  size_t i = begin;
+  for (; i + 64 <= end; i += 64)
+    process_block(masks(data + i), static_cast<uint32_t>(i), s, &w);
+  if (i < end) {
+    char tail[64];
+    memset(tail, ' ', sizeof(tail));
+    memcpy(tail, data + i, end - i);
+    process_block(scalar_masks(tail), static_cast<uint32_t>(i), s, &w);
+  }
+}
+
+#ifdef JSON_TAPE_X86
+__attribute__((target("sse4.2"))) inline uint64_t eq16(__m128i v, char c) {
+  return static_cast<uint16_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+}
+
+__attribute__((target("sse4.2"))) block_masks sse42_masks(const char* data) {
+  block_masks m = {0, 0, 0, 0, 0};
+  const __m128i lower = _mm_set1_epi8(0x20);
+  const __m128i ctrl = _mm_set1_epi8(0x1f);
+  for (int k = 0; k < 4; ++k) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * k));
+    // `[` и `]` отличаются от `{` и `}` только битом 0x20
+    __m128i vl = _mm_or_si128(v, lower);
+    int shift = 16 * k;
+    m.quote |= eq16(v, '"') << shift;
+    m.backslash |= eq16(v, '\\') << shift;
+    m.op |= (eq16(vl, '{') | eq16(vl, '}') | eq16(v, ':') | eq16(v, ','))
+            << shift;
+    m.ws |= (eq16(v, ' ') | eq16(v, '\t') | eq16(v, '\n') | eq16(v, '\r'))
+            << shift;
+    m.ctrl |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(
+                  _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl))))
+              << shift;
+  }
+  return m;
+}
+
+__attribute__((target("sse4.2"))) void scan_sse42(
+    const char* data,
+    size_t begin,
+    size_t end,
+    scan_state* s,
+    std::vector<uint32_t>* index) {
+  scan_blocks(data, begin, end, s, index, sse42_masks);
+}
+
+__attribute__((target("avx2"))) inline uint64_t eq32(__m256i v, char c) {
+  return static_cast<uint32_t>(
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+}
+
+__attribute__((target("avx2"))) block_masks avx2_masks(const char* data) {
+  block_masks m = {0, 0, 0, 0, 0};
+  const __m256i lower = _mm256_set1_epi8(0x20);
+  const __m256i ctrl = _mm256_set1_epi8(0x1f);
+  for (int k = 0; k < 2; ++k) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32 * k));
+    __m256i vl = _mm256_or_si256(v, lower);
+    int shift = 32 * k;
+    m.quote |= eq32(v, '"') << shift;
+    m.backslash |= eq32(v, '\\') << shift;
+    m.op |= (eq32(vl, '{') | eq32(vl, '}') | eq32(v, ':') | eq32(v, ','))
+            << shift;
+    m.ws |= (eq32(v, ' ') | eq32(v, '\t') | eq32(v, '\n') | eq32(v, '\r'))
+            << shift;
+    m.ctrl |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(
+                  _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl))))
+              << shift;
+  }
+  return m;
+}
+
+__attribute__((target("avx2"))) void scan_avx2(
+    const char* data,
+    size_t begin,
+    size_t end,
+    scan_state* s,
+    std::vector<uint32_t>* index) {
+  scan_blocks(data, begin, end, s, index, avx2_masks);
+}
+#endif  // JSON_TAPE_X86
+
+/**
+ * \brief Первый этап по кускам JSON_TAPE_CHUNK байт: индекс куска
+ *   дописывается к необработанному остатку индекса, память индекса
+ *   не растёт с размером документа
+ * */
+class structural_scanner {
+ public:
+  /** \brief `chunk` - размер куска, кратен 64 */
+  structural_scanner(const char* data,
+                     size_t len,
+                     json_simd_t simd,
+                     size_t chunk = JSON_TAPE_CHUNK)
+      : data_(data), len_(len), chunk_(chunk), scan_(chunkFunction(simd)) {}
+
+  /**
+   * \brief Удалить из `index` первые `consumed` позиций и дописать
+   *   индекс следующего куска
+   * \return false если документ закончился
+   * */
+  bool Next(std::vector<uint32_t>* index, size_t consumed) {
+    if (pos_ >= len_)
+      return false;
+    index->erase(index->begin(), index->begin() + consumed);
+    size_t end = std::min(pos_ + chunk_, len_);
+    scan_(data_, pos_, end, &state_, index);
+    pos_ = end;
+    return true;
+  }
+  /** \brief Незакрытая строка(после конца документа) или
+   *   управляющий символ в строке */
+  bool Failed() const {
+    return state_.error || (pos_ >= len_ && state_.in_string);
+  }
+  /** \brief В просмотренной части документа есть `\` */
+  bool Backslash() const { return state_.backslash != 0; }
+
+ private:
+  /** \brief Реализация с набором инструкций не старше
+   *   поддерживаемого процессором */
+  static scan_chunk_fn chunkFunction(json_simd_t simd) {
+    simd = std::min(simd, GetJSONSimd());
+#ifdef JSON_TAPE_X86
+    if (simd == json_simd_t::avx2)
+      return scan_avx2;
+    if (simd == json_simd_t::sse42)
+      return scan_sse42;
+#endif  // JSON_TAPE_X86
+    return scan_scalar;
+  }
+
+ private:
+  const char* data_;
+  size_t len_;
+  size_t chunk_;
+  scan_chunk_fn scan_;
+  /** \brief начало следующего куска */
+  size_t pos_ = 0;
+  scan_state state_;
+};
+
+/** \brief Записать код `cp` в utf-8, вернуть число байт */
+size_t utf8_encode(uint32_t cp, char* out) {
+  if (cp < 0x80) {
+    out[0] = static_cast<char>(cp);
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = static_cast<char>(0xC0 | (cp >> 6));
+    out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = static_cast<char>(0xE0 | (cp >> 12));
+    out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  out[0] = static_cast<char>(0xF0 | (cp >> 18));
+  out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+/** \brief Четыре шестнадцатеричные цифры `\uXXXX` */
+bool hex4(const char* s, uint32_t* out) {
+  auto [ptr, ec] = std::from_chars(s, s + 4, *out, 16);
+  return ec == std::errc() && ptr == s + 4;
+}
+
+/** \brief Число по грамматике json */
+bool is_json_number(const char* s, size_t len) {
+  const char* end = s + len;
+  const auto digits = [&s, end]() {
+    const char* start = s;
+    while (s < end && *s >= '0' && *s <= '9')
+      ++s;
+    return s - start;
+  };
+  if (s < end && *s == '-')
+    ++s;
+  if (s < end && *s == '0')
+    ++s;
+  else if (!digits())
+    return false;
+  if (s < end && *s == '.') {
+    ++s;
+    if (!digits())
+      return false;
+  }
+  if (s < end && (*s == 'e' || *s == 'E')) {
+    ++s;
+    if (s < end && (*s == '+' || *s == '-'))
+      ++s;
+    if (!digits())
+      return false;
+  }
+  return s == end;
+}
+
+/**
+ * \brief Второй этап: проверка грамматики по индексу
+ *   и построение ленты
+ * */
+class tape_builder {
+ public:
+  tape_builder(char* data,
+               size_t len,
+               structural_scanner* scanner,
+               json_tape_document* doc)
+      : data_(data), len_(len), scanner_(scanner), tape_(doc->tape) {}
+
+  /** \brief Построить ленту, вернуть описание ошибки или nullptr */
+  const char* Build() {
+    enum class state_t { value, key, after_value };
+    state_t state = state_t::value;
+    uint32_t name = 0, name_length = 0;
+    tape_.clear();
+    // оценка числа значений по размеру документа
+    tape_.reserve(len_ / 16);
+    while (true) {
+      if (state == state_t::key) {
+        if (current() != '"')
+          return "missing member name";
+        if (!readString(&name, &name_length))
+          return error_;
+        if (current() != ':')
+          return "missing colon after member name";
+        ++k_;
+        state = state_t::value;
+      } else if (state == state_t::value) {
+        char c = current();
+        if (c == '{' || c == '[') {
+          bool object = c == '{';
+          stack_.push_back(static_cast<uint32_t>(tape_.size()));
+          push(name, name_length, index_[k_], 0,
+               object ? json_type_t::object : json_type_t::array);
+          ++k_;
+          name = name_length = 0;
+          if (current() == (object ? '}' : ']')) {
+            ++k_;
+            close();
+            state = state_t::after_value;
+          } else {
+            state = object ? state_t::key : state_t::value;
+          }
+        } else if (c == '"') {
+          uint32_t value, value_length;
+          if (!readString(&value, &value_length))
+            return error_;
+          push(name, name_length, value, value_length, json_type_t::string);
+          state = state_t::after_value;
+        } else if (c == '\0' || is_op(c)) {
+          return "missing value";
+        } else {
+          if (!readScalar(name, name_length))
+            return error_;
+          state = state_t::after_value;
+        }
+      } else {
+        if (stack_.empty())
+          return ensure(1) ? "root not singular" : nullptr;
+        bool object = tape_[stack_.back()].type == json_type_t::object;
+        char c = current();
+        if (c == ',') {
+          ++k_;
+          name = name_length = 0;
+          state = object ? state_t::key : state_t::value;
+        } else if (c == (object ? '}' : ']')) {
+          ++k_;
+          close();
+        } else {
+          return object ? "missing comma or '}' after member"
+                        : "missing comma or ']' after element";
+        }
+      }
+    }
+  }
+
+ private:
+  /** \brief В индексе есть `n` позиций от текущей, индекс
+   *   дописывается по кускам */
+  bool ensure(size_t n) {
+    while (k_ + n > index_.size()) {
+      if (!scanner_->Next(&index_, k_))
+        return false;
+      k_ = 0;
+    }
+    return true;
+  }
+  /** \brief Текущий структурный символ, '\0' в конце документа */
+  char current() { return ensure(1) ? data_[index_[k_]] : '\0'; }
+  void push(uint32_t name,
+            uint32_t name_length,
+            uint32_t value,
+            uint32_t value_length,
+            json_type_t type) {
+    uint32_t next = static_cast<uint32_t>(tape_.size() + 1);
+    tape_.push_back(
+        json_tape_record{name, name_length, value, value_length, next, type});
+  }
+  void close() {
+    tape_[stack_.back()].next = static_cast<uint32_t>(tape_.size());
+    stack_.pop_back();
+  }
+  /** \brief Строка от текущей кавычки до следующей(первый этап
+   *   гарантирует, что следующий индекс - закрывающая кавычка) */
+  bool readString(uint32_t* offset, uint32_t* length) {
+    if (!ensure(2))
+      return fail("missing quotation mark");
+    uint32_t begin = index_[k_] + 1, end = index_[k_ + 1];
+    k_ += 2;
+    *offset = begin;
+    char* s = data_ + begin;
+    // до конца строки не было `\` - строка не проверяется
+    char* bs = scanner_->Backslash()
+                   ? static_cast<char*>(memchr(s, '\\', end - begin))
+                   : nullptr;
+    if (!bs) {
+      *length = end - begin;
+      return true;
+    }
+    char* out = bs;
+    const char* in = bs;
+    const char* stop = data_ + end;
+    while (in < stop) {
+      if (*in != '\\') {
+        *out++ = *in++;
+        continue;
+      }
+      ++in;
+      switch (*in++) {
+        case '"':
+          *out++ = '"';
+          break;
+        case '\\':
+          *out++ = '\\';
+          break;
+        case '/':
+          *out++ = '/';
+          break;
+        case 'b':
+          *out++ = '\b';
+          break;
+        case 'f':
+          *out++ = '\f';
+          break;
+        case 'n':
+          *out++ = '\n';
+          break;
+        case 'r':
+          *out++ = '\r';
+          break;
+        case 't':
+          *out++ = '\t';
+          break;
+        case 'u': {
+          uint32_t cp;
+          if (stop - in < 4 || !hex4(in, &cp))
+            return fail("incorrect hex digit after \\u escape");
+          in += 4;
+          if (cp >= 0xD800 && cp <= 0xDBFF) {
+            uint32_t low;
+            if (stop - in < 6 || in[0] != '\\' || in[1] != 'u' ||
+                !hex4(in + 2, &low) || low < 0xDC00 || low > 0xDFFF)
+              return fail("invalid surrogate pair");
+            in += 6;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          }
+          out += utf8_encode(cp, out);
+          break;
+        }
+        default:
+          return fail("invalid escape character");
+      }
+    }
+    *length = static_cast<uint32_t>(out - s);
+    return true;
+  }
+  /** \brief Число или литерал до следующего структурного символа */
+  bool readScalar(uint32_t name, uint32_t name_length) {
+    size_t end = ensure(2) ? index_[k_ + 1] : len_;
+    uint32_t begin = index_[k_];
+    ++k_;
+    while (end > begin && is_ws(data_[end - 1]))
+      --end;
+    std::string_view token(data_ + begin, end - begin);
+    json_type_t type;
+    if (token == "true")
+      type = json_type_t::true_value;
+    else if (token == "false")
+      type = json_type_t::false_value;
+    else if (token == "null")
+      type = json_type_t::null_value;
+    else if (is_json_number(token.data(), token.size()))
+      type = json_type_t::number;
+    else
+      return fail("invalid value");
+    push(name, name_length, begin, static_cast<uint32_t>(token.size()), type);
+    return true;
+  }
+  bool fail(const char* error) {
+    error_ = error;
+    return false;
+  }
+
+ private:
+  char* data_;
+  size_t len_;
+  structural_scanner* scanner_;
+  std::vector<json_tape_record>& tape_;
+  /** \brief необработанный остаток индекса */
+  std::vector<uint32_t> index_;
+  /** \brief позиция в индексе */
+  size_t k_ = 0;
+  /** \brief записи открытых контейнеров */
+  std::vector<uint32_t> stack_;
+  const char* error_ = nullptr;
+};
+}  // namespace
+
+json_simd_t GetJSONSimd() {
+#ifdef JSON_TAPE_X86
+  static const json_simd_t simd =
+      __builtin_cpu_supports("avx2")     ? json_simd_t::avx2
+      : __builtin_cpu_supports("sse4.2") ? json_simd_t::sse42
+                                         : json_simd_t::scalar;
+  return simd;
+#else
+  return json_simd_t::scalar;
+#endif  // JSON_TAPE_X86
+}
+
+merror_t JSONStructuralIndex(const char* data,
+                             size_t len,
+                             std::vector<uint32_t>* index,
+                             json_simd_t simd) {
+  index->clear();
+  // индекс нужен целиком - одним куском
+  structural_scanner scanner(data, len, simd, len);
+  scanner.Next(index, 0);
+  return scanner.Failed() ? ERROR_PARSER_FORMAT_ST : ERROR_SUCCESS_T;
+}
+
+merror_t ParseJSONTape(char* memory,
+                       size_t len,
+                       json_tape_document* doc,
+                       ErrorWrap* ew,
+                       json_simd_t simd) {
+  doc->data = memory;
+  doc->tape.clear();
+  if (!memory || len >= UINT32_MAX - 64)
+    return ew->SetError(ERROR_PARSER_FORMAT_ST,
+                        "json tape: empty or too large document");
+  structural_scanner scanner(memory, len, simd);
+  tape_builder builder(memory, len, &scanner, doc);
+  const char* error = builder.Build();
+  // ошибка первого этапа в просмотренной части - причина
+  //   ошибки грамматики
+  if (scanner.Failed()) {
+    doc->tape.clear();
+    return ew->SetError(ERROR_PARSER_FORMAT_ST,
+                        "json tape parse error: missing quotation mark or "
+                        "control character in string");
+  }
+  if (error) {
+    doc->tape.clear();
+    return ew->SetError(ERROR_PARSER_FORMAT_ST,
+                        std::string("json tape parse error: ") + error);
+  }
+  return ERROR_SUCCESS_T;
+}
+
+namespace {
+/** \brief Разобрать `v` целиком, `out` меняется только при успехе */
+template <class T>
+bool number_value(std::string_view v, T* out) {
+  T value;
+  auto [ptr, ec] = std::from_chars(v.data(), v.data() + v.size(), value);
+  if (ec != std::errc() || ptr != v.data() + v.size())
+    return false;
+  *out = value;
+  return true;
+}
+}  // namespace
+
+bool json_tape_node::GetInt64(int64_t* out) const {
+  return IsNumber() && number_value(GetValue(), out);
+}
+
+bool json_tape_node::GetUint64(uint64_t* out) const {
+  if (!IsNumber())
+    return false;
+  std::string_view v = GetValue();
+  if (v[0] == '-') {
+    // целое `-0` - ноль
+    int64_t i;
+    if (!number_value(v, &i) || i < 0)
+      return false;
+    *out = static_cast<uint64_t>(i);
+    return true;
+  }
+  return number_value(v, out);
+}
+
+bool json_tape_node::GetDouble(double* out) const {
+  return IsNumber() && number_value(GetValue(), out);
+}
+}  // namespace asp_utils
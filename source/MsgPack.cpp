@@ -0,0 +1,426 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Readers/MsgPack.h"
+
+#include "asp_utils/Readers/JSONTape.h"
+
+#include <array>
+#include <bit>
+
+namespace asp_utils {
+namespace {
+/** \brief Вид значения по байту типа */
+enum class tag_kind_t : uint8_t {
+  positive_fixint,
+  negative_fixint,
+  fixmap,
+  fixarray,
+  fixstr,
+  nil,
+  false_value,
+  true_value,
+  float32,
+  float64,
+  uint,
+  int_value,
+  /** \brief str или bin с длиной в следующих байтах */
+  str,
+  array,
+  map,
+  ext,
+  invalid
+};
+
+/** \brief Описание байта типа: вид и число байт длины или значения */
+struct tag_info {
+  tag_kind_t kind;
+  uint8_t bytes;
+};
+
+/** \brief Таблица байтов типа - один переход на значение вместо
+ *   цепочки сравнений */
+constexpr std::array<tag_info, 256> make_tags() {
+  std::array<tag_info, 256> tags{};
+  for (int t = 0; t < 256; ++t) {
+    tag_info& info = tags[t];
+    info.bytes = 0;
+    if (t < 0x80)
+      info.kind = tag_kind_t::positive_fixint;
+    else if (t < 0x90)
+      info.kind = tag_kind_t::fixmap;
+    else if (t < 0xa0)
+      info.kind = tag_kind_t::fixarray;
+    else if (t < 0xc0)
+      info.kind = tag_kind_t::fixstr;
+    else if (t >= 0xe0)
+      info.kind = tag_kind_t::negative_fixint;
+    else
+      info.kind = tag_kind_t::ext;
+  }
+  tags[0xc0].kind = tag_kind_t::nil;
+  tags[0xc1].kind = tag_kind_t::invalid;
+  tags[0xc2].kind = tag_kind_t::false_value;
+  tags[0xc3].kind = tag_kind_t::true_value;
+  tags[0xca] = {tag_kind_t::float32, 4};
+  tags[0xcb] = {tag_kind_t::float64, 8};
+  for (int i = 0; i < 4; ++i) {
+    uint8_t bytes = static_cast<uint8_t>(1 << i);
+    tags[0xcc + i] = {tag_kind_t::uint, bytes};
+    tags[0xd0 + i] = {tag_kind_t::int_value, bytes};
+  }
+  for (int i = 0; i < 3; ++i) {
+    uint8_t bytes = static_cast<uint8_t>(1 << i);
+    tags[0xc4 + i] = {tag_kind_t::str, bytes};
+    tags[0xd9 + i] = {tag_kind_t::str, bytes};
+  }
+  tags[0xdc] = {tag_kind_t::array, 2};
+  tags[0xdd] = {tag_kind_t::array, 4};
+  tags[0xde] = {tag_kind_t::map, 2};
+  tags[0xdf] = {tag_kind_t::map, 4};
+  return tags;
+}
+constexpr std::array<tag_info, 256> msgpack_tags = make_tags();
+
+/** \brief Число из `bytes` байт, старшие вперёд */
+inline uint64_t load_be(const uint8_t* p, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; ++i)
+    value = (value << 8) | p[i];
+  return value;
+}
+
+/**
+ * \brief Разбор документа в ленту за один проход
+ * */
+class msgpack_parser {
+ public:
+  msgpack_parser(const char* data, size_t len, msgpack_document* doc)
+      : begin_(reinterpret_cast<const uint8_t*>(data)),
+        p_(begin_),
+        end_(begin_ + len),
+        tape_(doc->tape) {}
+
+  /** \brief Построить ленту, вернуть описание ошибки или nullptr */
+  const char* Build() {
+    tape_.clear();
+    // оценка числа значений по размеру документа
+    tape_.reserve((end_ - begin_) / 8);
+    do {
+      msgpack_record r;
+      r.name = r.name_length = 0;
+      if (!stack_.empty() && stack_.back().map) {
+        if (!readKey(&r))
+          return error_;
+      }
+      uint32_t size = 0;
+      if (!readValue(&r, &size))
+        return error_;
+      r.next = static_cast<uint32_t>(tape_.size() + 1);
+      tape_.push_back(r);
+      if (size) {
+        bool map = r.type == msgpack_type_t::map;
+        stack_.push_back(
+            {static_cast<uint32_t>(tape_.size() - 1), size, map});
+        continue;
+      }
+      // значение прочитано - закрыть заполненные контейнеры
+      while (!stack_.empty() && --stack_.back().remaining == 0) {
+        tape_[stack_.back().index].next = static_cast<uint32_t>(tape_.size());
+        stack_.pop_back();
+      }
+    } while (!stack_.empty());
+    return p_ == end_ ? nullptr : "root not singular";
+  }
+
+ private:
+  /** \brief Открытый контейнер */
+  struct container {
+    uint32_t index;
+    /** \brief осталось прочитать значений */
+    uint32_t remaining;
+    bool map;
+  };
+
+ private:
+  uint32_t offset() const { return static_cast<uint32_t>(p_ - begin_); }
+  bool fail(const char* error) {
+    error_ = error;
+    return false;
+  }
+  /** \brief Прочитать `bytes` байт числа после байта типа */
+  bool readNumber(int bytes, uint64_t* value) {
+    if (end_ - p_ < bytes)
+      return fail("unexpected end of document");
+    *value = load_be(p_, bytes);
+    p_ += bytes;
+    return true;
+  }
+  /** \brief Строка длины `length` с текущей позиции */
+  bool readString(uint64_t length, uint32_t* offset, uint32_t* out) {
+    if (static_cast<uint64_t>(end_ - p_) < length)
+      return fail("unexpected end of document");
+    *offset = this->offset();
+    *out = static_cast<uint32_t>(length);
+    p_ += length;
+    return true;
+  }
+  /** \brief Ключ члена map - только строка */
+  bool readKey(msgpack_record* r) {
+    if (p_ == end_)
+      return fail("unexpected end of document");
+    uint8_t tag = *p_++;
+    const tag_info& info = msgpack_tags[tag];
+    uint64_t length = tag & 0x1f;
+    if (info.kind == tag_kind_t::str) {
+      if (!readNumber(info.bytes, &length))
+        return false;
+    } else if (info.kind != tag_kind_t::fixstr) {
+      return fail("map key is not a string");
+    }
+    return readString(length, &r->name, &r->name_length);
+  }
+  /** \brief Значение, для контейнера `size` - число его значений
+   *   (для map - пар) */
+  bool readValue(msgpack_record* r, uint32_t* size) {
+    if (p_ == end_)
+      return fail("unexpected end of document");
+    uint8_t tag = *p_++;
+    const tag_info& info = msgpack_tags[tag];
+    uint64_t value = 0;
+    if (info.bytes && !readNumber(info.bytes, &value))
+      return false;
+    switch (info.kind) {
+      case tag_kind_t::positive_fixint:
+        r->type = msgpack_type_t::uint_value;
+        r->value.u = tag;
+        break;
+      case tag_kind_t::negative_fixint:
+        r->type = msgpack_type_t::int_value;
+        r->value.i = static_cast<int8_t>(tag);
+        break;
+      case tag_kind_t::fixmap:
+        r->type = msgpack_type_t::map;
+        *size = tag & 0x0f;
+        break;
+      case tag_kind_t::fixarray:
+        r->type = msgpack_type_t::array;
+        *size = tag & 0x0f;
+        break;
+      case tag_kind_t::fixstr:
+        r->type = msgpack_type_t::string;
+        return readString(tag & 0x1f, &r->value.str.offset,
+                          &r->value.str.length);
+      case tag_kind_t::nil:
+        r->type = msgpack_type_t::null_value;
+        break;
+      case tag_kind_t::false_value:
+        r->type = msgpack_type_t::false_value;
+        break;
+      case tag_kind_t::true_value:
+        r->type = msgpack_type_t::true_value;
+        break;
+      case tag_kind_t::float32:
+        r->type = msgpack_type_t::float_value;
+        r->value.d = std::bit_cast<float>(static_cast<uint32_t>(value));
+        break;
+      case tag_kind_t::float64:
+        r->type = msgpack_type_t::float_value;
+        r->value.d = std::bit_cast<double>(value);
+        break;
+      case tag_kind_t::uint:
+        r->type = msgpack_type_t::uint_value;
+        r->value.u = value;
+        break;
+      case tag_kind_t::int_value: {
+        // расширение знака
+        int shift = 64 - 8 * info.bytes;
+        int64_t i = static_cast<int64_t>(value << shift) >> shift;
+        r->type =
+            i < 0 ? msgpack_type_t::int_value : msgpack_type_t::uint_value;
+        r->value.i = i;
+        break;
+      }
+      case tag_kind_t::str:
+        r->type = msgpack_type_t::string;
+        return readString(value, &r->value.str.offset, &r->value.str.length);
+      case tag_kind_t::array:
+        r->type = msgpack_type_t::array;
+        *size = static_cast<uint32_t>(value);
+        break;
+      case tag_kind_t::map:
+        r->type = msgpack_type_t::map;
+        *size = static_cast<uint32_t>(value);
+        break;
+      case tag_kind_t::ext:
+        return fail("unsupported ext type");
+      case tag_kind_t::invalid:
+        return fail("invalid type byte");
+    }
+    return true;
+  }
+
+ private:
+  const uint8_t* begin_;
+  const uint8_t* p_;
+  const uint8_t* end_;
+  std::vector<msgpack_record>& tape_;
+  /** \brief открытые контейнеры */
+  std::vector<container> stack_;
+  const char* error_ = nullptr;
+};
+}  // namespace
+
+merror_t ParseMsgPack(const char* memory,
+                      size_t len,
+                      msgpack_document* doc,
+                      ErrorWrap* ew) {
+  doc->data = memory;
+  doc->tape.clear();
+  if (!memory || !len || len >= UINT32_MAX)
+    return ew->SetError(ERROR_PARSER_FORMAT_ST,
+                        "msgpack: empty or too large document");
+  msgpack_parser parser(memory, len, doc);
+  if (const char* error = parser.Build()) {
+    doc->tape.clear();
+    return ew->SetError(ERROR_PARSER_FORMAT_ST,
+                        std::string("msgpack parse error: ") + error);
+  }
+  return ERROR_SUCCESS_T;
+}
+
+void msgpack_writer::Null() {
+  out_->push_back(static_cast<char>(0xc0));
+}
+
+void msgpack_writer::Bool(bool value) {
+  out_->push_back(static_cast<char>(value ? 0xc3 : 0xc2));
+}
+
+void msgpack_writer::Int(int64_t value) {
+  if (value >= 0)
+    Uint(static_cast<uint64_t>(value));
+  else if (value >= -32)
+    out_->push_back(static_cast<char>(value));
+  else if (value >= INT8_MIN)
+    put(0xd0, static_cast<uint64_t>(value), 1);
+  else if (value >= INT16_MIN)
+    put(0xd1, static_cast<uint64_t>(value), 2);
+  else if (value >= INT32_MIN)
+    put(0xd2, static_cast<uint64_t>(value), 4);
+  else
+    put(0xd3, static_cast<uint64_t>(value), 8);
+}
+
+void msgpack_writer::Uint(uint64_t value) {
+  if (value < 0x80)
+    out_->push_back(static_cast<char>(value));
+  else if (value <= UINT8_MAX)
+    put(0xcc, value, 1);
+  else if (value <= UINT16_MAX)
+    put(0xcd, value, 2);
+  else if (value <= UINT32_MAX)
+    put(0xce, value, 4);
+  else
+    put(0xcf, value, 8);
+}
+
+void msgpack_writer::Double(double value) {
+  put(0xcb, std::bit_cast<uint64_t>(value), 8);
+}
+
+void msgpack_writer::String(std::string_view value) {
+  if (value.size() < 32)
+    out_->push_back(static_cast<char>(0xa0 | value.size()));
+  else if (value.size() <= UINT8_MAX)
+    put(0xd9, value.size(), 1);
+  else if (value.size() <= UINT16_MAX)
+    put(0xda, value.size(), 2);
+  else
+    put(0xdb, value.size(), 4);
+  out_->append(value.data(), value.size());
+}
+
+void msgpack_writer::Array(uint32_t size) {
+  if (size < 16)
+    out_->push_back(static_cast<char>(0x90 | size));
+  else if (size <= UINT16_MAX)
+    put(0xdc, size, 2);
+  else
+    put(0xdd, size, 4);
+}
+
+void msgpack_writer::Map(uint32_t size) {
+  if (size < 16)
+    out_->push_back(static_cast<char>(0x80 | size));
+  else if (size <= UINT16_MAX)
+    put(0xde, size, 2);
+  else
+    put(0xdf, size, 4);
+}
+
+void msgpack_writer::put(uint8_t tag, uint64_t value, int bytes) {
+  char buf[9];
+  buf[0] = static_cast<char>(tag);
+  for (int i = bytes; i > 0; --i, value >>= 8)
+    buf[i] = static_cast<char>(value & 0xff);
+  out_->append(buf, bytes + 1);
+}
+
+merror_t JSONToMsgPack(char* memory,
+                       size_t len,
+                       std::string* out,
+                       ErrorWrap* ew) {
+  json_tape_document doc;
+  if (ParseJSONTape(memory, len, &doc, ew))
+    return ew->GetErrorCode();
+  out->clear();
+  msgpack_writer w(out);
+  // лента json записана обходом в глубину - проходится подряд,
+  //   в стеке концы открытых контейнеров и признак объекта
+  std::vector<std::pair<uint32_t, bool>> stack;
+  for (uint32_t i = 0; i < doc.tape.size(); ++i) {
+    while (!stack.empty() && stack.back().first <= i)
+      stack.pop_back();
+    json_tape_node v(&doc, i);
+    if (!stack.empty() && stack.back().second)
+      w.String(v.GetName());
+    if (v.IsObject() || v.IsArray()) {
+      uint32_t size = 0;
+      v.ForEachChild([&size](const json_tape_node&) { ++size; });
+      if (v.IsObject())
+        w.Map(size);
+      else
+        w.Array(size);
+      stack.emplace_back(doc.tape[i].next, v.IsObject());
+    } else if (v.IsString()) {
+      w.String(v.GetValue());
+    } else if (v.IsBool()) {
+      w.Bool(v.GetBool());
+    } else if (v.IsNull()) {
+      w.Null();
+    } else {
+      int64_t si;
+      uint64_t ui;
+      double d;
+      if (v.GetInt64(&si)) {
+        w.Int(si);
+      } else if (v.GetUint64(&ui)) {
+        w.Uint(ui);
+      } else if (v.GetDouble(&d)) {
+        w.Double(d);
+      } else {
+        return ew->SetError(ERROR_STR_PARSE_ST,
+                            "json to msgpack: number out of range '" +
+                                std::string(v.GetValue()) + "'");
+      }
+    }
+  }
+  return ERROR_SUCCESS_T;
+}
+}  // namespace asp_utils
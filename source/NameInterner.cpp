@@ -0,0 +1,70 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Readers/NameInterner.h"
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace asp_utils {
+const interned_name& NameInterner::Intern(std::string_view name,
+                                          uint64_t hash) {
+  {
+    std::shared_lock<SharedMutex> lock(mutex_);
+    if (const interned_name* n = find(name, hash))
+      return *n;
+  }
+  std::lock_guard<SharedMutex> lock(mutex_);
+  // имя могли добавить между блокировками
+  if (const interned_name* n = find(name, hash))
+    return *n;
+  names_.push_back(interned_name{static_cast<name_id>(names_.size()), hash,
+                                 std::string(name)});
+  table_.emplace(hash, &names_.back());
+  bytes_ += name.size();
+  return names_.back();
+}
+
+const interned_name* NameInterner::Find(std::string_view name,
+                                        uint64_t hash) const {
+  std::shared_lock<SharedMutex> lock(mutex_);
+  return find(name, hash);
+}
+
+const interned_name& NameInterner::Get(name_id id) const {
+  std::shared_lock<SharedMutex> lock(mutex_);
+  return names_[id];
+}
+
+size_t NameInterner::Size() const {
+  std::shared_lock<SharedMutex> lock(mutex_);
+  return names_.size();
+}
+
+size_t NameInterner::GetBytes() const {
+  std::shared_lock<SharedMutex> lock(mutex_);
+  return bytes_;
+}
+
+void NameInterner::Clear() {
+  std::lock_guard<SharedMutex> lock(mutex_);
+  table_.clear();
+  names_.clear();
+  bytes_ = 0;
+}
+
+const interned_name* NameInterner::find(std::string_view name,
+                                        uint64_t hash) const {
+  auto range = table_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->name == name)
+      return it->second;
+  }
+  return nullptr;
+}
+}  // namespace asp_utils
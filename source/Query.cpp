@@ -0,0 +1,172 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Readers/Query.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace asp_utils {
+namespace {
+/** \brief Разбор текста запроса, см. node_query */
+class query_parser {
+ public:
+  query_parser(std::string_view text, ErrorWrap* ew) : text_(text), ew_(ew) {}
+
+  merror_t Parse(std::vector<query_step>* steps) {
+    if (text_.empty())
+      return fail("empty query");
+    // ведущий `/` необязателен, путь всегда от корня
+    query_axis_t axis = query_axis_t::child;
+    if (skip("//"))
+      axis = query_axis_t::descendant;
+    else
+      skip("/");
+    for (;;) {
+      if (steps->size() == QUERY_MAX_STEPS)
+        return fail("too many steps");
+      steps->emplace_back();
+      query_step& step = steps->back();
+      step.axis = axis;
+      merror_t error = parseStep(&step);
+      if (error)
+        return error;
+      if (pos_ == text_.size())
+        break;
+      if (skip("//"))
+        axis = query_axis_t::descendant;
+      else if (skip("/"))
+        axis = query_axis_t::child;
+      else
+        return fail("expected '/'");
+    }
+    return ERROR_SUCCESS_T;
+  }
+
+ private:
+  merror_t parseStep(query_step* step) {
+    step->wildcard = skip("*");
+    if (!step->wildcard) {
+      step->name = std::string(name());
+      if (step->name.empty())
+        return fail("expected node name or '*'");
+    }
+    step->hash = name_hash(step->name);
+    while (skip("[")) {
+      step->predicates.emplace_back();
+      merror_t error = parsePredicate(&step->predicates.back());
+      if (error)
+        return error;
+    }
+    return ERROR_SUCCESS_T;
+  }
+  merror_t parsePredicate(query_predicate* p) {
+    spaces();
+    skip("@");
+    p->name = std::string(name());
+    if (p->name.empty())
+      return fail("expected parameter name");
+    spaces();
+    p->op = query_op_t::exists;
+    if (skip("!="))
+      p->op = query_op_t::ne;
+    else if (skip("<="))
+      p->op = query_op_t::le;
+    else if (skip(">="))
+      p->op = query_op_t::ge;
+    else if (skip("="))
+      p->op = query_op_t::eq;
+    else if (skip("<"))
+      p->op = query_op_t::lt;
+    else if (skip(">"))
+      p->op = query_op_t::gt;
+    p->is_number = p->is_bool = false;
+    if (p->op != query_op_t::exists) {
+      spaces();
+      merror_t error = parseValue(p);
+      if (error)
+        return error;
+      bool ordered = p->op != query_op_t::eq && p->op != query_op_t::ne;
+      if (ordered && !p->is_number)
+        return fail("expected number");
+    }
+    spaces();
+    if (!skip("]"))
+      return fail("expected ']'");
+    return ERROR_SUCCESS_T;
+  }
+  merror_t parseValue(query_predicate* p) {
+    if (pos_ < text_.size() && (text_[pos_] == '\'' || text_[pos_] == '"')) {
+      char quote = text_[pos_++];
+      size_t end = text_.find(quote, pos_);
+      if (end == std::string_view::npos)
+        return fail("unterminated string");
+      p->value = std::string(text_.substr(pos_, end - pos_));
+      pos_ = end + 1;
+    } else {
+      size_t start = pos_;
+      while (pos_ < text_.size() && !isSpace(text_[pos_]) &&
+             text_[pos_] != ']')
+        ++pos_;
+      p->value = std::string(text_.substr(start, pos_ - start));
+      if (p->value.empty())
+        return fail("expected value");
+    }
+    std::string_view value = trim_view(p->value);
+    p->is_number = str_to_value(value, &p->number);
+    p->is_bool = (value == "true" || value == "false");
+    p->boolean = (value == "true");
+    return ERROR_SUCCESS_T;
+  }
+  /** \brief Имя узла или параметра: до разделителя, скобки,
+   *   оператора или пробела */
+  std::string_view name() {
+    size_t start = pos_;
+    while (pos_ < text_.size() && !isSpace(text_[pos_]) &&
+           !strchr("/[]@=!<>*'\"", text_[pos_]))
+      ++pos_;
+    return text_.substr(start, pos_ - start);
+  }
+  static bool isSpace(char c) {
+    return isspace(static_cast<unsigned char>(c));
+  }
+  void spaces() {
+    while (pos_ < text_.size() && isSpace(text_[pos_]))
+      ++pos_;
+  }
+  bool skip(std::string_view token) {
+    if (text_.substr(pos_, token.size()) != token)
+      return false;
+    pos_ += token.size();
+    return true;
+  }
+  merror_t fail(const std::string& what) {
+    return ew_->SetError(ERROR_STR_PARSE_ST,
+                         "query '" + std::string(text_) + "' error at " +
+                             std::to_string(pos_) + ": " + what);
+  }
+
+ private:
+  std::string_view text_;
+  size_t pos_ = 0;
+  ErrorWrap* ew_;
+};
+}  // namespace
+
+merror_t CompileQuery(std::string_view text,
+                      node_query* query,
+                      ErrorWrap* ew) {
+  std::vector<query_step> steps;
+  merror_t error = query_parser(text, ew).Parse(&steps);
+  if (!error) {
+    query->text_ = std::string(text);
+    query->steps_ = std::move(steps);
+  }
+  return error;
+}
+}  // namespace asp_utils
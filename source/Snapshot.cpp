@@ -0,0 +1,183 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Readers/Snapshot.h"
+
+#include "asp_utils/FileBuffer.h"
+
+#include <chrono>
+#include <fstream>
+
+#include <string.h>
+
+namespace asp_utils {
+namespace {
+const char snapshot_magic[4] = {'A', 'S', 'P', 'S'};
+
+/** \brief Выравнивание смещения по 8 байт */
+uint64_t align8(uint64_t offset) {
+  return (offset + 7) & ~uint64_t(7);
+}
+}  // namespace
+
+uint32_t snapshot_builder::AddNode(std::string_view name,
+                                   std::string_view value) {
+  snapshot_record r;
+  r.name = addString(name);
+  r.name_length = static_cast<uint32_t>(name.size());
+  r.value = addString(value);
+  r.value_length = static_cast<uint32_t>(value.size());
+  r.first_child = 0;
+  r.childs_count = 0;
+  nodes_.push_back(r);
+  return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void snapshot_builder::SetChilds(uint32_t index,
+                                 uint32_t first_child,
+                                 uint32_t count) {
+  nodes_[index].first_child = first_child;
+  nodes_[index].childs_count = count;
+}
+
+uint64_t snapshot_builder::addString(std::string_view str) {
+  // пустые строки ссылаются на завершающий ноль первой строки
+  if (str.empty() && !strings_.empty())
+    return strings_.size() - 1;
+  uint64_t offset = strings_.size();
+  strings_.append(str);
+  strings_.push_back('\0');
+  return offset;
+}
+
+merror_t snapshot_builder::Write(const fs::path& path,
+                                 const snapshot_source& source,
+                                 ErrorWrap* ew) const {
+  snapshot_header h{};
+  memcpy(h.magic, snapshot_magic, sizeof(h.magic));
+  h.version = SNAPSHOT_VERSION;
+  h.byte_order = SNAPSHOT_BYTE_ORDER;
+  h.source = source;
+  h.nodes_offset = align8(sizeof(h));
+  h.nodes_count = nodes_.size();
+  h.strings_offset = h.nodes_offset + nodes_.size() * sizeof(snapshot_record);
+  h.strings_size = strings_.size();
+
+  // снимок пишется во временный файл и переименовывается, чтобы
+  //   читатели не увидели недописанный снимок
+  fs::path tmp = path;
+  tmp += ".tmp";
+  std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+  if (!out.is_open())
+    return ew->SetError(ERROR_FILE_OUT_ST,
+                        "snapshot open error for: " + tmp.string());
+  const char zeros[8] = {0};
+  out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  out.write(zeros, static_cast<std::streamsize>(h.nodes_offset - sizeof(h)));
+  out.write(reinterpret_cast<const char*>(nodes_.data()),
+            static_cast<std::streamsize>(nodes_.size() *
+                                         sizeof(snapshot_record)));
+  out.write(strings_.data(), static_cast<std::streamsize>(strings_.size()));
+  out.close();
+  if (!out)
+    return ew->SetError(ERROR_FILE_OUT_ST,
+                        "snapshot write error for: " + tmp.string());
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec)
+    return ew->SetError(ERROR_FILE_OUT_ST,
+                        "snapshot rename error for: " + path.string());
+  return ERROR_SUCCESS_T;
+}
+
+uint64_t content_hash(const char* data, size_t size) {
+  const uint64_t m = 0x9e3779b97f4a7c15ull;
+  uint64_t h = 0xcbf29ce484222325ull ^ (size * m);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t w;
+    memcpy(&w, data + i, 8);
+    h = (h ^ w) * m;
+    h ^= h >> 32;
+  }
+  uint64_t tail = 0;
+  if (i < size)
+    memcpy(&tail, data + i, size - i);
+  h = (h ^ tail) * m;
+  return h ^ (h >> 29);
+}
+
+merror_t GetSnapshotSource(const fs::path& path,
+                           snapshot_source* out,
+                           bool with_hash) {
+  std::error_code ec;
+  out->size = static_cast<uint64_t>(fs::file_size(path, ec));
+  if (ec)
+    return ERROR_FILE_EXISTS_ST;
+  auto mtime = fs::last_write_time(path, ec);
+  if (ec)
+    return ERROR_FILE_IN_ST;
+  out->mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+  out->hash = 0;
+  if (with_hash) {
+    ErrorWrap ew;
+    file_utils::FileBuffer memory;
+    if (memory.Load(path, file_utils::buffer_mode_t::mmap, ew))
+      return ew.GetErrorCode();
+    out->hash = content_hash(memory.GetData(), memory.GetSize());
+  }
+  return ERROR_SUCCESS_T;
+}
+
+merror_t OpenSnapshot(const char* memory,
+                      size_t size,
+                      snapshot_document* doc,
+                      ErrorWrap* ew) {
+  const snapshot_header* h = reinterpret_cast<const snapshot_header*>(memory);
+  if (!memory || size < sizeof(snapshot_header) ||
+      memcmp(h->magic, snapshot_magic, sizeof(h->magic)) != 0)
+    return ew->SetError(ERROR_PARSER_FORMAT_ST, "snapshot: bad header");
+  if (h->version != SNAPSHOT_VERSION || h->byte_order != SNAPSHOT_BYTE_ORDER)
+    return ew->SetError(ERROR_PARSER_FORMAT_ST,
+                        "snapshot: unsupported version or byte order");
+  // границы проверяются без переполнения
+  if (h->nodes_count == 0 || h->nodes_offset % 8 != 0 ||
+      h->nodes_offset > size ||
+      h->nodes_count > (size - h->nodes_offset) / sizeof(snapshot_record) ||
+      h->strings_offset > size || h->strings_size > size - h->strings_offset)
+    return ew->SetError(ERROR_PARSER_FORMAT_ST, "snapshot: bad layout");
+  doc->header = h;
+  doc->nodes =
+      reinterpret_cast<const snapshot_record*>(memory + h->nodes_offset);
+  doc->strings = memory + h->strings_offset;
+  return ERROR_SUCCESS_T;
+}
+
+bool IsSnapshotValid(const fs::path& snapshot,
+                     const fs::path& source,
+                     bool verify_content) {
+  snapshot_header h;
+  std::ifstream in(snapshot, std::ios::binary);
+  if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)))
+    return false;
+  if (memcmp(h.magic, snapshot_magic, sizeof(h.magic)) != 0 ||
+      h.version != SNAPSHOT_VERSION || h.byte_order != SNAPSHOT_BYTE_ORDER)
+    return false;
+  snapshot_source current;
+  if (GetSnapshotSource(source, &current, false))
+    return false;
+  if (current.size != h.source.size || current.mtime != h.source.mtime)
+    return false;
+  if (verify_content) {
+    if (GetSnapshotSource(source, &current, true))
+      return false;
+    return current.hash == h.source.hash;
+  }
+  return true;
+}
+}  // namespace asp_utils
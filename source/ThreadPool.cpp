@@ -0,0 +1,73 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/ThreadPool.h"
+
+#include <algorithm>
+
+namespace asp_utils {
+namespace {
+thread_local size_t worker_index = ThreadPool::npos;
+thread_local const ThreadPool* worker_pool = nullptr;
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads) {
+  if (!threads)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i)
+    threads_.emplace_back(&ThreadPool::worker, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+}
+
+size_t ThreadPool::GetCurrentWorker() const {
+  return (worker_pool == this) ? worker_index : npos;
+}
+
+size_t ThreadPool::GetWorkerIndex() {
+  return worker_index;
+}
+
+const ThreadPool* ThreadPool::GetCurrentPool() {
+  return worker_pool;
+}
+
+void ThreadPool::push(std::function<void()>&& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::worker(size_t index) {
+  worker_index = index;
+  worker_pool = this;
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty())
+        return;
+      task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+    task();
+  }
+}
+}  // namespace asp_utils
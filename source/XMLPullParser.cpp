@@ -0,0 +1,417 @@
+/**
+ * asp_utils library
+ *
+ * Copyright (c) 2020-2021 Mishutinski Yurii
+ *
+ * This library is distributed under the MIT License.
+ * See LICENSE file in the project root for full license information.
+ */
+#include "asp_utils/Readers/XMLPullParser.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace asp_utils {
+namespace {
+constexpr size_t npos = std::string::npos;
+
+inline bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+inline bool is_name_end(char c) {
+  return is_space(c) || c == '/' || c == '>' || c == '=';
+}
+inline bool is_blank(std::string_view s) {
+  return std::all_of(s.begin(), s.end(), is_space);
+}
+/** \brief Записать символ `cp` в utf-8 */
+void append_utf8(uint32_t cp, std::string* out) {
+  if (cp < 0x80) {
+    out->push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | (cp >> 6)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | (cp >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | (cp >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+}
+/** \brief Дописать в `out` строку `s`, раскрыв сущности.
+ *   Неизвестные сущности остаются как есть */
+void decode_entities(std::string_view s, std::string* out) {
+  for (size_t amp = s.find('&'); amp != npos; amp = s.find('&')) {
+    out->append(s.substr(0, amp));
+    s.remove_prefix(amp);
+    size_t semi = s.find(';');
+    if (semi == npos || semi > 12) {
+      out->push_back('&');
+      s.remove_prefix(1);
+      continue;
+    }
+    std::string_view e = s.substr(1, semi - 1);
+    if (e == "lt") {
+      out->push_back('<');
+    } else if (e == "gt") {
+      out->push_back('>');
+    } else if (e == "amp") {
+      out->push_back('&');
+    } else if (e == "quot") {
+      out->push_back('"');
+    } else if (e == "apos") {
+      out->push_back('\'');
+    } else if (e.size() > 1 && e[0] == '#') {
+      std::string num(e.substr(1));
+      bool hex = (num[0] == 'x' || num[0] == 'X');
+      char* end = nullptr;
+      unsigned long cp =
+          std::strtoul(num.c_str() + (hex ? 1 : 0), &end, hex ? 16 : 10);
+      if (end && *end == '\0' && cp <= 0x10FFFF)
+        append_utf8(static_cast<uint32_t>(cp), out);
+      else
+        out->append(s.substr(0, semi + 1));
+    } else {
+      out->append(s.substr(0, semi + 1));
+    }
+    s.remove_prefix(semi + 1);
+  }
+  out->append(s);
+}
+}  // namespace
+
+XMLPullParser::XMLPullParser(size_t chunk_size)
+    : BaseObject(STATUS_DEFAULT),
+      chunk_size_(std::max<size_t>(chunk_size, 16)) {}
+
+XMLPullParser::~XMLPullParser() {
+  if (file_)
+    std::fclose(file_);
+}
+
+merror_t XMLPullParser::Open(const fs::path& path) {
+  file_ = std::fopen(path.string().c_str(), "rb");
+  if (!file_) {
+    error_.SetError(ERROR_FILE_IN_ST, "cannot open file " + path.string());
+    status_ = STATUS_HAVE_ERROR;
+    return error_.GetErrorCode();
+  }
+  std::FILE* f = file_;
+  SetSource([f](char* buffer, size_t size) {
+    return std::fread(buffer, 1, size, f);
+  });
+  return ERROR_SUCCESS_T;
+}
+
+void XMLPullParser::SetData(std::string_view data) {
+  read_ = nullptr;
+  buf_.assign(data);
+  pos_ = 0;
+  eof_ = true;
+}
+
+void XMLPullParser::SetSource(read_function read) {
+  read_ = std::move(read);
+  buf_.clear();
+  pos_ = 0;
+  eof_ = false;
+}
+
+const std::string* XMLPullParser::GetAttribute(std::string_view name) const {
+  for (const auto& a : attributes_)
+    if (a.name == name)
+      return &a.value;
+  return nullptr;
+}
+
+XMLPullParser::event_t XMLPullParser::Next() {
+  if (error_.GetErrorCode())
+    return event_t::error;
+  if (pending_end_) {
+    pending_end_ = false;
+    name_ = std::move(stack_.back());
+    stack_.pop_back();
+    return event_t::end_element;
+  }
+  for (;;) {
+    if (!avail() && !refill()) {
+      if (!stack_.empty())
+        return fail("unexpected end of document, element '" + stack_.back() +
+                    "' is not closed");
+      return event_t::end_document;
+    }
+    if (buf_[pos_] != '<') {
+      size_t end = find("<", 0);
+      if (end == npos)
+        end = avail();
+      std::string_view raw(buf_.data() + pos_, end);
+      bool emit = !stack_.empty() && !is_blank(raw);
+      if (emit) {
+        text_.clear();
+        decode_entities(raw, &text_);
+      }
+      pos_ += end;
+      if (emit)
+        return event_t::text;
+      continue;
+    }
+    if (lookingAt("<!--")) {
+      if (!skipTo("-->", 4))
+        return fail("comment is not closed");
+    } else if (lookingAt("<![CDATA[")) {
+      size_t end = find("]]>", 9);
+      if (end == npos)
+        return fail("CDATA section is not closed");
+      text_.assign(buf_, pos_ + 9, end - 9);
+      pos_ += end + 3;
+      if (!stack_.empty())
+        return event_t::text;
+    } else if (lookingAt("<?")) {
+      if (!skipTo("?>", 2))
+        return fail("processing instruction is not closed");
+    } else if (lookingAt("</")) {
+      return parseEndTag();
+    } else if (lookingAt("<!")) {
+      if (!skipDoctype())
+        return fail("DOCTYPE is not closed");
+    } else {
+      return parseStartTag();
+    }
+  }
+}
+
+merror_t XMLPullParser::SkipElement() {
+  return scanElement(nullptr);
+}
+
+merror_t XMLPullParser::CaptureElement(std::string* out) {
+  out->assign(raw_tag_);
+  return scanElement(out);
+}
+
+bool XMLPullParser::refill() {
+  if (eof_)
+    return false;
+  if (pos_) {
+    buf_.erase(0, pos_);
+    pos_ = 0;
+  }
+  size_t old = buf_.size();
+  buf_.resize(old + chunk_size_);
+  size_t n = read_ ? read_(&buf_[old], chunk_size_) : 0;
+  buf_.resize(old + n);
+  if (!n)
+    eof_ = true;
+  return n > 0;
+}
+
+bool XMLPullParser::lookingAt(std::string_view s) {
+  while (avail() < s.size()) {
+    if (!refill())
+      return false;
+  }
+  return buf_.compare(pos_, s.size(), s) == 0;
+}
+
+size_t XMLPullParser::find(std::string_view pattern, size_t from) {
+  for (;;) {
+    size_t p = buf_.find(pattern.data(), pos_ + from, pattern.size());
+    if (p != npos)
+      return p - pos_;
+    size_t scanned = avail();
+    from = std::max(from, scanned >= pattern.size()
+                              ? scanned - pattern.size() + 1
+                              : size_t(0));
+    if (!refill())
+      return npos;
+  }
+}
+
+size_t XMLPullParser::findTagEnd(size_t from) {
+  char quote = 0;
+  for (size_t i = from;; ++i) {
+    while (i >= avail()) {
+      if (!refill())
+        return npos;
+    }
+    char c = buf_[pos_ + i];
+    if (quote) {
+      if (c == quote)
+        quote = 0;
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '>') {
+      return i;
+    }
+  }
+}
+
+void XMLPullParser::consume(size_t n, std::string* out) {
+  if (out)
+    out->append(buf_, pos_, n);
+  pos_ += n;
+}
+
+bool XMLPullParser::skipTo(std::string_view end, size_t from) {
+  size_t p = find(end, from);
+  if (p == npos)
+    return false;
+  pos_ += p + end.size();
+  return true;
+}
+
+bool XMLPullParser::skipDoctype() {
+  int brackets = 0;
+  for (size_t i = 2;; ++i) {
+    while (i >= avail()) {
+      if (!refill())
+        return false;
+    }
+    char c = buf_[pos_ + i];
+    if (c == '[') {
+      ++brackets;
+    } else if (c == ']') {
+      --brackets;
+    } else if (c == '>' && brackets <= 0) {
+      pos_ += i + 1;
+      return true;
+    }
+  }
+}
+
+XMLPullParser::event_t XMLPullParser::parseStartTag() {
+  size_t end = findTagEnd(1);
+  if (end == npos)
+    return fail("tag is not closed");
+  raw_tag_.assign(buf_, pos_, end + 1);
+  pos_ += end + 1;
+  std::string_view tag(raw_tag_);
+  tag = tag.substr(1, tag.size() - 2);
+  bool self_closing = !tag.empty() && tag.back() == '/';
+  if (self_closing)
+    tag.remove_suffix(1);
+  size_t i = 0;
+  while (i < tag.size() && !is_name_end(tag[i]))
+    ++i;
+  if (!i)
+    return fail("empty element name");
+  name_.assign(tag.substr(0, i));
+  attributes_.clear();
+  for (;;) {
+    while (i < tag.size() && is_space(tag[i]))
+      ++i;
+    if (i >= tag.size())
+      break;
+    size_t start = i;
+    while (i < tag.size() && !is_name_end(tag[i]))
+      ++i;
+    if (i == start)
+      return fail("bad attribute in element '" + name_ + "'");
+    attribute a;
+    a.name.assign(tag.substr(start, i - start));
+    while (i < tag.size() && is_space(tag[i]))
+      ++i;
+    if (i >= tag.size() || tag[i] != '=')
+      return fail("attribute '" + a.name + "' has no value");
+    ++i;
+    while (i < tag.size() && is_space(tag[i]))
+      ++i;
+    if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\''))
+      return fail("attribute '" + a.name + "' value is not quoted");
+    char quote = tag[i++];
+    size_t close = tag.find(quote, i);
+    if (close == npos)
+      return fail("attribute '" + a.name + "' value is not closed");
+    decode_entities(tag.substr(i, close - i), &a.value);
+    i = close + 1;
+    attributes_.push_back(std::move(a));
+  }
+  stack_.push_back(name_);
+  pending_end_ = self_closing;
+  return event_t::start_element;
+}
+
+XMLPullParser::event_t XMLPullParser::parseEndTag() {
+  size_t end = findTagEnd(2);
+  if (end == npos)
+    return fail("end tag is not closed");
+  std::string_view tag(buf_.data() + pos_ + 2, end - 2);
+  while (!tag.empty() && is_space(tag.back()))
+    tag.remove_suffix(1);
+  if (stack_.empty() || stack_.back() != tag)
+    return fail("unexpected end tag '" + std::string(tag) + "'");
+  pos_ += end + 1;
+  name_ = std::move(stack_.back());
+  stack_.pop_back();
+  return event_t::end_element;
+}
+
+merror_t XMLPullParser::scanElement(std::string* out) {
+  if (error_.GetErrorCode())
+    return error_.GetErrorCode();
+  if (stack_.empty()) {
+    fail("no element to skip");
+    return error_.GetErrorCode();
+  }
+  if (pending_end_) {
+    pending_end_ = false;
+    stack_.pop_back();
+    return ERROR_SUCCESS_T;
+  }
+  for (size_t depth = 1; depth;) {
+    size_t lt = find("<", 0);
+    if (lt == npos) {
+      fail("unexpected end of document, element '" + stack_.back() +
+           "' is not closed");
+      return error_.GetErrorCode();
+    }
+    consume(lt, out);
+    size_t end = npos;
+    if (lookingAt("<!--")) {
+      end = find("-->", 4);
+      end = (end != npos) ? end + 3 : npos;
+    } else if (lookingAt("<![CDATA[")) {
+      end = find("]]>", 9);
+      end = (end != npos) ? end + 3 : npos;
+    } else if (lookingAt("<?")) {
+      end = find("?>", 2);
+      end = (end != npos) ? end + 2 : npos;
+    } else if (lookingAt("</")) {
+      end = findTagEnd(2);
+      if (end != npos) {
+        ++end;
+        --depth;
+      }
+    } else if (lookingAt("<!")) {
+      end = findTagEnd(2);
+      end = (end != npos) ? end + 1 : npos;
+    } else {
+      end = findTagEnd(1);
+      if (end != npos) {
+        if (buf_[pos_ + end - 1] != '/')
+          ++depth;
+        ++end;
+      }
+    }
+    if (end == npos) {
+      fail("unexpected end of document in element '" + stack_.back() + "'");
+      return error_.GetErrorCode();
+    }
+    consume(end, out);
+  }
+  stack_.pop_back();
+  return ERROR_SUCCESS_T;
+}
+
+XMLPullParser::event_t XMLPullParser::fail(const std::string& msg) {
+  error_.SetError(ERROR_PARSER_FORMAT_ST, "xml pull parser: " + msg);
+  status_ = STATUS_HAVE_ERROR;
+  return event_t::error;
+}
+}  // namespace asp_utils
@@ -0,0 +1,2777 @@
+#include "asp_utils/ChunkQueue.h"
+#include "asp_utils/Readers/BatchLoader.h"
+#include "asp_utils/Readers/Binding.h"
+#include "asp_utils/Readers/ChildIndex.h"
+#include "asp_utils/Readers/DocumentCache.h"
+#include "asp_utils/Readers/JSONTape.h"
+#include "asp_utils/Readers/MsgPack.h"
+#include "asp_utils/Readers/PathHandle.h"
+#include "asp_utils/Readers/Query.h"
+#include "asp_utils/Readers/Reader.h"
+#include "asp_utils/Readers/TreeTraversal.h"
+#include "asp_utils/Readers/XMLPullParser.h"
+#ifdef WITH_PUGIXML
+#include "asp_utils/Readers/XMLStreamReader.h"
+#endif  // WITH_PUGIXML
+#ifdef WITH_RAPIDJSON
+#include "asp_utils/Readers/JSONReader.h"
+#include "asp_utils/Readers/JSONStreamReader.h"
+#endif  // WITH_RAPIDJSON
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace asp_utils;
+
+/**
+ * \brief Простое дерево для тестов шаблонов ридеров, без json/xml
+ *   библиотек. Формат: `name[=value][{ child child ... }]`
+ * */
+struct test_tree {
+  std::string name;
+  std::string value;
+  std::vector<test_tree> childs;
+
+  const test_tree* child(std::string_view n) const {
+    for (const auto& ch : childs)
+      if (ch.name == n)
+        return &ch;
+    return nullptr;
+  }
+  /** \brief Разобрать узел начиная с позиции `pos` */
+  static bool parse(const char* s, size_t* pos, test_tree* out) {
+    const auto skip = [s, pos]() {
+      while (s[*pos] && isspace(s[*pos]))
+        ++*pos;
+    };
+    const auto word = [s, pos]() {
+      size_t start = *pos;
+      while (s[*pos] && !isspace(s[*pos]) && !strchr("={}", s[*pos]))
+        ++*pos;
+      return std::string(s + start, *pos - start);
+    };
+    skip();
+    out->name = word();
+    if (out->name.empty())
+      return false;
+    if (s[*pos] == '=') {
+      ++*pos;
+      out->value = word();
+    }
+    skip();
+    if (s[*pos] == '{') {
+      ++*pos;
+      for (skip(); s[*pos] && s[*pos] != '}'; skip()) {
+        out->childs.emplace_back();
+        if (!parse(s, pos, &out->childs.back()))
+          return false;
+      }
+      if (s[*pos] != '}')
+        return false;
+      ++*pos;
+    }
+    return true;
+  }
+};
+
+namespace asp_utils {
+template <>
+struct lib_node<test_tree> {
+  using NodeDocType = test_tree;
+
+ public:
+  lib_node() {}
+  lib_node(test_tree* tn) : data(tn) {}
+
+  test_tree* GetNodePointer() { return data; }
+  test_tree* GetChild(const char* name) {
+    return const_cast<test_tree*>(data->child(name));
+  }
+  std::string_view GetValueView(std::string_view name) const {
+    const test_tree* ch = data->child(name);
+    return ch ? std::string_view(ch->value) : std::string_view();
+  }
+  template <class F>
+  void ForEachChild(F&& f) {
+    for (auto& ch : data->childs) {
+      lib_node child(&ch);
+      f(std::string_view(ch.name), std::string_view(ch.value), &child);
+    }
+  }
+  static bool IsInitialized(const test_tree* tn) { return tn != nullptr; }
+  static test_tree* InitDocumentRoot(test_tree* doc,
+                                     char* memory,
+                                     size_t,
+                                     std::string* root_name,
+                                     ErrorWrap* ew,
+                                     const reader_options&) {
+    size_t pos = 0;
+    if (!test_tree::parse(memory, &pos, doc)) {
+      ew->SetError(ERROR_PARSER_FORMAT_ST, "test_tree parse error");
+      return nullptr;
+    }
+    *root_name = doc->name;
+    return doc;
+  }
+
+ public:
+  test_tree* data = nullptr;
+};
+}  // namespace asp_utils
+
+/**
+ * \brief Инициализатор узла test_tree, считает вызовы InitData
+ * */
+class test_init : public INodeInitializer {
+ public:
+  merror_t InitData(test_tree* tn, const std::string& name) {
+    ++init_count;
+    if (init_delay_us)
+      std::this_thread::sleep_for(std::chrono::microseconds(init_delay_us));
+    {
+      std::lock_guard<std::mutex> lock(threads_mutex);
+      threads.insert(std::this_thread::get_id());
+    }
+    name_ = name;
+    node_ = tn;
+    for (const auto& ch : tn->childs)
+      if (!ch.childs.empty())
+        subnodes_.push_back(ch.name);
+    return ERROR_SUCCESS_T;
+  }
+  /** \brief Тот же узел, загруженный из бинарного снимка */
+  merror_t InitData(snapshot_node* sn, const std::string& name) {
+    ++init_count;
+    name_ = name;
+    snapshot_ = *sn;
+    for (size_t i = 0; i < sn->GetChildsCount(); ++i)
+      if (sn->GetChild(i).GetChildsCount())
+        subnodes_.emplace_back(sn->GetChild(i).GetName());
+    return ERROR_SUCCESS_T;
+  }
+  std::string GetParameter(const std::string& name) override {
+    if (!node_)
+      return std::string(snapshot_.GetChild(std::string_view(name)).GetValue());
+    const test_tree* ch = node_->child(name.c_str());
+    return ch ? ch->value : "";
+  }
+  void SetSubnodesNames(inodes_vec* subnodes) override {
+    *subnodes = subnodes_;
+  }
+  void SetParentData(test_init& parent) {
+    parent.childs_names.push_back(name_);
+  }
+
+ public:
+  /** \brief имена дочерних элементов в порядке вызова SetParentData */
+  std::vector<std::string> childs_names;
+
+  static std::atomic<int> init_count;
+  static std::atomic<int> init_delay_us;
+  static std::mutex threads_mutex;
+  static std::set<std::thread::id> threads;
+
+ private:
+  const test_tree* node_ = nullptr;
+  snapshot_node snapshot_;
+};
+std::atomic<int> test_init::init_count = 0;
+std::atomic<int> test_init::init_delay_us = 0;
+std::mutex test_init::threads_mutex;
+std::set<std::thread::id> test_init::threads;
+
+/**
+ * \brief Фабрика с состоянием, без GetThreadFactory
+ * */
+class counting_factory {
+ public:
+  template <class NodeT>
+  test_init* GetNodeInitializer() {
+    if (++active > 1)
+      overlapped = true;
+    ++created;
+    std::this_thread::yield();
+    --active;
+    return new test_init();
+  }
+
+ public:
+  int created = 0;
+  /** \brief фабрику вызывали одновременно из нескольких потоков */
+  std::atomic<bool> overlapped = false;
+
+ private:
+  std::atomic<int> active = 0;
+};
+
+/**
+ * \brief Фабрика, бросающая исключение, пока выставлен `fail`
+ * */
+class throwing_factory {
+ public:
+  template <class NodeT>
+  test_init* GetNodeInitializer() {
+    if (fail) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      throw std::runtime_error("factory failure");
+    }
+    return new test_init();
+  }
+
+ public:
+  std::atomic<bool> fail = false;
+};
+
+typedef ReaderSample<test_tree, test_init> test_reader;
+typedef node_sample<test_tree, test_init, SimpleInitializerFactory<test_init>>
+    test_node;
+
+/** \brief Документ: `root{ s0{ a{ x=.. } b{ ... } } s1{ ... } ... }` */
+static std::string test_document(int sections, int items) {
+  std::string doc = "root{ version=1 ";
+  for (int i = 0; i < sections; ++i) {
+    doc += "s" + std::to_string(i) + "{ id=" + std::to_string(i) + " ";
+    for (int j = 0; j < items; ++j)
+      doc += "i" + std::to_string(j) + "{ v=" + std::to_string(i * 1000 + j) +
+             " } ";
+    doc += "} ";
+  }
+  return doc + "}";
+}
+
+/**
+ * \brief Тест индекса поиска дочерних элементов
+ * */
+TEST(Readers, ChildsIndex) {
+  static_assert(name_hash("") == 0xcbf29ce484222325ull);
+  static_assert(name_hash("a") != name_hash("b"));
+
+  std::vector<std::string> names;
+  for (int i = 0; i < 1000; ++i)
+    names.push_back("child_" + std::to_string(i));
+  names.push_back("child_7");  // дубликат - найтись должен первый
+
+  childs_index idx;
+  EXPECT_FALSE(idx.IsBuilt());
+  idx.Build(names.size(),
+            [&names](size_t i) -> std::string_view { return names[i]; });
+  ASSERT_TRUE(idx.IsBuilt());
+  const auto find = [&names, &idx](const std::string& name) {
+    return idx.Find(name, [&](size_t i) { return names[i] == name; });
+  };
+  for (size_t i = 0; i < 1000; ++i)
+    EXPECT_EQ(find(names[i]), i);
+  EXPECT_EQ(find("child_7"), 7);
+  EXPECT_EQ(find("child_1000"), childs_index::npos);
+  EXPECT_EQ(find(""), childs_index::npos);
+}
+
+/**
+ * \brief Тест скомпилированных путей и индекса путей
+ * */
+TEST(Readers, PathHandle) {
+  constexpr auto sp = "data/d1/value"_path;
+  static_assert(sp.Size() == 3);
+  static_assert(sp.GetName(1) == "d1");
+  static_assert("data"_path.GetPrefixHash(1) == sp.GetPrefixHash(1));
+
+  path_handle ph("data/d1/value");
+  ASSERT_EQ(ph.Size(), 3);
+  path_handle pv(std::vector<std::string>{"data", "d1", "value"});
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(ph.GetName(i), sp.GetName(i));
+    EXPECT_EQ(pv.GetName(i), sp.GetName(i));
+    EXPECT_EQ(ph.GetHash(i), sp.GetHash(i));
+    EXPECT_EQ(ph.GetPrefixHash(i + 1), sp.GetPrefixHash(i + 1));
+  }
+  EXPECT_EQ(path_handle("").Size(), 0);
+  EXPECT_EQ(path_handle("a//b").GetName(1), "");
+
+  path_index<int> idx;
+  idx.Insert(path_hash_seed, "", 0);
+  std::vector<std::string> names;
+  for (int i = 0; i < 100; ++i) {
+    std::string name = "n" + std::to_string(i);
+    uint64_t h = path_hash_step(path_hash_seed, name_hash(name));
+    idx.Insert(h, name, i + 1);
+    idx.Insert(path_hash_step(h, name_hash("value")), name + '\0' + "value",
+               -i - 1);
+  }
+  // повторная вставка не перезаписывает значение
+  idx.Insert(path_hash_step(path_hash_seed, name_hash("n5")), "n5", 1000);
+  EXPECT_EQ(idx.Size(), 201);
+
+  const int* v = idx.Find(path_handle(""), 0);
+  ASSERT_NE(v, nullptr);
+  EXPECT_EQ(*v, 0);
+  v = idx.Find(path_handle("n5/value"), 1);
+  ASSERT_NE(v, nullptr);
+  EXPECT_EQ(*v, 6);
+  v = idx.Find(path_handle("n42/value"), 2);
+  ASSERT_NE(v, nullptr);
+  EXPECT_EQ(*v, -43);
+  v = idx.Find(std::vector<std::string>{"n42", "value"}, 2);
+  ASSERT_NE(v, nullptr);
+  EXPECT_EQ(*v, -43);
+  EXPECT_EQ(idx.Find(path_handle("n42/other"), 2), nullptr);
+  EXPECT_EQ(idx.Find(path_handle("n100"), 1), nullptr);
+}
+
+/**
+ * \brief Тест плоского дерева: то же дерево, параметры и поиск,
+ *   что и у дерева node_sample
+ * */
+TEST(Readers, FlatTree) {
+  // у корня дочерних элементов больше CHILDS_INDEX_THRESHOLD -
+  //   поиск по индексу, у секций - перебором
+  std::string doc = test_document(CHILDS_INDEX_THRESHOLD + 3, 3);
+  std::unique_ptr<test_reader> nodes(test_reader::Init(doc.c_str()));
+  ASSERT_EQ(nodes->InitData(), ERROR_SUCCESS_T);
+  reader_options opts;
+  opts.flat_tree = true;
+  std::unique_ptr<test_reader> flat(
+      test_reader::Init(doc.c_str(), nullptr, opts));
+  ASSERT_EQ(flat->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(flat->GetRootNode(), nullptr);
+
+  typedef flat_tree_sample<test_tree, test_init,
+                           SimpleInitializerFactory<test_init>>
+      test_flat;
+  test_tree tree;
+  size_t pos = 0;
+  ASSERT_TRUE(test_tree::parse(doc.c_str(), &pos, &tree));
+  test_flat ft(nullptr);
+  ASSERT_EQ(ft.Build(lib_node<test_tree>(&tree), "root"), ERROR_SUCCESS_T);
+
+  // обход дерева node_sample: каждый узел есть в плоском дереве
+  //   с тем же путём, дочерними элементами и параметрами
+  size_t count = 0;
+  std::vector<std::string> path;
+  std::function<void(const test_node&, test_flat::node_id)> walk;
+  walk = [&](const test_node& n, test_flat::node_id id) {
+    ++count;
+    ASSERT_NE(id, test_flat::npos);
+    const test_init* expected = n.node_data_ptr.get();
+    const test_flat::flat_node& fn = ft.GetNode(id);
+    EXPECT_EQ(fn.data->GetName(), expected->GetName());
+    EXPECT_EQ(fn.data->childs_names, expected->childs_names);
+    EXPECT_EQ(fn.childs_count, n.GetChilds().size());
+    EXPECT_EQ(ft.FindByPath(path, path.size()), fn.data);
+    test_init* via_reader = flat->GetNodeByPath(path);
+    ASSERT_NE(via_reader, nullptr);
+    EXPECT_EQ(via_reader->childs_names, expected->childs_names);
+    for (const char* param : {"id", "v", "version", "none"}) {
+      std::string a, b;
+      path.push_back(param);
+      EXPECT_EQ(flat->GetValueByPath(path, &a), ERROR_SUCCESS_T);
+      EXPECT_EQ(nodes->GetValueByPath(path, &b), ERROR_SUCCESS_T);
+      EXPECT_EQ(a, b);
+      path.pop_back();
+    }
+    EXPECT_EQ(ft.ChildByName(id, "none"), test_flat::npos);
+    for (const auto& ch : n) {
+      const std::string& name = ch.node_data_ptr->GetName();
+      test_flat::node_id ch_id = ft.ChildByName(id, name);
+      EXPECT_EQ(ch_id, ft.ChildByName(id, name, name_hash(name)));
+      if (ch_id != test_flat::npos) {
+        EXPECT_EQ(ft.GetNode(ch_id).parent, id);
+      }
+      path.push_back(name);
+      walk(ch, ch_id);
+      path.pop_back();
+    }
+  };
+  walk(*nodes->GetRootNode(), 0);
+  EXPECT_EQ(count, 1 + (CHILDS_INDEX_THRESHOLD + 3) * (1 + 3));
+  EXPECT_EQ(ft.Size(), count);
+  EXPECT_EQ(ft.GetNames().Size(), nodes->GetNames().Size());
+
+  // отсутствующие пути
+  std::string value;
+  EXPECT_EQ(flat->GetNodeByPath({"s1", "i7"}), nullptr);
+  EXPECT_EQ(nodes->GetNodeByPath({"s1", "i7"}), nullptr);
+  EXPECT_EQ(flat->GetValueByPath({"s99", "v"}, &value),
+            ERROR_PARSER_CHILD_NODE_ST);
+  EXPECT_EQ(nodes->GetValueByPath({"s99", "v"}, &value),
+            ERROR_PARSER_CHILD_NODE_ST);
+}
+
+/**
+ * \brief Тест индекса путей ридера: поиск по индексу совпадает
+ *   с обходом дерева
+ * */
+TEST(Readers, PathIndex) {
+  // одноимённые соседи у корня(поиск по индексу дочерних элементов)
+  //   и у секции(перебором) - найтись должен первый
+  std::string doc = test_document(CHILDS_INDEX_THRESHOLD + 3, 3);
+  doc.replace(doc.find("s0{ "), 4,
+              "dup{ v=1 k{ x=a } } dup{ v=2 k{ x=b } } s0{ "
+              "i1{ v=first } ");
+  std::unique_ptr<test_reader> walk(test_reader::Init(doc.c_str()));
+  ASSERT_EQ(walk->InitData(), ERROR_SUCCESS_T);
+
+  std::vector<std::vector<std::string>> paths = {
+      {},
+      {"dup"},
+      {"dup", "k"},
+      {"s0", "i1"},
+      {"s5", "i2"},
+      {"none"},
+      {"dup", "none"},
+      {"dup", "k", "x"},
+      {"s0", "i1", "v", "w"}};
+  reader_options flat;
+  flat.flat_tree = true;
+  reader_options lazy;
+  lazy.lazy_init = true;
+  for (reader_options opts : {reader_options(), flat, lazy}) {
+    opts.path_index = true;
+    std::unique_ptr<test_reader> indexed(
+        test_reader::Init(doc.c_str(), nullptr, opts));
+    ASSERT_EQ(indexed->InitData(), ERROR_SUCCESS_T);
+    for (const auto& path : paths) {
+      path_handle handle(path);
+      const test_init* expected = walk->GetNodeByPath(path);
+      test_init* found = indexed->GetNodeByPath(path);
+      EXPECT_EQ(found, indexed->GetNodeByPath(handle));
+      ASSERT_EQ(found != nullptr, expected != nullptr) << handle.Size();
+      if (found) {
+        EXPECT_EQ(found->GetName(), expected->GetName());
+        EXPECT_EQ(found->childs_names, expected->childs_names);
+      }
+      std::vector<std::string> param = path;
+      param.push_back("v");
+      std::string a, b, c;
+      merror_t err = walk->GetValueByPath(param, &a);
+      EXPECT_EQ(indexed->GetValueByPath(param, &b), err);
+      EXPECT_EQ(indexed->GetValueByPath(path_handle(param), &c), err);
+      EXPECT_EQ(b, a);
+      EXPECT_EQ(c, a);
+    }
+
+    std::string value;
+    ASSERT_EQ(indexed->GetValueByPath("dup/v"_path, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, "1");
+    ASSERT_EQ(indexed->GetValueByPath("dup/k/x"_path, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, "a");
+    ASSERT_EQ(indexed->GetValueByPath("s0/i1/v"_path, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, "first");
+    EXPECT_EQ(indexed->GetNodeByPath("s0/i1"_path),
+              indexed->GetNodeByPath({"s0", "i1"}));
+    EXPECT_EQ(indexed->GetNodeByPath("s99"_path), nullptr);
+    EXPECT_EQ(indexed->GetValueByPath("s99/v"_path, &value),
+              ERROR_PARSER_CHILD_NODE_ST);
+  }
+}
+
+/**
+ * \brief Тест ленивой инициализации дерева
+ * */
+TEST(Readers, LazyInit) {
+  std::string doc = test_document(10, 20);
+  test_init::init_count = 0;
+  std::unique_ptr<test_reader> eager(test_reader::Init(doc.c_str()));
+  ASSERT_EQ(eager->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(test_init::init_count, 1 + 10 + 10 * 20);
+
+  reader_options opts;
+  opts.lazy_init = true;
+  test_init::init_count = 0;
+  std::unique_ptr<test_reader> lazy(
+      test_reader::Init(doc.c_str(), nullptr, opts));
+  ASSERT_EQ(lazy->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(test_init::init_count, 1);
+
+  std::string value;
+  ASSERT_EQ(lazy->GetValueByPath({"version"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "1");
+  EXPECT_EQ(test_init::init_count, 1);
+  // инициализируются уровень секций и одна секция
+  ASSERT_EQ(lazy->GetValueByPath({"s3", "i7", "v"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "3007");
+  EXPECT_EQ(test_init::init_count, 1 + 10 + 20);
+  ASSERT_NE(lazy->GetNodeByPath("s3/i8"_path), nullptr);
+  EXPECT_EQ(lazy->GetNodeByPath({"s3", "i20"}), nullptr);
+  EXPECT_EQ(test_init::init_count, 1 + 10 + 20);
+
+  // конкурентное обращение - каждый уровень инициализируется один раз
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&lazy, t]() {
+      std::string v;
+      for (int i = 0; i < 10; ++i)
+        lazy->GetValueByPath(
+            {"s" + std::to_string((i + t) % 10), "i1", "v"}, &v);
+    });
+  }
+  for (auto& th : threads)
+    th.join();
+  EXPECT_EQ(test_init::init_count, 1 + 10 + 10 * 20);
+  ASSERT_EQ(lazy->GetValueByPath({"s9", "i1", "v"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "9001");
+
+  // фабрика без GetThreadFactory - ленивые вызовы из разных
+  //   потоков сериализуются
+  counting_factory factory;
+  std::unique_ptr<ReaderSample<test_tree, test_init, counting_factory>> fr(
+      ReaderSample<test_tree, test_init, counting_factory>::Init(
+          doc.c_str(), &factory, opts));
+  ASSERT_EQ(fr->InitData(), ERROR_SUCCESS_T);
+  threads.clear();
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&fr, t]() {
+      std::string v;
+      for (int i = 0; i < 10; ++i)
+        fr->GetValueByPath({"s" + std::to_string((i + t) % 10), "i1", "v"},
+                           &v);
+    });
+  }
+  for (auto& th : threads)
+    th.join();
+  EXPECT_EQ(factory.created, 1 + 10 + 10 * 20);
+  EXPECT_FALSE(factory.overlapped);
+}
+
+/**
+ * \brief Тест параллельной инициализации дерева
+ * */
+TEST(Readers, ParallelInit) {
+  std::string doc = test_document(16, 20);
+  std::unique_ptr<test_reader> seq(test_reader::Init(doc.c_str()));
+  ASSERT_EQ(seq->InitData(), ERROR_SUCCESS_T);
+
+  reader_options opts;
+  opts.parallel_init = true;
+  opts.threads = 4;
+  test_init::init_delay_us = 200;
+  test_init::threads.clear();
+  std::unique_ptr<test_reader> par(
+      test_reader::Init(doc.c_str(), nullptr, opts));
+  ASSERT_EQ(par->InitData(), ERROR_SUCCESS_T);
+  test_init::init_delay_us = 0;
+  EXPECT_GT(test_init::threads.size(), 1);
+
+  // порядок дочерних элементов совпадает с последовательным
+  EXPECT_EQ(par->GetNodeByPath(std::vector<std::string>{})->childs_names,
+            seq->GetNodeByPath(std::vector<std::string>{})->childs_names);
+  ASSERT_EQ(par->GetNodeByPath({"s5"})->childs_names.size(), 20);
+  for (int j = 0; j < 20; ++j)
+    EXPECT_EQ(par->GetNodeByPath({"s5"})->childs_names[j],
+              "i" + std::to_string(j));
+  std::string v1, v2;
+  for (int i = 0; i < 16; ++i) {
+    std::vector<std::string> path{"s" + std::to_string(i), "i3", "v"};
+    ASSERT_EQ(par->GetValueByPath(path, &v1), ERROR_SUCCESS_T);
+    ASSERT_EQ(seq->GetValueByPath(path, &v2), ERROR_SUCCESS_T);
+    EXPECT_EQ(v1, v2);
+  }
+
+  // фабрика без GetThreadFactory - вызовы сериализуются
+  counting_factory factory;
+  std::unique_ptr<ReaderSample<test_tree, test_init, counting_factory>> fr(
+      ReaderSample<test_tree, test_init, counting_factory>::Init(
+          doc.c_str(), &factory, opts));
+  ASSERT_EQ(fr->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(factory.created, 1 + 16 + 16 * 20);
+
+  // ридер, созданный в рабочем потоке чужого пула(как в BatchLoader),
+  //   инициализирует дерево своим пулом
+  ThreadPool outer(1);
+  EXPECT_EQ(outer.GetCurrentWorker(), ThreadPool::npos);
+  test_init::init_delay_us = 200;
+  test_init::threads.clear();
+  size_t worker = outer.Submit([&]() {
+    std::unique_ptr<test_reader> nested(
+        test_reader::Init(doc.c_str(), nullptr, opts));
+    EXPECT_EQ(nested->InitData(), ERROR_SUCCESS_T);
+    EXPECT_EQ(ThreadPool::GetCurrentPool(), &outer);
+    return outer.GetCurrentWorker();
+  }).get();
+  test_init::init_delay_us = 0;
+  EXPECT_EQ(worker, 0);
+  EXPECT_GT(test_init::threads.size(), 1);
+}
+
+/**
+ * \brief Тест потокового разборщика xml, блоки чтения меньше токенов
+ * */
+TEST(Readers, XMLPullParser) {
+  typedef XMLPullParser::event_t event_t;
+  const std::string xml =
+      "<?xml version=\"1.0\"?>\n"
+      "<!DOCTYPE catalog [ <!ELEMENT catalog ANY> ]>\n"
+      "<!-- catalog > comment -->\n"
+      "<catalog version=\"2\" note='a &gt; b &amp; &#x441;'>\n"
+      "  <item id=\"1\" expr=\"x > y\"><name>first &lt;1&gt;</name></item>\n"
+      "  <skipped><deep><deeper a=\"/>\"/></deep><!-- </skipped> --></skipped>\n"
+      "  <item id=\"2\"/>\n"
+      "  <raw><![CDATA[<not> & parsed]]></raw>\n"
+      "  <captured k=\"v\"><c>text</c><e/></captured>\n"
+      "</catalog>\n";
+  for (size_t chunk : {size_t(16), size_t(7), size_t(4096)}) {
+    XMLPullParser p(chunk);
+    size_t offset = 0;
+    p.SetSource([&xml, &offset](char* buf, size_t size) {
+      size_t n = std::min(size, xml.size() - offset);
+      memcpy(buf, xml.data() + offset, n);
+      offset += n;
+      return n;
+    });
+    ASSERT_EQ(p.Next(), event_t::start_element);
+    EXPECT_EQ(p.GetName(), "catalog");
+    ASSERT_EQ(p.GetAttributes().size(), 2);
+    EXPECT_EQ(*p.GetAttribute("version"), "2");
+    EXPECT_EQ(*p.GetAttribute("note"), "a > b & \xD1\x81");
+    EXPECT_EQ(p.GetDepth(), 1);
+
+    ASSERT_EQ(p.Next(), event_t::start_element);
+    EXPECT_EQ(p.GetName(), "item");
+    EXPECT_EQ(*p.GetAttribute("expr"), "x > y");
+    ASSERT_EQ(p.Next(), event_t::start_element);
+    EXPECT_EQ(p.GetName(), "name");
+    ASSERT_EQ(p.Next(), event_t::text);
+    EXPECT_EQ(p.GetText(), "first <1>");
+    ASSERT_EQ(p.Next(), event_t::end_element);
+    EXPECT_EQ(p.GetName(), "name");
+    ASSERT_EQ(p.Next(), event_t::end_element);
+    EXPECT_EQ(p.GetName(), "item");
+
+    ASSERT_EQ(p.Next(), event_t::start_element);
+    EXPECT_EQ(p.GetName(), "skipped");
+    ASSERT_EQ(p.SkipElement(), ERROR_SUCCESS_T);
+    EXPECT_EQ(p.GetDepth(), 1);
+
+    ASSERT_EQ(p.Next(), event_t::start_element);
+    EXPECT_EQ(*p.GetAttribute("id"), "2");
+    ASSERT_EQ(p.Next(), event_t::end_element);
+    EXPECT_EQ(p.GetName(), "item");
+
+    ASSERT_EQ(p.Next(), event_t::start_element);
+    ASSERT_EQ(p.Next(), event_t::text);
+    EXPECT_EQ(p.GetText(), "<not> & parsed");
+    ASSERT_EQ(p.Next(), event_t::end_element);
+
+    ASSERT_EQ(p.Next(), event_t::start_element);
+    std::string raw;
+    ASSERT_EQ(p.CaptureElement(&raw), ERROR_SUCCESS_T);
+    EXPECT_EQ(raw, "<captured k=\"v\"><c>text</c><e/></captured>");
+
+    ASSERT_EQ(p.Next(), event_t::end_element);
+    EXPECT_EQ(p.GetName(), "catalog");
+    EXPECT_EQ(p.Next(), event_t::end_document);
+    EXPECT_EQ(p.GetDepth(), 0);
+  }
+
+  XMLPullParser bad;
+  bad.SetData("<a><b></a>");
+  EXPECT_EQ(bad.Next(), event_t::start_element);
+  EXPECT_EQ(bad.Next(), event_t::start_element);
+  EXPECT_EQ(bad.Next(), event_t::error);
+  EXPECT_EQ(bad.GetError(), ERROR_PARSER_FORMAT_ST);
+  XMLPullParser unclosed;
+  unclosed.SetData("<a><b/>");
+  EXPECT_EQ(unclosed.Next(), event_t::start_element);
+  EXPECT_EQ(unclosed.Next(), event_t::start_element);
+  EXPECT_EQ(unclosed.Next(), event_t::end_element);
+  EXPECT_EQ(unclosed.Next(), event_t::error);
+}
+
+/**
+ * \brief Тест передачи документа ридеру по частям
+ * */
+TEST(Readers, Feed) {
+  std::string doc = test_document(5, 5);
+  test_init::init_count = 0;
+  std::unique_ptr<test_reader> fed(test_reader::InitFeed());
+  for (size_t i = 0; i < doc.size(); i += 7)
+    ASSERT_EQ(fed->Feed(std::string_view(doc).substr(i, 7)), ERROR_SUCCESS_T);
+  ASSERT_EQ(fed->Finish(), ERROR_SUCCESS_T);
+  EXPECT_EQ(test_init::init_count, 1 + 5 + 5 * 5);
+  std::string value;
+  ASSERT_EQ(fed->GetValueByPath({"s4", "i3", "v"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "4003");
+
+  // потоковый разбор xml из очереди, заполняемой другим потоком
+  std::string xml = "<root>";
+  for (int i = 0; i < 100; ++i)
+    xml += "<item id=\"" + std::to_string(i) + "\"><v>" + std::to_string(i) +
+           "</v></item>";
+  xml += "</root>";
+  ChunkQueue queue(4);
+  std::thread producer([&queue, &xml]() {
+    for (size_t i = 0; i < xml.size(); i += 5)
+      queue.Push(std::string_view(xml).substr(i, 5));
+    queue.Close();
+  });
+  XMLPullParser parser(32);
+  parser.SetSource(
+      [&queue](char* buffer, size_t size) { return queue.Read(buffer, size); });
+  int items = 0, sum = 0;
+  for (auto e = parser.Next(); e != XMLPullParser::event_t::end_document;
+       e = parser.Next()) {
+    ASSERT_NE(e, XMLPullParser::event_t::error);
+    if (e == XMLPullParser::event_t::start_element &&
+        parser.GetName() == "item")
+      ++items;
+    if (e == XMLPullParser::event_t::text)
+      sum += std::stoi(parser.GetText());
+  }
+  producer.join();
+  EXPECT_EQ(items, 100);
+  EXPECT_EQ(sum, 99 * 100 / 2);
+}
+
+/**
+ * \brief Тест пакетной загрузки файлов
+ * */
+TEST(Readers, BatchLoader) {
+  fs::path dir = "test_batch_dir";
+  fs::create_directory(dir);
+  std::vector<fs::path> names;
+  for (int i = 0; i < 12; ++i) {
+    names.push_back("file" + std::to_string(i));
+    std::ofstream f(dir / names.back(), std::ios::binary);
+    f << test_document(2 + i % 3, 4);
+  }
+  names.push_back("not_exists");
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  ASSERT_TRUE(root.IsInitialized());
+  auto urls = root.CreateFileURLs(names);
+
+  batch_options bo;
+  bo.io_threads = 2;
+  bo.parse_threads = 3;
+  bo.max_in_flight = 2;
+  BatchLoaderSample<test_tree, test_init> loader(bo);
+  auto items = loader.Load(urls);
+  ASSERT_EQ(items.size(), names.size());
+  for (int i = 0; i < 12; ++i) {
+    ASSERT_EQ(items[i].error, ERROR_SUCCESS_T);
+    ASSERT_TRUE(items[i].reader);
+    std::string value;
+    int last = 1 + i % 3;
+    ASSERT_EQ(items[i].reader->GetValueByPath(
+                  {"s" + std::to_string(last), "i3", "v"}, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, std::to_string(last * 1000 + 3));
+  }
+  EXPECT_EQ(items.back().error, ERROR_FILE_EXISTS_ST);
+  EXPECT_FALSE(items.back().reader);
+  const batch_stats& stats = loader.GetStats();
+  EXPECT_EQ(stats.io.files, 12);
+  EXPECT_EQ(stats.parse.files, 12);
+  EXPECT_EQ(stats.io.bytes, stats.parse.bytes);
+  EXPECT_EQ(stats.errors, 1);
+  EXPECT_GT(stats.wall_seconds, 0.0);
+
+  // фабрика без GetThreadFactory - разбор в одном потоке
+  counting_factory factory;
+  BatchLoaderSample<test_tree, test_init, counting_factory> counted(bo);
+  urls.pop_back();
+  auto citems = counted.Load(urls, &factory);
+  for (const auto& item : citems)
+    EXPECT_EQ(item.error, ERROR_SUCCESS_T);
+  EXPECT_EQ(factory.created, 4 * (1 + 2 + 2 * 4) + 4 * (1 + 3 + 3 * 4) +
+                                 4 * (1 + 4 + 4 * 4));
+
+  fs::remove_all(dir);
+}
+
+/**
+ * \brief Тест ридера с файлом, отображённым в память
+ * */
+TEST(Readers, MappedFile) {
+  fs::path dir = "test_mapped_dir";
+  fs::create_directory(dir);
+  // второй документ дополнен до 64 KiB - кратен размеру страницы,
+  //   отображение без завершающего нуля невозможно, файл считывается
+  std::string doc = test_document(5, 7);
+  std::string aligned = doc;
+  aligned.insert(aligned.size() - 1, "pad= ");
+  const size_t size = 64 * 1024;
+  aligned.insert(aligned.size() - 2, size - aligned.size(), 'x');
+  ASSERT_EQ(aligned.size(), size);
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  for (const std::string* text : {&doc, &aligned}) {
+    {
+      std::ofstream f(dir / "doc", std::ios::binary);
+      f << *text;
+    }
+    auto url = root.CreateFileURL("doc");
+    reader_options opts;
+    opts.buffer_mode = file_utils::buffer_mode_t::mmap;
+    std::unique_ptr<test_reader> reader(test_reader::Init(&url, nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    std::string value;
+    ASSERT_EQ(reader->GetValueByPath({"s4", "i6", "v"}, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, "4006");
+    ASSERT_EQ(reader->GetValueByPath({"pad"}, &value), ERROR_SUCCESS_T);
+    EXPECT_EQ(value.size(), (text == &doc) ? 0 : size - doc.size() - 5);
+
+    ErrorWrap ew;
+    file_utils::FileBuffer memory;
+    ASSERT_EQ(memory.Load(dir / "doc", file_utils::buffer_mode_t::mmap, ew),
+              ERROR_SUCCESS_T);
+    ASSERT_EQ(memory.GetSize(), text->size());
+    EXPECT_EQ(memory.GetData()[memory.GetSize()], '\0');
+#ifdef OS_UNIX
+    EXPECT_EQ(memory.IsMapped(), text == &doc);
+#endif  // OS_UNIX
+  }
+  fs::remove_all(dir);
+}
+
+/**
+ * \brief Тест бинарного снимка документа
+ * */
+TEST(Readers, Snapshot) {
+  fs::path dir = "test_snapshot_dir";
+  fs::create_directory(dir);
+  fs::path src = dir / "doc", snap = dir / "doc.snap";
+  {
+    std::ofstream f(src, std::ios::binary);
+    f << test_document(4, 6);
+  }
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  auto src_url = root.CreateFileURL("doc");
+  auto snap_url = root.CreateFileURL("doc.snap");
+
+  std::unique_ptr<test_reader> parsed(test_reader::Init(&src_url));
+  ASSERT_EQ(parsed->InitData(), ERROR_SUCCESS_T);
+  ASSERT_EQ(parsed->SaveSnapshot(snap), ERROR_SUCCESS_T);
+  EXPECT_TRUE(IsSnapshotValid(snap, src));
+  EXPECT_FALSE(IsSnapshotValid(src, src));
+
+  typedef ReaderSample<snapshot_node, test_init> snapshot_reader;
+  reader_options opts;
+  opts.buffer_mode = file_utils::buffer_mode_t::mmap;
+  test_init::init_count = 0;
+  std::unique_ptr<snapshot_reader> loaded(
+      snapshot_reader::Init(&snap_url, nullptr, opts));
+  ASSERT_EQ(loaded->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(test_init::init_count, 1 + 4 + 4 * 6);
+  std::string value;
+  ASSERT_EQ(loaded->GetValueByPath({"version"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "1");
+  ASSERT_EQ(loaded->GetValueByPath({"s2", "i5", "v"}, &value),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "2005");
+  EXPECT_EQ(loaded->GetNodeByPath({"s2", "i6"}), nullptr);
+  // снимок снимка совпадает с исходным
+  fs::path snap2 = dir / "doc2.snap";
+  ASSERT_EQ(loaded->SaveSnapshot(snap2), ERROR_SUCCESS_T);
+  EXPECT_EQ(fs::file_size(snap2), fs::file_size(snap));
+
+  // исходный файл изменён - снимок устарел
+  {
+    std::ofstream f(src, std::ios::binary | std::ios::app);
+    f << " ";
+  }
+  EXPECT_FALSE(IsSnapshotValid(snap, src));
+
+  // повреждённый снимок не загружается
+  {
+    std::fstream f(snap, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(0);
+    f << "XXXX";
+  }
+  std::unique_ptr<snapshot_reader> broken(
+      snapshot_reader::Init(&snap_url, nullptr, opts));
+  EXPECT_EQ(broken->InitData(), ERROR_PARSER_FORMAT_ST);
+
+  fs::remove_all(dir);
+}
+
+/**
+ * \brief Тест кэша разобранных документов
+ * */
+TEST(Readers, DocumentCache) {
+  fs::path dir = "test_cache_dir";
+  fs::create_directory(dir);
+  for (int i = 0; i < 3; ++i) {
+    std::ofstream f(dir / ("doc" + std::to_string(i)), std::ios::binary);
+    f << test_document(2, 3);
+  }
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  auto url0 = root.CreateFileURL("doc0");
+  auto url1 = root.CreateFileURL("doc1");
+  auto url2 = root.CreateFileURL("doc2");
+  size_t file_size = fs::file_size(dir / "doc0");
+
+  document_cache_options co;
+  co.max_bytes = 2 * file_size;
+  co.verify_content = true;
+  DocumentCacheSample<test_tree, test_init> cache(nullptr, reader_options(),
+                                                  co);
+  // одновременные обращения - один разбор
+  test_init::init_count = 0;
+  test_init::init_delay_us = 200;
+  std::vector<std::thread> threads;
+  std::vector<DocumentCacheSample<test_tree, test_init>::document_ptr> docs(8);
+  for (size_t i = 0; i < docs.size(); ++i)
+    threads.emplace_back([&, i]() { docs[i] = cache.Get(url0); });
+  for (auto& t : threads)
+    t.join();
+  test_init::init_delay_us = 0;
+  EXPECT_EQ(test_init::init_count, 1 + 2 + 2 * 3);
+  for (const auto& doc : docs)
+    EXPECT_EQ(doc.get(), docs[0].get());
+  std::string value;
+  ASSERT_TRUE(docs[0]);
+  ASSERT_EQ(docs[0]->GetValueByPath({"s1", "i2", "v"}, &value),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "1002");
+  auto stats = cache.GetStats();
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.hits, 7);
+  EXPECT_EQ(stats.bytes, file_size);
+
+  // вытеснение давно не использованного документа
+  auto doc1 = cache.Get(url1);
+  EXPECT_EQ(cache.Get(url0), docs[0]);
+  auto doc2 = cache.Get(url2);
+  stats = cache.GetStats();
+  EXPECT_EQ(stats.evictions, 1);
+  EXPECT_EQ(stats.documents, 2);
+  EXPECT_EQ(stats.bytes, 2 * file_size);
+  EXPECT_EQ(cache.Get(url0), docs[0]);
+  EXPECT_NE(cache.Get(url1), doc1);
+  ASSERT_EQ(doc1->GetValueByPath({"version"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "1");
+
+  // файл изменился - документ разбирается заново
+  {
+    std::ofstream f(dir / "doc0", std::ios::binary);
+    f << "root{ version=2 }";
+  }
+  merror_t error = ERROR_GENERAL_T;
+  auto changed = cache.Get(url0, &error);
+  EXPECT_EQ(error, ERROR_SUCCESS_T);
+  ASSERT_TRUE(changed);
+  EXPECT_NE(changed, docs[0]);
+  ASSERT_EQ(changed->GetValueByPath({"version"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "2");
+  EXPECT_EQ(cache.GetStats().invalidations, 1);
+
+  // ошибки не кэшируются
+  {
+    std::ofstream f(dir / "doc2", std::ios::binary);
+    f << "{";
+  }
+  EXPECT_FALSE(cache.Get(url2, &error));
+  EXPECT_EQ(error, ERROR_PARSER_FORMAT_ST);
+  auto missing = root.CreateFileURL("not_exists");
+  EXPECT_FALSE(cache.Get(missing, &error));
+  EXPECT_NE(error, ERROR_SUCCESS_T);
+
+  cache.Clear();
+  stats = cache.GetStats();
+  EXPECT_EQ(stats.documents, 0);
+  EXPECT_EQ(stats.bytes, 0);
+
+  // исключение при разборе получают все ждущие потоки, файл
+  //   разбирается заново при следующем обращении
+  throwing_factory factory;
+  DocumentCacheSample<test_tree, test_init, throwing_factory> throwing(
+      &factory);
+  factory.fail = true;
+  std::vector<std::thread> failed;
+  std::atomic<int> exceptions = 0;
+  for (int i = 0; i < 4; ++i) {
+    failed.emplace_back([&]() {
+      try {
+        throwing.Get(url1);
+      } catch (const std::runtime_error&) {
+        ++exceptions;
+      }
+    });
+  }
+  for (auto& t : failed)
+    t.join();
+  EXPECT_EQ(exceptions, 4);
+  factory.fail = false;
+  auto recovered = throwing.Get(url1, &error);
+  EXPECT_EQ(error, ERROR_SUCCESS_T);
+  ASSERT_TRUE(recovered);
+  EXPECT_EQ(throwing.GetStats().documents, 1);
+
+  fs::remove_all(dir);
+}
+
+/**
+ * \brief Тест обновления дерева по структурным хэшам узлов
+ * */
+TEST(Readers, Reload) {
+  fs::path dir = "test_reload_dir";
+  fs::create_directory(dir);
+  const auto write = [&dir](const std::string& doc) {
+    std::ofstream f(dir / "doc", std::ios::binary);
+    f << doc;
+  };
+  std::string doc = test_document(3, 4);
+  write(doc);
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  auto url = root.CreateFileURL("doc");
+
+  reader_options opts;
+  opts.reloadable = true;
+  opts.lazy_init = true;
+  std::unique_ptr<test_reader> reader(test_reader::Init(&url, nullptr, opts));
+  test_init::init_count = 0;
+  ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(test_init::init_count, 1 + 3 + 3 * 4);
+  std::vector<std::string> notified;
+  size_t id = reader->Subscribe(
+      [&notified](const std::vector<std::string>& paths) {
+        notified.insert(notified.end(), paths.begin(), paths.end());
+      });
+
+  // файл не изменился - ничего не инициализируется
+  std::vector<std::string> changed;
+  ASSERT_EQ(reader->Reload(&changed), ERROR_SUCCESS_T);
+  EXPECT_TRUE(changed.empty());
+  EXPECT_TRUE(notified.empty());
+  EXPECT_EQ(test_init::init_count, 1 + 3 + 3 * 4);
+
+  // изменился один параметр - заново инициализируются узел
+  //   и его предки, остальные инициализаторы переиспользуются
+  test_init* s0 = reader->GetNodeByPath({"s0"});
+  test_init* s1 = reader->GetNodeByPath({"s1"});
+  test_init* i2 = reader->GetNodeByPath({"s1", "i2"});
+  test_init* i3 = reader->GetNodeByPath({"s1", "i3"});
+  doc.replace(doc.find("1002"), 4, "7777");
+  write(doc);
+  test_init::init_count = 0;
+  ASSERT_EQ(reader->Reload(&changed), ERROR_SUCCESS_T);
+  EXPECT_EQ(changed, std::vector<std::string>{"s1/i2"});
+  EXPECT_EQ(notified, changed);
+  EXPECT_EQ(test_init::init_count, 3);
+  EXPECT_EQ(reader->GetNodeByPath({"s0"}), s0);
+  EXPECT_EQ(reader->GetNodeByPath({"s1", "i3"}), i3);
+  EXPECT_NE(reader->GetNodeByPath({"s1"}), s1);
+  EXPECT_NE(reader->GetNodeByPath({"s1", "i2"}), i2);
+  EXPECT_EQ(reader->GetNodeByPath({"s1"})->childs_names,
+            (std::vector<std::string>{"i0", "i1", "i2", "i3"}));
+  std::string value;
+  ASSERT_EQ(reader->GetValueByPath({"s1", "i2", "v"}, &value),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "7777");
+
+  // параметр корня, новый и удалённый узлы; узлы прошлой версии
+  //   документа остаются валидными
+  doc = test_document(3, 4);
+  doc.replace(doc.find("1002"), 4, "7777");
+  doc.replace(doc.find("version=1"), 9, "version=2");
+  doc.replace(doc.find("i3{ v=2003 } "), 13, "");
+  doc.insert(doc.size() - 1, "s3{ id=3 i0{ v=3000 } } ");
+  write(doc);
+  reader->Unsubscribe(id);
+  test_init::init_count = 0;
+  ASSERT_EQ(reader->Reload(&changed), ERROR_SUCCESS_T);
+  std::sort(changed.begin(), changed.end());
+  EXPECT_EQ(changed, (std::vector<std::string>{"", "s2/i3", "s3"}));
+  EXPECT_EQ(notified.size(), 1);
+  EXPECT_EQ(test_init::init_count, 1 + 1 + 2);
+  EXPECT_EQ(reader->GetNodeByPath({"s2", "i3"}), nullptr);
+  ASSERT_EQ(reader->GetValueByPath({"s1", "i2", "v"}, &value),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "7777");
+  ASSERT_EQ(reader->GetValueByPath({"version"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "2");
+  ASSERT_EQ(reader->GetValueByPath({"s3", "i0", "v"}, &value),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "3000");
+
+  // ошибка разбора оставляет дерево как есть
+  write("{");
+  EXPECT_EQ(reader->Reload(), ERROR_PARSER_FORMAT_ST);
+  ASSERT_EQ(reader->GetValueByPath({"version"}, &value), ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "2");
+
+  // без хэшей дерево строится заново
+  write(test_document(1, 1));
+  std::unique_ptr<test_reader> plain(test_reader::Init(&url));
+  ASSERT_EQ(plain->InitData(), ERROR_SUCCESS_T);
+  write(test_document(2, 1));
+  ASSERT_EQ(plain->Reload(&changed), ERROR_SUCCESS_T);
+  EXPECT_EQ(changed, std::vector<std::string>{""});
+  EXPECT_NE(plain->GetNodeByPath({"s1", "i0"}), nullptr);
+
+  fs::remove_all(dir);
+}
+
+/**
+ * \brief Тест типизированного доступа к параметрам узла
+ * */
+TEST(Readers, ParameterAs) {
+  const char* text = "root{ n=42 neg=-7 f=0.5 b=true big=300 s=abc }";
+  test_tree tree;
+  size_t pos = 0;
+  ASSERT_TRUE(test_tree::parse(text, &pos, &tree));
+  node_context ctx;
+  test_node node(lib_node<test_tree>(&tree), nullptr, "root", &ctx);
+
+  int i = 0;
+  EXPECT_EQ(node.GetParameterAs("n", &i), ERROR_SUCCESS_T);
+  EXPECT_EQ(i, 42);
+  EXPECT_EQ(node.GetParameterAs<int>("neg"), -7);
+  EXPECT_DOUBLE_EQ(node.GetParameterAs<double>("f"), 0.5);
+  EXPECT_TRUE(node.GetParameterAs<bool>("b"));
+  uint8_t u = 1;
+  EXPECT_EQ(node.GetParameterAs("big", &u), ERROR_PARSER_CHILD_NODE_ST);
+  EXPECT_EQ(u, 1);
+  EXPECT_EQ(node.GetParameterAs("s", &i), ERROR_PARSER_CHILD_NODE_ST);
+  EXPECT_EQ(node.GetParameterAs<int>("missing", 5), 5);
+
+  // значение запомнено в узле: изменение исходника его не меняет,
+  //   другой тип разбирается заново
+  tree.childs[0].value = "43";
+  EXPECT_EQ(node.GetParameterAs<int>("n"), 42);
+  EXPECT_EQ(node.GetParameterAs<long>("n"), 43);
+  // имя - string_view без завершающего нуля
+  std::string_view names = "negative";
+  EXPECT_EQ(node.GetParameterAs<int>(names.substr(0, 3)), -7);
+  EXPECT_EQ(node.GetParameterAs<int>(names.substr(0, 2), 5), 5);
+  EXPECT_EQ(node.GetParameterView(names.substr(0, 3)), "-7");
+
+  // параметр инициализатора - разбор строки GetParameter
+  double d = 0.0;
+  EXPECT_EQ(node.node_data_ptr->GetParameterAs("f", &d), ERROR_SUCCESS_T);
+  EXPECT_DOUBLE_EQ(d, 0.5);
+  EXPECT_EQ(node.node_data_ptr->GetParameterAs("s", &d), ERROR_STR_PARSE_ST);
+
+  // конкурентные обращения к узлу дерева ридера
+  std::vector<std::thread> threads;
+  std::atomic<int> sum = 0;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&node, &sum]() {
+      for (int k = 0; k < 1000; ++k)
+        sum += node.GetParameterAs<int>("neg") + 7;
+    });
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(sum, 0);
+}
+
+/**
+ * \brief Инициализатор без виртуальных функций
+ * */
+class static_init final : public NodeInitializer<static_init> {
+ public:
+  merror_t InitData(test_tree* tn, const std::string& name) {
+    name_ = name;
+    node_ = tn;
+    for (const auto& ch : tn->childs)
+      if (!ch.childs.empty())
+        subnodes_.push_back(ch.name);
+    return ERROR_SUCCESS_T;
+  }
+  std::string GetParameter(const std::string& name) {
+    const test_tree* ch = node_->child(name.c_str());
+    return ch ? ch->value : "";
+  }
+  void SetParentData(static_init& parent) { ++parent.childs_count; }
+
+ public:
+  int childs_count = 0;
+
+ private:
+  const test_tree* node_ = nullptr;
+};
+static_assert(NodeInitializerType<static_init>);
+static_assert(NodeInitializerType<test_init>);
+static_assert(!NodeInitializerType<test_tree>);
+/**
+ * \brief Наследник INodeInitializer, скрывающий GetName своим,
+ *   возвращающим имя по значению
+ * */
+class value_name_init final : public test_init {
+ public:
+  std::string GetName() const { return test_init::GetName(); }
+};
+static_assert(NodeInitializerType<value_name_init>);
+
+/**
+ * \brief Тест ридера с инициализатором без виртуальных функций
+ * */
+TEST(Readers, StaticInitializer) {
+  std::string doc = test_document(3, 5);
+  for (bool flat : {false, true}) {
+    reader_options opts;
+    opts.flat_tree = flat;
+    std::unique_ptr<ReaderSample<test_tree, static_init>> reader(
+        ReaderSample<test_tree, static_init>::Init(doc.c_str(), nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    std::string value;
+    ASSERT_EQ(reader->GetValueByPath({"s2", "i4", "v"}, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, "2004");
+    static_init* s1 = reader->GetNodeByPath({"s1"});
+    ASSERT_NE(s1, nullptr);
+    EXPECT_EQ(s1->childs_count, 5);
+    EXPECT_FALSE(s1->IsLeafNode());
+    int id = 0;
+    EXPECT_EQ(s1->GetParameterAs("id", &id), ERROR_SUCCESS_T);
+    EXPECT_EQ(id, 1);
+  }
+}
+
+/**
+ * \brief Тест ридера с инициализатором, возвращающим имя по значению:
+ *   индексы дочерних элементов и путей не ссылаются на временные имена
+ * */
+TEST(Readers, ValueNameInitializer) {
+  std::string doc = test_document(CHILDS_INDEX_THRESHOLD + 3, 3);
+  typedef ReaderSample<test_tree, value_name_init> value_reader;
+  reader_options flat;
+  flat.flat_tree = true;
+  reader_options lazy;
+  lazy.lazy_init = true;
+  reader_options indexed;
+  indexed.path_index = true;
+  for (const auto& opts : {reader_options(), flat, lazy, indexed}) {
+    std::unique_ptr<value_reader> reader(
+        value_reader::Init(doc.c_str(), nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    for (int i = 0; i < CHILDS_INDEX_THRESHOLD + 3; ++i) {
+      std::string section = "s" + std::to_string(i), value;
+      ASSERT_EQ(reader->GetValueByPath({section, "i2", "v"}, &value),
+                ERROR_SUCCESS_T);
+      EXPECT_EQ(value, std::to_string(i * 1000 + 2));
+      ASSERT_EQ(reader->GetValueByPath(path_handle(section + "/id"), &value),
+                ERROR_SUCCESS_T);
+      EXPECT_EQ(value, std::to_string(i));
+    }
+    value_name_init* s3 = reader->GetNodeByPath({"s3"});
+    ASSERT_NE(s3, nullptr);
+    EXPECT_EQ(s3->GetName(), "s3");
+    EXPECT_EQ(reader->GetNodeByPath({"s99"}), nullptr);
+  }
+}
+
+/**
+ * \brief Инициализатор, который считает живые объекты
+ * */
+class arena_init : public test_init {
+ public:
+  arena_init() { ++alive; }
+  ~arena_init() { --alive; }
+
+  static std::atomic<int> alive;
+};
+std::atomic<int> arena_init::alive = 0;
+
+/**
+ * \brief Фабрика инициализаторов в арене ридера
+ * */
+class arena_factory : public ArenaInitializerFactory<test_init> {
+ public:
+  using ArenaInitializerFactory<test_init>::GetNodeInitializer;
+  template <class NodeT>
+  test_init* GetNodeInitializer(Arena* arena) {
+    ++created;
+    return arena->Create<arena_init>();
+  }
+  arena_factory* GetThreadFactory(size_t /* worker */) { return this; }
+
+ public:
+  std::atomic<int> created = 0;
+};
+static_assert(ArenaFactoryType<arena_factory, test_init, test_tree>);
+static_assert(!ArenaFactoryType<counting_factory, test_init, test_tree>);
+
+/**
+ * \brief Тест перестроения дерева при росте таблицы имён и арен
+ *   после обновлений Reload
+ * */
+TEST(Readers, ReloadRebuild) {
+  typedef ReaderSample<test_tree, test_init, arena_factory> arena_reader;
+  fs::path dir = "test_reload_rebuild_dir";
+  fs::create_directory(dir);
+  // каждая версия заменяет элементы секции s0 элементами с новыми именами
+  const auto write = [&dir](int version) {
+    std::string doc = test_document(4, 4);
+    std::string items;
+    for (int j = 0; j < 4; ++j)
+      items += "n" + std::to_string(version * 4 + j) + "{ v=" +
+               std::to_string(version) + " } ";
+    size_t begin = doc.find("i0{");
+    doc.replace(begin, doc.find("} } ", begin) + 2 - begin, items);
+    std::ofstream f(dir / "doc", std::ios::binary);
+    f << doc;
+  };
+  write(0);
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  auto url = root.CreateFileURL("doc");
+
+  for (size_t growth : {size_t(RELOAD_REBUILD_GROWTH), size_t(0)}) {
+    reader_options opts;
+    opts.reloadable = true;
+    opts.reload_rebuild_growth = growth;
+    arena_factory factory;
+    std::unique_ptr<arena_reader> reader(
+        arena_reader::Init(&url, &factory, opts));
+    write(0);
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    const size_t names = reader->GetNames().Size();
+    const int alive = arena_init::alive;
+    size_t max_names = 0;
+    int max_alive = 0;
+    for (int version = 1; version <= 20; ++version) {
+      write(version);
+      std::vector<std::string> changed;
+      ASSERT_EQ(reader->Reload(&changed), ERROR_SUCCESS_T);
+      EXPECT_FALSE(changed.empty());
+      max_names = std::max(max_names, reader->GetNames().Size());
+      max_alive = std::max<int>(max_alive, arena_init::alive);
+      std::string value;
+      std::string path = "n" + std::to_string(version * 4 + 3);
+      ASSERT_EQ(reader->GetValueByPath({"s0", path, "v"}, &value),
+                ERROR_SUCCESS_T);
+      EXPECT_EQ(value, std::to_string(version));
+      EXPECT_EQ(reader->GetNodeByPath({"s0", "n0"}), nullptr);
+    }
+    if (growth) {
+      EXPECT_LE(max_names, growth * names);
+      EXPECT_LE(max_alive, int(growth) * alive);
+    } else {
+      // без перестроения имена и инициализаторы накапливаются
+      EXPECT_GT(max_names, 2 * names);
+      EXPECT_GT(max_alive, 2 * alive);
+    }
+  }
+  EXPECT_EQ(arena_init::alive, 0);
+  fs::remove_all(dir);
+}
+
+/**
+ * \brief Тест создания инициализаторов в арене ридера
+ * */
+TEST(Readers, ArenaFactory) {
+  typedef ReaderSample<test_tree, test_init, arena_factory> arena_reader;
+  std::string doc = test_document(8, 10);
+  const int nodes = 1 + 8 + 8 * 10;
+  reader_options flat, parallel, lazy;
+  flat.flat_tree = true;
+  parallel.parallel_init = true;
+  parallel.threads = 4;
+  lazy.lazy_init = true;
+  for (const reader_options& opts : {reader_options(), flat, parallel, lazy}) {
+    arena_factory factory;
+    {
+      std::unique_ptr<arena_reader> reader(
+          arena_reader::Init(doc.c_str(), &factory, opts));
+      ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+      std::string value;
+      ASSERT_EQ(reader->GetValueByPath({"s7", "i9", "v"}, &value),
+                ERROR_SUCCESS_T);
+      EXPECT_EQ(value, "7009");
+      if (!opts.lazy_init) {
+        EXPECT_EQ(reader->GetNodeByPath({"s3"})->childs_names.size(), 10);
+        EXPECT_EQ(factory.created, nodes);
+      }
+      EXPECT_EQ(arena_init::alive, factory.created);
+    }
+    // инициализаторы освобождаются вместе с ридером
+    EXPECT_EQ(arena_init::alive, 0);
+  }
+
+  // узел без контекста ридера создаёт инициализаторы в куче
+  arena_factory factory;
+  test_tree tree;
+  size_t pos = 0;
+  ASSERT_TRUE(test_tree::parse("root{ a=1 }", &pos, &tree));
+  node_sample<test_tree, test_init, arena_factory> node(
+      lib_node<test_tree>(&tree), &factory, "root");
+  EXPECT_EQ(factory.created, 0);
+  EXPECT_EQ(node.node_data_ptr->GetParameter("a"), "1");
+}
+
+/**
+ * \brief Тест таблицы имён узлов
+ * */
+TEST(Readers, NameInterner) {
+  NameInterner names;
+  const interned_name& a = names.Intern("alpha");
+  EXPECT_EQ(&names.Intern(std::string("alpha")), &a);
+  EXPECT_EQ(a.hash, name_hash("alpha"));
+  EXPECT_EQ(names.Find("beta"), nullptr);
+  const interned_name& b = names.Intern("beta");
+  EXPECT_NE(a.id, b.id);
+  EXPECT_EQ(&names.Get(b.id), &b);
+  EXPECT_EQ(names.Find("beta"), &b);
+  EXPECT_EQ(names.Size(), 2);
+  EXPECT_EQ(names.GetBytes(), 9);
+
+  // одновременное добавление одних и тех же имён
+  std::vector<std::thread> threads;
+  std::vector<std::vector<const interned_name*>> got(4);
+  for (size_t t = 0; t < got.size(); ++t) {
+    threads.emplace_back([&names, &got, t]() {
+      for (int i = 0; i < 200; ++i)
+        got[t].push_back(&names.Intern("n" + std::to_string(i)));
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(names.Size(), 2 + 200);
+  for (size_t t = 1; t < got.size(); ++t)
+    EXPECT_EQ(got[t], got[0]);
+
+  // имена дерева ридера хранятся один раз, у узлов с индексом
+  //   дочерних элементов тоже
+  std::string doc = test_document(CHILDS_INDEX_THRESHOLD + 4, 10);
+  for (bool flat : {false, true}) {
+    reader_options opts;
+    opts.flat_tree = flat;
+    std::unique_ptr<test_reader> reader(
+        test_reader::Init(doc.c_str(), nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    // root, s0..s19, i0..i9
+    EXPECT_EQ(reader->GetNames().Size(), 1 + CHILDS_INDEX_THRESHOLD + 4 + 10);
+    std::string value;
+    ASSERT_EQ(reader->GetValueByPath({"s17", "i2", "v"}, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, "17002");
+  }
+  test_tree tree;
+  size_t pos = 0;
+  ASSERT_TRUE(test_tree::parse(doc.c_str(), &pos, &tree));
+  test_node root(lib_node<test_tree>(&tree), nullptr, "root");
+  const interned_name* s3 = root.GetNames().Find("s3");
+  ASSERT_NE(s3, nullptr);
+  test_node* node = root.ChildByName(*s3);
+  ASSERT_NE(node, nullptr);
+  EXPECT_EQ(node->GetNameId(), s3->id);
+  EXPECT_EQ(node->ChildByName(*s3), nullptr);
+  EXPECT_EQ(node, root.ChildByName("s3"));
+}
+
+struct bind_limits {
+  int min = 0;
+  int max = 0;
+};
+struct bind_host {
+  std::string addr;
+  double weight = 0.0;
+};
+struct bind_config {
+  std::string name;
+  int version = 0;
+  bool enabled = false;
+  std::string comment = "none";
+  bind_limits limits;
+  std::vector<int> ports;
+  std::vector<bind_host> hosts;
+};
+
+namespace asp_utils {
+template <>
+struct binding<bind_limits> {
+  static constexpr auto fields =
+      std::make_tuple(BINDING_FIELD(bind_limits, min),
+                      BINDING_FIELD(bind_limits, max));
+};
+template <>
+struct binding<bind_host> {
+  static constexpr auto fields =
+      std::make_tuple(BINDING_FIELD(bind_host, addr),
+                      bind_optional("weight", &bind_host::weight));
+};
+template <>
+struct binding<bind_config> {
+  static constexpr auto fields =
+      std::make_tuple(BINDING_FIELD(bind_config, name),
+                      BINDING_FIELD(bind_config, version),
+                      BINDING_FIELD(bind_config, enabled),
+                      bind_optional("comment", &bind_config::comment),
+                      BINDING_FIELD(bind_config, limits),
+                      bind_field("port", &bind_config::ports),
+                      bind_optional("host", &bind_config::hosts));
+};
+}  // namespace asp_utils
+
+static_assert(BoundType<bind_config>);
+static_assert(!BoundType<test_tree>);
+
+/**
+ * \brief Тест привязки документа к структурам
+ * */
+TEST(Readers, Binding) {
+  const char* text =
+      "config{ name=srv version=3 enabled=true limits{ min=1 max=10 } "
+      "port=80 port=443 host{ addr=a weight=0.5 } host{ addr=b } }";
+  bind_config config;
+  ErrorWrap ew;
+  ASSERT_EQ(BindString<test_tree>(text, &config, reader_options(), &ew),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(config.name, "srv");
+  EXPECT_EQ(config.version, 3);
+  EXPECT_TRUE(config.enabled);
+  EXPECT_EQ(config.comment, "none");
+  EXPECT_EQ(config.limits.min, 1);
+  EXPECT_EQ(config.limits.max, 10);
+  EXPECT_EQ(config.ports, std::vector<int>({80, 443}));
+  ASSERT_EQ(config.hosts.size(), 2);
+  EXPECT_EQ(config.hosts[0].addr, "a");
+  EXPECT_DOUBLE_EQ(config.hosts[0].weight, 0.5);
+  EXPECT_EQ(config.hosts[1].addr, "b");
+  EXPECT_DOUBLE_EQ(config.hosts[1].weight, 0.0);
+
+  // ошибки - с путём поля
+  ErrorWrap missing;
+  EXPECT_EQ(BindString<test_tree>("config{ name=srv version=3 enabled=1 "
+                                  "limits{ min=1 } port=80 }",
+                                  &config, reader_options(), &missing),
+            ERROR_PARSER_CHILD_NODE_ST);
+  EXPECT_NE(missing.GetMessage().find("'limits/max'"), std::string::npos);
+  ErrorWrap wrong;
+  EXPECT_EQ(BindString<test_tree>("config{ name=srv version=3 enabled=1 "
+                                  "limits{ min=1 max=2 } port=80 "
+                                  "host{ addr=a weight=heavy } }",
+                                  &config, reader_options(), &wrong),
+            ERROR_STR_PARSE_ST);
+  EXPECT_NE(wrong.GetMessage().find("'host/weight'"), std::string::npos);
+  ErrorWrap no_ports;
+  EXPECT_EQ(BindString<test_tree>("config{ name=srv version=3 enabled=1 "
+                                  "limits{ min=1 max=2 } }",
+                                  &config, reader_options(), &no_ports),
+            ERROR_PARSER_CHILD_NODE_ST);
+  ErrorWrap broken;
+  EXPECT_EQ(BindString<test_tree>("config{", &config, reader_options(),
+                                  &broken),
+            ERROR_PARSER_FORMAT_ST);
+
+  // файл и узел уже разобранного документа
+  fs::path path = "test_binding.txt";
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << text;
+  }
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path,
+                                               fs::current_path());
+  auto url = root.CreateFileURL(path.string());
+  bind_config from_file;
+  ASSERT_EQ(BindFile<test_tree>(&url, &from_file), ERROR_SUCCESS_T);
+  EXPECT_EQ(from_file.hosts.size(), 2);
+  fs::remove(path);
+
+  test_tree tree;
+  size_t pos = 0;
+  ASSERT_TRUE(test_tree::parse(text, &pos, &tree));
+  bind_limits limits;
+  lib_node<test_tree> limits_node(
+      lib_node<test_tree>(&tree).GetChild("limits"));
+  EXPECT_EQ(BindNode(limits_node, &limits), ERROR_SUCCESS_T);
+  EXPECT_EQ(limits.max, 10);
+}
+
+/**
+ * \brief Инициализатор узлов любого представления lib_node
+ *   с обходом дочерних узлов
+ * */
+template <class NodeT>
+class lib_init final : public NodeInitializer<lib_init<NodeT>> {
+ public:
+  merror_t InitData(NodeT* n, const std::string& name) {
+    this->name_ = name;
+    // lib_node<rjNValue> хранит указатель на узел, остальные - копию
+    if constexpr (std::is_constructible_v<lib_node<NodeT>, NodeT*>)
+      node_ = lib_node<NodeT>(n);
+    else
+      node_ = lib_node<NodeT>(*n);
+    node_.ForEachChild(
+        [this](std::string_view name, std::string_view, lib_node<NodeT>* ch) {
+          if (ch)
+            this->subnodes_.push_back(std::string(name));
+        });
+    return ERROR_SUCCESS_T;
+  }
+  std::string GetParameter(const std::string& name) {
+    std::string value;
+    node_.ForEachChild(
+        [&](std::string_view n, std::string_view v, lib_node<NodeT>* ch) {
+          if (!ch && value.empty() && n == name)
+            value = v;
+        });
+    return value;
+  }
+  void SetParentData(lib_init&) {}
+
+ private:
+  lib_node<NodeT> node_;
+};
+
+/**
+ * \brief Инициализатор, хранящий указатель на узел из InitData
+ *   и читающий параметры через него, как json_test_node примера
+ * */
+template <class NodeT>
+class source_init final : public NodeInitializer<source_init<NodeT>> {
+ public:
+  merror_t InitData(NodeT* n, const std::string& name) {
+    this->name_ = name;
+    source_ = n;
+    node().ForEachChild(
+        [this](std::string_view name, std::string_view, lib_node<NodeT>* ch) {
+          if (ch)
+            this->subnodes_.push_back(std::string(name));
+        });
+    return ERROR_SUCCESS_T;
+  }
+  std::string GetParameter(const std::string& name) {
+    std::string value;
+    node().ForEachChild(
+        [&](std::string_view n, std::string_view v, lib_node<NodeT>* ch) {
+          if (!ch && value.empty() && n == name)
+            value = v;
+        });
+    return value;
+  }
+  void SetParentData(source_init&) {}
+
+ private:
+  lib_node<NodeT> node() const {
+    if constexpr (std::is_constructible_v<lib_node<NodeT>, NodeT*>)
+      return lib_node<NodeT>(source_);
+    else
+      return lib_node<NodeT>(*source_);
+  }
+
+ private:
+  NodeT* source_ = nullptr;
+};
+
+/**
+ * \brief Тест разбора json в два этапа
+ * */
+TEST(Readers, JSONTape) {
+  // документ больше куска первого этапа, экранирование на разных
+  //   позициях блоков по 64 байта
+  std::string text = "{\"config\": {\"items\": [";
+  for (int i = 0; i < 3000; ++i) {
+    if (i)
+      text += ", ";
+    text += "{\"id\": " + std::to_string(i) + ", \"text\": \"" +
+            std::string(i % 70, 'x') + "\\\\\\\"\", \"flag\": true}";
+  }
+  text +=
+      "], \"name\": \"srv\\n\\u0041\\u00e9\\ud83d\\ude00\", "
+      "\"ratio\": -1.5e2, \"big\": 18446744073709551615, \"neg\": -0, "
+      "\"none\": null, \"limits\": {\"min\": 1, \"max\": 10}}}";
+  ASSERT_GT(text.size(), JSON_TAPE_CHUNK);
+
+  std::vector<uint32_t> scalar, sse42, avx2;
+  ASSERT_EQ(JSONStructuralIndex(text.data(), text.size(), &scalar,
+                                json_simd_t::scalar),
+            ERROR_SUCCESS_T);
+  ASSERT_EQ(JSONStructuralIndex(text.data(), text.size(), &sse42,
+                                json_simd_t::sse42),
+            ERROR_SUCCESS_T);
+  ASSERT_EQ(JSONStructuralIndex(text.data(), text.size(), &avx2,
+                                json_simd_t::avx2),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(scalar, sse42);
+  EXPECT_EQ(scalar, avx2);
+  EXPECT_EQ(text[scalar[0]], '{');
+
+  for (auto simd : {json_simd_t::scalar, json_simd_t::detect}) {
+    std::string buffer = text;
+    json_tape_document doc;
+    ErrorWrap ew;
+    ASSERT_EQ(ParseJSONTape(buffer.data(), buffer.size(), &doc, &ew, simd),
+              ERROR_SUCCESS_T);
+    json_tape_node config = json_tape_node(&doc, 0).GetChild("config");
+    ASSERT_TRUE(config.IsObject());
+    int items = 0;
+    config.GetChild("items").ForEachChild([&items](const json_tape_node& v) {
+      int64_t id = -1;
+      EXPECT_TRUE(v.GetChild("id").GetInt64(&id));
+      EXPECT_EQ(id, items);
+      EXPECT_EQ(v.GetChild("text").GetValue(),
+                std::string(items % 70, 'x') + "\\\"");
+      EXPECT_TRUE(v.GetChild("flag").GetBool());
+      ++items;
+    });
+    EXPECT_EQ(items, 3000);
+    EXPECT_EQ(config.GetChild("name").GetValue(),
+              "srv\nA\xC3\xA9\xF0\x9F\x98\x80");
+    double ratio = 0.0;
+    int64_t i = 1;
+    uint64_t u = 0;
+    EXPECT_TRUE(config.GetChild("ratio").GetDouble(&ratio));
+    EXPECT_DOUBLE_EQ(ratio, -150.0);
+    EXPECT_FALSE(config.GetChild("ratio").GetInt64(&i));
+    EXPECT_TRUE(config.GetChild("big").GetUint64(&u));
+    EXPECT_EQ(u, UINT64_MAX);
+    EXPECT_FALSE(config.GetChild("big").GetInt64(&i));
+    EXPECT_TRUE(config.GetChild("neg").GetInt64(&i));
+    EXPECT_EQ(i, 0);
+    EXPECT_TRUE(config.GetChild("none").IsNull());
+    EXPECT_FALSE(config.GetChild("missing").IsValid());
+  }
+
+  for (const char* broken :
+       {"", "{\"a\": }", "{\"a\" 1}", "[1 2]", "{\"a\": \"b}",
+        "{\"a\": \"b\x01\"}", "{\"a\": tru}", "{} {}", "{\"a\": \"\\q\"}",
+        "{\"a\": 01}", "{\"a\": \"\\ud83d\"}", "[1,]"}) {
+    std::string buffer = broken;
+    json_tape_document doc;
+    ErrorWrap ew;
+    EXPECT_EQ(ParseJSONTape(buffer.data(), buffer.size(), &doc, &ew),
+              ERROR_PARSER_FORMAT_ST)
+        << broken;
+    EXPECT_TRUE(doc.tape.empty());
+  }
+
+  // ридер и привязка структур поверх lib_node<json_tape_node>
+  typedef ReaderSample<json_tape_node, lib_init<json_tape_node>> tape_reader;
+  std::unique_ptr<tape_reader> reader(tape_reader::Init(text.c_str()));
+  ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+  std::string value;
+  ASSERT_EQ(reader->GetValueByPath({"limits", "max"}, &value),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "10");
+
+  bind_config config;
+  ASSERT_EQ(BindString<json_tape_node>(
+                "{\"config\": {\"name\": \"srv\", \"version\": 3, "
+                "\"enabled\": true, \"limits\": {\"min\": 1, \"max\": 10}, "
+                "\"port\": [80, 443], \"host\": [{\"addr\": \"a\", "
+                "\"weight\": 0.5}, {\"addr\": \"b\"}]}}",
+                &config),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(config.version, 3);
+  EXPECT_TRUE(config.enabled);
+  EXPECT_EQ(config.limits.max, 10);
+  EXPECT_EQ(config.ports, std::vector<int>({80, 443}));
+  ASSERT_EQ(config.hosts.size(), 2);
+  EXPECT_DOUBLE_EQ(config.hosts[0].weight, 0.5);
+  EXPECT_EQ(config.hosts[1].addr, "b");
+}
+
+#ifdef WITH_RAPIDJSON
+/**
+ * \brief Тест разбора json RapidJSON на месте, в буффере ридера
+ * */
+TEST(Readers, RapidJSONInsitu) {
+  typedef ReaderSample<rjNValue, lib_init<rjNValue>> rj_reader;
+  fs::path dir = "test_insitu_dir";
+  fs::create_directory(dir);
+  // экранированная строка раскрывается на месте и становится короче
+  const std::string text =
+      "{\"config\": {\"name\": \"srv\", \"path\": \"a\\\\tb\", "
+      "\"port\": 80, \"limits\": {\"max\": \"10\"}}}";
+  {
+    std::ofstream f(dir / "doc.json", std::ios::binary);
+    f << text;
+  }
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  auto url = root.CreateFileURL("doc.json");
+  std::vector<std::unique_ptr<rj_reader>> readers;
+  for (bool insitu : {false, true}) {
+    reader_options opts;
+    opts.parse_insitu = insitu;
+    readers.emplace_back(rj_reader::Init(&url, nullptr, opts));
+    ASSERT_EQ(readers.back()->InitData(), ERROR_SUCCESS_T);
+  }
+  // файл больше не нужен: значения в буфферах ридеров
+  fs::remove_all(dir);
+  for (size_t i = 0; i < readers.size(); ++i) {
+    const auto* config = readers[i]->GetRootNode();
+    ASSERT_NE(config, nullptr);
+    std::string_view name = config->GetParameterView("name");
+    std::string_view path = config->GetParameterView("path");
+    EXPECT_EQ(name, "srv");
+    EXPECT_EQ(path, "a\\tb");
+    if (i) {
+      // строки разобраны в буффере ридера на своих местах в тексте
+      EXPECT_EQ(path.data() - name.data(),
+                static_cast<std::ptrdiff_t>(text.find("a\\\\tb") -
+                                            text.find("srv")));
+    }
+    int port = 0;
+    EXPECT_EQ(config->GetParameterAs("port", &port), ERROR_SUCCESS_T);
+    EXPECT_EQ(port, 80);
+    std::string value;
+    ASSERT_EQ(readers[i]->GetValueByPath({"limits", "max"}, &value),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(value, "10");
+    // представления валидны, пока жив ридер
+    EXPECT_EQ(config->GetParameterView("name"), name);
+    EXPECT_EQ(name, "srv");
+    EXPECT_EQ(path, "a\\tb");
+  }
+
+  // ошибки инициализации рута: одна ошибка на случай
+  for (const char* broken : {"[1]", "{}", "\"srv\""}) {
+    std::unique_ptr<rj_reader> reader(rj_reader::Init(broken));
+    EXPECT_EQ(reader->InitData(), ERROR_PARSER_PARSE_ST) << broken;
+  }
+  for (const char* broken : {"{\"a\": }", "{\"a\": {}} {}"}) {
+    std::unique_ptr<rj_reader> reader(rj_reader::Init(broken));
+    EXPECT_EQ(reader->InitData(), ERROR_PARSER_FORMAT_ST) << broken;
+  }
+  typedef JSONReaderSample<lib_init<rjNValue>> json_reader;
+  for (const char* broken : {"[1]", "{}"}) {
+    std::unique_ptr<json_reader> reader(json_reader::Init(broken));
+    EXPECT_EQ(reader->InitData(), ERROR_JSON_PARSE_ST) << broken;
+    EXPECT_EQ(reader->GetRootNode(), nullptr);
+  }
+}
+
+/** \brief Значение json параметра строкой, массив - `[a,b]` */
+static std::string rj_text(const rjNValue& v) {
+  if (v.IsString())
+    return std::string(v.GetString(), v.GetStringLength());
+  if (v.IsBool())
+    return v.GetBool() ? "true" : "false";
+  if (v.IsInt64())
+    return std::to_string(v.GetInt64());
+  if (v.IsNumber())
+    return std::to_string(v.GetDouble());
+  if (v.IsArray()) {
+    std::string text;
+    for (auto e = v.Begin(); e != v.End(); ++e)
+      text += (text.empty() ? "" : ",") + rj_text(*e);
+    return "[" + text + "]";
+  }
+  return "null";
+}
+#endif  // WITH_RAPIDJSON
+
+#if defined(WITH_RAPIDJSON) || defined(WITH_PUGIXML)
+/**
+ * \brief Инициализатор узлов потоковых ридеров: параметры узла
+ *   и закрытые дочерние узлы записываются строкой в `trace`
+ *   родителя - `name{k=v;...child{...}}`
+ * */
+class stream_init final : public NodeInitializer<stream_init> {
+ public:
+#ifdef WITH_RAPIDJSON
+  merror_t InitData(rjNValue* v, const std::string& name) {
+    name_ = name;
+    for (auto m = v->MemberBegin(); m != v->MemberEnd(); ++m)
+      params += std::string(m->name.GetString()) + "=" + rj_text(m->value) +
+                ";";
+    return init();
+  }
+#endif  // WITH_RAPIDJSON
+#ifdef WITH_PUGIXML
+  /** \brief Параметры - атрибуты и текст не обходимых подэлементов */
+  merror_t InitData(pugi::xml_node* n, const std::string& name) {
+    name_ = name;
+    source = n;
+    for (pugi::xml_attribute a : n->attributes())
+      params += std::string(a.name()) + "=" + a.value() + ";";
+    for (pugi::xml_node ch : n->children()) {
+      if (ch.type() == pugi::node_element && *ch.child_value() &&
+          std::find(walked.begin(), walked.end(), ch.name()) == walked.end())
+        params += std::string(ch.name()) + "=" + ch.child_value() + ";";
+    }
+    return init();
+  }
+  /** \brief Имя и атрибуты узла, переданного в InitData */
+  std::string SourceText() const {
+    std::string text = std::string(source->name()) + ":";
+    for (pugi::xml_attribute a : source->attributes())
+      text += std::string(a.name()) + "=" + a.value() + ";";
+    return text;
+  }
+#endif  // WITH_PUGIXML
+  std::string GetParameter(const std::string&) { return ""; }
+  void SetParentData(stream_init& parent) {
+    parent.trace += name_ + "{" + params + trace + "}";
+  }
+
+ public:
+  std::string params;
+  std::string trace;
+#ifdef WITH_PUGIXML
+  /** \brief узел, переданный в InitData */
+  const pugi::xml_node* source = nullptr;
+#endif  // WITH_PUGIXML
+
+  /** \brief имена обходимых поддеревьев всех узлов */
+  static inodes_vec walked;
+  /** \brief InitData узла с этим именем возвращает ошибку */
+  static std::string fail_on;
+
+ private:
+  merror_t init() {
+    subnodes_ = walked;
+    return (name_ == fail_on) ? ERROR_GENERAL_T : ERROR_SUCCESS_T;
+  }
+};
+inodes_vec stream_init::walked;
+std::string stream_init::fail_on;
+
+/** \brief Фабрика, не создающая инициализаторы */
+class null_stream_factory {
+ public:
+  template <class NodeT>
+  stream_init* GetNodeInitializer() {
+    return nullptr;
+  }
+};
+#endif  // WITH_RAPIDJSON || WITH_PUGIXML
+
+#ifdef WITH_RAPIDJSON
+/**
+ * \brief Тест потокового json ридера
+ * */
+TEST(Readers, JSONStream) {
+  typedef JSONStreamReaderSample<stream_init> json_stream;
+  stream_init::walked = {"limits", "item", "sub"};
+  stream_init::fail_on.clear();
+  // корень - первый член-объект документа, "skip" и "other" не
+  //   обходятся, "item" - массив дочерних узлов
+  const std::string text =
+      "{\"meta\": 1, \"list\": [{\"a\": 1}], \"config\": {\"name\": \"srv\", "
+      "\"ports\": [80, 443], \"flag\": true, \"none\": null, "
+      "\"limits\": {\"max\": 10}, "
+      "\"skip\": {\"deep\": {\"x\": 1}, \"arr\": [1, [2], {\"y\": 3}]}, "
+      "\"item\": [{\"id\": 1}, {\"id\": 2, \"sub\": {\"v\": \"a\"}}], "
+      "\"other\": [{\"id\": 3}, {\"id\": 4}], \"empty\": []}, "
+      "\"tail\": {\"x\": 1}}";
+  const std::string params = "name=srv;ports=[80,443];flag=true;none=null;";
+  const std::string trace = "limits{max=10;}item{id=1;}item{id=2;sub{v=a;}}";
+  {
+    std::unique_ptr<json_stream> reader(json_stream::Init(text.c_str()));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    stream_init* root = reader->GetRootData();
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(root->GetName(), "config");
+    EXPECT_EQ(root->params, params);
+    EXPECT_EQ(root->trace, trace);
+    EXPECT_EQ(reader->GetInitializedCount(), 5);
+    EXPECT_EQ(reader->GetMaxDepth(), 3);
+  }
+
+  // чтение файла и Feed: блоки меньше имён и значений
+  fs::path dir = "test_json_stream_dir";
+  fs::create_directory(dir);
+  {
+    std::ofstream f(dir / "doc.json", std::ios::binary);
+    f << text;
+  }
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  auto url = root.CreateFileURL("doc.json");
+  reader_options opts;
+  opts.stream_buffer_size = 16;
+  opts.feed_queue_size = 2;
+  {
+    std::unique_ptr<json_stream> reader(json_stream::Init(&url, nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    EXPECT_EQ(reader->GetRootData()->params, params);
+    EXPECT_EQ(reader->GetRootData()->trace, trace);
+  }
+  fs::remove_all(dir);
+  {
+    std::unique_ptr<json_stream> reader(json_stream::InitFeed(nullptr, opts));
+    for (size_t i = 0; i < text.size(); i += 7)
+      ASSERT_EQ(reader->Feed(std::string_view(text).substr(i, 7)),
+                ERROR_SUCCESS_T);
+    ASSERT_EQ(reader->Finish(), ERROR_SUCCESS_T);
+    EXPECT_EQ(reader->GetRootData()->params, params);
+    EXPECT_EQ(reader->GetRootData()->trace, trace);
+  }
+
+  // скаляры до первого объекта массива - параметр узла
+  {
+    std::unique_ptr<json_stream> reader(
+        json_stream::Init("{\"config\": {\"other\": [1, {\"id\": 3}]}}"));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    EXPECT_EQ(reader->GetRootData()->params, "other=[1];");
+  }
+  // скалярный параметр после вложенного объекта - ошибка, а не потеря
+  for (const char* late :
+       {"{\"config\": {\"a\": 1, \"limits\": {}, \"b\": 2}}",
+        "{\"config\": {\"skip\": {}, \"b\": \"text\"}}",
+        "{\"config\": {\"limits\": {}, \"ports\": [1]}}",
+        "{\"config\": {\"other\": [{\"id\": 3}, 5]}}",
+        "{\"config\": {\"other\": [1, {\"id\": 3}, 2]}}",
+        "{\"config\": {\"item\": [{\"id\": 1}, null]}}"}) {
+    std::unique_ptr<json_stream> reader(json_stream::Init(late));
+    EXPECT_EQ(reader->InitData(), ERROR_JSON_FORMAT_ST) << late;
+  }
+  {
+    std::unique_ptr<json_stream> reader(json_stream::InitFeed(nullptr, opts));
+    std::string late = "{\"config\": {\"limits\": {}, \"b\": 2, \"pad\": \"";
+    late += std::string(1024, 'x') + "\"}}";
+    for (size_t i = 0; i < late.size(); i += 7)
+      reader->Feed(std::string_view(late).substr(i, 7));
+    EXPECT_EQ(reader->Finish(), ERROR_JSON_FORMAT_ST);
+  }
+
+  // ошибки разбора и инициализации корня
+  for (const char* broken : {"[1]", "{\"meta\": 1}", "{}"}) {
+    std::unique_ptr<json_stream> reader(json_stream::Init(broken));
+    EXPECT_EQ(reader->InitData(), ERROR_JSON_PARSE_ST) << broken;
+    EXPECT_EQ(reader->GetRootData(), nullptr);
+  }
+  for (const char* broken : {"{\"config\": {", "{\"config\": {\"a\" 1}}"}) {
+    std::unique_ptr<json_stream> reader(json_stream::Init(broken));
+    EXPECT_EQ(reader->InitData(), ERROR_JSON_FORMAT_ST) << broken;
+  }
+  stream_init::fail_on = "sub";
+  {
+    std::unique_ptr<json_stream> reader(json_stream::Init(text.c_str()));
+    EXPECT_EQ(reader->InitData(), ERROR_GENERAL_T);
+  }
+  stream_init::fail_on.clear();
+}
+#endif  // WITH_RAPIDJSON
+
+#ifdef WITH_PUGIXML
+/**
+ * \brief Тест потокового xml ридера
+ * */
+TEST(Readers, XMLStream) {
+  typedef XMLStreamReaderSample<stream_init> xml_stream;
+  stream_init::walked = {"group", "item", "sub"};
+  stream_init::fail_on.clear();
+  // "skip" и "other" не обходятся, второй корневой элемент пропускается
+  const std::string text =
+      "<?xml version=\"1.0\"?>\n<!-- comment -->\n"
+      "<config name=\"srv\" port=\"80\">\n"
+      "  <skip><deep a=\"1\"/></skip>\n"
+      "  <group id=\"g1\">\n"
+      "    <item id=\"1\"><v>a</v><sub k=\"x\"><w>1</w></sub></item>\n"
+      "    <other/>\n"
+      "    <item id=\"2\"><v>b &amp; c</v></item>\n"
+      "  </group>\n"
+      "  <group id=\"g2\"><item id=\"3\"/></group>\n"
+      "</config>\n<tail/>\n";
+  const std::string streamed_trace =
+      "group{id=g1;item{id=1;v=a;sub{k=x;w=1;}}item{id=2;v=b & c;}}"
+      "group{id=g2;item{id=3;}}";
+  {
+    // элементы уровня 1 - поддеревья xml_node_sample, в котором
+    //   обходится только первый дочерний элемент с именем
+    std::unique_ptr<xml_stream> reader(xml_stream::Init(text.c_str()));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    stream_init* root = reader->GetRootData();
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(root->GetName(), "config");
+    EXPECT_EQ(root->params, "name=srv;port=80;");
+    EXPECT_EQ(root->trace,
+              "group{id=g1;item{id=1;v=a;sub{k=x;w=1;}}}"
+              "group{id=g2;item{id=3;}}");
+    EXPECT_EQ(reader->GetStreamedCount(), 1);
+    EXPECT_EQ(reader->GetSubtreesCount(), 2);
+    // узел корня, переданный в InitData, валиден вместе с ридером
+    EXPECT_EQ(root->SourceText(), "config:name=srv;port=80;");
+  }
+  reader_options opts;
+  opts.xml_stream_depth = 2;
+  opts.stream_buffer_size = 16;
+  opts.feed_queue_size = 2;
+  {
+    std::unique_ptr<xml_stream> reader(
+        xml_stream::Init(text.c_str(), nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    stream_init* root = reader->GetRootData();
+    EXPECT_EQ(root->params, "name=srv;port=80;");
+    EXPECT_EQ(root->trace, streamed_trace);
+    EXPECT_EQ(reader->GetStreamedCount(), 3);
+    EXPECT_EQ(reader->GetSubtreesCount(), 3);
+    EXPECT_EQ(root->SourceText(), "config:name=srv;port=80;");
+  }
+
+  // чтение файла и Feed блоками меньше имён элементов
+  fs::path dir = "test_xml_stream_dir";
+  fs::create_directory(dir);
+  {
+    std::ofstream f(dir / "doc.xml", std::ios::binary);
+    f << text;
+  }
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path, dir);
+  auto url = root.CreateFileURL("doc.xml");
+  {
+    std::unique_ptr<xml_stream> reader(xml_stream::Init(&url, nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    EXPECT_EQ(reader->GetRootData()->trace, streamed_trace);
+  }
+  fs::remove_all(dir);
+  {
+    std::unique_ptr<xml_stream> reader(xml_stream::InitFeed(nullptr, opts));
+    for (size_t i = 0; i < text.size(); i += 5)
+      ASSERT_EQ(reader->Feed(std::string_view(text).substr(i, 5)),
+                ERROR_SUCCESS_T);
+    ASSERT_EQ(reader->Finish(), ERROR_SUCCESS_T);
+    EXPECT_EQ(reader->GetRootData()->trace, streamed_trace);
+    EXPECT_EQ(reader->GetRootData()->SourceText(), "config:name=srv;port=80;");
+  }
+
+  // ошибки разбора, корня и инициализаторов
+  for (const char* broken :
+       {"<config><group></config>", "<config><group id=\"1></group></config>",
+        "<config><group><item><v>a</item></group></config>", "<config>"}) {
+    std::unique_ptr<xml_stream> reader(
+        xml_stream::Init(broken, nullptr, opts));
+    EXPECT_EQ(reader->InitData(), ERROR_PARSER_FORMAT_ST) << broken;
+  }
+  for (const char* empty : {"", "<?xml version=\"1.0\"?><!-- none -->"}) {
+    std::unique_ptr<xml_stream> reader(xml_stream::Init(empty));
+    EXPECT_EQ(reader->InitData(), ERROR_PARSER_PARSE_ST) << empty;
+    EXPECT_EQ(reader->GetRootData(), nullptr);
+  }
+  for (const char* fail : {"group", "sub"}) {
+    stream_init::fail_on = fail;
+    std::unique_ptr<xml_stream> reader(
+        xml_stream::Init(text.c_str(), nullptr, opts));
+    EXPECT_EQ(reader->InitData(), ERROR_GENERAL_T) << fail;
+  }
+  stream_init::fail_on.clear();
+  null_stream_factory factory;
+  std::unique_ptr<XMLStreamReaderSample<stream_init, null_stream_factory>>
+      reader(XMLStreamReaderSample<stream_init, null_stream_factory>::Init(
+          text.c_str(), &factory));
+  EXPECT_EQ(reader->InitData(), ERROR_GENERAL_T);
+  EXPECT_EQ(reader->GetRootData(), nullptr);
+}
+#endif  // WITH_PUGIXML
+
+/**
+ * \brief Параметры плоского дерева и дерева node_sample ридера
+ *   с source_init: корень `root`, секции `s<i>` с параметром `id`
+ *   и дочерним `c` с параметром `v`
+ * */
+template <class NodeT>
+static void expect_flat_source(const std::string& text, int sections) {
+  typedef ReaderSample<NodeT, source_init<NodeT>> source_reader;
+  std::unique_ptr<source_reader> nodes(source_reader::Init(text.c_str()));
+  ASSERT_EQ(nodes->InitData(), ERROR_SUCCESS_T);
+  reader_options opts;
+  opts.flat_tree = true;
+  std::unique_ptr<source_reader> flat(
+      source_reader::Init(text.c_str(), nullptr, opts));
+  ASSERT_EQ(flat->InitData(), ERROR_SUCCESS_T);
+  std::string a, b;
+  ASSERT_EQ(flat->GetValueByPath({"version"}, &a), ERROR_SUCCESS_T);
+  EXPECT_EQ(a, "1");
+  for (int i = 0; i < sections; ++i) {
+    std::string s = "s" + std::to_string(i);
+    for (const auto& path : {std::vector<std::string>{s, "id"},
+                             std::vector<std::string>{s, "c", "v"}}) {
+      ASSERT_EQ(flat->GetValueByPath(path, &a), ERROR_SUCCESS_T);
+      ASSERT_EQ(nodes->GetValueByPath(path, &b), ERROR_SUCCESS_T);
+      EXPECT_EQ(a, b);
+      EXPECT_EQ(a, std::to_string(i));
+    }
+  }
+}
+
+/**
+ * \brief Тест плоского дерева поверх библиотечных представлений
+ *   узлов: указатель, переданный в InitData, валиден, пока жив ридер
+ * */
+TEST(Readers, FlatTreeSource) {
+  // корень с количеством дочерних элементов больше
+  //   CHILDS_INDEX_THRESHOLD, узлы добавляются при обходе
+  const int sections = CHILDS_INDEX_THRESHOLD + 3;
+  std::string json = "{\"root\": {\"version\": \"1\"";
+  for (int i = 0; i < sections; ++i) {
+    std::string n = std::to_string(i);
+    json += ", \"s" + n + "\": {\"id\": \"" + n + "\", \"c\": {\"v\": \"" + n +
+            "\"}}";
+  }
+  json += "}}";
+  expect_flat_source<json_tape_node>(json, sections);
+#ifdef WITH_RAPIDJSON
+  expect_flat_source<rjNValue>(json, sections);
+#endif  // WITH_RAPIDJSON
+#ifdef WITH_PUGIXML
+  std::string xml = "<root version=\"1\">";
+  for (int i = 0; i < sections; ++i) {
+    std::string n = std::to_string(i);
+    xml += "<s" + n + " id=\"" + n + "\"><c v=\"" + n + "\"/></s" + n + ">";
+  }
+  xml += "</root>";
+  expect_flat_source<pugi::xml_node>(xml, sections);
+#endif  // WITH_PUGIXML
+}
+
+/** \brief Обход документа через lib_node::ForEachChild в строку */
+template <class NodeT>
+void flatten_document(lib_node<NodeT>& node, std::string* out) {
+  node.ForEachChild(
+      [out](std::string_view name, std::string_view v, lib_node<NodeT>* ch) {
+        std::string childs;
+        if (ch)
+          flatten_document(*ch, &childs);
+        *out += std::string(name) + "=";
+        *out += childs.empty() ? std::string(v) + ";" : "{" + childs + "}";
+      });
+}
+
+/**
+ * \brief Тест бинарного формата MessagePack
+ * */
+TEST(Readers, MsgPack) {
+  // все размеры заголовков чисел, строк и контейнеров
+  std::string packed;
+  msgpack_writer w(&packed);
+  const std::vector<int64_t> ints = {-5,         -100,      -1000,
+                                     -100000,    INT64_MIN, 0,
+                                     127,        200,       60000,
+                                     4000000000, INT64_MAX};
+  w.Map(1);
+  w.String("config");
+  w.Map(static_cast<uint32_t>(ints.size()) + 8);
+  for (size_t i = 0; i < ints.size(); ++i) {
+    w.String("i" + std::to_string(i));
+    w.Int(ints[i]);
+  }
+  w.String("u");
+  w.Uint(UINT64_MAX);
+  w.String("d");
+  w.Double(-2.5);
+  w.String("t");
+  w.Bool(true);
+  w.String("n");
+  w.Null();
+  w.String("s");
+  w.String(std::string(300, 's'));
+  w.String("long");
+  w.String(std::string(70000, 'l'));
+  w.String("items");
+  w.Array(20);
+  for (int i = 0; i < 20; ++i) {
+    w.Map(1);
+    w.String("id");
+    w.Int(i);
+  }
+  w.String("empty");
+  w.Array(0);
+
+  msgpack_document doc;
+  ErrorWrap ew;
+  ASSERT_EQ(ParseMsgPack(packed.data(), packed.size(), &doc, &ew),
+            ERROR_SUCCESS_T);
+  msgpack_node config = msgpack_node(&doc, 0).GetChild("config");
+  ASSERT_TRUE(config.IsMap());
+  for (size_t i = 0; i < ints.size(); ++i) {
+    int64_t value = 1;
+    EXPECT_TRUE(config.GetChild("i" + std::to_string(i)).GetInt64(&value));
+    EXPECT_EQ(value, ints[i]);
+  }
+  uint64_t u = 0;
+  int64_t i = 0;
+  double d = 0.0;
+  EXPECT_TRUE(config.GetChild("u").GetUint64(&u));
+  EXPECT_EQ(u, UINT64_MAX);
+  EXPECT_FALSE(config.GetChild("u").GetInt64(&i));
+  EXPECT_TRUE(config.GetChild("d").GetDouble(&d));
+  EXPECT_DOUBLE_EQ(d, -2.5);
+  EXPECT_FALSE(config.GetChild("d").GetInt64(&i));
+  EXPECT_TRUE(config.GetChild("t").GetBool());
+  EXPECT_TRUE(config.GetChild("n").IsNull());
+  EXPECT_EQ(config.GetChild("s").GetString(), std::string(300, 's'));
+  EXPECT_EQ(config.GetChild("long").GetString().size(), 70000);
+  int items = 0;
+  config.GetChild("items").ForEachChild([&items](const msgpack_node& v) {
+    int64_t id = -1;
+    EXPECT_TRUE(v.GetChild("id").GetInt64(&id));
+    EXPECT_EQ(id, items++);
+  });
+  EXPECT_EQ(items, 20);
+  EXPECT_TRUE(config.GetChild("empty").IsArray());
+  EXPECT_FALSE(config.GetChild("missing").IsValid());
+
+  for (std::string broken :
+       {std::string(), std::string("\x81\xa1", 2), std::string("\xc1"),
+        std::string("\xd4\x01\x02"), std::string("\x81\x01\x01"),
+        std::string("\x90\x90"), std::string("\xdd\xff\xff\xff\xff\x01")}) {
+    msgpack_document bd;
+    ErrorWrap bew;
+    EXPECT_EQ(ParseMsgPack(broken.data(), broken.size(), &bd, &bew),
+              ERROR_PARSER_FORMAT_ST);
+    EXPECT_TRUE(bd.tape.empty());
+  }
+
+  // json с типами значений: обход тот же, что у разборщика json
+  std::string json =
+      "{\"config\": {\"name\": \"srv\", \"version\": 3, \"enabled\": true, "
+      "\"ratio\": -1.5e2, \"big\": 18446744073709551615, \"none\": null, "
+      "\"limits\": {\"min\": -1, \"max\": 10}, \"port\": [80, 443], "
+      "\"host\": [{\"addr\": \"a\", \"weight\": 0.5}, {\"addr\": \"b\"}]}}";
+  std::string json_buffer = json, from_json;
+  ASSERT_EQ(JSONToMsgPack(json_buffer.data(), json_buffer.size(), &from_json,
+                          &ew),
+            ERROR_SUCCESS_T);
+  EXPECT_LT(from_json.size(), json.size());
+  json_buffer = json;
+  json_tape_document json_doc;
+  ASSERT_EQ(ParseJSONTape(json_buffer.data(), json_buffer.size(), &json_doc,
+                          &ew),
+            ERROR_SUCCESS_T);
+  ASSERT_EQ(ParseMsgPack(from_json.data(), from_json.size(), &doc, &ew),
+            ERROR_SUCCESS_T);
+  lib_node<json_tape_node> json_root(json_tape_node(&json_doc, 0));
+  lib_node<msgpack_node> msgpack_root(msgpack_node(&doc, 0));
+  std::string json_flat, msgpack_flat;
+  flatten_document(json_root, &json_flat);
+  flatten_document(msgpack_root, &msgpack_flat);
+  EXPECT_EQ(json_flat, msgpack_flat);
+  int min = 0;
+  EXPECT_TRUE(lib_node<msgpack_node>(msgpack_root.GetChild("config"))
+                  .GetChild("limits")
+                  .IsMap());
+  lib_node<msgpack_node> limits(
+      lib_node<msgpack_node>(msgpack_root.GetChild("config"))
+          .GetChild("limits"));
+  EXPECT_TRUE(limits.GetValueAs("min", &min));
+  EXPECT_EQ(min, -1);
+  unsigned umin = 0;
+  EXPECT_FALSE(limits.GetValueAs("min", &umin));
+
+  // ридер и привязка структур
+  fs::path path = "test_msgpack.bin";
+  {
+    std::ofstream f(path, std::ios::binary);
+    f << from_json;
+  }
+  file_utils::FileURLRootSample<fs::path> root(file_utils::url_t::fs_path,
+                                               fs::current_path());
+  auto url = root.CreateFileURL(path.string());
+  typedef ReaderSample<msgpack_node, lib_init<msgpack_node>> msgpack_reader;
+  std::unique_ptr<msgpack_reader> reader(msgpack_reader::Init(&url));
+  ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+  std::string value;
+  ASSERT_EQ(reader->GetValueByPath({"limits", "max"}, &value),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(value, "10");
+  fs::remove(path);
+
+  bind_config bound;
+  file_utils::FileBuffer buffer;
+  buffer.Assign(from_json.data(), from_json.size());
+  ASSERT_EQ(BindBuffer<msgpack_node>(buffer, &bound), ERROR_SUCCESS_T);
+  EXPECT_EQ(bound.version, 3);
+  EXPECT_EQ(bound.ports, std::vector<int>({80, 443}));
+  ASSERT_EQ(bound.hosts.size(), 2);
+  EXPECT_DOUBLE_EQ(bound.hosts[0].weight, 0.5);
+
+  // текстовые документы - строками значений
+  std::string text = test_document(2, 3), from_text;
+  ASSERT_EQ(ConvertToMsgPack<test_tree>(text.data(), text.size(), &from_text,
+                                        &ew),
+            ERROR_SUCCESS_T);
+  test_tree tree;
+  size_t pos = 0;
+  ASSERT_TRUE(test_tree::parse(text.c_str(), &pos, &tree));
+  msgpack_document text_doc;
+  ASSERT_EQ(ParseMsgPack(from_text.data(), from_text.size(), &text_doc, &ew),
+            ERROR_SUCCESS_T);
+  lib_node<test_tree> tree_root(&tree);
+  lib_node<msgpack_node> text_root(
+      msgpack_node(&text_doc, 0).GetChild(tree.name));
+  std::string tree_flat, text_flat;
+  flatten_document(tree_root, &tree_flat);
+  flatten_document(text_root, &text_flat);
+  EXPECT_EQ(tree_flat, text_flat);
+
+  // пустые объекты - пустыми map, а не строками
+  std::string empty_json =
+      "{\"config\": {\"name\": \"srv\", \"empty\": {}, "
+      "\"nested\": {\"inner\": {}}, \"list\": []}}";
+  std::string empty_buffer = empty_json, from_empty;
+  ASSERT_EQ(ConvertToMsgPack<json_tape_node>(
+                empty_buffer.data(), empty_buffer.size(), &from_empty, &ew),
+            ERROR_SUCCESS_T);
+  msgpack_document empty_doc;
+  ASSERT_EQ(
+      ParseMsgPack(from_empty.data(), from_empty.size(), &empty_doc, &ew),
+      ERROR_SUCCESS_T);
+  msgpack_node empty_config = msgpack_node(&empty_doc, 0).GetChild("config");
+  EXPECT_EQ(empty_config.GetChild("name").GetString(), "srv");
+  msgpack_node empty = empty_config.GetChild("empty");
+  ASSERT_TRUE(empty.IsMap());
+  int empty_size = 0;
+  empty.ForEachChild([&empty_size](const msgpack_node&) { ++empty_size; });
+  EXPECT_EQ(empty_size, 0);
+  EXPECT_TRUE(empty_config.GetChild("nested").GetChild("inner").IsMap());
+  empty_buffer = empty_json;
+  ASSERT_EQ(JSONToMsgPack(empty_buffer.data(), empty_buffer.size(),
+                          &from_empty, &ew),
+            ERROR_SUCCESS_T);
+  ASSERT_EQ(
+      ParseMsgPack(from_empty.data(), from_empty.size(), &empty_doc, &ew),
+      ERROR_SUCCESS_T);
+  empty_config = msgpack_node(&empty_doc, 0).GetChild("config");
+  EXPECT_TRUE(empty_config.GetChild("empty").IsMap());
+  EXPECT_TRUE(empty_config.GetChild("list").IsArray());
+}
+
+/** \brief Значения параметра `name` результатов запроса */
+template <class Range>
+static std::vector<std::string> query_values(Range&& range,
+                                             const std::string& name) {
+  std::vector<std::string> values;
+  for (auto* data : range)
+    values.push_back(name.empty() ? data->GetName()
+                                  : data->GetParameter(name));
+  return values;
+}
+
+/**
+ * \brief Тест запросов к дереву ридера
+ * */
+TEST(Readers, Query) {
+  const char* doc =
+      "catalog{ version=3 "
+      "  g1{ name=first kind=a i1{ id=1 price=10 } i2{ id=2 price=25.5 } } "
+      "  g2{ name=second i1{ id=3 price=7 } "
+      "    g3{ name=first i1{ id=4 price=1 } } } "
+      "  misc{ i9{ id=5 } } }";
+  typedef std::vector<std::string> strings;
+  ErrorWrap ew;
+  node_query q;
+  for (const char* broken : {"", "a[", "a[@p>x]", "a/[@p]", "a[@p='x]",
+                             "a[=1]", "a b"}) {
+    EXPECT_EQ(CompileQuery(broken, &q, &ew), ERROR_STR_PARSE_ST) << broken;
+  }
+  const auto select = [&q, &ew](const auto& reader, const char* text,
+                                const std::string& name = "id") {
+    EXPECT_EQ(CompileQuery(text, &q, &ew), ERROR_SUCCESS_T) << text;
+    return query_values(reader->Select(q), name);
+  };
+
+  reader_options flat;
+  flat.flat_tree = true;
+  reader_options lazy;
+  lazy.lazy_init = true;
+  for (const auto& opts : {reader_options(), flat, lazy}) {
+    std::unique_ptr<test_reader> reader(
+        test_reader::Init(doc, nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    EXPECT_EQ(select(reader, "g1/i1"), strings({"1"}));
+    EXPECT_EQ(select(reader, "/*/i1"), strings({"1", "3"}));
+    EXPECT_EQ(select(reader, "//i1"), strings({"1", "3", "4"}));
+    // каждый узел - один раз, в порядке документа
+    EXPECT_EQ(select(reader, "//*//i1"), strings({"1", "3", "4"}));
+    EXPECT_EQ(select(reader, "g2//*", ""), strings({"i1", "g3", "i1"}));
+    EXPECT_EQ(select(reader, "//*[@name='first']", ""),
+              strings({"g1", "g3"}));
+    EXPECT_EQ(select(reader, "//*[name = \"first\"]/i1"), strings({"1", "4"}));
+    EXPECT_EQ(select(reader, "//*[@price>9]"), strings({"1", "2"}));
+    EXPECT_EQ(select(reader, "//*[@price<=7][@id]"), strings({"3", "4"}));
+    EXPECT_EQ(select(reader, "//*[@kind]", ""), strings({"g1"}));
+    EXPECT_EQ(select(reader, "//*[@name!=first]", ""), strings({"g2"}));
+    EXPECT_TRUE(select(reader, "missing//i1").empty());
+
+    // индекс значений параметра: те же результаты
+    ASSERT_EQ(reader->BuildQueryIndex("name"), ERROR_SUCCESS_T);
+    ASSERT_EQ(CompileQuery("//*[@name='first']/i1", &q, &ew),
+              ERROR_SUCCESS_T);
+    auto indexed = reader->Select(q);
+    EXPECT_TRUE(indexed.IsIndexed());
+    EXPECT_EQ(query_values(indexed, "id"), strings({"1", "4"}));
+    EXPECT_EQ(select(reader, "//*[@name=first]//*"), strings({"1", "2", "4"}));
+    EXPECT_EQ(select(reader, "//g3[@name='first']", ""), strings({"g3"}));
+    EXPECT_TRUE(select(reader, "//*[@name='none']").empty());
+  }
+
+  // нестроковые значения json сравниваются как числа и bool
+  std::string json =
+      "{\"root\": {\"a\": {\"id\": 5, \"ok\": true}, \"b\": {\"id\": \"5\"}, "
+      "\"c\": {\"id\": 5.5, \"ok\": false}}}";
+  typedef ReaderSample<json_tape_node, lib_init<json_tape_node>> tape_reader;
+  std::unique_ptr<tape_reader> reader(tape_reader::Init(json.c_str()));
+  ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(select(reader, "//*[@id=5]", ""), strings({"a", "b"}));
+  EXPECT_EQ(select(reader, "//*[@id>5]", ""), strings({"c"}));
+  EXPECT_EQ(select(reader, "//*[@ok=true]", ""), strings({"a"}));
+  EXPECT_EQ(select(reader, "//*[@ok]", ""), strings({"a", "c"}));
+  ASSERT_EQ(reader->BuildQueryIndex("id"), ERROR_SUCCESS_T);
+  ASSERT_EQ(CompileQuery("//*[@id=5]", &q, &ew), ERROR_SUCCESS_T);
+  auto indexed = reader->Select(q);
+  EXPECT_TRUE(indexed.IsIndexed());
+  EXPECT_EQ(query_values(indexed, ""), strings({"a", "b"}));
+}
+
+/** \brief Узел для проверки обхода глубоких деревьев без ридера */
+struct chain_node {
+  typedef childs_const_iterator<chain_node> const_iterator;
+
+  const_iterator begin() const { return const_iterator(childs.cbegin()); }
+  const_iterator end() const { return const_iterator(childs.cend()); }
+
+  std::vector<std::unique_ptr<chain_node>> childs;
+};
+static_assert(ChildsIterableType<chain_node>);
+static_assert(ChildsIterableType<test_node>);
+
+/**
+ * \brief Тест константного обхода дерева ридера
+ * */
+TEST(Readers, TreeTraversal) {
+  const char* doc =
+      "catalog{ version=3 "
+      "  g1{ name=first i1{ id=1 } i2{ id=2 } } "
+      "  g2{ name=second i1{ id=3 } g3{ i1{ id=4 } } } "
+      "  misc{ i9{ id=5 } } }";
+  typedef std::vector<std::string> strings;
+  const strings dfs = {"catalog", "g1", "i1", "i2", "g2",
+                       "i1",      "g3", "i1", "misc", "i9"};
+  const strings bfs = {"catalog", "g1", "g2", "misc", "i1",
+                       "i2",      "i1", "g3", "i9",   "i1"};
+  const std::vector<size_t> dfs_depth = {0, 1, 2, 2, 1, 2, 2, 3, 1, 2};
+  const std::vector<size_t> bfs_depth = {0, 1, 1, 1, 2, 2, 2, 2, 2, 3};
+
+  reader_options flat;
+  flat.flat_tree = true;
+  std::unique_ptr<test_reader> flat_reader(
+      test_reader::Init(doc, nullptr, flat));
+  ASSERT_EQ(flat_reader->InitData(), ERROR_SUCCESS_T);
+  EXPECT_EQ(flat_reader->GetRootNode(), nullptr);
+
+  reader_options lazy;
+  lazy.lazy_init = true;
+  for (const auto& opts : {reader_options(), lazy}) {
+    std::unique_ptr<test_reader> reader(test_reader::Init(doc, nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    const test_node* root = reader->GetRootNode();
+    ASSERT_NE(root, nullptr);
+
+    strings childs;
+    for (const auto& ch : *root)
+      childs.push_back(ch.node_data_ptr->GetName());
+    EXPECT_EQ(childs, strings({"g1", "g2", "misc"}));
+
+    strings names;
+    std::vector<size_t> depths;
+    auto df = DepthFirst(*root);
+    for (auto it = df.begin(); it != df.end(); ++it) {
+      names.push_back(it->node_data_ptr->GetName());
+      depths.push_back(it.GetDepth());
+    }
+    EXPECT_EQ(names, dfs);
+    EXPECT_EQ(depths, dfs_depth);
+
+    names.clear();
+    depths.clear();
+    auto bf = BreadthFirst(*root);
+    for (auto it = bf.begin(); it != bf.end(); ++it) {
+      names.push_back(it->node_data_ptr->GetName());
+      depths.push_back(it.GetDepth());
+    }
+    EXPECT_EQ(names, bfs);
+    EXPECT_EQ(depths, bfs_depth);
+
+    // пропуск поддерева g2
+    names.clear();
+    auto skip = DepthFirst(*root);
+    for (auto it = skip.begin(); it != skip.end(); ++it) {
+      names.push_back(it->node_data_ptr->GetName());
+      if (names.back() == "g2")
+        skip.SkipChilds();
+    }
+    EXPECT_EQ(names,
+              strings({"catalog", "g1", "i1", "i2", "g2", "misc", "i9"}));
+  }
+
+  // прежний обход NextChild совпадает с константным
+  test_tree tree;
+  size_t pos = 0;
+  ASSERT_TRUE(test_tree::parse(doc, &pos, &tree));
+  test_node cursor(lib_node<test_tree>(&tree), nullptr, "catalog");
+  for (int r = 0; r < 2; ++r) {
+    strings next;
+    while (test_node* ch = cursor.NextChild())
+      next.push_back(ch->node_data_ptr->GetName());
+    EXPECT_EQ(next, strings({"g1", "g2", "misc"}));
+    EXPECT_EQ(cursor.NextChild(), nullptr);
+    cursor.child_pos = 0;
+  }
+
+  // одно дерево обходят несколько потоков, без общего состояния
+  std::string big = test_document(64, 32);
+  reader_options lazy_opts;
+  lazy_opts.lazy_init = true;
+  std::unique_ptr<test_reader> reader(
+      test_reader::Init(big.c_str(), nullptr, lazy_opts));
+  ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+  const test_node* root = reader->GetRootNode();
+  std::vector<size_t> counts(8);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < counts.size(); ++t) {
+    threads.emplace_back([root, &counts, t]() {
+      for (int r = 0; r < 4; ++r) {
+        size_t count = 0;
+        if (t % 2) {
+          for (const auto& n : DepthFirst(*root))
+            count += !n.node_data_ptr->GetName().empty();
+        } else {
+          for (const auto& n : BreadthFirst(*root))
+            count += !n.node_data_ptr->GetName().empty();
+        }
+        counts[t] = count;
+      }
+    });
+  }
+  for (auto& th : threads)
+    th.join();
+  for (size_t count : counts)
+    EXPECT_EQ(count, 1u + 64 + 64 * 32);
+
+  // глубина дерева ограничена памятью, а не стеком
+  const size_t depth = 200000;
+  chain_node chain;
+  chain_node* last = &chain;
+  for (size_t i = 0; i < depth; ++i) {
+    last->childs.emplace_back(new chain_node());
+    last = last->childs.back().get();
+  }
+  size_t visited = 0, max_depth = 0;
+  auto df = DepthFirst(chain);
+  for (auto it = df.begin(); it != df.end(); ++it) {
+    ++visited;
+    max_depth = std::max(max_depth, it.GetDepth());
+  }
+  EXPECT_EQ(visited, depth + 1);
+  EXPECT_EQ(max_depth, depth);
+  size_t bf_visited = 0;
+  for (const auto& n : BreadthFirst(chain))
+    bf_visited += n.childs.size() <= 1;
+  EXPECT_EQ(bf_visited, depth + 1);
+  // удаление цепочки без рекурсии деструкторов
+  std::unique_ptr<chain_node> next = std::move(chain.childs.front());
+  while (next) {
+    std::unique_ptr<chain_node> tmp =
+        next->childs.empty() ? nullptr : std::move(next->childs.front());
+    next = std::move(tmp);
+  }
+}
+
+/**
+ * \brief Тест замороженного дерева ридера
+ * */
+TEST(Readers, Freeze) {
+  std::string doc = test_document(8, 24);
+  std::unique_ptr<test_reader> empty(test_reader::Init(doc.c_str()));
+  EXPECT_EQ(empty->Freeze(), nullptr);
+
+  std::vector<std::vector<std::string>> paths = {
+      {"version"}, {"s3", "id"}, {"s7", "i23", "v"}, {"s0", "i0", "none"}};
+  std::vector<path_handle> handles;
+  for (const auto& p : paths)
+    handles.emplace_back(p);
+  reader_options flat;
+  flat.flat_tree = true;
+  reader_options lazy;
+  lazy.lazy_init = true;
+  for (const auto& opts : {reader_options(), flat, lazy}) {
+    std::unique_ptr<test_reader> reader(
+        test_reader::Init(doc.c_str(), nullptr, opts));
+    ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+    std::shared_ptr<const test_reader::frozen_reader> frozen =
+        reader->Freeze();
+    ASSERT_NE(frozen, nullptr);
+    EXPECT_EQ(frozen->Size(), 1u + 8 + 8 * 24);
+
+    std::string value, buffer;
+    std::string_view view;
+    for (size_t i = 0; i < paths.size(); ++i) {
+      ASSERT_EQ(reader->GetValueByPath(paths[i], &value), ERROR_SUCCESS_T);
+      ASSERT_EQ(frozen->GetValueByPath(paths[i], &view, &buffer),
+                ERROR_SUCCESS_T);
+      EXPECT_EQ(view, value);
+      ASSERT_EQ(frozen->GetValueByPath(handles[i], &view, &buffer),
+                ERROR_SUCCESS_T);
+      EXPECT_EQ(view, value);
+    }
+    EXPECT_EQ(frozen->GetValueByPath("s7/i23/v"_path, &view, &buffer),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(view, "7023");
+    EXPECT_EQ(frozen->GetValueView("s2/i5"_path, "v", &view, &buffer),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(view, "2005");
+    EXPECT_EQ(frozen->GetValueByPath("s9/id"_path, &view, &buffer),
+              ERROR_PARSER_CHILD_NODE_ST);
+    // имя параметра сравнивается с именем из пути, без копирования
+    view = "x";
+    EXPECT_EQ(frozen->GetValueByPath(path_handle(std::string(300, 'p')),
+                                     &view, &buffer),
+              ERROR_SUCCESS_T);
+    EXPECT_TRUE(view.empty());
+
+    const std::vector<std::string> node_path = {"s4", "i1"};
+    EXPECT_EQ(frozen->GetNodeByPath(node_path),
+              reader->GetNodeByPath(node_path));
+    EXPECT_EQ(frozen->GetNodeByPath("s4/i1"_path)->GetName(), "i1");
+    EXPECT_EQ(frozen->GetNodeByPath("s4/none"_path), nullptr);
+    int v = 0;
+    EXPECT_EQ(frozen->GetValueAs("s5/i6"_path, "v", &v), ERROR_SUCCESS_T);
+    EXPECT_EQ(v, 5006);
+    EXPECT_EQ(frozen->GetValueAs("s5/i6"_path, "none", &v),
+              ERROR_PARSER_CHILD_NODE_ST);
+
+    // чтение из многих потоков без синхронизации
+    std::atomic<int> mismatches = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 16; ++t) {
+      threads.emplace_back([&frozen, &mismatches, t]() {
+        std::string_view view;
+        std::string buffer;
+        for (int r = 0; r < 200; ++r) {
+          int s = (t + r) % 8, i = r % 24;
+          path_handle path("s" + std::to_string(s) + "/i" +
+                           std::to_string(i) + "/v");
+          if (frozen->GetValueByPath(path, &view, &buffer) ||
+              view != std::to_string(s * 1000 + i))
+            ++mismatches;
+        }
+      });
+    }
+    for (auto& th : threads)
+      th.join();
+    EXPECT_EQ(mismatches, 0);
+  }
+
+  // числа и логические значения json - как у ReaderSample
+  std::string json =
+      "{\"root\": {\"n\": {\"i\": 42, \"neg\": -7, \"d\": 1.5, "
+      "\"ok\": true, \"no\": false, \"s\": \"str\"}}}";
+  typedef ReaderSample<json_tape_node, lib_init<json_tape_node>> tape_reader;
+  std::unique_ptr<tape_reader> reader(tape_reader::Init(json.c_str()));
+  ASSERT_EQ(reader->InitData(), ERROR_SUCCESS_T);
+  std::shared_ptr<const tape_reader::frozen_reader> frozen = reader->Freeze();
+  ASSERT_NE(frozen, nullptr);
+  std::string value, buffer;
+  std::string_view view;
+  for (const char* name : {"i", "neg", "d", "ok", "no", "s", "none"}) {
+    ASSERT_EQ(reader->GetValueByPath({"n", name}, &value), ERROR_SUCCESS_T);
+    ASSERT_EQ(frozen->GetValueView("n"_path, name, &view, &buffer),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(view, value) << name;
+    ASSERT_EQ(frozen->GetValueByPath(path_handle(std::string("n/") + name),
+                                     &view, &buffer),
+              ERROR_SUCCESS_T);
+    EXPECT_EQ(view, value) << name;
+  }
+  EXPECT_EQ(frozen->GetValueByPath("n/d"_path, &view, &buffer),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(view, "1.5");
+  EXPECT_EQ(frozen->GetValueByPath("n/ok"_path, &view, &buffer),
+            ERROR_SUCCESS_T);
+  EXPECT_EQ(view, "true");
+}
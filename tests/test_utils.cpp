@@ -1,5 +1,8 @@
+#include "asp_utils/Arena.h"
+#include "asp_utils/ChunkQueue.h"
 #include "asp_utils/Common.h"
 #include "asp_utils/ErrorWrap.h"
+#include "asp_utils/FileBuffer.h"
 #include "asp_utils/FileURL.h"
 
 #include "gtest/gtest.h"
@@ -7,6 +10,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 #include <assert.h>
 
@@ -51,6 +55,56 @@ TEST(Common, SplitJoin) {
 /**
  * \brief Тест врапера ошибок
  * */
+namespace test_enum {
+enum class mode { off, on };
+bool from_string(std::string_view s, mode* m) {
+  if (s == "off" || s == "on") {
+    *m = (s == "on") ? mode::on : mode::off;
+    return true;
+  }
+  return false;
+}
+}  // namespace test_enum
+
+TEST(Common, StrToValue) {
+  EXPECT_EQ(trim_view("  \t12.5 \n"), "12.5");
+  EXPECT_EQ(trim_view("   "), "");
+  EXPECT_EQ(trim_view(""), "");
+
+  int i = 0;
+  EXPECT_TRUE(str_to_value("-42", &i));
+  EXPECT_EQ(i, -42);
+  EXPECT_TRUE(str_to_value("+7", &i));
+  EXPECT_EQ(i, 7);
+  EXPECT_FALSE(str_to_value("12abc", &i));
+  EXPECT_FALSE(str_to_value("+-1", &i));
+  EXPECT_FALSE(str_to_value("", &i));
+  EXPECT_EQ(i, 7);
+  uint8_t u = 0;
+  EXPECT_FALSE(str_to_value("300", &u));
+  EXPECT_TRUE(str_to_value("255", &u));
+  EXPECT_EQ(u, 255);
+  double d = 0.0;
+  EXPECT_TRUE(str_to_value("1.5e3", &d));
+  EXPECT_DOUBLE_EQ(d, 1500.0);
+  float f = 0.0f;
+  EXPECT_TRUE(str_to_value(trim_view(" 0.25 "), &f));
+  EXPECT_FLOAT_EQ(f, 0.25f);
+  EXPECT_FALSE(str_to_value("1,5", &f));
+  bool b = false;
+  EXPECT_TRUE(str_to_value("true", &b));
+  EXPECT_TRUE(b);
+  EXPECT_TRUE(str_to_value("0", &b));
+  EXPECT_FALSE(b);
+  EXPECT_FALSE(str_to_value("yes", &b));
+  test_enum::mode m = test_enum::mode::off;
+  EXPECT_TRUE(str_to_value("on", &m));
+  EXPECT_EQ(m, test_enum::mode::on);
+  EXPECT_TRUE(str_to_value("0", &m));
+  EXPECT_EQ(m, test_enum::mode::off);
+  EXPECT_FALSE(str_to_value("maybe", &m));
+}
+
 TEST(ErrorWrap, Full) {
   ErrorWrap ew;
   /* конструктор по умолчанию */
@@ -143,6 +197,139 @@ TEST(FileURL, Full_filesystem) {
   EXPECT_TRUE(fs::remove_all(td));
 }
 
+/**
+ * \brief Тест арены объектов
+ * */
+TEST(Arena, Full) {
+  struct counted {
+    counted(int* c, int v) : c(c), v(v) { ++*c; }
+    ~counted() { --*c; }
+    int* c;
+    int v;
+  };
+  int alive = 0;
+  Arena arena(256);
+  std::vector<counted*> objs;
+  for (int i = 0; i < 100; ++i)
+    objs.push_back(arena.Create<counted>(&alive, i));
+  EXPECT_EQ(alive, 100);
+  EXPECT_EQ(arena.GetObjectsCount(), 100);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(objs[i]->v, i);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(objs[i]) % alignof(counted), 0);
+  }
+  /* объект больше блока */
+  char* big = static_cast<char*>(arena.Allocate(1024, 64));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % 64, 0);
+  memset(big, 1, 1024);
+  EXPECT_GE(arena.GetAllocatedSize(), 1024);
+
+  Arena moved(std::move(arena));
+  EXPECT_EQ(arena.GetObjectsCount(), 0);
+  moved.Release();
+  EXPECT_EQ(alive, 0);
+  EXPECT_EQ(moved.GetAllocatedSize(), 0);
+}
+
+/**
+ * \brief Тест FileBuffer
+ *
+ * Загрузка файла копированием и отображением в память
+ * */
+TEST(FileBuffer, Load) {
+  fs::path tf = "test_file_buffer";
+  const std::string content = "<root>\n  <a> 1 </a>\n</root>\n";
+  std::ofstream file(tf, std::ios::binary);
+  ASSERT_TRUE(file.is_open());
+  file << content;
+  file.close();
+
+  for (auto mode : {buffer_mode_t::copy, buffer_mode_t::mmap}) {
+    ErrorWrap ew;
+    FileBuffer fb;
+    EXPECT_EQ(fb.Load(tf, mode, ew), ERROR_SUCCESS_T);
+    ASSERT_EQ(fb.GetSize(), content.size());
+    EXPECT_EQ(std::string(fb.GetData()), content);
+    EXPECT_EQ(fb.GetData()[fb.GetSize()], '\0');
+    #ifdef OS_UNIX
+    EXPECT_EQ(fb.IsMapped(), mode == buffer_mode_t::mmap);
+    #endif  // OS_UNIX
+    /* данные изменяемы, файл при этом не меняется */
+    fb.GetData()[0] = '_';
+    FileBuffer moved(std::move(fb));
+    EXPECT_TRUE(fb.IsEmpty());
+    EXPECT_EQ(moved.GetData()[0], '_');
+  }
+  std::ifstream check(tf);
+  std::stringstream sstr;
+  sstr << check.rdbuf();
+  EXPECT_EQ(sstr.str(), content);
+
+  /* несуществующий файл */
+  ErrorWrap ew;
+  FileBuffer fb;
+  EXPECT_EQ(fb.Load("not_exists_file", buffer_mode_t::mmap, ew),
+            ERROR_FILE_EXISTS_ST);
+  EXPECT_TRUE(fb.IsEmpty());
+
+  /* копия строки */
+  EXPECT_EQ(fb.Assign(content.c_str(), content.size()), ERROR_SUCCESS_T);
+  EXPECT_FALSE(fb.IsMapped());
+  EXPECT_EQ(std::string(fb.GetData()), content);
+
+  /* сборка из частей */
+  FileBuffer parts;
+  for (size_t i = 0; i < content.size(); i += 3)
+    EXPECT_EQ(parts.Append(content.data() + i,
+                           std::min<size_t>(3, content.size() - i)),
+              ERROR_SUCCESS_T);
+  EXPECT_EQ(parts.Append(nullptr, 0), ERROR_SUCCESS_T);
+  ASSERT_EQ(parts.GetSize(), content.size());
+  EXPECT_EQ(std::string(parts.GetData()), content);
+
+  EXPECT_TRUE(fs::remove(tf));
+}
+
+/**
+ * \brief Тест ChunkQueue
+ *
+ * Источник в отдельном потоке, очередь меньше количества блоков
+ * */
+TEST(ChunkQueue, Full) {
+  std::string expected;
+  for (int i = 0; i < 200; ++i)
+    expected += "chunk" + std::to_string(i) + ";";
+  ChunkQueue queue(2);
+  std::thread producer([&queue]() {
+    for (int i = 0; i < 200; ++i)
+      EXPECT_TRUE(queue.Push("chunk" + std::to_string(i) + ";"));
+    queue.Close();
+  });
+  std::string read;
+  char buffer[7];
+  size_t n;
+  while ((n = queue.Read(buffer, sizeof(buffer))) != 0)
+    read.append(buffer, n);
+  producer.join();
+  EXPECT_EQ(read, expected);
+
+  /* прерванное чтение освобождает источник */
+  ChunkQueue cancelled(1);
+  EXPECT_TRUE(cancelled.Push("a"));
+  std::thread blocked([&cancelled]() { EXPECT_FALSE(cancelled.Push("b")); });
+  cancelled.Cancel();
+  blocked.join();
+  EXPECT_EQ(cancelled.Read(buffer, sizeof(buffer)), 0);
+
+  /* после Drain блоки отбрасываются */
+  ChunkQueue drained(1);
+  drained.Drain();
+  EXPECT_TRUE(drained.Push("a"));
+  EXPECT_TRUE(drained.Push("b"));
+  drained.Close();
+  EXPECT_EQ(drained.Read(buffer, sizeof(buffer)), 0);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();